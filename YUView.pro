@@ -1,9 +1,11 @@
 TEMPLATE = subdirs
-SUBDIRS = YUViewLib YUViewApp YUViewUnitTest
+SUBDIRS = YUViewLib YUViewApp YUViewCLI YUViewUnitTest
 
 YUViewApp.subdir = YUViewApp
+YUViewCLI.subdir = YUViewCLI
 YUViewLib.subdir = YUViewLib
 YUViewUnitTest.subdir = YUViewUnitTest
 
 YUViewApp.depends = YUViewLib
+YUViewCLI.depends = YUViewLib
 YUViewUnitTest.depends = YUViewLib
@@ -0,0 +1,314 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "batchAnalysis.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <cmath>
+
+#include "parser/parserAnnexBAVC.h"
+#include "parser/parserAnnexBHEVC.h"
+#include "parser/parserAnnexBVVC.h"
+#include "parser/parserAVFormat.h"
+#include "playlistitem/playlistItemCompressedVideo.h"
+#include "playlistitem/playlistItemDifference.h"
+#include "playlistitem/playlistItemRawFile.h"
+#include "playlistitem/playlistItemStatisticsBinaryFile.h"
+
+using namespace YUView;
+
+namespace
+{
+  batchAnalysis::jobResult error(const QString &message)
+  {
+    batchAnalysis::jobResult r;
+    r.message = message;
+    return r;
+  }
+
+  batchAnalysis::jobResult success(const QString &message)
+  {
+    batchAnalysis::jobResult r;
+    r.success = true;
+    r.message = message;
+    return r;
+  }
+
+  // Get the path of an output file. It is placed in the output directory (if set) or next to the input file.
+  QString getOutputFilePath(const QString &inputFile, const QString &fileName, const batchAnalysis::options &opt)
+  {
+    const QString dir = opt.outputDir.isEmpty() ? QFileInfo(inputFile).absolutePath() : opt.outputDir;
+    return QDir(dir).filePath(fileName);
+  }
+
+  // Open the file as a raw file (if the extension is one of the raw extensions) or as a compressed video
+  playlistItemWithVideo *openVideoFile(const QString &file, const batchAnalysis::options &opt)
+  {
+    QStringList rawExtensions, filters;
+    playlistItemRawFile::getSupportedFileExtensions(rawExtensions, filters);
+    if (rawExtensions.contains(QFileInfo(file).suffix().toLower()))
+    {
+      if (opt.rawFrameSize.isValid())
+        return new playlistItemRawFile(file, opt.rawFrameSize, opt.rawPixelFormat);
+      return new playlistItemRawFile(file);
+    }
+    return new playlistItemCompressedVideo(file);
+  }
+
+  // Get the number of frames to process of the item (limited by maxFrames)
+  int getNumberFramesToProcess(const playlistItem *item, const batchAnalysis::options &opt)
+  {
+    const indexRange range = item->getFrameIdxRange();
+    if (range.first < 0 || range.second < range.first)
+      return 0;
+    const int nrFrames = range.second - range.first + 1;
+    return (opt.maxFrames >= 0) ? std::min(nrFrames, opt.maxFrames) : nrFrames;
+  }
+
+  // Get the bit depth of the raw (YUV/RGB) data of the video handler
+  int getBitDepth(frameHandler *handler)
+  {
+    if (auto yuvVideo = dynamic_cast<videoHandlerYUV*>(handler))
+      return YUV_Internals::yuvPixelFormat(yuvVideo->getRawYUVPixelFormatName()).bitsPerSample;
+    if (auto rgbVideo = dynamic_cast<videoHandlerRGB*>(handler))
+    {
+      RGB_Internals::rgbPixelFormat format;
+      format.setFromName(rgbVideo->getRawRGBPixelFormatName());
+      return format.bitsPerValue;
+    }
+    return 8;
+  }
+
+  double mseToPSNR(double mse, int bitDepth)
+  {
+    if (mse <= 0.0)
+      return PSNR_IDENTICAL_FRAMES;
+    const double maxVal = double((1 << bitDepth) - 1);
+    return 10.0 * std::log10(maxVal * maxVal / mse);
+  }
+}
+
+batchAnalysis::jobResult batchAnalysis::parseFile(const job &j, const options &opt)
+{
+  const QFileInfo fileInfo(j.fileA);
+  if (!fileInfo.exists())
+    return error("File not found.");
+
+  // Get the right parser (in the same way that playlistItemCompressedVideo determines the input format)
+  QScopedPointer<parserBase> parser;
+  const QString ext = fileInfo.suffix().toLower();
+  if (ext == "hevc" || ext == "h265" || ext == "265")
+    parser.reset(new parserAnnexBHEVC());
+  else if (ext == "vvc" || ext == "h266" || ext == "266")
+    parser.reset(new parserAnnexBVVC());
+  else if (ext == "avc" || ext == "h264" || ext == "264")
+    parser.reset(new parserAnnexBAVC());
+  else
+    parser.reset(new parserAVFormat());
+
+  // With the packet model enabled, the file is really parsed (the bitstream index does not contain the bitrates).
+  // The AnnexB parsers only keep a compact record per NAL unit in this case.
+  parser->enableModel();
+  parser->setParsingLimitEnabled(false);
+  if (!parser->runParsingOfFile(j.fileA))
+    return error("Error parsing the bitstream.");
+
+  const QString outputFile = getOutputFilePath(j.fileA, fileInfo.completeBaseName() + "_bitrate.csv", opt);
+  QFile file(outputFile);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    return error(QString("Error opening output file %1.").arg(outputFile));
+
+  QTextStream out(&file);
+  out << "Stream;DTS;PTS;Bitrate;Keyframe;FrameType\n";
+  const auto bitratePerStream = parser->getBitrateItemModel()->getBitratePerStreamData();
+  int nrEntries = 0;
+  for (auto it = bitratePerStream.constBegin(); it != bitratePerStream.constEnd(); it++)
+  {
+    for (const auto &entry : it.value())
+    {
+      out << it.key() << ";" << entry.dts << ";" << entry.pts << ";" << entry.bitrate << ";" << (entry.keyframe ? 1 : 0) << ";" << entry.frameType << "\n";
+      nrEntries++;
+    }
+  }
+
+  return success(QString("Wrote %1 bitrate entries of %2 streams to %3").arg(nrEntries).arg(bitratePerStream.size()).arg(outputFile));
+}
+
+batchAnalysis::jobResult batchAnalysis::decodeFile(const job &j, const options &opt)
+{
+  if (!QFileInfo(j.fileA).exists())
+    return error("File not found.");
+
+  QScopedPointer<playlistItemWithVideo> item(openVideoFile(j.fileA, opt));
+  if (item->isError())
+    return error(item->getErrorText());
+  videoHandler *video = dynamic_cast<videoHandler*>(item->getFrameHandler());
+  if (video == nullptr || !video->isFormatValid())
+    return error("The video format is not valid.");
+
+  // The output file name follows the conventions that YUView uses to guess the format from the name
+  const QSize size = video->getFrameSize();
+  const int bitDepth = getBitDepth(video);
+  QString fileName = QString("%1_%2x%3_%4_%5bit").arg(QFileInfo(j.fileA).completeBaseName()).arg(size.width()).arg(size.height()).arg(int(item->getFrameRate())).arg(bitDepth);
+  if (auto yuvVideo = dynamic_cast<videoHandlerYUV*>(video))
+  {
+    const QStringList subsamplings = QStringList() << "444" << "422" << "420" << "440" << "410" << "411" << "400";
+    const YUV_Internals::yuvPixelFormat format(yuvVideo->getRawYUVPixelFormatName());
+    fileName += "_" + subsamplings.value(format.subsampling) + ".yuv";
+  }
+  else
+    fileName += ".rgb";
+
+  const QString outputFile = getOutputFilePath(j.fileA, fileName, opt);
+  QFile file(outputFile);
+  if (!file.open(QIODevice::WriteOnly))
+    return error(QString("Error opening output file %1.").arg(outputFile));
+
+  const int nrFrames = getNumberFramesToProcess(item.data(), opt);
+  for (int frameIdx = 0; frameIdx < nrFrames; frameIdx++)
+  {
+    const QByteArray frameData = video->getRawFrameData(frameIdx);
+    if (frameData.isEmpty())
+      return error(QString("Error decoding frame %1.").arg(frameIdx));
+    if (file.write(frameData) != frameData.size())
+      return error(QString("Error writing frame %1 to %2.").arg(frameIdx).arg(outputFile));
+  }
+
+  return success(QString("Wrote %1 frames to %2").arg(nrFrames).arg(outputFile));
+}
+
+batchAnalysis::jobResult batchAnalysis::compareFiles(const job &j, const options &opt)
+{
+  if (!QFileInfo(j.fileA).exists() || !QFileInfo(j.fileB).exists())
+    return error("File not found.");
+
+  QScopedPointer<playlistItemWithVideo> items[2];
+  items[0].reset(openVideoFile(j.fileA, opt));
+  items[1].reset(openVideoFile(j.fileB, opt));
+  for (int i = 0; i < 2; i++)
+    if (items[i]->isError())
+      return error(QString("%1: %2").arg(items[i]->getName()).arg(items[i]->getErrorText()));
+
+  frameHandler *video[2] = {items[0]->getFrameHandler(), items[1]->getFrameHandler()};
+  if (!video[0]->isFormatValid() || !video[1]->isFormatValid())
+    return error("The video format is not valid.");
+
+  const QString outputFile = getOutputFilePath(j.fileA, QString("%1_vs_%2_psnr.csv").arg(QFileInfo(j.fileA).completeBaseName()).arg(QFileInfo(j.fileB).completeBaseName()), opt);
+  QFile file(outputFile);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    return error(QString("Error opening output file %1.").arg(outputFile));
+  QTextStream out(&file);
+
+  // The difference is calculated in the higher bit depth of the two inputs
+  const int bitDepth = std::max(getBitDepth(video[0]), getBitDepth(video[1]));
+  const int nrFrames = std::min(getNumberFramesToProcess(items[0].data(), opt), getNumberFramesToProcess(items[1].data(), opt));
+  double psnrSum[3] = {0, 0, 0};
+  bool headerWritten = false;
+  for (int frameIdx = 0; frameIdx < nrFrames; frameIdx++)
+  {
+    QStringList components;
+    QList<double> mse;
+    auto yuvVideo0 = dynamic_cast<videoHandlerYUV*>(video[0]);
+    auto yuvVideo1 = dynamic_cast<videoHandlerYUV*>(video[1]);
+    if (yuvVideo0 && yuvVideo1)
+    {
+      // Calculate the SSE of the Y, U and V components directly from the raw data (no difference image is created)
+      int64_t sse[3], nrSamples[3];
+      if (!videoHandlerYUV::calculateSSE(yuvVideo0->getRawFrameData(frameIdx), yuvVideo0->getFrameSize(), YUV_Internals::yuvPixelFormat(yuvVideo0->getRawYUVPixelFormatName()),
+                                         yuvVideo1->getRawFrameData(frameIdx), yuvVideo1->getFrameSize(), YUV_Internals::yuvPixelFormat(yuvVideo1->getRawYUVPixelFormatName()),
+                                         sse, nrSamples))
+        return error(QString("Error calculating the difference of frame %1.").arg(frameIdx));
+      components << "Y" << "U" << "V";
+      for (int c = 0; c < 3; c++)
+        mse.append((nrSamples[c] > 0) ? double(sse[c]) / nrSamples[c] : 0.0);
+    }
+    else
+    {
+      // The difference function returns the MSE per component (R/G/B) and in total in the info list
+      QList<infoItem> differenceInfoList;
+      if (video[0]->calculateDifference(video[1], frameIdx, frameIdx, differenceInfoList, 1, false).isNull())
+        return error(QString("Error calculating the difference of frame %1.").arg(frameIdx));
+
+      for (const infoItem &info : differenceInfoList)
+        if (info.name.startsWith("MSE ") && info.name != "MSE All")
+        {
+          components.append(info.name.mid(4));
+          mse.append(info.text.toDouble());
+        }
+    }
+    if (mse.size() != 3)
+      return error(QString("No MSE values for frame %1.").arg(frameIdx));
+
+    if (!headerWritten)
+    {
+      out << "Frame";
+      for (const QString &c : components)
+        out << ";MSE " << c;
+      for (const QString &c : components)
+        out << ";PSNR " << c;
+      out << "\n";
+      headerWritten = true;
+    }
+
+    out << frameIdx;
+    for (double m : mse)
+      out << ";" << m;
+    for (int c = 0; c < 3; c++)
+    {
+      const double psnr = mseToPSNR(mse[c], bitDepth);
+      psnrSum[c] += psnr;
+      out << ";" << psnr;
+    }
+    out << "\n";
+  }
+
+  if (nrFrames == 0)
+    return error("There are no frames to compare.");
+  return success(QString("Compared %1 frames (average PSNR %2/%3/%4 dB). Wrote %5")
+                 .arg(nrFrames).arg(psnrSum[0] / nrFrames, 0, 'f', 2).arg(psnrSum[1] / nrFrames, 0, 'f', 2).arg(psnrSum[2] / nrFrames, 0, 'f', 2).arg(outputFile));
+}
+
+batchAnalysis::jobResult batchAnalysis::convertStatisticsFile(const job &j, const options &opt)
+{
+  if (!QFileInfo(j.fileA).exists())
+    return error("File not found.");
+
+  const QString outputFile = getOutputFilePath(j.fileA, QFileInfo(j.fileA).completeBaseName() + ".yuvstat", opt);
+  QString errorText;
+  if (!playlistItemStatisticsBinaryFile::convertStatisticsFile(j.fileA, outputFile, errorText))
+    return error(errorText);
+  return success(QString("Wrote %1").arg(outputFile));
+}
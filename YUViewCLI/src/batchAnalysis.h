@@ -0,0 +1,80 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BATCHANALYSIS_H
+#define BATCHANALYSIS_H
+
+#include <QSize>
+#include <QString>
+
+/* The batch analysis functions of the command line interface (yuview-cli). Each function processes one file
+ * (or one pair of files) without any user interaction and can be called from any thread. All the objects
+ * (playlist items, parsers, decoders) are created by the job itself, so different jobs can run in parallel.
+ */
+namespace batchAnalysis
+{
+  struct options
+  {
+    // The directory to write the output files to. If empty, the output is written next to the input file.
+    QString outputDir;
+    // The frame size and pixel format of raw (YUV/RGB) input files. If not set, they are guessed from the file.
+    QSize rawFrameSize;
+    QString rawPixelFormat;
+    // The maximum number of frames to decode/compare (-1: all frames)
+    int maxFrames {-1};
+  };
+
+  // A job processes one file (fileB is only used for the comparison)
+  struct job
+  {
+    QString fileA;
+    QString fileB;
+  };
+
+  struct jobResult
+  {
+    bool success {false};
+    // A summary of the result or the error
+    QString message;
+  };
+
+  // Parse the bitstream and write the bitrate of each frame/packet to "<name>_bitrate.csv"
+  jobResult parseFile(const job &j, const options &opt);
+  // Decode the file and write the raw frames (in the decoded pixel format) to "<name>_<size>_<rate>_<bitDepth>.yuv/.rgb"
+  jobResult decodeFile(const job &j, const options &opt);
+  // Calculate the MSE/PSNR of each frame between fileA and fileB and write them to "<nameA>_vs_<nameB>_psnr.csv"
+  jobResult compareFiles(const job &j, const options &opt);
+  // Convert a CSV/VTMBMS statistics file to a binary statistics file "<name>.yuvstat"
+  jobResult convertStatisticsFile(const job &j, const options &opt);
+}
+
+#endif // BATCHANALYSIS_H
@@ -0,0 +1,193 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <algorithm>
+#include <functional>
+
+#include "batchAnalysis.h"
+#include "common/typedef.h"
+
+/* yuview-cli runs the analysis functions of YUViewLib without a display. Each input file (or pair of files
+ * for the comparison) is processed as one job and the jobs are distributed over all cores.
+ */
+int main(int argc, char *argv[])
+{
+  // The playlist items use QIcon/QImage which need a QGuiApplication. Use the offscreen platform unless
+  // a platform is explicitly requested.
+  if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+
+  qRegisterMetaType<recacheIndicator>("recacheIndicator");
+
+  QApplication app(argc, argv);
+  // Use the same settings as the GUI (e.g. the decoder library paths)
+  app.setApplicationName("YUView");
+  app.setApplicationVersion(QString::fromUtf8(YUVIEW_VERSION));
+  app.setOrganizationName("Institut für Nachrichtentechnik, RWTH Aachen University");
+  app.setOrganizationDomain("ient.rwth-aachen.de");
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription("YUView batch analysis.\n\n"
+                                   "Commands:\n"
+                                   "  parse    Parse bitstreams and write the bitrate tables (<name>_bitrate.csv)\n"
+                                   "  decode   Decode videos and write the raw frames\n"
+                                   "  compare  Calculate the per frame MSE/PSNR of file pairs (<nameA>_vs_<nameB>_psnr.csv)\n"
+                                   "  stats    Convert CSV/VTMBMS statistics files to binary statistics files (<name>.yuvstat)");
+  parser.addHelpOption();
+  parser.addVersionOption();
+  parser.addPositionalArgument("command", "The command to run (parse, decode, compare, stats).");
+  parser.addPositionalArgument("files", "The input files. For compare, the files are processed in pairs.", "[files...]");
+  QCommandLineOption listOption(QStringList() << "l" << "list", "Read additional input files from the list file (one file per line).", "file");
+  QCommandLineOption outputOption(QStringList() << "o" << "output", "Write all output files to this directory (default: next to the input file).", "directory");
+  QCommandLineOption sizeOption(QStringList() << "s" << "size", "The frame size of raw input files (e.g. 1920x1080).", "WxH");
+  QCommandLineOption formatOption(QStringList() << "f" << "format", "The pixel format name of raw input files (e.g. \"4:2:0 Y'CbCr 8-bit planar\").", "format");
+  QCommandLineOption framesOption(QStringList() << "n" << "frames", "The maximum number of frames to decode/compare.", "number");
+  QCommandLineOption jobsOption(QStringList() << "j" << "jobs", "The number of files to process in parallel (default: number of cores).", "number");
+  parser.addOption(listOption);
+  parser.addOption(outputOption);
+  parser.addOption(sizeOption);
+  parser.addOption(formatOption);
+  parser.addOption(framesOption);
+  parser.addOption(jobsOption);
+  parser.process(app);
+
+  QTextStream out(stdout);
+  QTextStream err(stderr);
+
+  QStringList args = parser.positionalArguments();
+  if (args.isEmpty())
+    parser.showHelp(1);
+
+  std::function<batchAnalysis::jobResult(const batchAnalysis::job&, const batchAnalysis::options&)> jobFunction;
+  const QString command = args.takeFirst();
+  if (command == "parse")
+    jobFunction = batchAnalysis::parseFile;
+  else if (command == "decode")
+    jobFunction = batchAnalysis::decodeFile;
+  else if (command == "compare")
+    jobFunction = batchAnalysis::compareFiles;
+  else if (command == "stats")
+    jobFunction = batchAnalysis::convertStatisticsFile;
+  else
+  {
+    err << "Unknown command " << command << "\n";
+    return 1;
+  }
+
+  // Collect all input files
+  QStringList files = args;
+  if (parser.isSet(listOption))
+  {
+    QFile listFile(parser.value(listOption));
+    if (!listFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+      err << "Error opening the list file " << listFile.fileName() << "\n";
+      return 1;
+    }
+    while (!listFile.atEnd())
+    {
+      const QString line = QString::fromUtf8(listFile.readLine()).trimmed();
+      if (!line.isEmpty())
+        files.append(line);
+    }
+  }
+
+  const bool compare = (command == "compare");
+  if (files.isEmpty() || (compare && files.size() % 2 != 0))
+  {
+    err << (compare ? "The compare command needs pairs of input files.\n" : "No input files given.\n");
+    return 1;
+  }
+
+  batchAnalysis::options opt;
+  opt.outputDir = parser.value(outputOption);
+  if (parser.isSet(sizeOption))
+  {
+    const QStringList size = parser.value(sizeOption).split('x');
+    if (size.size() == 2)
+      opt.rawFrameSize = QSize(size[0].toInt(), size[1].toInt());
+    if (!opt.rawFrameSize.isValid())
+    {
+      err << "Invalid frame size " << parser.value(sizeOption) << "\n";
+      return 1;
+    }
+  }
+  opt.rawPixelFormat = parser.value(formatOption);
+  if (parser.isSet(framesOption))
+    opt.maxFrames = parser.value(framesOption).toInt();
+
+  QList<batchAnalysis::job> jobs;
+  for (int i = 0; i < files.size(); i += (compare ? 2 : 1))
+  {
+    batchAnalysis::job j;
+    j.fileA = files[i];
+    if (compare)
+      j.fileB = files[i + 1];
+    jobs.append(j);
+  }
+
+  // The jobs run in their own pool. The library itself uses the global thread pool (e.g. for background parsing)
+  // and a job may wait for such a task to finish.
+  QThreadPool jobPool;
+  if (parser.isSet(jobsOption))
+    jobPool.setMaxThreadCount(std::max(parser.value(jobsOption).toInt(), 1));
+
+  QList<QFuture<batchAnalysis::jobResult>> futures;
+  for (const batchAnalysis::job &j : jobs)
+    futures.append(QtConcurrent::run(&jobPool, jobFunction, j, opt));
+
+  int nrErrors = 0;
+  for (int i = 0; i < jobs.size(); i++)
+  {
+    const batchAnalysis::jobResult result = futures[i].result();
+    const QString name = compare ? jobs[i].fileA + " / " + jobs[i].fileB : jobs[i].fileA;
+    if (result.success)
+      out << name << ": " << result.message << "\n";
+    else
+    {
+      err << name << ": Error: " << result.message << "\n";
+      nrErrors++;
+    }
+    out.flush();
+    err.flush();
+  }
+
+  if (nrErrors > 0)
+    err << nrErrors << " of " << jobs.size() << " jobs failed.\n";
+  return (nrErrors > 0) ? 1 : 0;
+}
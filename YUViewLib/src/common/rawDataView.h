@@ -0,0 +1,72 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef RAWDATAVIEW_H
+#define RAWDATAVIEW_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+
+/* A read-only view on a block of raw data (e.g. one raw YUV or RGB frame). The data is either held by an
+ * (implicitly shared) QByteArray or it lives in memory that is owned by someone else (e.g. a memory mapped file).
+ * In the second case, the view shares the ownership of that memory: As long as any copy of the view exists,
+ * the memory stays valid. Copying a view never copies the data.
+ */
+class rawDataView
+{
+public:
+  rawDataView() {}
+  // Create a view of the data in the array (no copy is made)
+  rawDataView(const QByteArray &array) : array(array) {}
+  // Create a view of size bytes at data. The memory must stay valid as long as owner exists.
+  rawDataView(const char *data, int size, const QSharedPointer<const void> &owner) : array(QByteArray::fromRawData(data, size)), owner(owner) {}
+
+  const char *data() const { return array.constData(); }
+  int size() const { return array.size(); }
+  bool isEmpty() const { return array.isEmpty(); }
+  void clear() { array.clear(); owner.clear(); }
+
+  // Get a QByteArray of the data without copying it. If the data is not owned by an array, the array
+  // only refers to the data. So do not keep it longer than the view.
+  const QByteArray &byteArray() const { return array; }
+  // Get a deep copy of the data that is independent of the view.
+  QByteArray toByteArray() const { return QByteArray(array.constData(), array.size()); }
+
+  // Is this a view of memory that is not owned by a QByteArray (like a mapped file)?
+  bool isExternal() const { return !owner.isNull(); }
+
+private:
+  QByteArray array;
+  QSharedPointer<const void> owner;
+};
+
+#endif // RAWDATAVIEW_H
@@ -108,8 +108,9 @@ enum { is_Q_OS_LINUX = 0 };
 // However, it is not yet clear what to do if the user wants/needs a second instance.
 #define WIN_LINUX_SINGLE_INSTANCE 0
 
-// Activate SSE YUV conversion
-// Do not activate. This is not supported right now.
+// Activate the aligned buffers for the old SSE YUV conversion.
+// Do not activate. This is not supported right now. The YUV conversion in the videoHandlerYUV
+// selects vectorized kernels at runtime (see video/videoHandlerYUVKernels.h).
 #define SSE_CONVERSION 0
 #if SSE_CONVERSION
 
@@ -3132,23 +3132,22 @@ bool AVPacketWrapper::checkForObuFormat(QByteArray &data)
     {
       parserCommon::sub_byte_reader reader(data, posInData);
 
-      QString bitsRead;
-      bool obu_forbidden_bit = (reader.readBits(1, bitsRead) != 0);
-      unsigned int obu_type = reader.readBits(4, bitsRead); // obu_type
+      bool obu_forbidden_bit = (reader.readBits(1) != 0);
+      unsigned int obu_type = reader.readBits(4); // obu_type
       if (obu_type == 0 || (obu_type >= 9 && obu_type <= 14))
         // RESERVED obu types should not occur (highly unlikely)
         return false;
-      bool obu_extension_flag = (reader.readBits(1, bitsRead) != 0);
-      bool obu_has_size_field = (reader.readBits(1, bitsRead) != 0);
-      bool obu_reserved_1bit = (reader.readBits(1, bitsRead) != 0);
+      bool obu_extension_flag = (reader.readBits(1) != 0);
+      bool obu_has_size_field = (reader.readBits(1) != 0);
+      bool obu_reserved_1bit = (reader.readBits(1) != 0);
 
       if (obu_forbidden_bit || obu_reserved_1bit)
         return false;
       if (obu_extension_flag)
       {
-        reader.readBits(3, bitsRead); // temporal_id
-        reader.readBits(2, bitsRead); // spatial_id
-        unsigned int extension_header_reserved_3bits = reader.readBits(3, bitsRead);
+        reader.readBits(3); // temporal_id
+        reader.readBits(2); // spatial_id
+        unsigned int extension_header_reserved_3bits = reader.readBits(3);
         if (extension_header_reserved_3bits != 0)
           return false;
       }
@@ -3156,7 +3155,7 @@ bool AVPacketWrapper::checkForObuFormat(QByteArray &data)
       if (obu_has_size_field)
       {
         int bitCount;
-        obu_size = reader.readLeb128(bitsRead, bitCount);
+        obu_size = reader.readLeb128(bitCount);
       }
       else
       {
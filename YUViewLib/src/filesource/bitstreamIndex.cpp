@@ -0,0 +1,142 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "bitstreamIndex.h"
+
+#include <climits>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#define BITSTREAMINDEX_DEBUG_OUTPUT 0
+#if BITSTREAMINDEX_DEBUG_OUTPUT && !NDEBUG
+#include <QDebug>
+#define DEBUG_INDEX qDebug
+#else
+#define DEBUG_INDEX(fmt,...) ((void)0)
+#endif
+
+// The magic number ("YVIX") and the version of the index file header
+#define INDEX_MAGIC   0x59564958
+#define INDEX_VERSION 1
+
+bitstreamIndex::bitstreamIndex(const QFileInfo &bitstreamFile, const QString &type) :
+  type(type),
+  bitstreamPath(bitstreamFile.absoluteFilePath()),
+  bitstreamSize(bitstreamFile.size()),
+  bitstreamModified(bitstreamFile.lastModified().toMSecsSinceEpoch())
+{
+}
+
+QString bitstreamIndex::getIndexFilePath() const
+{
+  const QString cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  if (cacheDir.isEmpty() || bitstreamPath.isEmpty())
+    return {};
+
+  // One index file per bitstream and type. The path is hashed because it can not be used as a file name.
+  const QByteArray pathHash = QCryptographicHash::hash(bitstreamPath.toUtf8(), QCryptographicHash::Sha1).toHex();
+  return cacheDir + "/bitstreamIndex/" + QString::fromLatin1(pathHash) + "." + type;
+}
+
+bool bitstreamIndex::open()
+{
+  const QString indexPath = getIndexFilePath();
+  if (indexPath.isEmpty())
+    return false;
+
+  indexFile.setFileName(indexPath);
+  if (!indexFile.open(QIODevice::ReadOnly) || indexFile.size() == 0 || indexFile.size() > INT_MAX)
+    return false;
+
+  uchar *data = indexFile.map(0, indexFile.size());
+  if (data == nullptr)
+    return false;
+  mappedData = QByteArray::fromRawData((const char*)data, int(indexFile.size()));
+  reader.reset(new QDataStream(mappedData));
+  setStreamVersion(*reader);
+
+  quint32 magic, version;
+  QString indexType, path;
+  qint64 size, modified;
+  *reader >> magic >> version >> indexType >> path >> size >> modified;
+  if (reader->status() != QDataStream::Ok || magic != INDEX_MAGIC || version != INDEX_VERSION || indexType != type)
+    return false;
+  if (path != bitstreamPath || size != bitstreamSize || modified != bitstreamModified)
+  {
+    DEBUG_INDEX("bitstreamIndex::open Index %s is outdated", indexPath.toStdString().c_str());
+    return false;
+  }
+
+  DEBUG_INDEX("bitstreamIndex::open Using index %s", indexPath.toStdString().c_str());
+  return true;
+}
+
+QDataStream &bitstreamIndex::writeStream()
+{
+  if (!writer)
+  {
+    writer.reset(new QDataStream(&writeData, QIODevice::WriteOnly));
+    setStreamVersion(*writer);
+  }
+  return *writer;
+}
+
+bool bitstreamIndex::save()
+{
+  const QString indexPath = getIndexFilePath();
+  if (indexPath.isEmpty() || !writer || writer->status() != QDataStream::Ok)
+    return false;
+  if (!QDir().mkpath(QFileInfo(indexPath).absolutePath()))
+    return false;
+
+  // Write to a temporary file first so that a partially written index is never used
+  QSaveFile file(indexPath);
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+
+  QDataStream header(&file);
+  setStreamVersion(header);
+  header << quint32(INDEX_MAGIC) << quint32(INDEX_VERSION) << type << bitstreamPath << bitstreamSize << bitstreamModified;
+  header.writeRawData(writeData.constData(), writeData.size());
+  if (header.status() != QDataStream::Ok)
+  {
+    file.cancelWriting();
+    return false;
+  }
+
+  DEBUG_INDEX("bitstreamIndex::save Saved index %s", indexPath.toStdString().c_str());
+  return file.commit();
+}
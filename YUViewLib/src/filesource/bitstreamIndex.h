@@ -0,0 +1,80 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef BITSTREAMINDEX_H
+#define BITSTREAMINDEX_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QFile>
+#include <QFileInfo>
+#include <QScopedPointer>
+#include <QString>
+
+/* A persistent index for a bitstream file. Finding all frames and random access points in a long bitstream
+ * takes a long time because the whole file has to be read. The parsers can save what they found in an index
+ * file (in the cache directory) and read it the next time that the same bitstream is opened.
+ * An index is only used if the path, the size and the modification time of the bitstream did not change.
+ * The index file is memory mapped for reading.
+ */
+class bitstreamIndex
+{
+public:
+  // The type identifies who wrote the index and the format of the data in it.
+  bitstreamIndex(const QFileInfo &bitstreamFile, const QString &type);
+
+  // Map the index file and check if it belongs to the bitstream. If it does, the data can be read from readStream().
+  bool open();
+  QDataStream &readStream() { return *reader; }
+
+  // Write the data to writeStream() and then call save() to replace the index file.
+  QDataStream &writeStream();
+  bool save();
+
+private:
+  QString getIndexFilePath() const;
+  void setStreamVersion(QDataStream &stream) const { stream.setVersion(QDataStream::Qt_5_6); }
+
+  QString type;
+  QString bitstreamPath;
+  qint64 bitstreamSize;
+  qint64 bitstreamModified;
+
+  QFile indexFile;
+  QByteArray mappedData;
+  QScopedPointer<QDataStream> reader;
+
+  QByteArray writeData;
+  QScopedPointer<QDataStream> writer;
+};
+
+#endif // BITSTREAMINDEX_H
@@ -32,6 +32,9 @@
 
 #include "fileSource.h"
 
+#include <algorithm>
+#include <climits>
+
 #include <QDateTime>
 #include <QDir>
 #include <QRegExp>
@@ -39,6 +42,13 @@
 #ifdef Q_OS_WIN
 #include <windows.h>
 #endif
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #include "common/typedef.h"
  
@@ -47,6 +57,80 @@
 #include <QThread>
 #endif
 
+// A read-only memory mapping of a file. The mapping uses its own QFile so that it does not
+// interfere with the seek/read position of the srcFile and can outlive the fileSource.
+class fileSourceMapping
+{
+public:
+  ~fileSourceMapping()
+  {
+    if (data != nullptr)
+      file.unmap(data);
+  }
+
+  bool map(const QString &filePath)
+  {
+    file.setFileName(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+      return false;
+    size = file.size();
+    if (size <= 0)
+      return false;
+    data = file.map(0, size);
+    return data != nullptr;
+  }
+
+  // Accessing a mapped page beyond the end of the file raises SIGBUS. This check only catches a file that was
+  // truncated (e.g. rewritten by another application) before a view is handed out. If the file shrinks while a
+  // view is used, the access still crashes. So files that may change must not be mapped at all.
+  // On windows, the mapping locks the file so that it can not be truncated.
+  bool isTruncated() const
+  {
+#ifdef Q_OS_UNIX
+    struct stat fileStat;
+    if (::fstat(file.handle(), &fileStat) != 0)
+      return true;
+    return int64_t(fileStat.st_size) < size;
+#else
+    return false;
+#endif
+  }
+
+  QFile file;
+  uchar *data {nullptr};
+  int64_t size {0};
+};
+
+#ifdef Q_OS_UNIX
+namespace
+{
+
+// Read nrBytes at startPos from the file descriptor without using (or changing) the file offset.
+// Return how many bytes were read or -1 if an error occurred before anything was read.
+int64_t readAtPosition(int fd, char *target, int64_t startPos, int64_t nrBytes)
+{
+  if (fd < 0)
+    return -1;
+
+  int64_t nrRead = 0;
+  while (nrRead < nrBytes)
+  {
+    const ssize_t ret = ::pread(fd, target + nrRead, size_t(nrBytes - nrRead), off_t(startPos + nrRead));
+    if (ret < 0 && errno == EINTR)
+      continue;
+    if (ret < 0)
+      return (nrRead > 0) ? nrRead : -1;
+    if (ret == 0)
+      // End of file
+      break;
+    nrRead += ret;
+  }
+  return nrRead;
+}
+
+} // namespace
+#endif
+
 fileSource::fileSource()
 {
   fileChanged = false;
@@ -62,14 +146,18 @@ bool fileSource::openFile(const QString &filePath)
   if (!fileInfo.exists() || !fileInfo.isFile())
     return false;
 
-  if (isFileOpened && srcFile.isOpen())
-    srcFile.close();
-
-  // open file for reading
-  srcFile.setFileName(filePath);
-  isFileOpened = srcFile.open(QIODevice::ReadOnly);
-  if (!isFileOpened)
-    return false;
+  {
+    // Other threads may still be reading from the old file
+    QWriteLocker locker(&fileLock);
+    if (isFileOpened && srcFile.isOpen())
+      srcFile.close();
+
+    // open file for reading
+    srcFile.setFileName(filePath);
+    isFileOpened = srcFile.open(QIODevice::ReadOnly);
+    if (!isFileOpened)
+      return false;
+  }
 
   // Save the full file path
   fullFilePath = filePath;
@@ -78,6 +166,13 @@ bool fileSource::openFile(const QString &filePath)
   updateFileWatchSetting();
   fileChanged = false;
 
+  // Drop a mapping of a previously opened file and map the new one (if memory mapping is active)
+  {
+    QWriteLocker locker(&fileLock);
+    fileMapping.clear();
+  }
+  updateMemoryMapSetting();
+
   return true;
 }
 
@@ -109,10 +204,78 @@ int64_t fileSource::readBytes(QByteArray &targetBuffer, int64_t startPos, int64_
   QThread::msleep(50);
 #endif
 
-  // lock the seek and read function
-  QMutexLocker locker(&readMutex);
+#ifdef Q_OS_UNIX
+  QReadLocker locker(&fileLock);
+  return readAtPosition(srcFile.handle(), targetBuffer.data(), startPos, nrBytes);
+#else
+  // seek and read have to be done in one go
+  QWriteLocker locker(&fileLock);
   srcFile.seek(startPos);
   return srcFile.read(targetBuffer.data(), nrBytes);
+#endif
+}
+
+rawDataView fileSource::readBytesView(int64_t startPos, int64_t nrBytes)
+{
+  // A QByteArray can not hold more than INT_MAX bytes
+  if (!isOk() || startPos < 0 || nrBytes <= 0 || nrBytes > INT_MAX)
+    return rawDataView();
+
+  QSharedPointer<fileSourceMapping> mapping;
+  {
+    QReadLocker locker(&fileLock);
+    mapping = fileMapping;
+  }
+
+  if (mapping && mapping->isTruncated())
+  {
+    // Do not use the mapping anymore. Views that were handed out before keep it alive.
+    QWriteLocker locker(&fileLock);
+    if (fileMapping == mapping)
+      fileMapping.clear();
+    mapping.clear();
+  }
+
+  if (mapping)
+  {
+    if (startPos + nrBytes > mapping->size)
+      return rawDataView();
+    return rawDataView((const char*)mapping->data + startPos, int(nrBytes), mapping);
+  }
+
+  QByteArray data;
+  if (readBytes(data, startPos, nrBytes) < nrBytes)
+    return rawDataView();
+  return rawDataView(data);
+}
+
+void fileSource::readAheadHint(int64_t startPos, int64_t nrBytes)
+{
+  if (!isOk() || startPos < 0 || nrBytes <= 0)
+    return;
+
+#ifdef Q_OS_UNIX
+  QReadLocker locker(&fileLock);
+  if (fileMapping)
+  {
+    // The start of the advised range must be aligned to a page
+    if (startPos >= fileMapping->size)
+      return;
+    const int64_t pageSize = sysconf(_SC_PAGESIZE);
+    const int64_t alignedStart = (pageSize > 0) ? startPos - startPos % pageSize : startPos;
+    const int64_t length = std::min(startPos + nrBytes, fileMapping->size) - alignedStart;
+    ::madvise(fileMapping->data + alignedStart, size_t(length), MADV_WILLNEED);
+    return;
+  }
+#if defined(Q_OS_LINUX)
+  ::posix_fadvise(srcFile.handle(), off_t(startPos), off_t(nrBytes), POSIX_FADV_WILLNEED);
+#elif defined(Q_OS_MAC)
+  struct radvisory advisory;
+  advisory.ra_offset = off_t(startPos);
+  advisory.ra_count = int(std::min(nrBytes, int64_t(INT_MAX)));
+  ::fcntl(srcFile.handle(), F_RDADVISE, &advisory);
+#endif
+#endif
 }
 
 QList<infoItem> fileSource::getFileInfoList() const
@@ -315,6 +478,41 @@ void fileSource::updateFileWatchSetting()
     fileWatcher.removePath(fullFilePath);
 }
 
+void fileSource::updateMemoryMapSetting()
+{
+  if (!isFileOpened)
+    return;
+
+  // A file that is watched for changes is expected to change while it is open. Mapped views of such a file are
+  // not safe (see fileSourceMapping::isTruncated). So it is only mapped if file watching is off.
+  QSettings settings;
+  const bool mapFile = settings.value("MemoryMapFiles", false).toBool() && !settings.value("WatchFiles", true).toBool();
+  if (mapFile == isMemoryMapped())
+    return;
+
+  // If mapping fails (e.g. the file does not fit into the address space) we fall back to reading.
+  QSharedPointer<fileSourceMapping> mapping;
+  if (mapFile)
+  {
+    mapping.reset(new fileSourceMapping);
+    if (!mapping->map(fullFilePath))
+      mapping.clear();
+  }
+
+  QWriteLocker locker(&fileLock);
+  fileMapping = mapping;
+}
+
+void fileSource::fileSystemWatcherFileChanged(const QString &path)
+{
+  Q_UNUSED(path);
+  fileChanged = true;
+
+  // The file may have been truncated or rewritten. Read it normally until it is opened again.
+  QWriteLocker locker(&fileLock);
+  fileMapping.clear();
+}
+
 void fileSource::clearFileCache()
 {
   if (!isFileOpened)
@@ -323,7 +521,7 @@ void fileSource::clearFileCache()
 #ifdef Q_OS_WIN
   // We will close the QFile, open it using the FILE_FLAG_NO_BUFFERING flags, close it and reopen the QFile.
   // Suggested: http://stackoverflow.com/questions/478340/clear-file-cache-to-repeat-performance-testing
-  QMutexLocker locker(&readMutex);
+  QWriteLocker locker(&fileLock);
   srcFile.close();
 
   LPCWSTR file = (const wchar_t*) fullFilePath.utf16();
@@ -36,12 +36,15 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QFileSystemWatcher>
-#include <QMutex>
-#include <QMutexLocker>
+#include <QReadWriteLock>
+#include <QSharedPointer>
 #include <QSize>
 #include <QString>
 
 #include "common/fileInfo.h"
+#include "common/rawDataView.h"
+
+class fileSourceMapping;
 
 /* The fileSource class provides functions for accessing files. Besides the reading of
  * certain blocks of the file, it also directly provides information on the file for the
@@ -72,7 +75,7 @@ public:
   virtual bool atEnd() const { return !isFileOpened ? true : srcFile.atEnd(); }
   QByteArray readLine() { return !isFileOpened ? QByteArray() : srcFile.readLine(); }
   virtual bool seek(int64_t pos) { return !isFileOpened ? false : srcFile.seek(pos); }
-  int64_t pos() { return !isFileOpened ? 0 : srcFile.pos(); }
+  virtual int64_t pos() { return !isFileOpened ? 0 : srcFile.pos(); }
 
   // Guess the format (width, height, framerate, packed/planar) from the file name.
   // Certain patterns are recognized. E.g: "something_352x288_24.yuv"
@@ -90,10 +93,24 @@ public:
 
   // Read the given number of bytes starting at startPos into the QByteArray out
   // Resize the QByteArray if necessary. Return how many bytes were read.
+  // This function is thread safe. On unix, the reads of multiple threads are not serialized because
+  // a positional read (pread) is used which does not depend on the position of the srcFile.
   int64_t readBytes(QByteArray &targetBuffer, int64_t startPos, int64_t nrBytes);
 #if SSE_CONVERSION
   void readBytes(byteArrayAligned &data, int64_t startPos, int64_t nrBytes);
 #endif
+  // Get a read-only view of nrBytes starting at startPos. If the file is memory mapped, the view points
+  // directly into the mapping. Nothing is copied and no lock is held while the data is accessed.
+  // Otherwise, the bytes are read into a new buffer. If not all bytes are available, an empty view is returned.
+  // Mapped views are not safe for files that change: If the file is truncated while a view into the mapping is used,
+  // the access raises SIGBUS (unix). On windows, the file can not be changed by other applications while it is mapped.
+  // So memory mapping is off by default and a file is never mapped if it is watched for changes. If a truncated
+  // file is detected before a view is handed out, the mapping is dropped and the file is read normally.
+  rawDataView readBytesView(int64_t startPos, int64_t nrBytes);
+  // Tell the system that the given range of the file will be read soon. This only gives a hint to the operating
+  // system (so that it can start fetching the data into the page cache in the background) and returns immediately.
+  // Currently only supported on unix.
+  void readAheadHint(int64_t startPos, int64_t nrBytes);
 
   QString getAbsoluteFilePath() const { return fileInfo.absoluteFilePath(); }
 
@@ -104,12 +121,15 @@ public:
   bool isFileChanged() { bool b = fileChanged; fileChanged = false; return b; }
   // Check if we are supposed to watch the file for changes. If no, remove the file watcher. If yes, install one.
   void updateFileWatchSetting();
+  // Check if we are supposed to memory map the file (only if it is not watched for changes). Map or unmap it accordingly.
+  void updateMemoryMapSetting();
+  bool isMemoryMapped() const { return !fileMapping.isNull(); }
 
   // Clear the cache of the file in the system. Currently only windows supported.
   void clearFileCache();
 
 private slots:
-  void fileSystemWatcherFileChanged(const QString &path) { Q_UNUSED(path); fileChanged = true; }
+  void fileSystemWatcherFileChanged(const QString &path);
 
 protected:
   // Info on the source file.
@@ -125,8 +145,14 @@ private:
   QFileSystemWatcher fileWatcher;
   bool fileChanged;
 
-  // protect the read function with a mutex
-  QMutex readMutex;
+  // Reads that do not use the position of srcFile (pread, the mapping) only need a read lock. This
+  // makes sure that the file is not closed/reopened while they run. Everything that uses the position
+  // of srcFile or reopens the file needs the write lock.
+  QReadWriteLock fileLock;
+
+  // The memory mapping of the file (if enabled). Views returned by readBytesView share the ownership
+  // so that the mapping stays valid until the last view is gone (even if the file is reopened).
+  QSharedPointer<fileSourceMapping> fileMapping;
 };
 
 #endif
@@ -32,6 +32,13 @@
 
 #include "fileSourceAnnexBFile.h"
 
+#include <algorithm>
+#include <cstring>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+
 #define ANNEXBFILE_DEBUG_OUTPUT 0
 #if ANNEXBFILE_DEBUG_OUTPUT && !NDEBUG
 #include <QDebug>
@@ -40,6 +47,90 @@
 #define DEBUG_ANNEXBFILE(fmt,...) ((void)0)
 #endif
 
+/* This thread reads the file buffer by buffer (starting at a given position) and finds all start codes in each buffer.
+ * The buffers are put into a bounded queue from which fileSourceAnnexBFile::updateBuffer takes them.
+ * The file is opened again so that the reading does not interfere with the srcFile of the fileSourceAnnexBFile.
+*/
+class fileSourceAnnexBReader : public QThread
+{
+public:
+  struct readBuffer
+  {
+    QByteArray data;
+    QVector<int> startCodes;
+  };
+
+  fileSourceAnnexBReader(const QString &filePath, int64_t startPos)
+  {
+    file.setFileName(filePath);
+    if (file.open(QIODevice::ReadOnly))
+      file.seek(startPos);
+  }
+
+  ~fileSourceAnnexBReader()
+  {
+    {
+      QMutexLocker lock(&mutex);
+      abort = true;
+      queueNotFull.wakeAll();
+    }
+    wait();
+  }
+
+  // Get the next buffer. This blocks until the buffer was read. After the end of the file, an empty buffer is returned.
+  readBuffer takeBuffer()
+  {
+    QMutexLocker lock(&mutex);
+    while (queue.isEmpty() && !finished)
+      queueNotEmpty.wait(&mutex);
+    if (queue.isEmpty())
+      return {};
+    readBuffer buffer = queue.dequeue();
+    queueNotFull.wakeAll();
+    return buffer;
+  }
+
+protected:
+  void run() Q_DECL_OVERRIDE
+  {
+    bool endOfFile = false;
+    while (!endOfFile)
+    {
+      readBuffer buffer;
+      buffer.data.resize(BUFFER_SIZE);
+      const qint64 nrBytes = file.isOpen() ? file.read(buffer.data.data(), BUFFER_SIZE) : 0;
+      buffer.data.resize(nrBytes > 0 ? int(nrBytes) : 0);
+      endOfFile = (buffer.data.size() < BUFFER_SIZE);
+
+      const char *data = buffer.data.constData();
+      int pos = fileSourceAnnexBFile::findStartCode(data, 0, buffer.data.size());
+      while (pos >= 0)
+      {
+        buffer.startCodes.append(pos);
+        pos = fileSourceAnnexBFile::findStartCode(data, pos + 1, buffer.data.size());
+      }
+
+      QMutexLocker lock(&mutex);
+      while (queue.size() >= BACKGROUND_READ_AHEAD_BUFFERS && !abort)
+        queueNotFull.wait(&mutex);
+      if (abort)
+        return;
+      queue.enqueue(buffer);
+      finished = endOfFile;
+      queueNotEmpty.wakeAll();
+    }
+  }
+
+private:
+  QFile file;
+  QMutex mutex;
+  QWaitCondition queueNotFull;
+  QWaitCondition queueNotEmpty;
+  QQueue<readBuffer> queue;
+  bool abort {false};
+  bool finished {false};
+};
+
 fileSourceAnnexBFile::fileSourceAnnexBFile()
 {
   fileBuffer.resize(BUFFER_SIZE);
@@ -50,16 +141,74 @@ fileSourceAnnexBFile::fileSourceAnnexBFile()
   startCode.append((char)1);
 }
 
+fileSourceAnnexBFile::~fileSourceAnnexBFile()
+{
+}
+
+int fileSourceAnnexBFile::findStartCode(const char *data, int start, int end)
+{
+  // Search for the 1 byte using memchr (which is vectorized in all common C libraries) and then check if
+  // the two bytes before it are 0. This is much faster than comparing the whole pattern at every position.
+  int pos = start + 2;
+  while (pos < end)
+  {
+    const char *one = (const char*)memchr(data + pos, 1, size_t(end - pos));
+    if (one == nullptr)
+      return -1;
+    const int onePos = int(one - data);
+    if (data[onePos - 1] == (char)0 && data[onePos - 2] == (char)0)
+      return onePos - 2;
+    pos = onePos + 1;
+  }
+  return -1;
+}
+
+int fileSourceAnnexBFile::findNextStartCodeInBuffer(int start) const
+{
+  if (bufferStartCodesValid)
+  {
+    auto it = std::lower_bound(bufferStartCodes.constBegin(), bufferStartCodes.constEnd(), start);
+    return (it == bufferStartCodes.constEnd()) ? -1 : *it;
+  }
+  return findStartCode(fileBuffer.constData(), start, int(fileBufferSize));
+}
+
+void fileSourceAnnexBFile::startBackgroundReading()
+{
+  if (!isFileOpened || backgroundReader || fileBufferSize < BUFFER_SIZE)
+    // Already running or there is nothing more to read
+    return;
+
+  DEBUG_ANNEXBFILE("fileSourceAnnexBFile::startBackgroundReading at %d", bufferStartPosInFile + fileBufferSize);
+  backgroundReader.reset(new fileSourceAnnexBReader(fileInfo.absoluteFilePath(), bufferStartPosInFile + fileBufferSize));
+  backgroundReader->start();
+}
+
+void fileSourceAnnexBFile::stopBackgroundReading()
+{
+  if (!backgroundReader)
+    return;
+
+  backgroundReader.reset();
+  // The buffers from the reader have their own size. Restore our own buffer.
+  fileBuffer.resize(BUFFER_SIZE);
+  bufferStartCodesValid = false;
+}
+
 // Open the file and fill the read buffer. 
 bool fileSourceAnnexBFile::openFile(const QString &fileName)
 {
   DEBUG_ANNEXBFILE("fileSourceAnnexBFile::openFile fileName %s", fileName);
+  stopBackgroundReading();
 
   // Open the input file (again)
   fileSource::openFile(fileName);
 
   // Fill the buffer
-  fileBufferSize = srcFile.read(fileBuffer.data(), BUFFER_SIZE);
+  bufferStartPosInFile = 0;
+  posInBuffer = 0;
+  startCodeBytesInLastBuffer = 0;
+  readBufferAt(0);
   if (fileBufferSize == 0)
     // The file is empty of there was an error reading from the file.
     return false;
@@ -71,7 +220,7 @@ bool fileSourceAnnexBFile::openFile(const QString &fileName)
 
 void fileSourceAnnexBFile::seekToFirstNAL()
 {
-  int nextStartCodePos = fileBuffer.indexOf(startCode, posInBuffer);
+  int nextStartCodePos = findNextStartCodeInBuffer(posInBuffer);
   if (nextStartCodePos == -1)
     // The first buffer does not contain a start code. This is very unusual. Use the normal getNextNALUnit to seek
     getNextNALUnit();
@@ -92,16 +241,21 @@ QByteArray fileSourceAnnexBFile::getNextNALUnit(bool getLastDataAgain, QUint64Pa
 
   lastReturnArray.clear();
 
+  // The first bytes of the start code may have been at the end of the last buffer
+  if (startCodeBytesInLastBuffer > 0)
+    lastReturnArray.fill((char)0, startCodeBytesInLastBuffer);
   if (startEndPosInFile)
-    startEndPosInFile->first = bufferStartPosInFile + posInBuffer;
+    startEndPosInFile->first = bufferStartPosInFile + posInBuffer - startCodeBytesInLastBuffer;
+  startCodeBytesInLastBuffer = 0;
 
   int nextStartCodePos = -1;
+  int searchStart = posInBuffer + 3;
   bool startCodeFound = false;
   while (!startCodeFound)
   {
-    nextStartCodePos = fileBuffer.indexOf(startCode, posInBuffer + 3);
+    nextStartCodePos = findNextStartCodeInBuffer(searchStart);
 
-    if (nextStartCodePos < 0 || (uint64_t)nextStartCodePos > fileBufferSize)
+    if (nextStartCodePos < 0)
     {
       // No start code found ... append all data in the current buffer.
       lastReturnArray += fileBuffer.mid(posInBuffer, fileBufferSize - posInBuffer);
@@ -123,6 +277,8 @@ QByteArray fileSourceAnnexBFile::getNextNALUnit(bool getLastDataAgain, QUint64Pa
 
       // We have to continue searching - get the next buffer
       updateBuffer();
+      // A start code at position 0 is found by the boundary checks. Continue the search after that.
+      searchStart = 1;
       
       if (fileBufferSize > 2)
       {
@@ -159,7 +315,16 @@ QByteArray fileSourceAnnexBFile::getNextNALUnit(bool getLastDataAgain, QUint64Pa
   // Position found
   if (startEndPosInFile)
     startEndPosInFile->second = bufferStartPosInFile + nextStartCodePos;
-  lastReturnArray += fileBuffer.mid(posInBuffer, nextStartCodePos - posInBuffer);
+  if (nextStartCodePos < 0)
+  {
+    // The first bytes of the start code are at the end of the last buffer. They were already added
+    // but belong to the next NAL unit.
+    lastReturnArray.chop(-nextStartCodePos);
+    startCodeBytesInLastBuffer = -nextStartCodePos;
+    nextStartCodePos = 0;
+  }
+  else
+    lastReturnArray += fileBuffer.mid(posInBuffer, nextStartCodePos - posInBuffer);
   DEBUG_ANNEXBFILE("fileSourceHEVCAnnexBFile::getNextNALUnit start code found - ret size %d", lastReturnArray.size());
   posInBuffer = nextStartCodePos;
   return lastReturnArray;
@@ -202,12 +367,33 @@ QByteArray fileSourceAnnexBFile::getFrameData(QUint64Pair startEndFilePos)
   return retArray;
 }
 
+void fileSourceAnnexBFile::readBufferAt(uint64_t pos)
+{
+  // readBytes uses a positional read (pread) where available. So the position of srcFile is not used and other
+  // threads (e.g. a caching thread) that read from this file source can not change the position in between.
+  const int64_t nrBytes = readBytes(fileBuffer, int64_t(pos), BUFFER_SIZE);
+  fileBufferSize = (nrBytes > 0) ? uint64_t(nrBytes) : 0;
+}
+
 bool fileSourceAnnexBFile::updateBuffer()
 {
   // Save the position of the first byte in this new buffer
   bufferStartPosInFile += fileBufferSize;
 
-  fileBufferSize = srcFile.read(fileBuffer.data(), BUFFER_SIZE);
+  if (backgroundReader)
+  {
+    // Take the next buffer (and the start code positions in it) from the background reader
+    fileSourceAnnexBReader::readBuffer buffer = backgroundReader->takeBuffer();
+    fileBuffer = buffer.data;
+    fileBufferSize = buffer.data.size();
+    bufferStartCodes = buffer.startCodes;
+    bufferStartCodesValid = true;
+  }
+  else
+  {
+    readBufferAt(bufferStartPosInFile);
+    bufferStartCodesValid = false;
+  }
   posInBuffer = 0;
 
   DEBUG_ANNEXBFILE("fileSourceHEVCAnnexBFile::updateBuffer fileBufferSize %d", fileBufferSize);
@@ -220,9 +406,12 @@ bool fileSourceAnnexBFile::seek(int64_t pos)
     return false;
 
   DEBUG_ANNEXBFILE("fileSourceHEVCAnnexBFile::seek ot %d", pos);
-  // Seek the file and update the buffer
-  srcFile.seek(pos);
-  fileBufferSize = srcFile.read(fileBuffer.data(), BUFFER_SIZE);
+  stopBackgroundReading();
+  bufferStartCodesValid = false;
+  startCodeBytesInLastBuffer = 0;
+
+  // Update the buffer
+  readBufferAt(pos);
   if (fileBufferSize == 0)
     // The file is empty of there was an error reading from the file.
     return false;
@@ -33,6 +33,9 @@
 #ifndef FILESOURCEANNEXBFILE_H
 #define FILESOURCEANNEXBFILE_H
 
+#include <QScopedPointer>
+#include <QVector>
+
 #include "fileSource.h"
 #include "video/videoHandlerYUV.h"
 
@@ -40,10 +43,15 @@ using namespace YUV_Internals;
 
 // Internally, we use a buffer which we only update if necessary
 #define BUFFER_SIZE 500000
+// When reading in the background, up to this many buffers are read ahead
+#define BACKGROUND_READ_AHEAD_BUFFERS 32
+
+class fileSourceAnnexBReader;
 
 /* This class is a normal fileSource for opening of raw AnnexBFiles.
  * Basically it understands that this is a binary file where each unit starts with a start code (0x0000001)
- * TODO: The reading / parsing could be performed in a background thread in order to increase the performance
+ * For reading the whole file linearly (parsing), the reading and the search for start codes can be performed
+ * in a background thread (startBackgroundReading).
 */
 class fileSourceAnnexBFile : public fileSource
 {
@@ -52,13 +60,15 @@ class fileSourceAnnexBFile : public fileSource
 public:
   fileSourceAnnexBFile();
   fileSourceAnnexBFile(const QString &filePath) : fileSourceAnnexBFile() { openFile(filePath); }
-  ~fileSourceAnnexBFile() {};
+  ~fileSourceAnnexBFile();
 
   // Open the given file. If another file is given, 
   bool openFile(const QString &filePath) Q_DECL_OVERRIDE;
 
   // Is the file at the end?
   bool atEnd() const Q_DECL_OVERRIDE { return fileBufferSize < BUFFER_SIZE && posInBuffer >= fileBufferSize; }
+  // The position of the next NAL unit in the file. The position of the srcFile is not used for reading.
+  int64_t pos() Q_DECL_OVERRIDE { return int64_t(bufferStartPosInFile + posInBuffer); }
 
   // --- Retrieving of data from the file ---
   // You can either read a file NAL by NAL or frame by frame. Do not mix the two interfaces.
@@ -74,8 +84,18 @@ public:
   QByteArray getFrameData(QUint64Pair startEndFilePos);
   
   // Seek the file to the given byte position. Update the buffer.
+  // This stops reading in the background.
   bool seek(int64_t pos) Q_DECL_OVERRIDE;
 
+  // Start a thread that reads the following buffers of the file ahead and finds the start codes in them.
+  // This is useful if the whole file is read NAL by NAL. The thread is stopped when seeking or when
+  // stopBackgroundReading is called. Stop it when done reading so that the thread and its buffers are released.
+  void startBackgroundReading();
+  void stopBackgroundReading();
+
+  // Find the next start code (0x000001) in data between start and end. Return the position of the first 0 byte or -1.
+  static int findStartCode(const char *data, int start, int end);
+
 protected:
 
   QByteArray   fileBuffer;
@@ -85,12 +105,23 @@ protected:
   // The current position in the input buffer in bytes. This always points to the first byte of a start code.
   // So if the start code is 0001 it will point to the first byte (the first 0). If the start code is 001, it will point to the first 0 here.
   unsigned int posInBuffer {0};
+  // If a start code spans two buffers, this is the number of its bytes at the end of the last buffer
+  int startCodeBytesInLastBuffer {0};
 
   // The start code pattern
   QByteArray startCode;
 
+  // If the buffer was read in the background, the positions of all start codes in the buffer are already known.
+  QVector<int> bufferStartCodes;
+  bool bufferStartCodesValid {false};
+  int findNextStartCodeInBuffer(int start) const;
+
+  QScopedPointer<fileSourceAnnexBReader> backgroundReader;
+
   // load the next buffer
   bool updateBuffer();
+  // Read the buffer starting at the given position in the file (using readBytes) and set fileBufferSize
+  void readBufferAt(uint64_t pos);
 
   // Seek to the first NAL header in the bitstream
   void seekToFirstNAL();
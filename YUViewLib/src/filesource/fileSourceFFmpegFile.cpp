@@ -32,9 +32,11 @@
 
 #include "fileSourceFFmpegFile.h"
 
+#include <algorithm>
 #include <QSettings>
 #include <QProgressDialog>
 
+#include "filesource/bitstreamIndex.h"
 #include "parser/parserCommon.h"
 
 #define FILESOURCEFFMPEGFILE_DEBUG_OUTPUT 0
@@ -157,12 +159,11 @@ QByteArray fileSourceFFmpegFile::getNextUnit(bool getLastDataAgain, uint64_t *pt
 
     try
     {
-      QString bitsRead;
-      bool obu_forbidden_bit = (reader.readBits(1, bitsRead) != 0);
-      reader.readBits(4, bitsRead); // obu_type
-      bool obu_extension_flag = (reader.readBits(1, bitsRead) != 0);
-      bool obu_has_size_field = (reader.readBits(1, bitsRead) != 0);
-      bool obu_reserved_1bit = (reader.readBits(1, bitsRead) != 0);
+      bool obu_forbidden_bit = (reader.readBits(1) != 0);
+      reader.readBits(4); // obu_type
+      bool obu_extension_flag = (reader.readBits(1) != 0);
+      bool obu_has_size_field = (reader.readBits(1) != 0);
+      bool obu_reserved_1bit = (reader.readBits(1) != 0);
 
       if (obu_forbidden_bit || obu_reserved_1bit)
       {
@@ -171,9 +172,9 @@ QByteArray fileSourceFFmpegFile::getNextUnit(bool getLastDataAgain, uint64_t *pt
       }
       if (obu_extension_flag)
       {
-        reader.readBits(3, bitsRead); // temporal_id
-        reader.readBits(2, bitsRead); // spatial_id
-        unsigned int extension_header_reserved_3bits = reader.readBits(3, bitsRead);
+        reader.readBits(3); // temporal_id
+        reader.readBits(2); // spatial_id
+        unsigned int extension_header_reserved_3bits = reader.readBits(3);
         if (extension_header_reserved_3bits != 0)
         {
           currentPacketData.clear();
@@ -183,7 +184,7 @@ QByteArray fileSourceFFmpegFile::getNextUnit(bool getLastDataAgain, uint64_t *pt
       if (obu_has_size_field)
       {
         int bitCount;
-        unsigned int obu_size = reader.readLeb128(bitsRead, bitCount);
+        unsigned int obu_size = reader.readLeb128(bitCount);
         unsigned int completeSize = obu_size + reader.nrBytesRead();
         lastReturnArray = currentPacketData.mid(posInData, completeSize);
         posInData += completeSize;
@@ -357,8 +358,12 @@ bool fileSourceFFmpegFile::openFile(const QString &filePath, QWidget *mainWindow
   }
   else if (parseFile)
   {
-    if (!scanBitstream(mainWindow))
-      return false;
+    if (!loadIndex())
+    {
+      if (!scanBitstream(mainWindow))
+        return false;
+      saveIndex();
+    }
     
     seekFileToBeginning();
   }
@@ -402,6 +407,17 @@ int fileSourceFFmpegFile::getClosestSeekableDTSBefore(int frameIdx, int &seekToF
   return bestSeekDTS;
 }
 
+QList<int> fileSourceFFmpegFile::getKeyFrames() const
+{
+  QList<int> frames;
+  for (pictureIdx idx : keyFrameList)
+    if (idx.frame >= 0)
+      frames.append(int(idx.frame));
+  std::sort(frames.begin(), frames.end());
+  frames.erase(std::unique(frames.begin(), frames.end()), frames.end());
+  return frames;
+}
+
 bool fileSourceFFmpegFile::scanBitstream(QWidget *mainWindow)
 {
   if (!isFileOpened)
@@ -449,6 +465,46 @@ bool fileSourceFFmpegFile::scanBitstream(QWidget *mainWindow)
   return !progress->wasCanceled();
 }
 
+bool fileSourceFFmpegFile::loadIndex()
+{
+  bitstreamIndex index(fileInfo, "fileSourceFFmpegFile");
+  if (!index.open())
+    return false;
+
+  QDataStream &in = index.readStream();
+  qint32 indexNrFrames, nrKeyFrames;
+  in >> indexNrFrames >> nrKeyFrames;
+  if (in.status() != QDataStream::Ok || nrKeyFrames <= 0)
+    return false;
+  QList<pictureIdx> indexKeyFrameList;
+  for (int i = 0; i < nrKeyFrames && in.status() == QDataStream::Ok; i++)
+  {
+    qint64 frame, dts;
+    in >> frame >> dts;
+    indexKeyFrameList.append(pictureIdx(frame, dts));
+  }
+  if (in.status() != QDataStream::Ok)
+    return false;
+
+  DEBUG_FFMPEG("fileSourceFFmpegFile::loadIndex: Read %d frames and %d keyframes from the index.", indexNrFrames, indexKeyFrameList.length());
+  nrFrames = indexNrFrames;
+  keyFrameList = indexKeyFrameList;
+  return true;
+}
+
+void fileSourceFFmpegFile::saveIndex()
+{
+  if (keyFrameList.isEmpty())
+    return;
+
+  bitstreamIndex index(fileInfo, "fileSourceFFmpegFile");
+  QDataStream &out = index.writeStream();
+  out << qint32(nrFrames) << qint32(keyFrameList.size());
+  for (const pictureIdx &idx : keyFrameList)
+    out << qint64(idx.frame) << qint64(idx.dts);
+  index.save();
+}
+
 void fileSourceFFmpegFile::openFileAndFindVideoStream(QString fileName)
 {
   isFileOpened = false;
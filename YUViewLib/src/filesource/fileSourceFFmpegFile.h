@@ -104,6 +104,8 @@ public:
   // Look through the keyframes and find the closest one before (or equal)
   // the given frameIdx where we can start decoding
   int getClosestSeekableDTSBefore(int frameIdx, int &seekToFrameIdx) const;
+  // Get the frame indices of all keyframes (sorted)
+  QList<int> getKeyFrames() const;
 
   QStringList getFFmpegLoadingLog() const { return ff.getLog(); }
   
@@ -159,6 +161,9 @@ protected:
   // If a mainWindow pointer is given, open a progress dialog. Return true on success. False if the process was canceled.
   bool scanBitstream(QWidget *mainWindow);
   int nrFrames {0};
+  // The result of scanBitstream is saved in a bitstream index. If a valid index exists, scanning is not necessary.
+  bool loadIndex();
+  void saveIndex();
 
   // Private struct for navigation. We index frames by frame number and FFMpeg uses the pts.
   // This connects both values.
@@ -32,9 +32,13 @@
 
 #include "parserAnnexB.h"
 
+#include <algorithm>
 #include <assert.h>
 #include <QProgressDialog>
 #include <QElapsedTimer>
+#include <QSet>
+
+#include "filesource/bitstreamIndex.h"
 
 #define PARSERANNEXB_DEBUG_OUTPUT 0
 #if PARSERANNEXB_DEBUG_OUTPUT && !NDEBUG
@@ -110,6 +114,23 @@ int parserAnnexB::getClosestSeekableFrameNumberBefore(int frameIdx, int &codingO
   return POCList.indexOf(bestSeekPOC);
 }
 
+QList<int> parserAnnexB::getRandomAccessFrames() const
+{
+  // Get the frame index for every POC once instead of searching the POC list for every random access point
+  QHash<int, int> frameIdxForPOC;
+  for (int i = 0; i < POCList.size(); i++)
+    if (!frameIdxForPOC.contains(POCList[i]))
+      frameIdxForPOC.insert(POCList[i], i);
+
+  QList<int> frames;
+  for (const annexBFrame &f : frameList)
+    if (f.randomAccessPoint && frameIdxForPOC.contains(f.poc))
+      frames.append(frameIdxForPOC.value(f.poc));
+  std::sort(frames.begin(), frames.end());
+  frames.erase(std::unique(frames.begin(), frames.end()), frames.end());
+  return frames;
+}
+
 QUint64Pair parserAnnexB::getFrameStartEndPos(int codingOrderFrameIdx)
 {
   if (codingOrderFrameIdx < 0 || codingOrderFrameIdx >= frameList.size())
@@ -137,9 +158,24 @@ bool parserAnnexB::parseAnnexBFile(QScopedPointer<fileSourceAnnexBFile> &file, Q
   }
 
   stream_info.file_size = file->getFileSize();
+
+  // The index does not contain the details of all NAL units. So it can only be used if they are not shown.
+  const bool useIndex = packetModel->isNull();
+  if (useIndex && loadIndex(file->getFileInfo()))
+  {
+    DEBUG_ANNEXB("parserAnnexB::parseAnnexBFile Read %d POCs from index.", POCList.length());
+    stream_info.nr_frames = frameList.size();
+    emit streamInfoUpdated();
+    emit backgroundParsingDone("");
+    return true;
+  }
+
   stream_info.parsing = true;
   emit streamInfoUpdated();
 
+  // The file is read linearly. Reading and finding the start codes can be done in the background.
+  file->startBackgroundReading();
+
   // Just push all NAL units from the annexBFile into the annexBParser
   QByteArray nalData;
   int nalID = 0;
@@ -154,6 +190,7 @@ bool parserAnnexB::parseAnnexBFile(QScopedPointer<fileSourceAnnexBFile> &file, Q
     if (stream_info.file_size > 0)
       progressPercentValue = clip((int)(pos * 100 / stream_info.file_size), 0, 100);
 
+    const int nrPacketRecords = packetModel->isPacketMode() ? packetModel->getNumberPacketRecords() : 0;
     try
     {
       nalData = file->getNextNALUnit(false, &nalStartEndPosFile);
@@ -174,13 +211,27 @@ bool parserAnnexB::parseAnnexBFile(QScopedPointer<fileSourceAnnexBFile> &file, Q
       DEBUG_ANNEXB("parserAnnexB::parseAndAddNALUnit Exception thrown parsing NAL %d", nalID);
     }
 
+    if (packetModel->isPacketMode() && packetModel->getNumberPacketRecords() == nrPacketRecords)
+    {
+      // Parsing failed before the NAL unit was named. Still add it so that it can be inspected.
+      parserCommon::PacketItemModel::packetRecord record;
+      record.name = QString("NAL %1: Error").arg(nalID);
+      record.fileStartEndPos = nalStartEndPosFile;
+      record.packetID = nalID;
+      record.error = true;
+      packetModel->addPacketRecord(record);
+    }
+
     nalID++;
 
     if (progressDialog)
     {
       // Updating the dialog (setValue) is quite slow. Only do this if the percent value changes.
       if (progressDialog->wasCanceled())
+      {
+        file->stopBackgroundReading();
         return false;
+      }
 
       int newPercentValue = 0;
       if (maxPos > 0)
@@ -210,7 +261,8 @@ bool parserAnnexB::parseAnnexBFile(QScopedPointer<fileSourceAnnexBFile> &file, Q
     }
   }
 
-  // We are done.
+  // We are done. Stop the reader thread (if the file was not read to the end) and release its buffers.
+  file->stopBackgroundReading();
   parseAndAddNALUnit(-1, QByteArray(), this->bitrateItemModel.data());
   DEBUG_ANNEXB("parserAnnexB::parseAndAddNALUnit Parsing done. Found %d POCs.", POCList.length());
 
@@ -223,16 +275,277 @@ bool parserAnnexB::parseAnnexBFile(QScopedPointer<fileSourceAnnexBFile> &file, Q
   emit streamInfoUpdated();
   emit backgroundParsingDone("");
 
+  if (useIndex && !cancelBackgroundParser)
+    saveIndex(file->getFileInfo());
+
   return !cancelBackgroundParser;
 }
 
+void parserAnnexB::saveIndex(const QFileInfo &bitstreamFile)
+{
+  bitstreamIndex index(bitstreamFile, getIndexType());
+  QDataStream &out = index.writeStream();
+
+  out << qint32(pocOfFirstRandomAccessFrame) << qint32(stream_info.nr_nal_units);
+
+  // The parameter sets are parsed again when reading the index
+  QList<QSharedPointer<nal_unit>> parameterSets;
+  for (auto nal : nalUnitList)
+    if (nal->isParameterSet())
+      parameterSets.append(nal);
+  out << qint32(parameterSets.size());
+  for (auto nal : parameterSets)
+    out << qint32(nal->nal_idx) << quint64(nal->filePosStartEnd.first) << quint64(nal->filePosStartEnd.second) << nal->getRawNALData();
+
+  out << qint32(frameList.size());
+  for (const annexBFrame &f : frameList)
+    out << qint32(f.poc) << quint64(f.fileStartEndPos.first) << quint64(f.fileStartEndPos.second) << f.randomAccessPoint;
+  out << POCList;
+
+  // Get the seek information for every random access point (in one pass over the NAL units). Parameter sets which
+  // are active at multiple random access points are only saved once.
+  QSet<int> pocsInList;
+  for (int poc : POCList)
+    pocsInList.insert(poc);
+  QSet<int> randomAccessPOCs;
+  for (const annexBFrame &f : frameList)
+    if (f.randomAccessPoint && pocsInList.contains(f.poc))
+      randomAccessPOCs.insert(f.poc);
+  const QMap<int, seekFrameParameterSets> seekFrames = getSeekFrameParameterSetsForPOCs(randomAccessPOCs);
+
+  QHash<QByteArray, int> parameterSetIdx;
+  QList<QByteArray> uniqueParameterSets;
+  QList<QPair<int, indexSeekPoint>> seekPoints;
+  for (const annexBFrame &f : frameList)
+  {
+    if (!randomAccessPOCs.contains(f.poc))
+      continue;
+    const seekFrameParameterSets seekFrame = seekFrames.value(f.poc, seekFrameParameterSets{0, {}});
+    indexSeekPoint seekPoint;
+    seekPoint.filePos = seekFrame.filePos;
+    for (const QByteArray &p : seekFrame.parameterSets)
+    {
+      if (!parameterSetIdx.contains(p))
+      {
+        parameterSetIdx.insert(p, uniqueParameterSets.size());
+        uniqueParameterSets.append(p);
+      }
+      seekPoint.parameterSetIdx.append(parameterSetIdx[p]);
+    }
+    seekPoints.append(qMakePair(f.poc, seekPoint));
+  }
+  out << uniqueParameterSets;
+  out << qint32(seekPoints.size());
+  for (const auto &s : seekPoints)
+    out << qint32(s.first) << quint64(s.second.filePos) << s.second.parameterSetIdx;
+
+  if (!index.save())
+    DEBUG_ANNEXB("parserAnnexB::saveIndex Saving the index failed");
+}
+
+bool parserAnnexB::loadIndex(const QFileInfo &bitstreamFile)
+{
+  bitstreamIndex index(bitstreamFile, getIndexType());
+  if (!index.open())
+    return false;
+  QDataStream &in = index.readStream();
+
+  qint32 firstRandomAccessPOC, nrNalUnits, nrParameterSets;
+  in >> firstRandomAccessPOC >> nrNalUnits >> nrParameterSets;
+  if (in.status() != QDataStream::Ok || nrParameterSets < 0)
+    return false;
+  struct parameterSetNAL
+  {
+    qint32 nalIdx;
+    quint64 start, end;
+    QByteArray data;
+  };
+  QList<parameterSetNAL> parameterSets;
+  for (int i = 0; i < nrParameterSets && in.status() == QDataStream::Ok; i++)
+  {
+    parameterSetNAL p;
+    in >> p.nalIdx >> p.start >> p.end >> p.data;
+    parameterSets.append(p);
+  }
+
+  qint32 nrFrames;
+  in >> nrFrames;
+  if (in.status() != QDataStream::Ok || nrFrames < 0)
+    return false;
+  QList<annexBFrame> frames;
+  frames.reserve(nrFrames);
+  for (int i = 0; i < nrFrames && in.status() == QDataStream::Ok; i++)
+  {
+    qint32 poc;
+    quint64 start, end;
+    bool randomAccessPoint;
+    in >> poc >> start >> end >> randomAccessPoint;
+    annexBFrame f;
+    f.poc = poc;
+    f.fileStartEndPos = QUint64Pair(start, end);
+    f.randomAccessPoint = randomAccessPoint;
+    frames.append(f);
+  }
+  QList<int> pocs;
+  QList<QByteArray> uniqueParameterSets;
+  qint32 nrSeekPoints;
+  in >> pocs >> uniqueParameterSets >> nrSeekPoints;
+  if (in.status() != QDataStream::Ok || nrSeekPoints < 0)
+    return false;
+  QMap<int, indexSeekPoint> seekPoints;
+  for (int i = 0; i < nrSeekPoints && in.status() == QDataStream::Ok; i++)
+  {
+    qint32 poc;
+    quint64 filePos;
+    indexSeekPoint s;
+    in >> poc >> filePos >> s.parameterSetIdx;
+    s.filePos = filePos;
+    for (int idx : s.parameterSetIdx)
+      if (idx < 0 || idx >= uniqueParameterSets.size())
+        return false;
+    seekPoints.insert(poc, s);
+  }
+  if (in.status() != QDataStream::Ok || pocs.size() != frames.size())
+    return false;
+
+  // Parse the parameter sets again. This restores everything that is derived from them (frame size, format, extradata ...).
+  parserCommon::BitrateItemModel bitrateModel;
+  for (const parameterSetNAL &p : parameterSets)
+    parseAndAddNALUnit(p.nalIdx, p.data, &bitrateModel, nullptr, QUint64Pair(p.start, p.end));
+
+  frameList = frames;
+  POCList = pocs;
+  pocOfFirstRandomAccessFrame = firstRandomAccessPOC;
+  indexParameterSets = uniqueParameterSets;
+  indexSeekPoints = seekPoints;
+  stream_info.nr_nal_units = nrNalUnits;
+  return true;
+}
+
+bool parserAnnexB::getSeekFrameParamerSetsFromIndex(int iFrameNr, uint64_t &filePos, QList<QByteArray> &paramSets) const
+{
+  if (indexSeekPoints.isEmpty() || iFrameNr < 0 || iFrameNr >= POCList.size())
+    return false;
+  auto it = indexSeekPoints.find(POCList[iFrameNr]);
+  if (it == indexSeekPoints.end())
+    return false;
+
+  filePos = it->filePos;
+  paramSets.clear();
+  for (int idx : it->parameterSetIdx)
+    paramSets.append(indexParameterSets[idx]);
+  return true;
+}
+
 bool parserAnnexB::runParsingOfFile(QString compressedFilePath)
 {
   DEBUG_ANNEXB("playlistItemCompressedVideo::runParsingOfFile");
+  if (!packetModel->isNull())
+  {
+    // Only a compact record is kept for each NAL unit. So there is no need to limit the number of parsed frames.
+    bitstreamFilePath = compressedFilePath;
+    parsingLimitEnabled = false;
+    packetModel->enablePacketMode([this](int row) { return parseNALUnitTree(row); });
+  }
   QScopedPointer<fileSourceAnnexBFile> file(new fileSourceAnnexBFile(compressedFilePath));
   return parseAnnexBFile(file);
 }
 
+void parserAnnexB::setNALUnitName(parserCommon::TreeItem *nalRoot, const nal_unit &nal, const QString &name, bool isRandomAccess, bool error, int parameterSetID)
+{
+  if (nalRoot)
+  {
+    nalRoot->itemData.append(name);
+    if (error)
+      nalRoot->setError();
+  }
+  else if (packetModel->isPacketMode())
+  {
+    parserCommon::PacketItemModel::packetRecord record;
+    record.name = name;
+    record.fileStartEndPos = nal.filePosStartEnd;
+    record.packetID = nal.nal_idx;
+    record.isParameterSet = nal.isParameterSet();
+    if (record.isParameterSet)
+      record.parameterSetKey = QString("%1 %2").arg(nal.nal_unit_type_id).arg(parameterSetID);
+    record.isRandomAccess = isRandomAccess;
+    record.error = error;
+    packetModel->addPacketRecord(record);
+  }
+}
+
+parserCommon::TreeItem *parserAnnexB::parseNALUnitTree(int row) const
+{
+  if (row < 0 || row >= packetModel->getNumberPacketRecords())
+    return nullptr;
+
+  fileSource file;
+  if (!file.openFile(bitstreamFilePath))
+    return nullptr;
+
+  // The slices need the parameter sets and (for the POC) the NAL units since the last random access point
+  int replayStart = row;
+  for (int i = row - 1; i >= 0; i--)
+    if (packetModel->getPacketRecord(i).isRandomAccess)
+    {
+      replayStart = i;
+      break;
+    }
+  // Before the random access point, only the latest parameter set of each type and ID is needed
+  QList<parserCommon::PacketItemModel::packetRecord> replayRecords;
+  QSet<QString> parameterSetKeys;
+  for (int i = replayStart - 1; i >= 0; i--)
+  {
+    const auto record = packetModel->getPacketRecord(i);
+    if (record.isParameterSet && !parameterSetKeys.contains(record.parameterSetKey))
+    {
+      parameterSetKeys.insert(record.parameterSetKey);
+      replayRecords.prepend(record);
+    }
+  }
+  for (int i = replayStart; i < row; i++)
+    replayRecords.append(packetModel->getPacketRecord(i));
+
+  auto readNALUnit = [&file](const parserCommon::PacketItemModel::packetRecord &record)
+  {
+    // The end position is the start of the next start code or the last byte of the file
+    QByteArray data;
+    file.readBytes(data, record.fileStartEndPos.first, record.fileStartEndPos.second - record.fileStartEndPos.first + 1);
+    return data;
+  };
+
+  QScopedPointer<parserAnnexB> parser(createNewParser());
+  for (const auto &record : replayRecords)
+  {
+    try
+    {
+      parser->parseAndAddNALUnit(record.packetID, readNALUnit(record), parser->bitrateItemModel.data(), nullptr, record.fileStartEndPos);
+    }
+    catch (...)
+    {
+      DEBUG_ANNEXB("parserAnnexB::parseNALUnitTree Exception thrown parsing NAL %d", record.packetID);
+    }
+  }
+
+  const auto record = packetModel->getPacketRecord(row);
+  parserCommon::TreeItem nalParent(nullptr);
+  try
+  {
+    parser->parseAndAddNALUnit(record.packetID, readNALUnit(record), parser->bitrateItemModel.data(), &nalParent, record.fileStartEndPos);
+  }
+  catch (...)
+  {
+    DEBUG_ANNEXB("parserAnnexB::parseNALUnitTree Exception thrown parsing NAL %d", record.packetID);
+  }
+  if (nalParent.childItems.isEmpty())
+    return nullptr;
+
+  // Take the tree of the NAL unit from the temporary parent
+  parserCommon::TreeItem *nalRoot = nalParent.childItems.takeFirst();
+  nalRoot->parentItem = nullptr;
+  return nalRoot;
+}
+
 QList<QTreeWidgetItem*> parserAnnexB::stream_info_type::getStreamInfo()
 {
   QList<QTreeWidgetItem*> infoList;
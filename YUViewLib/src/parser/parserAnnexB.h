@@ -33,7 +33,11 @@
 #ifndef PARSERANNEXB_H
 #define PARSERANNEXB_H
 
+#include <QFileInfo>
+#include <QHash>
 #include <QList>
+#include <QMap>
+#include <QSet>
 
 #include "video/videoHandlerYUV.h"
 #include "parserBase.h"
@@ -81,6 +85,8 @@ public:
   // frameIdx: The frame index in display order that we want to seek to
   // codingOrderFrameIdx: The index of the frame in coding order (for use with getFrameStartEndPos).
   int getClosestSeekableFrameNumberBefore(int frameIdx, int &codingOrderFrameIdx) const;
+  // Get the frame indices (in display order) of all random access points (sorted)
+  QList<int> getRandomAccessFrames() const;
 
   // Get the parameters sets as extradata. The format of this depends on the underlying codec.
   virtual QByteArray getExtradata() = 0;
@@ -90,9 +96,13 @@ public:
 
   QUint64Pair getFrameStartEndPos(int codingOrderFrameIdx);
 
+  // Parse the whole file to find all frames and random access points. If no packet model is used,
+  // the result is saved in a bitstream index and read from there the next time the file is opened.
   bool parseAnnexBFile(QScopedPointer<fileSourceAnnexBFile> &file, QWidget *mainWindow=nullptr);
 
   // Called from the bitstream analyzer. This function can run in a background process.
+  // The packet model is used in the packet mode, so only a compact record is kept for each NAL unit and the whole
+  // file can be parsed. The syntax tree of a NAL unit is parsed again when it is expanded (parseNALUnitTree).
   bool runParsingOfFile(QString compressedFilePath) Q_DECL_OVERRIDE;
 
   // Parsing of an SEI message may fail when the required parameter sets are not yet available and parsing has to be performed
@@ -136,6 +146,23 @@ public:
   };
 
 protected:
+
+  // Create a new parser of the same type. This is used to parse NAL units again.
+  virtual parserAnnexB *createNewParser() const = 0;
+
+  // Set the name of the tree item of a NAL unit after it was parsed. In the packet mode of the packet model, there is
+  // no tree item for the NAL unit. A record of the NAL unit is added to the packet model instead.
+  // For parameter sets, give the parameter set ID so that a later parameter set of the same type and ID replaces it.
+  void setNALUnitName(parserCommon::TreeItem *nalRoot, const nal_unit &nal, const QString &name, bool isRandomAccess, bool error, int parameterSetID=-1);
+  bool isNALUnitNameNeeded(parserCommon::TreeItem *nalRoot) const { return nalRoot != nullptr || packetModel->isPacketMode(); }
+  // Should the NAL units be added to the tree of the packet model?
+  bool isAddingNALUnitsToModel() const { return !packetModel->isNull() && !packetModel->isPacketMode(); }
+
+  // Parse the NAL unit in the given row of the packet model again and return its syntax tree. A new parser is used
+  // which first parses the parameter sets and the NAL units since the last random access point before the NAL unit.
+  parserCommon::TreeItem *parseNALUnitTree(int row) const;
+  // The file that is parsed in the bitstream analyzer
+  QString bitstreamFilePath;
   
   struct annexBFrame
   {
@@ -161,6 +188,34 @@ protected:
 
   int pocOfFirstRandomAccessFrame {-1};
 
+  // Save the frame list and the information needed to seek to each random access point in the bitstream index.
+  void saveIndex(const QFileInfo &bitstreamFile);
+  // Read the frame list from the bitstream index. Only the parameter sets are parsed again. Return false if there
+  // is no valid index for the bitstream.
+  bool loadIndex(const QFileInfo &bitstreamFile);
+  QString getIndexType() const { return QString(metaObject()->className()) + (parsingLimitEnabled ? "Limited" : ""); }
+
+  // The file position of the first slice of a frame and the parameter sets that are active there (without start codes)
+  struct seekFrameParameterSets
+  {
+    uint64_t filePos;
+    QList<QByteArray> parameterSets;
+  };
+  // Get the seek information for all of the given POCs in one pass over the nalUnitList. For each POC, the result is
+  // the same as what getSeekFrameParamerSets returns. POCs without a slice are not in the returned map.
+  virtual QMap<int, seekFrameParameterSets> getSeekFrameParameterSetsForPOCs(const QSet<int> &pocs) const { Q_UNUSED(pocs); return {}; }
+
+  // If the frame list was read from the index, the nalUnitList does not contain the slices. The parameter sets
+  // and the file position for seeking to a random access point are then returned from here.
+  bool getSeekFrameParamerSetsFromIndex(int iFrameNr, uint64_t &filePos, QList<QByteArray> &paramSets) const;
+  struct indexSeekPoint
+  {
+    uint64_t filePos;
+    QList<int> parameterSetIdx;  //< Indices into indexParameterSets
+  };
+  QMap<int, indexSeekPoint> indexSeekPoints;  //< Seek points by POC
+  QList<QByteArray> indexParameterSets;
+
   // Save general information about the file here
   struct stream_info_type
   {
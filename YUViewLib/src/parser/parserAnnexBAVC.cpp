@@ -171,7 +171,7 @@ bool parserAnnexBAVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
   TreeItem *nalRoot = nullptr;
   if (parent)
     nalRoot = new TreeItem(parent);
-  else if (!packetModel->isNull())
+  else if (isAddingNALUnitsToModel())
     nalRoot = new TreeItem(packetModel->getRootItem());
 
   // Create a nal_unit and read the header
@@ -202,6 +202,9 @@ bool parserAnnexBAVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
   bool parsingSuccess = true;
   bool currentSliceIntra = false;
   QString currentSliceType;
+  // Decoding can start at the first slice of an I picture or at a recovery point SEI
+  bool isRandomAccessPoint = false;
+  int parameterSetID = -1;
   if (nal_avc.nal_unit_type == SPS)
   {
     // A sequence parameter set
@@ -210,6 +213,7 @@ bool parserAnnexBAVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
 
     // Add sps (replace old one if existed)
     active_SPS_list.insert(new_sps->seq_parameter_set_id, new_sps);
+    parameterSetID = new_sps->seq_parameter_set_id;
 
     // Also add sps to list of all nals
     nalUnitList.append(new_sps);
@@ -232,6 +236,7 @@ bool parserAnnexBAVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
 
     // Add pps (replace old one if existed)
     active_PPS_list.insert(new_pps->pic_parameter_set_id, new_pps);
+    parameterSetID = new_pps->pic_parameter_set_id;
 
     // Also add pps to list of all nals
     nalUnitList.append(new_pps);
@@ -288,6 +293,7 @@ bool parserAnnexBAVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
 
       currentSliceIntra = new_slice->isRandomAccess();
       currentSliceType = new_slice->getSliceTypeString();
+      isRandomAccessPoint = new_slice->isRandomAccess() && new_slice->first_mb_in_slice == 0;
 
       DEBUG_AVC("parserAnnexBAVC::parseAndAddNALUnit Parsed Slice POC %d", new_slice->globalPOC);
     }
@@ -346,8 +352,13 @@ bool parserAnnexBAVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
         result = new_user_data_sei->parse_user_data_sei(sub_sei_data, message_tree);
       }
       else
+      {
+        if (new_sei->payloadType == 6)
+          // A recovery point
+          isRandomAccessPoint = true;
         // The default parser just logs the raw bytes
         result = new_sei->parser_sei_bytes(sub_sei_data, message_tree);
+      }
       
       if (result == SEI_PARSING_WAIT_FOR_PARAMETER_SETS)
         reparse_sei.append(reparse);
@@ -414,12 +425,9 @@ bool parserAnnexBAVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
     currentAUAllSliceTypes += currentSliceType + " ";
   }
 
-  if (nalRoot)
-  {
+  if (isNALUnitNameNeeded(nalRoot))
     // Set a useful name of the TreeItem (the root for this NAL)
-    nalRoot->itemData.append(QString("NAL %1: %2").arg(nal_avc.nal_idx).arg(nal_unit_type_toString.value(nal_avc.nal_unit_type)) + specificDescription);
-    nalRoot->setError(!parsingSuccess);
-  }
+    setNALUnitName(nalRoot, nal_avc, QString("NAL %1: %2").arg(nal_avc.nal_idx).arg(nal_unit_type_toString.value(nal_avc.nal_unit_type)) + specificDescription, isRandomAccessPoint, !parsingSuccess, parameterSetID);
 
   return parsingSuccess;
 }
@@ -1947,16 +1955,38 @@ bool parserAnnexBAVC::user_data_sei::parse_internal(QByteArray &sliceHeaderData,
 
 QList<QByteArray> parserAnnexBAVC::getSeekFrameParamerSets(int iFrameNr, uint64_t &filePos)
 {
+  QList<QByteArray> indexParamSets;
+  if (getSeekFrameParamerSetsFromIndex(iFrameNr, filePos, indexParamSets))
+    return indexParamSets;
+
   // Get the POC for the frame number
   int seekPOC = POCList[iFrameNr];
 
+  const QMap<int, seekFrameParameterSets> seekFrames = getSeekFrameParameterSetsForPOCs(QSet<int>() << seekPOC);
+  auto it = seekFrames.constFind(seekPOC);
+  if (it == seekFrames.constEnd())
+    return QList<QByteArray>();
+
+  // Seek here
+  filePos = it->filePos;
+  return it->parameterSets;
+}
+
+QMap<int, parserAnnexB::seekFrameParameterSets> parserAnnexBAVC::getSeekFrameParameterSetsForPOCs(const QSet<int> &pocs) const
+{
+  QMap<int, seekFrameParameterSets> seekFrames;
+
   // Collect the active parameter sets
   sps_map active_SPS_list;
   pps_map active_PPS_list;
 
   for (auto nal : nalUnitList)
   {
-    // This should be an hevc nal
+    if (seekFrames.size() == pocs.size())
+      // All frames found
+      break;
+
+    // This should be an avc nal
     auto nal_avc = nal.dynamicCast<nal_unit_avc>();
 
     if (nal_avc->isSlice()) 
@@ -1964,20 +1994,17 @@ QList<QByteArray> parserAnnexBAVC::getSeekFrameParamerSets(int iFrameNr, uint64_
       // We can cast this to a slice.
       auto s = nal_avc.dynamicCast<slice_header>();
 
-      if (s->globalPOC == seekPOC)
+      const int poc = s->globalPOC;
+      if (pocs.contains(poc) && !seekFrames.contains(poc))
       {
-        // Seek here
-        filePos = s->filePosStartEnd.first;
-
-        // Get the bitstream of all active parameter sets
-        QList<QByteArray> paramSets;
-
+        // The first slice of the frame. Get the bitstream of all active parameter sets.
+        seekFrameParameterSets seekFrame;
+        seekFrame.filePos = s->filePosStartEnd.first;
         for (auto s : active_SPS_list)
-          paramSets.append(s->getRawNALData());
+          seekFrame.parameterSets.append(s->getRawNALData());
         for (auto p : active_PPS_list)
-          paramSets.append(p->getRawNALData());
-
-        return paramSets;
+          seekFrame.parameterSets.append(p->getRawNALData());
+        seekFrames.insert(poc, seekFrame);
       }
     }
     else if (nal_avc->nal_unit_type == SPS) 
@@ -1994,7 +2021,7 @@ QList<QByteArray> parserAnnexBAVC::getSeekFrameParamerSets(int iFrameNr, uint64_
     }
   }
 
-  return QList<QByteArray>();
+  return seekFrames;
 }
 
 QByteArray parserAnnexBAVC::getExtradata()
@@ -62,6 +62,9 @@ public:
   QPair<int,int> getSampleAspectRatio() Q_DECL_OVERRIDE;
 
 protected:
+  parserAnnexB *createNewParser() const Q_DECL_OVERRIDE { return new parserAnnexBAVC(); }
+  QMap<int, seekFrameParameterSets> getSeekFrameParameterSetsForPOCs(const QSet<int> &pocs) const Q_DECL_OVERRIDE;
+
   // ----- Some nested classes that are only used in the scope of this file handler class
 
   // All the different NAL unit types (T-REC-H.265-201504 Page 85)
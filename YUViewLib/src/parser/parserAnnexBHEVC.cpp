@@ -153,9 +153,27 @@ yuvPixelFormat parserAnnexBHEVC::getPixelFormat() const
 
 QList<QByteArray> parserAnnexBHEVC::getSeekFrameParamerSets(int iFrameNr, uint64_t &filePos)
 {
+  QList<QByteArray> indexParamSets;
+  if (getSeekFrameParamerSetsFromIndex(iFrameNr, filePos, indexParamSets))
+    return indexParamSets;
+
   // Get the POC for the frame number
   int seekPOC = POCList[iFrameNr];
 
+  const QMap<int, seekFrameParameterSets> seekFrames = getSeekFrameParameterSetsForPOCs(QSet<int>() << seekPOC);
+  auto it = seekFrames.constFind(seekPOC);
+  if (it == seekFrames.constEnd())
+    return QList<QByteArray>();
+
+  // Seek here
+  filePos = it->filePos;
+  return it->parameterSets;
+}
+
+QMap<int, parserAnnexB::seekFrameParameterSets> parserAnnexBHEVC::getSeekFrameParameterSetsForPOCs(const QSet<int> &pocs) const
+{
+  QMap<int, seekFrameParameterSets> seekFrames;
+
   // Collect the active parameter sets
   vps_map active_VPS_list;
   sps_map active_SPS_list;
@@ -163,6 +181,10 @@ QList<QByteArray> parserAnnexBHEVC::getSeekFrameParamerSets(int iFrameNr, uint64
 
   for (auto nal : nalUnitList)
   {
+    if (seekFrames.size() == pocs.size())
+      // All frames found
+      break;
+
     // This should be an hevc nal
     auto nal_hevc = nal.dynamicCast<nal_unit_hevc>();
 
@@ -171,22 +193,19 @@ QList<QByteArray> parserAnnexBHEVC::getSeekFrameParamerSets(int iFrameNr, uint64
       // We can cast this to a slice.
       auto s = nal_hevc.dynamicCast<slice>();
 
-      if (s->globalPOC == seekPOC)
+      const int poc = s->globalPOC;
+      if (pocs.contains(poc) && !seekFrames.contains(poc))
       {
-        // Seek here
-        filePos = s->filePosStartEnd.first;
-
-        // Get the bitstream of all active parameter sets
-        QList<QByteArray> paramSets;
-
+        // The first slice of the frame. Get the bitstream of all active parameter sets.
+        seekFrameParameterSets seekFrame;
+        seekFrame.filePos = s->filePosStartEnd.first;
         for (auto v : active_VPS_list)
-          paramSets.append(v->getRawNALData());
+          seekFrame.parameterSets.append(v->getRawNALData());
         for (auto s : active_SPS_list)
-          paramSets.append(s->getRawNALData());
+          seekFrame.parameterSets.append(s->getRawNALData());
         for (auto p : active_PPS_list)
-          paramSets.append(p->getRawNALData());
-
-        return paramSets;
+          seekFrame.parameterSets.append(p->getRawNALData());
+        seekFrames.insert(poc, seekFrame);
       }
     }
     else if (nal_hevc->nal_type == VPS_NUT)
@@ -209,7 +228,7 @@ QList<QByteArray> parserAnnexBHEVC::getSeekFrameParamerSets(int iFrameNr, uint64
     }
   }
 
-  return QList<QByteArray>();
+  return seekFrames;
 }
 
 QByteArray parserAnnexBHEVC::getExtradata()
@@ -344,7 +363,7 @@ bool parserAnnexBHEVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIte
   TreeItem *nalRoot = nullptr;
   if (parent)
     nalRoot = new TreeItem(parent);
-  else if (!packetModel->isNull())
+  else if (isAddingNALUnitsToModel())
     nalRoot = new TreeItem(packetModel->getRootItem());
 
   // Create a nal_unit and read the header
@@ -381,6 +400,7 @@ bool parserAnnexBHEVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIte
   }
 
   bool parsingSuccess = true;
+  int parameterSetID = -1;
   if (nal_hevc.nal_type == VPS_NUT)
   {
     // A video parameter set
@@ -392,6 +412,7 @@ bool parserAnnexBHEVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIte
 
     // Add vps (replace old one if existed)
     active_VPS_list.insert(new_vps->vps_video_parameter_set_id, new_vps);
+    parameterSetID = new_vps->vps_video_parameter_set_id;
 
     // Add the VPS ID
     specificDescription = parsingSuccess ? QString(" VPS_NUT ID %1").arg(new_vps->vps_video_parameter_set_id) : " VPS_NUT ERR";
@@ -408,6 +429,7 @@ bool parserAnnexBHEVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIte
 
     // Add sps (replace old one if existed)
     active_SPS_list.insert(new_sps->sps_seq_parameter_set_id, new_sps);
+    parameterSetID = new_sps->sps_seq_parameter_set_id;
 
     // Also add sps to list of all nals
     nalUnitList.append(new_sps);
@@ -427,6 +449,7 @@ bool parserAnnexBHEVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIte
 
     // Add pps (replace old one if existed)
     active_PPS_list.insert(new_pps->pps_pic_parameter_set_id, new_pps);
+    parameterSetID = new_pps->pps_pic_parameter_set_id;
 
     // Also add pps to list of all nals
     nalUnitList.append(new_pps);
@@ -647,9 +670,9 @@ bool parserAnnexBHEVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIte
     currentAUAllSliceTypes += currentSliceType + " ";
   }
 
-  if (nalRoot)
+  if (isNALUnitNameNeeded(nalRoot))
     // Set a useful name of the TreeItem (the root for this NAL)
-    nalRoot->itemData.append(QString("NAL %1: %2").arg(nal_hevc.nal_idx).arg(nal_unit_type_toString.value(nal_hevc.nal_type)) + specificDescription);
+    setNALUnitName(nalRoot, nal_hevc, QString("NAL %1: %2").arg(nal_hevc.nal_idx).arg(nal_unit_type_toString.value(nal_hevc.nal_type)) + specificDescription, nal_hevc.isIRAP(), !parsingSuccess, parameterSetID);
 
   return true;
 }
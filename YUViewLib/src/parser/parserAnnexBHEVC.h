@@ -62,6 +62,9 @@ public:
   bool parseAndAddNALUnit(int nalID, QByteArray data, parserCommon::BitrateItemModel *bitrateModel, parserCommon::TreeItem *parent=nullptr, QUint64Pair nalStartEndPosFile = QUint64Pair(-1,-1), QString *nalTypeName=nullptr) Q_DECL_OVERRIDE;
 
 protected:
+  parserAnnexB *createNewParser() const Q_DECL_OVERRIDE { return new parserAnnexBHEVC(); }
+  QMap<int, seekFrameParameterSets> getSeekFrameParameterSetsForPOCs(const QSet<int> &pocs) const Q_DECL_OVERRIDE;
+
   // ----- Some nested classes that are only used in the scope of this file handler class
 
   // All the different NAL unit types (T-REC-H.265-201504 Page 85)
@@ -165,7 +165,7 @@ bool parserAnnexBMpeg2::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIt
   TreeItem *nalRoot = nullptr;
   if (parent)
     nalRoot = new TreeItem(parent);
-  else if (!packetModel->isNull())
+  else if (isAddingNALUnitsToModel())
     nalRoot = new TreeItem(packetModel->getRootItem());
 
   // Create a nal_unit and read the header
@@ -313,9 +313,9 @@ bool parserAnnexBMpeg2::parseAndAddNALUnit(int nalID, QByteArray data, BitrateIt
     currentAUAllSliceTypes += currentSliceType + " ";
   }
   
-  if (nalRoot)
+  if (isNALUnitNameNeeded(nalRoot))
     // Set a useful name of the TreeItem (the root for this NAL)
-    nalRoot->itemData.append(QString("NAL %1: %2").arg(nal_mpeg2.nal_idx).arg(nal_unit_type_toString.value(nal_mpeg2.nal_unit_type)) + specificDescription);
+    setNALUnitName(nalRoot, nal_mpeg2, QString("NAL %1: %2").arg(nal_mpeg2.nal_idx).arg(nal_unit_type_toString.value(nal_mpeg2.nal_unit_type)) + specificDescription, nal_mpeg2.nal_unit_type == SEQUENCE_HEADER || (nal_mpeg2.nal_unit_type == PICTURE && currentSliceIntra), !parsingSuccess);
 
   return parsingSuccess;
 }
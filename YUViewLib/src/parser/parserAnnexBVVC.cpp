@@ -112,7 +112,7 @@ bool parserAnnexBVVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
   TreeItem *nalRoot = nullptr;
   if (parent)
     nalRoot = new TreeItem(parent);
-  else if (!packetModel->isNull())
+  else if (isAddingNALUnitsToModel())
     nalRoot = new TreeItem(packetModel->getRootItem());
 
   // Create a nal_unit and read the header
@@ -147,9 +147,9 @@ bool parserAnnexBVVC::parseAndAddNALUnit(int nalID, QByteArray data, BitrateItem
 
   sizeCurrentAU += data.size();
 
-  if (nalRoot)
+  if (isNALUnitNameNeeded(nalRoot))
     // Set a useful name of the TreeItem (the root for this NAL)
-    nalRoot->itemData.append(QString("NAL %1: %2").arg(nal_vvc.nal_idx).arg(nal_vvc.nal_unit_type_id) + specificDescription);
+    setNALUnitName(nalRoot, nal_vvc, QString("NAL %1: %2").arg(nal_vvc.nal_idx).arg(nal_vvc.nal_unit_type_id) + specificDescription, nal_vvc.isIRAPOrGDR(), false);
 
   return true;
 }
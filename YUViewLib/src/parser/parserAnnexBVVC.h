@@ -62,6 +62,8 @@ public:
   bool parseAndAddNALUnit(int nalID, QByteArray data, parserCommon::BitrateItemModel *bitrateModel, parserCommon::TreeItem *parent=nullptr, QUint64Pair nalStartEndPosFile = QUint64Pair(-1,-1), QString *nalTypeName=nullptr) Q_DECL_OVERRIDE;
 
 protected:
+  parserAnnexB *createNewParser() const Q_DECL_OVERRIDE { return new parserAnnexBVVC(); }
+
   // ----- Some nested classes that are only used in the scope of this file handler class
 
   /* The basic VVC NAL unit. Additionally to the basic NAL unit, it knows the HEVC nal unit types.
@@ -77,6 +79,8 @@ protected:
     bool parse_nal_unit_header(const QByteArray &parameterSetData, parserCommon::TreeItem *root) override;
 
     bool isAUDelimiter() { return nal_unit_type_id == 19; }
+    // IDR_W_RADL, IDR_N_LP, CRA_NUT or GDR_NUT
+    bool isIRAPOrGDR() const { return nal_unit_type_id >= 7 && nal_unit_type_id <= 10; }
 
     // The information of the NAL unit header
     unsigned int nuh_layer_id;
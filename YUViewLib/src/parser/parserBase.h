@@ -41,7 +41,8 @@
 
 // If the file parsing limit is enabled (setParsingLimitEnabled) parsing will be aborted after
 // 500 frames have been parsed. This should be enough in most situations and full parsing can be
-// enabled manually if needed.
+// enabled manually if needed. Parsers that keep only a compact record per packet in the packet
+// model (parserAnnexB) don't use the limit.
 #define PARSER_FILE_FRAME_NR_LIMIT 500
 
 /* Abstract base class that prvides features which are common to all parsers
@@ -75,6 +76,7 @@ public:
   void setStreamColorCoding(bool colorCoding) { packetModel->setUseColorCoding(colorCoding); }
   void setFilterStreamIndex(int streamIndex) { streamIndexFilter->setFilterStreamIndex(streamIndex); }
   void setParsingLimitEnabled(bool limitEnabled) { parsingLimitEnabled = limitEnabled; }
+  bool isParsingLimitEnabled() const { return parsingLimitEnabled; }
   void setBitrateSortingIndex(int sortingIndex) { bitrateItemModel->setBitrateSortingIndex(sortingIndex); }
 
 signals:
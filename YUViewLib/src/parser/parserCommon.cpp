@@ -64,15 +64,75 @@
 
 using namespace parserCommon;
 
-unsigned int sub_byte_reader::readBits(int nrBits, QString &bitsRead)
+namespace
 {
-  int out = 0;
-  int nrBitsRead = nrBits;
+  void appendBitsToString(QString *bitsRead, uint64_t value, int nrBits)
+  {
+    for (int i = nrBits-1; i >= 0; i--)
+      bitsRead->append((value & (uint64_t(1) << i)) ? QChar('1') : QChar('0'));
+  }
+}
 
+unsigned int sub_byte_reader::readBits(int nrBits, QString *bitsRead)
+{
   // The return unsigned int is of depth 32 bits
   if (nrBits > 32)
     throw std::logic_error("Trying to read more than 32 bits at once from the bitstream.");
+  if (nrBits <= 0)
+    return 0;
+
+  const unsigned int out = readBitsFast(nrBits);
+  if (bitsRead)
+    appendBitsToString(bitsRead, out, nrBits);
+  return out;
+}
+
+unsigned int sub_byte_reader::readBitsFast(int nrBits)
+{
+  const unsigned int curBitsLeft = 8 - posInBuffer_bits;
+  if (unsigned(nrBits) <= curBitsLeft)
+  {
+    // All bits are in the current byte
+    const unsigned char c = (unsigned char)byteArray[posInBuffer_bytes];
+    posInBuffer_bits += nrBits;
+    return (c >> (curBitsLeft - nrBits)) & ((1u << nrBits) - 1);
+  }
+
+  // Load 8 bytes starting with the current one. We have to enter at most 4 new bytes.
+  if (posInBuffer_bytes + 8 > unsigned(byteArray.size()))
+    return readBitsBytewise(nrBits);
+  const unsigned char *data = (const unsigned char*)byteArray.constData() + posInBuffer_bytes;
+
+  // The bits after the last read bit (counted from the start of the current byte) and the number of bytes to enter
+  const unsigned int endBit = posInBuffer_bits + nrBits;
+  const unsigned int nrNewBytes = (endBit - 1) / 8;
+  if (skipEmulationPrevention)
+    for (unsigned int i = 1; i <= nrNewBytes; i++)
+      if (data[i] == 3)
+        // This may be an emulation prevention byte which has to be skipped.
+        return readBitsBytewise(nrBits);
+
+  uint64_t word = 0;
+  for (int i = 0; i < 8; i++)
+    word = (word << 8) | data[i];
+  const unsigned int out = (unsigned int)((word << posInBuffer_bits) >> (64 - nrBits));
+
+  // Update the counter of zero bytes in the same way as gotoNextByte() would
+  for (unsigned int i = 1; i <= nrNewBytes; i++)
+  {
+    if (data[i-1] == 0)
+      numEmuPrevZeroBytes++;
+    if (skipEmulationPrevention && data[i] != 0)
+      numEmuPrevZeroBytes = 0;
+  }
+  posInBuffer_bytes += nrNewBytes;
+  posInBuffer_bits = endBit - nrNewBytes * 8;
+  return out;
+}
 
+unsigned int sub_byte_reader::readBitsBytewise(int nrBits)
+{
+  unsigned int out = 0;
   while (nrBits > 0)
   {
     if (posInBuffer_bits == 8 && nrBits != 0) 
@@ -105,9 +165,9 @@ unsigned int sub_byte_reader::readBits(int nrBits, QString &bitsRead)
     // Shift output value so that the new bits fit
     out = out << readBits;
 
-    char c = byteArray[posInBuffer_bytes];
+    unsigned char c = (unsigned char)byteArray[posInBuffer_bytes];
     c = c >> offset;
-    int mask = ((1<<readBits) - 1);
+    unsigned int mask = ((1u<<readBits) - 1);
 
     // Write bits to output
     out += (c & mask);
@@ -117,18 +177,10 @@ unsigned int sub_byte_reader::readBits(int nrBits, QString &bitsRead)
     posInBuffer_bits += readBits;
   }
 
-  for (int i = nrBitsRead-1; i >= 0; i--)
-  {
-    if (out & (1 << i))
-      bitsRead.append("1");
-    else
-      bitsRead.append("0");
-  }
-
   return out;
 }
 
-uint64_t sub_byte_reader::readBits64(int nrBits, QString &bitsRead)
+uint64_t sub_byte_reader::readBits64(int nrBits, QString *bitsRead)
 {
   if (nrBits > 64)
     throw std::logic_error("Trying to read more than 64 bits at once from the bitstream.");
@@ -137,10 +189,9 @@ uint64_t sub_byte_reader::readBits64(int nrBits, QString &bitsRead)
 
   // We just use the readBits function twice
   int lowerBits = nrBits - 32;
-  int upper = readBits(32, bitsRead);
-  int lower = readBits(lowerBits, bitsRead);
-  uint64_t ret = (upper << lowerBits) + lower;
-  return ret;
+  uint64_t upper = readBits(32, bitsRead);
+  uint64_t lower = readBits(lowerBits, bitsRead);
+  return (upper << lowerBits) + lower;
 }
 
 QByteArray sub_byte_reader::readBytes(int nrBytes)
@@ -168,7 +219,7 @@ QByteArray sub_byte_reader::readBytes(int nrBytes)
   return retArray;
 }
 
-unsigned int sub_byte_reader::readUE_V(QString &bitsRead, int &bit_count)
+unsigned int sub_byte_reader::readUE_V(int &bit_count, QString *bitsRead)
 {
   int readBit = readBits(1, bitsRead);
   bit_count++;
@@ -193,16 +244,16 @@ unsigned int sub_byte_reader::readUE_V(QString &bitsRead, int &bit_count)
   return val;
 }
 
-int sub_byte_reader::readSE_V(QString &bitsRead, int &bit_count)
+int sub_byte_reader::readSE_V(int &bit_count, QString *bitsRead)
 {
-  int val = readUE_V(bitsRead, bit_count);
+  int val = readUE_V(bit_count, bitsRead);
   if (val%2 == 0) 
     return -(val+1)/2;
   else
     return (val+1)/2;
 }
 
-uint64_t sub_byte_reader::readLeb128(QString &bitsRead, int &bit_count)
+uint64_t sub_byte_reader::readLeb128(int &bit_count, QString *bitsRead)
 {
   // We will read full bytes (up to 8)
   // The highest bit indicates if we need to read another bit. The rest of the bits is added to the counter (shifted accordingly)
@@ -212,14 +263,14 @@ uint64_t sub_byte_reader::readLeb128(QString &bitsRead, int &bit_count)
   {
     int leb128_byte = readBits(8, bitsRead);
     bit_count += 8;
-    value |= ((leb128_byte & 0x7f) << (i*7));
+    value |= (uint64_t(leb128_byte & 0x7f) << (i*7));
     if (!(leb128_byte & 0x80))
       break;
   }
   return value;
 }
 
-uint64_t sub_byte_reader::readUVLC(QString &bitsRead, int &bit_count)
+uint64_t sub_byte_reader::readUVLC(int &bit_count, QString *bitsRead)
 {
   int leadingZeros = 0;
   while (1)
@@ -236,7 +287,7 @@ uint64_t sub_byte_reader::readUVLC(QString &bitsRead, int &bit_count)
   return value + ((uint64_t)1 << leadingZeros) - 1;
 }
 
-int sub_byte_reader::readNS(int maxVal, QString &bitsRead, int &bit_count)
+int sub_byte_reader::readNS(int maxVal, int &bit_count, QString *bitsRead)
 {
   // FloorLog2
   int floorVal;
@@ -262,7 +313,7 @@ int sub_byte_reader::readNS(int maxVal, QString &bitsRead, int &bit_count)
   return (v << 1) - m + extra_bit;
 }
 
-int sub_byte_reader::readSU(int nrBits, QString &bitsRead)
+int sub_byte_reader::readSU(int nrBits, QString *bitsRead)
 {
   int value = readBits(nrBits, bitsRead);
   int signMask = 1 << (nrBits - 1);
@@ -477,7 +528,7 @@ void reader_helper::removeLogSubLevel()
 bool reader_helper::readBits(int numBits, unsigned int &into, QString intoName, QString meaning)
 {
   QString code;
-  if (!readBits_catch(into, numBits, code))
+  if (!readBits_catch(into, numBits, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)
     new TreeItem(intoName, into, QString("u(v) -> u(%1)").arg(numBits), code, meaning, currentTreeLevel);
@@ -487,7 +538,7 @@ bool reader_helper::readBits(int numBits, unsigned int &into, QString intoName,
 bool reader_helper::readBits(int numBits, uint64_t &into, QString intoName, QString meaning)
 {
   QString code;
-  if (!readBits64_catch(into, numBits, code))
+  if (!readBits64_catch(into, numBits, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)
     new TreeItem(intoName, into, QString("u(v) -> u(%1)").arg(numBits), code, meaning, currentTreeLevel);
@@ -497,7 +548,7 @@ bool reader_helper::readBits(int numBits, uint64_t &into, QString intoName, QStr
 bool reader_helper::readBits(int numBits, unsigned int &into, QString intoName, QStringList meanings)
 {
   QString code;
-  if (!readBits_catch(into, numBits, code))
+  if (!readBits_catch(into, numBits, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)
     new TreeItem(intoName, into, QString("u(v) -> u(%1)").arg(numBits), code, getMeaningValue(meanings, into), currentTreeLevel);
@@ -507,7 +558,7 @@ bool reader_helper::readBits(int numBits, unsigned int &into, QString intoName,
 bool reader_helper::readBits(int numBits, unsigned int &into, QString intoName, QMap<int,QString> meanings)
 {
   QString code;
-  if (!readBits_catch(into, numBits, code))
+  if (!readBits_catch(into, numBits, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)
     new TreeItem(intoName, into, QString("u(v) -> u(%1)").arg(numBits), code, getMeaningValue(meanings, into), currentTreeLevel);
@@ -517,7 +568,7 @@ bool reader_helper::readBits(int numBits, unsigned int &into, QString intoName,
 bool reader_helper::readBits(int numBits, unsigned int &into, QString intoName, meaning_callback_function pMeaning)
 {
   QString code;
-  if (!readBits_catch(into, numBits, code))
+  if (!readBits_catch(into, numBits, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)
     new TreeItem(intoName, into, QString("u(v) -> u(%1)").arg(numBits), code, pMeaning(into), currentTreeLevel);
@@ -528,13 +579,15 @@ bool reader_helper::readBits(int numBits, QList<unsigned int> &into, QString int
 {
   QString code;
   unsigned int val;
-  if (!readBits_catch(val, numBits, code))
+  if (!readBits_catch(val, numBits, codeIfLogging(code)))
     return false;
   into.append(val);
-  if (idx >= 0)
-    intoName += QString("[%1]").arg(idx);
   if (currentTreeLevel)
+  {
+    if (idx >= 0)
+      intoName += QString("[%1]").arg(idx);
     new TreeItem(intoName, val, QString("u(v) -> u(%1)").arg(numBits), code, currentTreeLevel);
+  }
   return true;
 }
 
@@ -542,13 +595,15 @@ bool reader_helper::readBits(int numBits, QList<unsigned int> &into, QString int
 {
   QString code;
   unsigned int val;
-  if (!readBits_catch(val, numBits, code))
+  if (!readBits_catch(val, numBits, codeIfLogging(code)))
     return false;
   into.append(val);
-  if (idx >= 0)
-    intoName += QString("[%1]").arg(idx);
   if (currentTreeLevel)
+  {
+    if (idx >= 0)
+      intoName += QString("[%1]").arg(idx);
     new TreeItem(intoName, val, QString("u(v) -> u(%1)").arg(numBits), code, pMeaning(val), currentTreeLevel);
+  }
   return true;
 }
 
@@ -557,20 +612,22 @@ bool reader_helper::readBits(int numBits, QByteArray &into, QString intoName, in
   assert(numBits <= 8);
   QString code;
   unsigned int val;
-  if (!readBits_catch(val, numBits, code))
+  if (!readBits_catch(val, numBits, codeIfLogging(code)))
     return false;
   into.append(val);
-  if (idx >= 0)
-    intoName += QString("[%1]").arg(idx);
   if (currentTreeLevel)
+  {
+    if (idx >= 0)
+      intoName += QString("[%1]").arg(idx);
     new TreeItem(intoName, val, QString("u(v) -> u(%1)").arg(numBits), code, currentTreeLevel);
+  }
   return true;
 }
 
 bool reader_helper::readBits(int numBits, unsigned int &into, QMap<int, QString> intoNames)
 {
   QString code;
-  if (!readBits_catch(into, numBits, code))
+  if (!readBits_catch(into, numBits, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)    
     new TreeItem(getMeaningValue(intoNames, into), into, QString("u(v) -> u(%1)").arg(numBits), code, currentTreeLevel);
@@ -585,7 +642,7 @@ bool reader_helper::readZeroBits(int numBits, QString intoName)
   while (numBits > 0)
   {
     unsigned int into;
-    if (!readBits_catch(into, 1, code))
+    if (!readBits_catch(into, 1, codeIfLogging(code)))
       return false;
     if (into != 0)
       allZero = false;
@@ -603,17 +660,14 @@ bool reader_helper::readZeroBits(int numBits, QString intoName)
 bool reader_helper::ignoreBits(int numBits)
 {
   unsigned int into;
-  QString code;
-  if (!readBits_catch(into, numBits, code))
-    return false;
-  return true;
+  return readBits_catch(into, numBits, nullptr);
 }
 
 bool reader_helper::readFlag(bool &into, QString intoName, QString meaning)
 {
   QString code;
   unsigned int read_val;
-  if (!readBits_catch(read_val, 1, code))
+  if (!readBits_catch(read_val, 1, codeIfLogging(code)))
     return false;
   into = (read_val != 0);
   if (currentTreeLevel)
@@ -625,14 +679,16 @@ bool reader_helper::readFlag(QList<bool> &into, QString intoName, int idx, QStri
 {
   QString code;
   unsigned int read_val;
-  if (!readBits_catch(read_val, 1, code))
+  if (!readBits_catch(read_val, 1, codeIfLogging(code)))
     return false;
   bool val = (read_val != 0);
   into.append(val);
-  if (idx >= 0)
-    intoName += QString("[%1]").arg(idx);
   if (currentTreeLevel)
+  {
+    if (idx >= 0)
+      intoName += QString("[%1]").arg(idx);
     new TreeItem(intoName, val, "u(1)", code, meaning, currentTreeLevel);
+  }
   return true;
 }
 
@@ -640,7 +696,7 @@ bool reader_helper::readFlag(bool &into, QString intoName, QStringList meanings)
 {
   QString code;
   unsigned int read_val;
-  if (!readBits_catch(read_val, 1, code))
+  if (!readBits_catch(read_val, 1, codeIfLogging(code)))
     return false;
   into = (read_val != 0);
   if (currentTreeLevel)
@@ -652,7 +708,7 @@ bool reader_helper::readUEV(unsigned int &into, QString intoName, QStringList me
 {
   QString code;
   int bit_count = 0;
-  if (!readUEV_catch(into, bit_count, code))
+  if (!readUEV_catch(into, bit_count, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)
     new TreeItem(intoName, into, QString("ue(v) -> ue(%1)").arg(bit_count), code, getMeaningValue(meanings, into), currentTreeLevel);
@@ -663,7 +719,7 @@ bool reader_helper::readUEV(unsigned int &into, QString intoName, QString meanin
 {
   QString code;
   int bit_count = 0;
-  if (!readUEV_catch(into, bit_count, code))
+  if (!readUEV_catch(into, bit_count, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)
     new TreeItem(intoName, into, QString("ue(v) -> ue(%1)").arg(bit_count), code, meaning, currentTreeLevel);
@@ -675,13 +731,15 @@ bool reader_helper::readUEV(QList<quint32> &into, QString intoName, int idx, QSt
   QString code;
   int bit_count = 0;
   unsigned int val;
-  if (!readUEV_catch(val, bit_count, code))
+  if (!readUEV_catch(val, bit_count, codeIfLogging(code)))
     return false;
   into.append(val);
-  if (idx >= 0)
-    intoName += QString("[%1]").arg(idx);
   if (currentTreeLevel)
+  {
+    if (idx >= 0)
+      intoName += QString("[%1]").arg(idx);
     new TreeItem(intoName, val, QString("ue(v) -> ue(%1)").arg(bit_count), code, meaning, currentTreeLevel);
+  }
   return true;
 }
 
@@ -689,7 +747,7 @@ bool reader_helper::readSEV(int &into, QString intoName, QStringList meanings)
 {
   QString code;
   int bit_count = 0;
-  if (!readSEV_catch(into, bit_count, code))
+  if (!readSEV_catch(into, bit_count, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)
     new TreeItem(intoName, into, QString("se(v) -> se(%1)").arg(bit_count), code, getMeaningValue(meanings, (unsigned int)into), currentTreeLevel);
@@ -701,13 +759,15 @@ bool reader_helper::readSEV(QList<int> into, QString intoName, int idx)
   QString code;
   int bit_count = 0;
   unsigned int val;
-  if (!readUEV_catch(val, bit_count, code))
+  if (!readUEV_catch(val, bit_count, codeIfLogging(code)))
     return false;
   into.append(val);
-  if (idx >= 0)
-    intoName += QString("[%1]").arg(idx);
   if (currentTreeLevel)
+  {
+    if (idx >= 0)
+      intoName += QString("[%1]").arg(idx);
     new TreeItem(intoName, val, QString("se(v) -> se(%1)").arg(bit_count), code, currentTreeLevel);
+  }
   return true;
 }
 
@@ -715,7 +775,7 @@ bool reader_helper::readLeb128(uint64_t &into, QString intoName)
 {
   QString code;
   int bit_count = 0;
-  if (!readLeb128_catch(into, bit_count, code))
+  if (!readLeb128_catch(into, bit_count, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)
     new TreeItem(intoName, into, QString("leb128(v) -> leb128(%1)").arg(bit_count), code, currentTreeLevel);
@@ -726,7 +786,7 @@ bool reader_helper::readUVLC(uint64_t &into, QString intoName)
 {
   QString code;
   int bit_count = 0;
-  if (!readUVLC_catch(into, bit_count, code))
+  if (!readUVLC_catch(into, bit_count, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)
     new TreeItem(intoName, into, QString("leb128(v) -> leb128(%1)").arg(bit_count), code, currentTreeLevel);
@@ -737,7 +797,7 @@ bool reader_helper::readNS(int &into, QString intoName, int maxVal)
 {
   QString code;
   int bit_count = 0;
-  if (!readNS_catch(into, maxVal, bit_count, code))
+  if (!readNS_catch(into, maxVal, bit_count, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)
     new TreeItem(intoName, into, QString("ns(%1)").arg(bit_count), code, currentTreeLevel);
@@ -747,7 +807,7 @@ bool reader_helper::readNS(int &into, QString intoName, int maxVal)
 bool reader_helper::readSU(int &into, QString intoName, int nrBits)
 {
   QString code;
-  if (!readSU_catch(into, nrBits, code))
+  if (!readSU_catch(into, nrBits, codeIfLogging(code)))
     return false;
   if (currentTreeLevel)
     new TreeItem(intoName, into, QString("su(%1)").arg(nrBits), code, currentTreeLevel);
@@ -788,7 +848,7 @@ bool reader_helper::addErrorMessageChildItem(QString errorMessage, TreeItem *ite
   return false;
 }
 
-bool reader_helper::readBits_catch(unsigned int &into, int numBits, QString &code)
+bool reader_helper::readBits_catch(unsigned int &into, int numBits, QString *code)
 {
   try
   {
@@ -802,7 +862,7 @@ bool reader_helper::readBits_catch(unsigned int &into, int numBits, QString &cod
   return true;
 }
 
-bool reader_helper::readBits64_catch(uint64_t &into, int numBits, QString &code)
+bool reader_helper::readBits64_catch(uint64_t &into, int numBits, QString *code)
 {
   try
   {
@@ -816,11 +876,11 @@ bool reader_helper::readBits64_catch(uint64_t &into, int numBits, QString &code)
   return true;
 }
 
-bool reader_helper::readUEV_catch(unsigned int &into, int &bit_count, QString &code)
+bool reader_helper::readUEV_catch(unsigned int &into, int &bit_count, QString *code)
 {
   try
   {
-    into = sub_byte_reader::readUE_V(code, bit_count);
+    into = sub_byte_reader::readUE_V(bit_count, code);
   }
   catch (const std::exception& ex)
   {
@@ -830,11 +890,11 @@ bool reader_helper::readUEV_catch(unsigned int &into, int &bit_count, QString &c
   return true;
 }
 
-bool reader_helper::readSEV_catch(int &into, int &bit_count, QString &code)
+bool reader_helper::readSEV_catch(int &into, int &bit_count, QString *code)
 {
   try
   {
-    into = sub_byte_reader::readSE_V(code, bit_count);
+    into = sub_byte_reader::readSE_V(bit_count, code);
   }
   catch (const std::exception& ex)
   {
@@ -844,11 +904,11 @@ bool reader_helper::readSEV_catch(int &into, int &bit_count, QString &code)
   return true;
 }
 
-bool reader_helper::readLeb128_catch(uint64_t &into, int &bit_count, QString &code)
+bool reader_helper::readLeb128_catch(uint64_t &into, int &bit_count, QString *code)
 {
   try
   {
-    into = sub_byte_reader::readLeb128(code, bit_count);
+    into = sub_byte_reader::readLeb128(bit_count, code);
   }
   catch (const std::exception& ex)
   {
@@ -858,11 +918,11 @@ bool reader_helper::readLeb128_catch(uint64_t &into, int &bit_count, QString &co
   return true;
 }
 
-bool reader_helper::readUVLC_catch(uint64_t &into, int &bit_count, QString &code)
+bool reader_helper::readUVLC_catch(uint64_t &into, int &bit_count, QString *code)
 {
   try
   {
-    into = sub_byte_reader::readUVLC(code, bit_count);
+    into = sub_byte_reader::readUVLC(bit_count, code);
   }
   catch (const std::exception& ex)
   {
@@ -872,11 +932,11 @@ bool reader_helper::readUVLC_catch(uint64_t &into, int &bit_count, QString &code
   return true;
 }
 
-bool reader_helper::readNS_catch(int &into, int maxVal, int &bit_count, QString &code)
+bool reader_helper::readNS_catch(int &into, int maxVal, int &bit_count, QString *code)
 {
   try
   {
-    into = sub_byte_reader::readNS(maxVal, code, bit_count);
+    into = sub_byte_reader::readNS(maxVal, bit_count, code);
   }
   catch (const std::exception& ex)
   {
@@ -886,7 +946,7 @@ bool reader_helper::readNS_catch(int &into, int maxVal, int &bit_count, QString
   return true;
 }
 
-bool reader_helper::readSU_catch(int &into, int numBits, QString &code)
+bool reader_helper::readSU_catch(int &into, int numBits, QString *code)
 {
   try
   {
@@ -946,6 +1006,7 @@ PacketItemModel::PacketItemModel(QObject *parent) : QAbstractItemModel(parent)
 
 PacketItemModel::~PacketItemModel()
 {
+  qDeleteAll(packetTrees);
 }
 
 QVariant PacketItemModel::headerData(int section, Qt::Orientation orientation, int role) const
@@ -961,6 +1022,27 @@ QVariant PacketItemModel::data(const QModelIndex &index, int role) const
   if (!index.isValid())
     return QVariant();
 
+  if (isPacketIndex(index))
+  {
+    // A first level item in the packet mode. Everything is taken from the record.
+    const packetRecord record = getPacketRecord(index.row());
+    if (role == Qt::ForegroundRole)
+      return record.error ? QVariant(QBrush(QColor(255, 0, 0))) : QVariant(QBrush());
+    if (role == Qt::BackgroundRole)
+    {
+      if (!useColorCoding || record.streamIndex < 0)
+        return QVariant(QBrush());
+      return QVariant(QBrush(streamIndexColors.at(record.streamIndex % streamIndexColors.length())));
+    }
+    if ((role == Qt::DisplayRole || role == Qt::ToolTipRole) && index.column() == 0)
+    {
+      if (!showVideoOnly && record.streamIndex != -1)
+        return QVariant(QString("Stream %1 - ").arg(record.streamIndex) + record.name);
+      return QVariant(record.name);
+    }
+    return QVariant();
+  }
+
   TreeItem *item = static_cast<TreeItem*>(index.internalPointer());
   if (role == Qt::ForegroundRole)
   {
@@ -992,13 +1074,19 @@ QModelIndex PacketItemModel::index(int row, int column, const QModelIndex &paren
   if (!hasIndex(row, column, parent))
     return QModelIndex();
 
+  if (packetMode && !parent.isValid())
+    return createIndex(row, column, nullptr);
+
   TreeItem *parentItem;
   if (!parent.isValid())
     parentItem = rootItem.data();
+  else if (isPacketIndex(parent))
+    parentItem = packetTrees.value(parent.row(), nullptr);
   else
     parentItem = static_cast<TreeItem*>(parent.internalPointer());
 
-  Q_ASSERT_X(parentItem != nullptr, "PacketItemModel::index", "pointer to parent is null. This must never happen");
+  if (parentItem == nullptr)
+    return QModelIndex();
 
   TreeItem *childItem = parentItem->childItems.value(row, nullptr);
   if (childItem)
@@ -1009,7 +1097,7 @@ QModelIndex PacketItemModel::index(int row, int column, const QModelIndex &paren
 
 QModelIndex PacketItemModel::parent(const QModelIndex &index) const
 {
-  if (!index.isValid())
+  if (!index.isValid() || isPacketIndex(index))
     return QModelIndex();
 
   TreeItem *childItem = static_cast<TreeItem*>(index.internalPointer());
@@ -1018,6 +1106,10 @@ QModelIndex PacketItemModel::parent(const QModelIndex &index) const
   if (parentItem == rootItem.data())
     return QModelIndex();
 
+  // The root of the syntax tree of a packet is represented by the packet index
+  if (packetTreeRows.contains(parentItem))
+    return createIndex(packetTreeRows.value(parentItem), 0, nullptr);
+
   // Get the row of the item in the list of children of the parent item
   int row = 0;
   if (parentItem)
@@ -1034,12 +1126,100 @@ int PacketItemModel::rowCount(const QModelIndex &parent) const
   if (!parent.isValid())
   {
     TreeItem *p = rootItem.data();
-    return (p == nullptr) ? 0 : nrShowChildItems;
+    return (p == nullptr && !packetMode) ? 0 : nrShowChildItems;
+  }
+  if (isPacketIndex(parent))
+  {
+    // Only if the packet was expanded (fetchMore) we know its children.
+    TreeItem *tree = packetTrees.value(parent.row(), nullptr);
+    return (tree == nullptr) ? 0 : tree->childItems.count();
   }
   TreeItem *p = static_cast<TreeItem*>(parent.internalPointer());
   return (p == nullptr) ? 0 : p->childItems.count();
 }
 
+bool PacketItemModel::hasChildren(const QModelIndex &parent) const
+{
+  // We don't know how many children a packet has before it is parsed again. Always show it as expandable.
+  if (isPacketIndex(parent))
+    return !packetTrees.contains(parent.row()) || packetTrees.value(parent.row())->childItems.count() > 0;
+  return QAbstractItemModel::hasChildren(parent);
+}
+
+bool PacketItemModel::canFetchMore(const QModelIndex &parent) const
+{
+  return isPacketIndex(parent) && packetParser && !packetTrees.contains(parent.row());
+}
+
+void PacketItemModel::fetchMore(const QModelIndex &parent)
+{
+  if (!canFetchMore(parent))
+    return;
+
+  const int row = parent.row();
+  const packetRecord record = getPacketRecord(row);
+  TreeItem *tree = packetParser(row);
+  if (tree == nullptr)
+  {
+    tree = new TreeItem(record.name, nullptr);
+    reader_helper::addErrorMessageChildItem("The packet could not be parsed again.", tree);
+  }
+  tree->parentItem = nullptr;
+  tree->setStreamIndex(record.streamIndex);
+
+  if (tree->childItems.isEmpty())
+  {
+    packetTrees.insert(row, tree);
+    packetTreeRows.insert(tree, row);
+    return;
+  }
+  beginInsertRows(parent, 0, tree->childItems.count() - 1);
+  packetTrees.insert(row, tree);
+  packetTreeRows.insert(tree, row);
+  endInsertRows();
+}
+
+void PacketItemModel::enablePacketMode(packetParserFunction parserFunction)
+{
+  Q_ASSERT_X(getNumberFirstLevelChildren() == 0, "PacketItemModel::enablePacketMode", "The packet mode must be enabled before adding items.");
+  packetMode = true;
+  packetParser = parserFunction;
+}
+
+void PacketItemModel::addPacketRecord(const packetRecord &record)
+{
+  QMutexLocker lock(&packetRecordsMutex);
+  packetRecords.append(record);
+}
+
+int PacketItemModel::getNumberPacketRecords() const
+{
+  QMutexLocker lock(&packetRecordsMutex);
+  return packetRecords.size();
+}
+
+PacketItemModel::packetRecord PacketItemModel::getPacketRecord(int row) const
+{
+  QMutexLocker lock(&packetRecordsMutex);
+  return packetRecords.value(row);
+}
+
+int PacketItemModel::getStreamIndex(const QModelIndex &index) const
+{
+  if (!index.isValid())
+    return -1;
+  if (isPacketIndex(index))
+    return getPacketRecord(index.row()).streamIndex;
+  return static_cast<TreeItem*>(index.internalPointer())->getStreamIndex();
+}
+
+unsigned int PacketItemModel::getNumberFirstLevelChildren() const
+{
+  if (packetMode)
+    return getNumberPacketRecords();
+  return rootItem.isNull() ? 0 : rootItem->childItems.size();
+}
+
 void PacketItemModel::updateNumberModelItems()
 {
   auto n = getNumberFirstLevelChildren();
@@ -1224,6 +1404,12 @@ void BitrateItemModel::addBitratePoint(int streamIndex, bitrateEntry &entry)
   bitratePerStreamData[streamIndex].insert(insertIterator, entry);
 }
 
+QMap<unsigned int, QList<BitrateItemModel::bitrateEntry>> BitrateItemModel::getBitratePerStreamData() const
+{
+  QMutexLocker locker(&this->bitratePerStreamDataMutex);
+  return this->bitratePerStreamData;
+}
+
 void BitrateItemModel::setBitrateSortingIndex(int index)
 {
   if (index == 1)
@@ -1276,28 +1462,19 @@ bool FilterByStreamIndexProxyModel::filterAcceptsRow(int row, const QModelIndex
     return true;
   }
 
-  TreeItem *parentItem;
-  if (!sourceParent.isValid())
+  PacketItemModel *p = static_cast<PacketItemModel*>(sourceModel());
+  if (p == nullptr)
   {
-    // Get the root item
-    QAbstractItemModel *s = sourceModel();
-    PacketItemModel *p = static_cast<PacketItemModel*>(s);
-    if (p == nullptr)
-    {
-      DEBUG_FILTER("FilterByStreamIndexProxyModel::filterAcceptsRow Unable to get root item");  
-      return false;
-    }
-    parentItem = p->getRootItem();
+    DEBUG_FILTER("FilterByStreamIndexProxyModel::filterAcceptsRow Unable to get source model");  
+    return false;
   }
-  else
-    parentItem = static_cast<TreeItem*>(sourceParent.internalPointer());
-  Q_ASSERT_X(parentItem != nullptr, "PacketItemModel::index", "pointer to parent is null. This must never happen");
 
-  TreeItem *childItem = parentItem->childItems.value(row, nullptr);
-  if (childItem != nullptr)
+  const QModelIndex index = p->index(row, 0, sourceParent);
+  if (index.isValid())
   {
-    DEBUG_FILTER("FilterByStreamIndexProxyModel::filterAcceptsRow item %d", childItem->getStreamIndex());
-    return childItem->getStreamIndex() == streamIndex || childItem->getStreamIndex() == -1;
+    const int itemStreamIndex = p->getStreamIndex(index);
+    DEBUG_FILTER("FilterByStreamIndexProxyModel::filterAcceptsRow item %d", itemStreamIndex);
+    return itemStreamIndex == streamIndex || itemStreamIndex == -1;
   }
 
   DEBUG_FILTER("FilterByStreamIndexProxyModel::filterAcceptsRow item null -> reject");
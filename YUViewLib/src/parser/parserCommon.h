@@ -34,13 +34,16 @@
 #ifndef PARSERCOMMON_H
 #define PARSERCOMMON_H
 
+#include <functional>
 #include <QBrush>
 #include <QByteArray>
+#include <QHash>
 #include <QList>
 #include <QMap>
 #include <QMutex>
 #include <QSortFilterProxyModel>
 #include <QString>
+#include <QVector>
 
 #include "common/typedef.h"
 
@@ -58,22 +61,24 @@ namespace parserCommon
     
     void set_input(const QByteArray &inArr, unsigned int inArrOffset = 0) { byteArray = inArr; posInBuffer_bytes = inArrOffset; initialPosInBuffer = inArrOffset; }
     
-    // Read the given number of bits and return as integer. If bitsRead is true, the bits that were read are returned as a QString.
-    unsigned int readBits(int nrBits, QString &bitsRead);
-    uint64_t     readBits64(int nrBits, QString &bitsRead);
+    // Read the given number of bits and return as integer. If bitsRead is given, the bits that were read are appended to it
+    // as a string of '0' and '1'. Without bitsRead, no strings are created at all (this is what the parsers use if they don't
+    // log the syntax elements to a tree).
+    unsigned int readBits(int nrBits, QString *bitsRead = nullptr);
+    uint64_t     readBits64(int nrBits, QString *bitsRead = nullptr);
     QByteArray   readBytes(int nrBytes);
     // Read an UE(v) code from the array. If given, increase bit_count with every bit read.
-    unsigned int readUE_V(QString &bitsRead, int &bit_count);
+    unsigned int readUE_V(int &bit_count, QString *bitsRead = nullptr);
     // Read an SE(v) code from the array
-    int readSE_V(QString &bitsRead, int &bit_count);
+    int readSE_V(int &bit_count, QString *bitsRead = nullptr);
     // Read an leb128 code from the array (as defined in AV1)
-    uint64_t readLeb128(QString &bitsRead, int &bit_count);
+    uint64_t readLeb128(int &bit_count, QString *bitsRead = nullptr);
     // REad an uvlc code from the array (as defined in AV1)
-    uint64_t readUVLC(QString &bitsRead, int &bit_count);
+    uint64_t readUVLC(int &bit_count, QString *bitsRead = nullptr);
     // Read a NS code from the array (as defined in AV1)
-    int readNS(int maxVal, QString &bitsRead, int &bit_count);
+    int readNS(int maxVal, int &bit_count, QString *bitsRead = nullptr);
     // Read a SU code from the array (as defined in AV1)
-    int readSU(int nrBits, QString &bitsRead);
+    int readSU(int nrBits, QString *bitsRead = nullptr);
 
     // Is there more RBSP data or are we at the end?
     bool more_rbsp_data();
@@ -95,6 +100,12 @@ namespace parserCommon
     // This function is just used by the internal reading functions.
     bool gotoNextByte();
 
+    // Read 1 to 32 bits. If possible, the bits are extracted from a 64 bit word that is loaded at the current
+    // position with a shift and a mask. Only if there is an emulation prevention byte candidate in the bytes
+    // or if we are close to the end of the buffer, the bits are read byte by byte.
+    unsigned int readBitsFast(int nrBits);
+    unsigned int readBitsBytewise(int nrBits);
+
     unsigned int posInBuffer_bytes   {0}; // The byte position in the buffer
     unsigned int posInBuffer_bits    {0}; // The sub byte (bit) position in the buffer (0...7)
     unsigned int numEmuPrevZeroBytes {0}; // The number of emulation prevention three bytes that were found
@@ -206,6 +217,10 @@ namespace parserCommon
     void logValue(QString value, QString valueName, QString meaning = "");
     void logInfo(QString info);
 
+    // Are the read syntax elements logged to a tree? If not, no strings or tree items are created while reading. The
+    // reading macros (parserCommonMacros.h) also skip evaluating the names and meanings in this case.
+    bool isLogging() const { return currentTreeLevel != nullptr; }
+
     bool addErrorMessageChildItem(QString msg) { return addErrorMessageChildItem(msg, currentTreeLevel); }
     static bool addErrorMessageChildItem(QString msg, TreeItem *item);
 
@@ -235,14 +250,17 @@ namespace parserCommon
         }
     }
     */
-    bool readBits_catch(unsigned int &into, int numBits, QString &code);
-    bool readBits64_catch(uint64_t &into, int numBits, QString &code);
-    bool readUEV_catch(unsigned int &into, int &bit_count, QString &code);
-    bool readSEV_catch(int &into, int &bit_count, QString &code);
-    bool readLeb128_catch(uint64_t &into, int &bit_count, QString &code);
-    bool readUVLC_catch(uint64_t &into, int &bit_count, QString &code);
-    bool readNS_catch(int &into, int maxVal, int &bit_count, QString &code);
-    bool readSU_catch(int &into, int numBits, QString &code);
+    bool readBits_catch(unsigned int &into, int numBits, QString *code);
+    bool readBits64_catch(uint64_t &into, int numBits, QString *code);
+    bool readUEV_catch(unsigned int &into, int &bit_count, QString *code);
+    bool readSEV_catch(int &into, int &bit_count, QString *code);
+    bool readLeb128_catch(uint64_t &into, int &bit_count, QString *code);
+    bool readUVLC_catch(uint64_t &into, int &bit_count, QString *code);
+    bool readNS_catch(int &into, int maxVal, int &bit_count, QString *code);
+    bool readSU_catch(int &into, int numBits, QString *code);
+
+    // The code string to pass to the sub_byte_reader. Only if we are logging, the read bits are written to code.
+    QString *codeIfLogging(QString &code) { return currentTreeLevel ? &code : nullptr; }
 
     QString getMeaningValue(QStringList &meanings, unsigned int val);
     QString getMeaningValue(QMap<int,QString> &meanings, int val);
@@ -275,12 +293,42 @@ namespace parserCommon
     virtual QModelIndex parent(const QModelIndex &index) const Q_DECL_OVERRIDE;
     virtual int rowCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
     virtual int columnCount(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE { Q_UNUSED(parent); return 5; }
+    virtual bool hasChildren(const QModelIndex &parent = QModelIndex()) const Q_DECL_OVERRIDE;
+    virtual bool canFetchMore(const QModelIndex &parent) const Q_DECL_OVERRIDE;
+    virtual void fetchMore(const QModelIndex &parent) Q_DECL_OVERRIDE;
 
     // The root of the tree
     QScopedPointer<TreeItem> rootItem;
     TreeItem *getRootItem() { return rootItem.data(); }
     bool isNull() { return rootItem.isNull(); }
 
+    // In the packet mode, the model does not keep the syntax tree of all first level items (packets / NAL units).
+    // Only a compact record is kept for each packet. When a packet is expanded in the view, its syntax tree is parsed
+    // again using the packet parser function. So the packets of a whole file can be shown without running out of memory.
+    struct packetRecord
+    {
+      QString name;
+      QUint64Pair fileStartEndPos;
+      int packetID {-1};
+      int streamIndex {-1};
+      bool isParameterSet {false};
+      QString parameterSetKey;  //< A later parameter set with the same key (type and ID) replaces this one
+      bool isRandomAccess {false};
+      bool error {false};
+    };
+    // Parse the packet with the given row again and return the root of its syntax tree (or nullptr if parsing failed).
+    // This is called from the main thread.
+    typedef std::function<TreeItem*(int row)> packetParserFunction;
+    void enablePacketMode(packetParserFunction parserFunction);
+    bool isPacketMode() const { return packetMode; }
+    // Add a packet (this can be called from a background thread)
+    void addPacketRecord(const packetRecord &record);
+    int getNumberPacketRecords() const;
+    packetRecord getPacketRecord(int row) const;
+
+    // Get the stream index of the item with the given index
+    int getStreamIndex(const QModelIndex &index) const;
+
     void setUseColorCoding(bool colorCoding);
     void setShowVideoStreamOnly(bool showVideoOnly);
 
@@ -291,7 +339,18 @@ namespace parserCommon
     // about them. The bitstream analysis window will then update this count and the view to show the new items.
     unsigned int nrShowChildItems {0};
 
-    unsigned int getNumberFirstLevelChildren() { return rootItem.isNull() ? 0 : rootItem->childItems.size(); }
+    unsigned int getNumberFirstLevelChildren() const;
+
+    // In the packet mode, the first level items have no TreeItem (the internal pointer of their index is null).
+    bool isPacketIndex(const QModelIndex &index) const { return packetMode && index.isValid() && index.internalPointer() == nullptr; }
+
+    bool packetMode {false};
+    packetParserFunction packetParser;
+    QVector<packetRecord> packetRecords;
+    QMutex mutable packetRecordsMutex;
+    // The syntax trees of the packets that were expanded (by row). These are not children of the rootItem.
+    QHash<int, TreeItem*> packetTrees;
+    QHash<TreeItem*, int> packetTreeRows;
 
     static QList<QColor> streamIndexColors;
     bool useColorCoding { true };
@@ -347,6 +406,9 @@ namespace parserCommon
     void addBitratePoint(int streamIndex, bitrateEntry &entry);
     void setBitrateSortingIndex(int index);
 
+    // Get a copy of the bitrate points of all streams (sorted by the current sorting index)
+    QMap<unsigned int, QList<bitrateEntry>> getBitratePerStreamData() const;
+
   private:
     // The current number of bitrate points that we show.
     // The background parser will add more data to "bitrateData" and periodically update the model
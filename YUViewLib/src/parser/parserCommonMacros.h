@@ -30,35 +30,38 @@
 *   along with this program. If not, see <http://www.gnu.org/licenses/>.
 */
 
-#define READBITS(into,numBits) do { if (!reader.readBits(numBits, into, #into)) return false; } while(0)
-#define READBITS_M(into,numBits,meanings) do { if (!reader.readBits(numBits, into, #into, meanings)) return false; } while(0)
-#define READBITS_M_E(into,numBits,meanings,type) do { unsigned int val; if (!reader.readBits(numBits, val, #into, meanings)) return false; into = (type)val; } while (0)
-#define READBITS_A(into,numBits,idx) do { if (!reader.readBits(numBits, into, #into, idx)) return false; } while(0)
-#define READBITS_A_M(into,numBits,idx,meanings) do { if (!reader.readBits(numBits, into, #into, idx, meanings)) return false; } while(0)
-#define READZEROBITS(numBits,name) do { if (!reader.readZeroBits(numBits, name)) return false; } while(0)
+// If the reader does not log to a tree (reader.isLogging() is false), the name strings and the meanings of the syntax
+// elements are not evaluated. So no strings are created when a file is only scanned (e.g. for the POC and random access
+// points) and the reading compiles down to the bit reading of the sub_byte_reader.
+#define READBITS(into,numBits) do { if (!(reader.isLogging() ? reader.readBits(numBits, into, #into) : reader.readBits(numBits, into, QString()))) return false; } while(0)
+#define READBITS_M(into,numBits,meanings) do { if (!(reader.isLogging() ? reader.readBits(numBits, into, #into, meanings) : reader.readBits(numBits, into, QString()))) return false; } while(0)
+#define READBITS_M_E(into,numBits,meanings,type) do { unsigned int val; if (!(reader.isLogging() ? reader.readBits(numBits, val, #into, meanings) : reader.readBits(numBits, val, QString()))) return false; into = (type)val; } while (0)
+#define READBITS_A(into,numBits,idx) do { if (!(reader.isLogging() ? reader.readBits(numBits, into, #into, idx) : reader.readBits(numBits, into, QString(), idx))) return false; } while(0)
+#define READBITS_A_M(into,numBits,idx,meanings) do { if (!(reader.isLogging() ? reader.readBits(numBits, into, #into, idx, meanings) : reader.readBits(numBits, into, QString(), idx))) return false; } while(0)
+#define READZEROBITS(numBits,name) do { if (!reader.readZeroBits(numBits, reader.isLogging() ? QString(name) : QString())) return false; } while(0)
 #define IGNOREBITS(numBits) do { if (!reader.ignoreBits(numBits)) return false; } while(0)
 
-#define READFLAG(into) do { if (!reader.readFlag(into, #into)) return false; } while(0)
-#define READFLAG_M(into,meanings) do { if (!reader.readFlag(into, #into, meanings)) return false; } while(0)
-#define READFLAG_A(into,idx) do { if (!reader.readFlag(into, #into, idx)) return false; } while(0)
-#define READFLAG_A_M(into,idx,meanings) do { if (!reader.readFlag(into, #into, idx, meanings)) return false; } while(0)
+#define READFLAG(into) do { if (!(reader.isLogging() ? reader.readFlag(into, #into) : reader.readFlag(into, QString()))) return false; } while(0)
+#define READFLAG_M(into,meanings) do { if (!(reader.isLogging() ? reader.readFlag(into, #into, meanings) : reader.readFlag(into, QString()))) return false; } while(0)
+#define READFLAG_A(into,idx) do { if (!(reader.isLogging() ? reader.readFlag(into, #into, idx) : reader.readFlag(into, QString(), idx))) return false; } while(0)
+#define READFLAG_A_M(into,idx,meanings) do { if (!(reader.isLogging() ? reader.readFlag(into, #into, idx, meanings) : reader.readFlag(into, QString(), idx))) return false; } while(0)
 
-#define READUEV(into) do { if (!reader.readUEV(into, #into)) return false; } while(0)
-#define READUEV_M(into,meanings) do { if (!reader.readUEV(into, #into, meanings)) return false; } while(0)
-#define READUEV_A(into,idx) do { if (!reader.readUEV(into, #into, idx)) return false; } while(0)
-#define READUEV_A_M(into,idx,meanings) do { if (!reader.readUEV(into, #into, idx, meanings)) return false; } while(0)
+#define READUEV(into) do { if (!(reader.isLogging() ? reader.readUEV(into, #into) : reader.readUEV(into, QString()))) return false; } while(0)
+#define READUEV_M(into,meanings) do { if (!(reader.isLogging() ? reader.readUEV(into, #into, meanings) : reader.readUEV(into, QString()))) return false; } while(0)
+#define READUEV_A(into,idx) do { if (!(reader.isLogging() ? reader.readUEV(into, #into, idx) : reader.readUEV(into, QString(), idx))) return false; } while(0)
+#define READUEV_A_M(into,idx,meanings) do { if (!(reader.isLogging() ? reader.readUEV(into, #into, idx, meanings) : reader.readUEV(into, QString(), idx))) return false; } while(0)
 
-#define READSEV(into) do { if (!reader.readSEV(into, #into)) return false; } while(0)
-#define READSEV_A(into,idx) do { if (!reader.readSEV(into, #into, idx)) return false; } while(0)
-#define READUEV_APP(into) do { if (!reader.readSEV(into, #into, -1)) return false; } while(0)
+#define READSEV(into) do { if (!(reader.isLogging() ? reader.readSEV(into, #into) : reader.readSEV(into, QString()))) return false; } while(0)
+#define READSEV_A(into,idx) do { if (!(reader.isLogging() ? reader.readSEV(into, #into, idx) : reader.readSEV(into, QString(), idx))) return false; } while(0)
+#define READUEV_APP(into) do { if (!(reader.isLogging() ? reader.readSEV(into, #into, -1) : reader.readSEV(into, QString(), -1))) return false; } while(0)
 
-#define READLEB128(into) do { if (!reader.readLeb128(into, #into)) return false; } while(0)
-#define READUVLC(into) do { if (!reader.readUVLC(into, #into)) return false; } while (0)
-#define READNS(into,maxValue) do { if (!reader.readNS(into, #into, maxValue)) return false; } while (0) 
-#define READSU(into,numBits) do { if (!reader.readSU(into, #into, numBits)) return false; } while (0)
+#define READLEB128(into) do { if (!(reader.isLogging() ? reader.readLeb128(into, #into) : reader.readLeb128(into, QString()))) return false; } while(0)
+#define READUVLC(into) do { if (!(reader.isLogging() ? reader.readUVLC(into, #into) : reader.readUVLC(into, QString()))) return false; } while (0)
+#define READNS(into,maxValue) do { if (!(reader.isLogging() ? reader.readNS(into, #into, maxValue) : reader.readNS(into, QString(), maxValue))) return false; } while (0) 
+#define READSU(into,numBits) do { if (!(reader.isLogging() ? reader.readSU(into, #into, numBits) : reader.readSU(into, QString(), numBits))) return false; } while (0)
 
-#define LOGVAL(val) reader.logValue(val, #val)
-#define LOGVAL_M(val,meaning) reader.logValue(val, #val, meaning)
-#define LOGSTRVAL(name,val) reader.logValue(val, name)
-#define LOGPARAM(name,val,coding,code,meaning) reader.logValue(val, name, coding, code, meaning)
-#define LOGINFO(info) reader.logInfo(info)
\ No newline at end of file
+#define LOGVAL(val) do { if (reader.isLogging()) reader.logValue(val, #val); } while(0)
+#define LOGVAL_M(val,meaning) do { if (reader.isLogging()) reader.logValue(val, #val, meaning); } while(0)
+#define LOGSTRVAL(name,val) do { if (reader.isLogging()) reader.logValue(val, name); } while(0)
+#define LOGPARAM(name,val,coding,code,meaning) do { if (reader.isLogging()) reader.logValue(val, name, coding, code, meaning); } while(0)
+#define LOGINFO(info) do { if (reader.isLogging()) reader.logInfo(info); } while(0)
@@ -34,8 +34,10 @@
 #define PLAYLISTITEM_H
 
 #include <QDir>
+#include <QImage>
 #include <QTreeWidgetItem>
 #include "common/fileInfo.h"
+#include "common/rawDataView.h"
 #include "common/saveUi.h"
 #include "common/typedef.h"
 #include "common/YUViewDomElement.h"
@@ -185,7 +187,9 @@ public:
   void tagItemForDeletion() { itemTaggedForDeletion = true; }
   // Cache the given frame. This function is thread save. So multiple instances of this function can run at the same time.
   // In test mode, we don't check if the frame is already cached and don't cache it. We just convert it and return.
-  virtual void cacheFrame(int idx, bool testMode) { Q_UNUSED(idx); Q_UNUSED(testMode); }
+  // Return the number of frames that were produced (loaded/decoded and converted). This can be 0 if the frame was already
+  // cached or if another thread will produce it, or more than 1 if several frames were decoded at once.
+  virtual int cacheFrame(int idx, bool testMode) { Q_UNUSED(idx); Q_UNUSED(testMode); return 0; }
   // Get a list of all cached frames (just the frame indices)
   virtual QList<int> getCachedFrames() const { return QList<int>(); }
   virtual int getNumberCachedFrames() const { return 0; }
@@ -195,6 +199,17 @@ public:
   virtual void removeFrameFromCache(int idx) { Q_UNUSED(idx); }
   virtual void removeAllFramesFromCache() {};
 
+  // ----- Pulling frames -----
+  // Get the raw data (or the image) of the given frame (internal frame index) and return it to the caller. In contrast to
+  // the signalRequestRawData/signalRequestFrame handoff of the videoHandler, no shared buffer is used and no state is changed.
+  // So these functions can be called from several threads at the same time (e.g. by all caching threads for this item).
+  // Items that can not do this (like a decoder that must decode the frames in order) return false in canPull...().
+  // caching is set if the raw data is requested by a caching thread (and not for drawing the frame).
+  virtual bool canPullRawFrameData() const { return false; }
+  virtual rawDataView pullRawFrameData(int frameIdxInternal, bool caching) { Q_UNUSED(frameIdxInternal); Q_UNUSED(caching); return rawDataView(); }
+  virtual bool canPullFrameImage() const { return false; }
+  virtual QImage pullFrameImage(int frameIdxInternal) { Q_UNUSED(frameIdxInternal); return QImage(); }
+
   // ----- Detection of source/file change events -----
 
   // Returns if the items source (usually a file) was changed by another process. This means that the playlistItem
@@ -234,6 +249,10 @@ signals:
   // The item finished loading a frame into the double buffer. This is relevant if playback is paused and waiting
   // for the item to load the next frame into the double buffer. This will restart the timer. 
   void signalItemDoubleBufferLoaded();
+
+  // The item requests that the playback jumps to the given frame (e.g. the next frame where the inputs of a difference
+  // item differ). This is only done if the item is currently selected.
+  void signalItemJumpToFrame(int frameIdx);
   
 protected:
 
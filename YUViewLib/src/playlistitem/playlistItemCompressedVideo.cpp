@@ -36,6 +36,7 @@
 #include <QInputDialog>
 #include <QPlainTextEdit>
 
+#include <algorithm>
 #include <inttypes.h>
 
 #include "common/functions.h"
@@ -495,18 +496,9 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
     bool seek = (frameIdxInternal < curFrameIdx);
 
     // Get the closest possible seek position
-    int seekToFrame = -1;
     int seekToAnnexBFrameCount = -1;
     int seekToDTS = -1;
-    if (isInputFormatTypeAnnexB(inputFormatType))
-      seekToFrame = inputFileAnnexBParser->getClosestSeekableFrameNumberBefore(frameIdxInternal, seekToAnnexBFrameCount);
-    else
-    {
-      if (caching)
-        seekToDTS = inputFileFFmpegCaching->getClosestSeekableDTSBefore(frameIdxInternal, seekToFrame);
-      else
-        seekToDTS = inputFileFFmpegLoading->getClosestSeekableDTSBefore(frameIdxInternal, seekToFrame);
-    }
+    int seekToFrame = getRandomAccessPointBefore(frameIdxInternal, seekToAnnexBFrameCount, seekToDTS);
 
     if (curFrameIdx == -1 || seekToFrame > curFrameIdx + FORWARD_SEEK_THRESHOLD)
     {
@@ -530,63 +522,16 @@ void playlistItemCompressedVideo::loadRawData(int frameIdxInternal, bool caching
     while (dec->needsMoreData())
     {
       DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData decoder needs more data");
-      if (isInputFormatTypeFFmpeg(inputFormatType) && decoderEngineType == decoderEngineFFMpeg)
+      fileSourceAnnexBFile *annexBFile = caching ? inputFileAnnexBCaching.data() : inputFileAnnexBLoading.data();
+      fileSourceFFmpegFile *ffmpegFile = caching ? inputFileFFmpegCaching.data() : inputFileFFmpegLoading.data();
+      if (!pushNextDataToDecoder(dec, annexBFile, ffmpegFile, readAnnexBFrameCounterCodingOrder, repushData))
       {
-        // In this scenario, we can read and push AVPackets
-        // from the FFmpeg file and pass them to the FFmpeg decoder directly.
-        AVPacketWrapper pkt = caching ? inputFileFFmpegCaching->getNextPacket(repushData) : inputFileFFmpegLoading->getNextPacket(repushData);
-        repushData = false;
-        if (pkt)
-          DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData retrived packet PTS %" PRId64 "", pkt.get_pts());
-        else
-          DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData retrived empty packet");
-        decoderFFmpeg *ffmpegDec = (caching ? dynamic_cast<decoderFFmpeg*>(cachingDecoder.data()) : dynamic_cast<decoderFFmpeg*>(loadingDecoder.data()));
-        if (!ffmpegDec->pushAVPacket(pkt))
-        {
-          if (!ffmpegDec->decodeFrames())
-            // The decoder did not switch to decoding frame mode. Error.
-            return;
-          repushData = true;
-        }
+        if (isInputFormatTypeFFmpeg(inputFormatType))
+          // The decoder did not switch to decoding frame mode. Error.
+          return;
+        decodingNotPossibleAfter = frameIdxInternal;
+        break;
       }
-      else if (isInputFormatTypeAnnexB(inputFormatType) && decoderEngineType == decoderEngineFFMpeg)
-      {
-        // We are reading from a raw annexB file and use ffmpeg for decoding
-        // Get the data of the next frame (which might be multiple NAL units)
-        QUint64Pair frameStartEndFilePos = inputFileAnnexBParser->getFrameStartEndPos(readAnnexBFrameCounterCodingOrder);
-        QByteArray data;
-        if (frameStartEndFilePos != QUint64Pair(-1, -1))
-          data = caching ? inputFileAnnexBCaching->getFrameData(frameStartEndFilePos) : inputFileAnnexBLoading->getFrameData(frameStartEndFilePos);
-        DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData retrived frame data from file - AnnexBCnt %d startEnd %lu-%lu - size %d", readAnnexBFrameCounterCodingOrder, frameStartEndFilePos.first, frameStartEndFilePos.second, data.size());
-        if (!dec->pushData(data))
-        {
-          if (!dec->decodeFrames())
-          {
-            DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData The decoder did not switch to decoding frame mode. Error.");
-            decodingNotPossibleAfter = frameIdxInternal;
-            break;
-          }
-          // Pushing the data failed because the ffmpeg decoder wants us to read frames first.
-          // Don't increase readAnnexBFrameCounterCodingOrder so that we will push the same data again.
-        }
-        else
-          readAnnexBFrameCounterCodingOrder++;
-      }
-      else if (isInputFormatTypeAnnexB(inputFormatType) && decoderEngineType != decoderEngineFFMpeg)
-      {
-        QByteArray data = caching ? inputFileAnnexBCaching->getNextNALUnit(repushData) : inputFileAnnexBLoading->getNextNALUnit(repushData);
-        DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData retrived nal unit from file - size %d", data.size());
-        repushData = !dec->pushData(data);
-      }
-      else if (isInputFormatTypeFFmpeg(inputFormatType) && decoderEngineType != decoderEngineFFMpeg)
-      {
-        // Get the next unit (NAL or OBU) form ffmepg and push it to the decoder
-        QByteArray data = caching ? inputFileFFmpegCaching->getNextUnit(repushData) : inputFileFFmpegLoading->getNextUnit(repushData);
-        DEBUG_COMPRESSED("playlistItemCompressedVideo::loadYUVData retrived nal unit from file - size %d", data.size());
-        repushData = !dec->pushData(data);
-      }
-      else
-        assert(false);
     }
 
     if (dec->decodeFrames())
@@ -643,10 +588,26 @@ void playlistItemCompressedVideo::seekToPosition(int seekToFrame, int seekToDTS,
 {
   // Do the seek
   decoderBase *dec = caching ? cachingDecoder.data() : loadingDecoder.data();
-  dec->resetDecoder();
   repushData = false;
   decodingNotPossibleAfter = -1;
 
+  fileSourceAnnexBFile *annexBFile = caching ? inputFileAnnexBCaching.data() : inputFileAnnexBLoading.data();
+  fileSourceFFmpegFile *ffmpegFile = caching ? inputFileFFmpegCaching.data() : inputFileFFmpegLoading.data();
+  if (!seekDecoder(dec, annexBFile, ffmpegFile, seekToFrame, seekToDTS))
+  {
+    setDecodingError("Error when seeking in file.");
+    return;
+  }
+  if (caching)
+    currentFrameIdx[1] = seekToFrame - 1;
+  else
+    currentFrameIdx[0] = seekToFrame - 1;
+}
+
+bool playlistItemCompressedVideo::seekDecoder(decoderBase *dec, fileSourceAnnexBFile *annexBFile, fileSourceFFmpegFile *ffmpegFile, int seekToFrame, int seekToDTS)
+{
+  dec->resetDecoder();
+
   // Retrieval of the raw metadata is only required if the the reader or the decoder is not ffmpeg
   const bool bothFFmpeg = (!isInputFormatTypeAnnexB(inputFormatType) && decoderEngineType == decoderEngineFFMpeg);
   const bool decFFmpeg = (decoderEngineType == decoderEngineFFMpeg);
@@ -657,21 +618,15 @@ void playlistItemCompressedVideo::seekToPosition(int seekToFrame, int seekToDTS,
     uint64_t filePos = 0;
     if (!bothFFmpeg)
       parametersets = inputFileAnnexBParser->getSeekFrameParamerSets(seekToFrame, filePos);
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::seekToPosition seeking annexB file to filePos %" PRIu64 "", filePos);
-    if (caching)
-      inputFileAnnexBCaching->seek(filePos);
-    else
-      inputFileAnnexBLoading->seek(filePos);
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::seekDecoder seeking annexB file to filePos %" PRIu64 "", filePos);
+    annexBFile->seek(filePos);
   }
   else
   {
     if (!bothFFmpeg)
-      parametersets = caching ? inputFileFFmpegCaching->getParameterSets() : inputFileFFmpegLoading->getParameterSets();
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::seekToPosition seeking ffmpeg file to pts %d", seekToDTS);
-    if (caching)
-      inputFileFFmpegCaching->seekToDTS(seekToDTS);
-    else
-      inputFileFFmpegLoading->seekToDTS(seekToDTS);
+      parametersets = ffmpegFile->getParameterSets();
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::seekDecoder seeking ffmpeg file to pts %d", seekToDTS);
+    ffmpegFile->seekToDTS(seekToDTS);
   }
 
   // In case of using ffmpeg for decoding, we don't need to push the parameter sets (the
@@ -679,18 +634,83 @@ void playlistItemCompressedVideo::seekToPosition(int seekToFrame, int seekToDTS,
   if (!decFFmpeg)
   {
     // Push the parameter sets to the decoder
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::seekToPosition pushing parameter sets to decoder (nr %d)", parametersets.length());
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::seekDecoder pushing parameter sets to decoder (nr %d)", parametersets.length());
     for (QByteArray d : parametersets)
       if (!dec->pushData(d))
+        return false;
+  }
+  return true;
+}
+
+bool playlistItemCompressedVideo::pushNextDataToDecoder(decoderBase *dec, fileSourceAnnexBFile *annexBFile, fileSourceFFmpegFile *ffmpegFile, int &annexBFrameCounter, bool &repush)
+{
+  if (isInputFormatTypeFFmpeg(inputFormatType) && decoderEngineType == decoderEngineFFMpeg)
+  {
+    // In this scenario, we can read and push AVPackets
+    // from the FFmpeg file and pass them to the FFmpeg decoder directly.
+    AVPacketWrapper pkt = ffmpegFile->getNextPacket(repush);
+    repush = false;
+    if (pkt)
+      DEBUG_COMPRESSED("playlistItemCompressedVideo::pushNextDataToDecoder retrived packet PTS %" PRId64 "", pkt.get_pts());
+    else
+      DEBUG_COMPRESSED("playlistItemCompressedVideo::pushNextDataToDecoder retrived empty packet");
+    decoderFFmpeg *ffmpegDec = dynamic_cast<decoderFFmpeg*>(dec);
+    if (!ffmpegDec->pushAVPacket(pkt))
+    {
+      if (!ffmpegDec->decodeFrames())
+        // The decoder did not switch to decoding frame mode. Error.
+        return false;
+      repush = true;
+    }
+  }
+  else if (isInputFormatTypeAnnexB(inputFormatType) && decoderEngineType == decoderEngineFFMpeg)
+  {
+    // We are reading from a raw annexB file and use ffmpeg for decoding
+    // Get the data of the next frame (which might be multiple NAL units)
+    QUint64Pair frameStartEndFilePos = inputFileAnnexBParser->getFrameStartEndPos(annexBFrameCounter);
+    QByteArray data;
+    if (frameStartEndFilePos != QUint64Pair(-1, -1))
+      data = annexBFile->getFrameData(frameStartEndFilePos);
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::pushNextDataToDecoder retrived frame data from file - AnnexBCnt %d startEnd %lu-%lu - size %d", annexBFrameCounter, frameStartEndFilePos.first, frameStartEndFilePos.second, data.size());
+    if (!dec->pushData(data))
+    {
+      if (!dec->decodeFrames())
       {
-        setDecodingError("Error when seeking in file.");
-        return;
+        DEBUG_COMPRESSED("playlistItemCompressedVideo::pushNextDataToDecoder The decoder did not switch to decoding frame mode. Error.");
+        return false;
       }
+      // Pushing the data failed because the ffmpeg decoder wants us to read frames first.
+      // Don't increase annexBFrameCounter so that we will push the same data again.
+    }
+    else
+      annexBFrameCounter++;
+  }
+  else if (isInputFormatTypeAnnexB(inputFormatType) && decoderEngineType != decoderEngineFFMpeg)
+  {
+    QByteArray data = annexBFile->getNextNALUnit(repush);
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::pushNextDataToDecoder retrived nal unit from file - size %d", data.size());
+    repush = !dec->pushData(data);
+  }
+  else if (isInputFormatTypeFFmpeg(inputFormatType) && decoderEngineType != decoderEngineFFMpeg)
+  {
+    // Get the next unit (NAL or OBU) form ffmepg and push it to the decoder
+    QByteArray data = ffmpegFile->getNextUnit(repush);
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::pushNextDataToDecoder retrived nal unit from file - size %d", data.size());
+    repush = !dec->pushData(data);
   }
-  if (caching)
-    currentFrameIdx[1] = seekToFrame - 1;
   else
-    currentFrameIdx[0] = seekToFrame - 1;
+    assert(false);
+  return true;
+}
+
+int playlistItemCompressedVideo::getRandomAccessPointBefore(int frameIdxInternal, int &annexBFrameCount, int &dts) const
+{
+  int seekToFrame = -1;
+  if (isInputFormatTypeAnnexB(inputFormatType))
+    seekToFrame = inputFileAnnexBParser->getClosestSeekableFrameNumberBefore(frameIdxInternal, annexBFrameCount);
+  else
+    dts = inputFileFFmpegLoading->getClosestSeekableDTSBefore(frameIdxInternal, seekToFrame);
+  return seekToFrame;
 }
 
 void playlistItemCompressedVideo::createPropertiesWidget()
@@ -750,45 +770,54 @@ bool playlistItemCompressedVideo::allocateDecoder(int displayComponent)
   loadingDecoder.reset();
   cachingDecoder.reset();
 
+  DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder Initializing interactive decoder");
+  loadingDecoder.reset(createDecoder(displayComponent, false, inputFileFFmpegLoading.data()));
+  if (!loadingDecoder)
+  {
+    infoText = "No valid decoder was selected.";
+    decodingEnabled = false;
+    return false;
+  }
+  if (cachingEnabled)
+  {
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder Initializing caching decoder");
+    cachingDecoder.reset(createDecoder(displayComponent, true, inputFileFFmpegCaching.data()));
+  }
+  allocateParallelCachingDecoders();
+
+  decodingEnabled = !loadingDecoder->errorInDecoder();
+  if (!decodingEnabled)
+  {
+    infoText = "There was an error allocating the new decoder: \n";
+    infoText += loadingDecoder->decoderErrorString();
+    infoText += "\n";
+    return false;
+  }
+
+  return true;
+}
+
+decoderBase *playlistItemCompressedVideo::createDecoder(int displayComponent, bool cachingDecoder, fileSourceFFmpegFile *ffmpegFile)
+{
   if (decoderEngineType == decoderEngineLibde265)
   {
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder Initializing interactive libde265 decoder");
-    loadingDecoder.reset(new decoderLibde265(displayComponent));
-    if (cachingEnabled)
-    {
-      DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder Initializing caching libde265 decoder");
-      cachingDecoder.reset(new decoderLibde265(displayComponent, true));
-    }
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::createDecoder Initializing libde265 decoder");
+    return new decoderLibde265(displayComponent, cachingDecoder);
   }
   else if (decoderEngineType == decoderEngineHM)
   {
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder Initializing interactive HM decoder");
-    loadingDecoder.reset(new decoderHM(displayComponent));
-    if (cachingEnabled)
-    {
-      DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder caching interactive HM decoder");
-      cachingDecoder.reset(new decoderHM(displayComponent, true));
-    }
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::createDecoder Initializing HM decoder");
+    return new decoderHM(displayComponent, cachingDecoder);
   }
   else if (decoderEngineType == decoderEngineVTM)
   {
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder Initializing interactive VTM decoder");
-    loadingDecoder.reset(new decoderVTM(displayComponent));
-    if (cachingEnabled)
-    {
-      DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder caching interactive VTM decoder");
-      cachingDecoder.reset(new decoderVTM(displayComponent, true));
-    }
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::createDecoder Initializing VTM decoder");
+    return new decoderVTM(displayComponent, cachingDecoder);
   }
   else if (decoderEngineType == decoderEngineDav1d)
   {
-    DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder Initializing interactive dav1d decoder");
-    loadingDecoder.reset(new decoderDav1d(displayComponent));
-    if (cachingEnabled)
-    {
-      DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder caching interactive dav1d decoder");
-      cachingDecoder.reset(new decoderDav1d(displayComponent, true));
-    }
+    DEBUG_COMPRESSED("playlistItemCompressedVideo::createDecoder Initializing dav1d decoder");
+    return new decoderDav1d(displayComponent, cachingDecoder);
   }
   else if (decoderEngineType == decoderEngineFFMpeg)
   {
@@ -800,42 +829,56 @@ bool playlistItemCompressedVideo::allocateDecoder(int displayComponent)
       auto profileLevel = inputFileAnnexBParser->getProfileLevel();
       auto ratio = inputFileAnnexBParser->getSampleAspectRatio();
 
-      DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder Initializing interactive ffmpeg decoder from raw anexB stream. frameSize %dx%d extradata length %d yuvPixelFormat %s profile/level %d/%d, aspect raio %d/%d", frameSize.width(), frameSize.height(), extradata.length(), fmt.getName().toStdString().c_str(), profileLevel.first, profileLevel.second, ratio.first, ratio.second);
-      loadingDecoder.reset(new decoderFFmpeg(ffmpegCodec, frameSize, extradata, fmt, profileLevel, ratio));
-      if (cachingEnabled)
-      {
-        DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder Initializing caching ffmpeg decoder from raw anexB stream. Same settings.");
-        cachingDecoder.reset(new decoderFFmpeg(ffmpegCodec, frameSize, extradata, fmt, profileLevel, ratio, true));
-      }
+      DEBUG_COMPRESSED("playlistItemCompressedVideo::createDecoder Initializing ffmpeg decoder from raw anexB stream. frameSize %dx%d extradata length %d yuvPixelFormat %s profile/level %d/%d, aspect raio %d/%d", frameSize.width(), frameSize.height(), extradata.length(), fmt.getName().toStdString().c_str(), profileLevel.first, profileLevel.second, ratio.first, ratio.second);
+      return new decoderFFmpeg(ffmpegCodec, frameSize, extradata, fmt, profileLevel, ratio, cachingDecoder);
     }
     else
     {
-      DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder Initializing interactive ffmpeg decoder using ffmpeg as parser");
-      loadingDecoder.reset(new decoderFFmpeg(inputFileFFmpegLoading->getVideoCodecPar()));
-      if (cachingEnabled)
-      {
-        DEBUG_COMPRESSED("playlistItemCompressedVideo::allocateDecoder Initializing caching ffmpeg decoder using ffmpeg as parser");
-        cachingDecoder.reset(new decoderFFmpeg(inputFileFFmpegCaching->getVideoCodecPar()));
-      }
+      DEBUG_COMPRESSED("playlistItemCompressedVideo::createDecoder Initializing ffmpeg decoder using ffmpeg as parser");
+      return new decoderFFmpeg(ffmpegFile->getVideoCodecPar());
     }
   }
-  else
-  {
-    infoText = "No valid decoder was selected.";
-    decodingEnabled = false;
-    return false;
-  }
+  return nullptr;
+}
 
-  decodingEnabled = !loadingDecoder->errorInDecoder();
-  if (!decodingEnabled)
+void playlistItemCompressedVideo::allocateParallelCachingDecoders()
+{
+  QMutexLocker locker(&parallelCachingMutex);
+
+  // Drop all existing decoders. Decoders that are still in use by a caching thread are deleted when the thread is done.
+  parallelCachingDecoders.clear();
+  parallelCachingGeneration++;
+  parallelCachingRandomAccessPoints.clear();
+
+  QSettings settings;
+  parallelCachingSetting = settings.value("VideoCache/ParallelDecoding", false).toBool();
+  parallelCaching = parallelCachingSetting && cachingEnabled && cachingDecoder;
+  parallelCachingPoolSize = functions::getOptimalThreadCount();
+  if (!parallelCaching)
+    return;
+
+  for (int i = 0; i < parallelCachingPoolSize; i++)
   {
-    infoText = "There was an error allocating the new decoder: \n";
-    infoText += loadingDecoder->decoderErrorString();
-    infoText += "\n";
-    return false;
+    QSharedPointer<parallelCachingDecoder> ctx(new parallelCachingDecoder);
+    if (isInputFormatTypeAnnexB(inputFormatType))
+      ctx->annexBFile.reset(new fileSourceAnnexBFile(plItemNameOrFileName));
+    else
+    {
+      // Opening the file using the loading file will copy the list of key frames instead of scanning the file again
+      ctx->ffmpegFile.reset(new fileSourceFFmpegFile());
+      if (!ctx->ffmpegFile->openFile(plItemNameOrFileName, nullptr, inputFileFFmpegLoading.data()))
+        break;
+    }
+    ctx->decoder.reset(createDecoder(cachingDecoder->getDecodeSignal(), true, ctx->ffmpegFile.data()));
+    if (!ctx->decoder || ctx->decoder->errorInDecoder())
+      break;
+    parallelCachingDecoders.append(ctx);
   }
 
-  return true;
+  if (parallelCachingDecoders.isEmpty())
+    parallelCaching = false;
+  else
+    parallelCachingPoolSize = parallelCachingDecoders.size();
 }
 
 void playlistItemCompressedVideo::fillStatisticList()
@@ -936,15 +979,148 @@ void playlistItemCompressedVideo::reloadItemSource()
   loadRawData(0, false);
 }
 
-void playlistItemCompressedVideo::cacheFrame(int frameIdx, bool testMode)
+int playlistItemCompressedVideo::cacheFrame(int frameIdx, bool testMode)
 {
   if (!cachingEnabled)
-    return;
+    return 0;
 
   // Cache a certain frame. This is always called in a separate thread.
-  cachingMutex.lock();
-  video->cacheFrame(getFrameIdxInternal(frameIdx), testMode);
-  cachingMutex.unlock();
+  if (parallelCaching && !testMode)
+    return cacheFrameParallel(getFrameIdxInternal(frameIdx));
+
+  QMutexLocker locker(&cachingMutex);
+  return video->cacheFrame(getFrameIdxInternal(frameIdx), testMode);
+}
+
+int playlistItemCompressedVideo::cacheFrameParallel(int frameIdxInternal)
+{
+  if (video->isInCache(frameIdxInternal) || frameIdxInternal < 0 || frameIdxInternal > startEndFrame.second)
+    return 0;
+
+  QSharedPointer<parallelCachingDecoder> ctx;
+  int gopStart;
+  int gopEnd;
+  int generation;
+  {
+    QMutexLocker locker(&parallelCachingMutex);
+    if (parallelCachingRandomAccessPoints.isEmpty())
+    {
+      // Get all random access points once (in one pass over the key frames of the file)
+      const QList<int> randomAccessPoints = isInputFormatTypeAnnexB(inputFormatType) ? inputFileAnnexBParser->getRandomAccessFrames() : inputFileFFmpegLoading->getKeyFrames();
+      for (int rap : randomAccessPoints)
+        if (rap <= startEndFrame.second)
+          parallelCachingRandomAccessPoints.append(rap);
+      if (parallelCachingRandomAccessPoints.isEmpty())
+        return 0;
+    }
+
+    // Find the GOP that the frame belongs to
+    auto it = std::upper_bound(parallelCachingRandomAccessPoints.constBegin(), parallelCachingRandomAccessPoints.constEnd(), frameIdxInternal);
+    if (it == parallelCachingRandomAccessPoints.constBegin())
+      return 0;
+    gopStart = *(it - 1);
+    gopEnd = getNextRandomAccessPoint(gopStart);
+
+    // The video cache requests the frames in order. So usually, another thread is already decoding the GOP of the frame.
+    // It will put the frame into the cache when it gets there. This thread is done then and the video cache can use
+    // it to request the next frame (which may start the next GOP).
+    while (parallelCachingGOPs.contains(gopStart))
+    {
+      parallelCachingGOP &gop = parallelCachingGOPs[gopStart];
+      if (gop.decodedUpTo < frameIdxInternal)
+      {
+        gop.requestedFrames.insert(frameIdxInternal);
+        return 0;
+      }
+      // The decoder is already past the frame. Wait until it is done and decode the GOP again.
+      parallelCachingGOPDone.wait(&parallelCachingMutex);
+      if (video->isInCache(frameIdxInternal))
+        return 0;
+    }
+
+    if (parallelCachingDecoders.isEmpty())
+      return 0;
+    parallelCachingGOP &gop = parallelCachingGOPs[gopStart];
+    gop.requestedFrames.insert(frameIdxInternal);
+    gop.decodedUpTo = gopStart - 1;
+    ctx = parallelCachingDecoders.takeLast();
+    generation = parallelCachingGeneration;
+  }
+
+  const int nrFramesCached = decodeGOPForCaching(ctx.data(), gopStart, gopEnd);
+
+  QMutexLocker locker(&parallelCachingMutex);
+  parallelCachingGOPs.remove(gopStart);
+  if (generation == parallelCachingGeneration)
+    parallelCachingDecoders.append(ctx);
+  parallelCachingGOPDone.wakeAll();
+  return nrFramesCached;
+}
+
+int playlistItemCompressedVideo::getNextRandomAccessPoint(int gopStart)
+{
+  auto it = std::upper_bound(parallelCachingRandomAccessPoints.constBegin(), parallelCachingRandomAccessPoints.constEnd(), gopStart);
+  if (it == parallelCachingRandomAccessPoints.constEnd())
+    return startEndFrame.second + 1;
+  return *it;
+}
+
+int playlistItemCompressedVideo::decodeGOPForCaching(parallelCachingDecoder *ctx, int gopStart, int gopEnd)
+{
+  DEBUG_COMPRESSED("playlistItemCompressedVideo::decodeGOPForCaching frames %d to %d", gopStart, gopEnd - 1);
+
+  int seekToAnnexBFrameCount = -1;
+  int seekToDTS = -1;
+  const int seekToFrame = getRandomAccessPointBefore(gopStart, seekToAnnexBFrameCount, seekToDTS);
+  decoderBase *dec = ctx->decoder.data();
+  ctx->annexBFrameCounter = seekToAnnexBFrameCount;
+  ctx->repushData = false;
+  if (!seekDecoder(dec, ctx->annexBFile.data(), ctx->ffmpegFile.data(), seekToFrame, seekToDTS))
+    return 0;
+
+  // Decode all frames of the GOP and put the requested ones into the cache
+  int frameIdx = seekToFrame - 1;
+  int nrFramesCached = 0;
+  while (frameIdx < gopEnd - 1 && !dec->errorInDecoder())
+  {
+    while (dec->needsMoreData())
+      if (!pushNextDataToDecoder(dec, ctx->annexBFile.data(), ctx->ffmpegFile.data(), ctx->annexBFrameCounter, ctx->repushData))
+        return nrFramesCached;
+
+    if (dec->decodeFrames() && dec->decodeNextFrame())
+    {
+      frameIdx++;
+      if (frameIdx >= gopStart)
+      {
+        bool requested;
+        {
+          QMutexLocker locker(&parallelCachingMutex);
+          parallelCachingGOP &gop = parallelCachingGOPs[gopStart];
+          requested = gop.requestedFrames.contains(frameIdx);
+          gop.decodedUpTo = frameIdx;
+        }
+        if (requested && video->cacheRawFrame(frameIdx, dec->getRawFrameData()))
+          nrFramesCached++;
+      }
+    }
+
+    if (!dec->needsMoreData() && !dec->decodeFrames())
+      break;
+  }
+  return nrFramesCached;
+}
+
+void playlistItemCompressedVideo::updateSettings()
+{
+  playlistItemWithVideo::updateSettings();
+  /* TODO loadingDecoder->updateFileWatchSetting(); statSource.updateSettings(); */
+
+  QSettings settings;
+  // Compare with the setting (and not with parallelCaching, which also depends on the item). Reallocating
+  // the decoders opens the file and creates a decoder for every thread.
+  const bool newParallelCaching = settings.value("VideoCache/ParallelDecoding", false).toBool();
+  if (newParallelCaching != parallelCachingSetting)
+    allocateParallelCachingDecoders();
 }
 
 void playlistItemCompressedVideo::loadFrame(int frameIdx, bool playing, bool loadRawdata, bool emitSignals)
@@ -1000,6 +1176,9 @@ void playlistItemCompressedVideo::displaySignalComboBoxChanged(int idx)
     loadingDecoder->setDecodeSignal(idx, resetDecoder);
     cachingDecoder->setDecodeSignal(idx, resetDecoder);
 
+    // The parallel caching decoders are recreated with the new signal
+    allocateParallelCachingDecoders();
+
     if (resetDecoder)
     {
       loadingDecoder->resetDecoder();
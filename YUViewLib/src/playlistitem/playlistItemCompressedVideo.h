@@ -33,6 +33,11 @@
 #ifndef PLAYLISTITEMCOMPRESSEDVIDEO_H
 #define PLAYLISTITEMCOMPRESSEDVIDEO_H
 
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QWaitCondition>
+
 #include "decoder/decoderBase.h"
 #include "filesource/fileSourceFFmpegFile.h"
 #include "parser/parserAnnexB.h"
@@ -88,7 +93,7 @@ public:
   // ----- Detection of source/file change events -----
   virtual bool isSourceChanged()        Q_DECL_OVERRIDE { /* TODO */ return false; }
   virtual void reloadItemSource()       Q_DECL_OVERRIDE;
-  virtual void updateSettings()         Q_DECL_OVERRIDE { /* TODO loadingDecoder->updateFileWatchSetting(); statSource.updateSettings(); */ }
+  virtual void updateSettings()         Q_DECL_OVERRIDE;
 
   // Do we need to load the given frame first?
   virtual itemLoadingState needsLoading(int frameIdx, bool loadRawData) Q_DECL_OVERRIDE;
@@ -100,11 +105,13 @@ public:
 
   // Cache the frame with the given index.
   // For all compressed items, a mutex must be locked when caching a frame (only one frame can be cached at a time because we only have one decoder).
-  void cacheFrame(int idx, bool testMode) Q_DECL_OVERRIDE;
+  // If parallel decoding is enabled, the GOPs are decoded by several caching threads with their own decoders instead.
+  int cacheFrame(int idx, bool testMode) Q_DECL_OVERRIDE;
 
   // We only have one caching decoder so it is better if only one thread caches frames from this item.
   // This way, the frames will always be cached in the right order and no unnecessary decoding is performed.
-  virtual int cachingThreadLimit() Q_DECL_OVERRIDE { return 1; }
+  // With parallel decoding, there is one thread per caching decoder.
+  virtual int cachingThreadLimit() Q_DECL_OVERRIDE { return parallelCaching ? parallelCachingPoolSize : 1; }
 
   YUView::inputFormat getInputFormat() const { return inputFormatType; }
   
@@ -125,6 +132,8 @@ protected:
   YUView::decoderEngine decoderEngineType;
   // Delete existing decoders and allocate decoders for the type "decoderEngineType"
   bool allocateDecoder(int displayComponent = 0);
+  // Create a new decoder of the type "decoderEngineType". For FFmpeg input, the codec parameters are taken from the given file.
+  decoderBase *createDecoder(int displayComponent, bool cachingDecoder, fileSourceFFmpegFile *ffmpegFile);
 
   // In order to parse raw annexB files, we need a file reader (that can read NAL units)
   // and a parser that can understand what the NAL units mean. We open the file source twice (once for interactive loading,
@@ -164,6 +173,14 @@ protected:
 
   // Seek the input file to the given position, reset the decoder and prepare it to start decoding from the given position.
   void seekToPosition(int seekToFrame, int seekToDTS, bool caching);
+  // Reset the given decoder, seek the given input file and push the parameter sets. Return false if pushing failed.
+  bool seekDecoder(decoderBase *dec, fileSourceAnnexBFile *annexBFile, fileSourceFFmpegFile *ffmpegFile, int seekToFrame, int seekToDTS);
+  // Read the next data (NAL unit, frame or packet) from the input file and push it to the decoder. Return false if the
+  // decoder could neither take the data nor switch to decoding frames.
+  bool pushNextDataToDecoder(decoderBase *dec, fileSourceAnnexBFile *annexBFile, fileSourceFFmpegFile *ffmpegFile, int &annexBFrameCounter, bool &repush);
+  // Get the closest frame before (or at) the given frame that decoding can start at. For annexB files the frame counter
+  // in coding order is returned in annexBFrameCount, for FFmpeg files the DTS to seek to is returned in dts.
+  int getRandomAccessPointBefore(int frameIdxInternal, int &annexBFrameCount, int &dts) const;
 
   // For certain decoders (FFmpeg or HM), pushing data may fail. The decoder may or may not switch to retrieveing mode.
   // In this case, we must re-push the packet for which pushing failed.
@@ -177,6 +194,45 @@ protected:
   // might be unable to decode some of the frames at the end of the sequence.
   int decodingNotPossibleAfter { -1 };
 
+  // --- Parallel caching
+  // If enabled in the settings, the frames are cached using multiple decoders. A caching thread decodes the whole GOP
+  // (from one random access point to the next) of the frame that it should cache with its own decoder and input file.
+  struct parallelCachingDecoder
+  {
+    QScopedPointer<decoderBase> decoder;
+    QScopedPointer<fileSourceAnnexBFile> annexBFile;
+    QScopedPointer<fileSourceFFmpegFile> ffmpegFile;
+    int annexBFrameCounter {-1};
+    bool repushData {false};
+  };
+  bool parallelCaching {false};
+  bool parallelCachingSetting {false};  // The value of the setting that parallelCaching was allocated for
+  int parallelCachingPoolSize {1};
+  // The idle decoders. They are allocated in the main thread (allocateParallelCachingDecoders) and taken by the caching threads.
+  QList<QSharedPointer<parallelCachingDecoder>> parallelCachingDecoders;
+  // Incremented when the decoders are reallocated. Decoders of an older generation are not returned to the list.
+  int parallelCachingGeneration {0};
+  // The GOPs that are currently decoded by a caching thread [start frame of the GOP]. Only the frames that the video
+  // cache requested (and accounted for) are put into the cache. If the video cache requests a frame of a GOP that is
+  // being decoded, the request is added to the GOP and the caching thread of the frame is done right away.
+  struct parallelCachingGOP
+  {
+    QSet<int> requestedFrames;
+    int decodedUpTo {-1};  // The last frame of the GOP that was decoded
+  };
+  QHash<int, parallelCachingGOP> parallelCachingGOPs;
+  QWaitCondition parallelCachingGOPDone;
+  // All random access points (sorted). This is filled when it is first needed.
+  QList<int> parallelCachingRandomAccessPoints;
+  QMutex parallelCachingMutex;
+  void allocateParallelCachingDecoders();
+  // Return the number of frames that this call put into the cache (see cacheFrame)
+  int cacheFrameParallel(int frameIdxInternal);
+  // Get the random access point after the one at gopStart (or the frame after the last frame). The mutex must be locked.
+  int getNextRandomAccessPoint(int gopStart);
+  // Decode the GOP using the given decoder and put the requested frames into the cache. Return the number of cached frames.
+  int decodeGOPForCaching(parallelCachingDecoder *ctx, int gopStart, int gopEnd);
+
 private slots:
   // Load the raw (YUV or RGN) data for the given frame index from file. This slot is called by the videoHandler if the frame that is
   // requested to be drawn has not been loaded yet.
@@ -32,9 +32,20 @@
 
 #include "playlistItemDifference.h"
 
+#include <QFileInfo>
+#include <QGroupBox>
+#include <QHeaderView>
 #include <QPainter>
+#include <QtConcurrent>
+#include <algorithm>
+#include <cmath>
+#include <functional>
 
 #include "common/functions.h"
+#include "playlistItemRawFile.h"
+#include "video/frameHashIndex.h"
+#include "video/videoHandlerRGB.h"
+#include "video/videoHandlerYUV.h"
 
 // Activate this if you want to know when which difference is loaded
 #define PLAYLISTITEMDIFFERENCE_DEBUG_LOADING 0
@@ -46,6 +57,40 @@
 
 #define DIFFERENCE_INFO_TEXT "Please drop two video item's onto this difference item to calculate the difference."
 
+namespace
+{
+
+// A raw frame of one of the inputs
+struct inputFrame
+{
+  int frameIdxInternal;
+  QByteArray rawData;
+};
+
+// Read the raw frames chunkStart to chunkEnd-1 of both inputs at the same time. Each input is read in order so that a
+// decoder does not have to seek. Frames for which skipFrame(input, frameIdxInternal) returns true are not read.
+// Return false if the reading was canceled.
+bool readRawFramesOfBothInputs(videoHandler *const video[2], const QVector<int> *const frameIdxInternal[2], int chunkStart, int chunkEnd,
+                               const std::function<bool(int, int)> &skipFrame, const std::atomic<bool> &cancel, QVector<inputFrame> frames[2])
+{
+  auto readInput = [&](int i)
+  {
+    for (int f = chunkStart; f < chunkEnd && !cancel; f++)
+    {
+      const int idx = frameIdxInternal[i]->at(f);
+      if (skipFrame && skipFrame(i, idx))
+        continue;
+      frames[i].append(inputFrame{idx, video[i]->getRawFrameData(idx)});
+    }
+  };
+  QFuture<void> readFuture = QtConcurrent::run(readInput, 0);
+  readInput(1);
+  readFuture.waitForFinished();
+  return !cancel;
+}
+
+} // namespace
+
 playlistItemDifference::playlistItemDifference()
   : playlistItemContainer("Difference Item")
 {
@@ -63,6 +108,14 @@ playlistItemDifference::playlistItemDifference()
   infoText = DIFFERENCE_INFO_TEXT;
 
   connect(&difference, &videoHandlerDifference::signalHandlerChanged, this, &playlistItemDifference::signalItemChanged);
+  connect(this, &playlistItemDifference::signalSequenceMetricsUpdated, this, &playlistItemDifference::updateSequenceMetricsControls, Qt::QueuedConnection);
+  connect(this, &playlistItemDifference::signalFrameHashesUpdated, this, &playlistItemDifference::updateFrameHashControls, Qt::QueuedConnection);
+}
+
+playlistItemDifference::~playlistItemDifference()
+{
+  cancelSequenceMetrics();
+  cancelFrameHashComparison();
 }
 
 /* For a difference item, the info list is just a list of the names of the
@@ -94,6 +147,7 @@ void playlistItemDifference::drawItem(QPainter *painter, int frameIdx, double zo
 {
   const int frameIdxInternal = getFrameIdxInternal(frameIdx);
   DEBUG_DIFF("playlistItemDifference::drawItem frameIdx %d %s", frameIdxInternal, childLlistUpdateRequired ? "childLlistUpdateRequired" : "");
+  lastDrawnFrameIdx = frameIdx;
   if (childLlistUpdateRequired)
   {
     // Update the 'childList' and connect the signals/slots
@@ -107,6 +161,9 @@ void playlistItemDifference::drawItem(QPainter *painter, int frameIdx, double zo
     if (childCount() >= 2)
       childVideo1 = getChildPlaylistItem(1)->getFrameHandler();
 
+    // Metrics of the old inputs are not valid anymore
+    cancelSequenceMetrics();
+    cancelFrameHashComparison();
     difference.setInputVideos(childVideo0, childVideo1);
 
     // Update the frame range
@@ -161,9 +218,86 @@ void playlistItemDifference::createPropertiesWidget()
   vAllLaout->addWidget(line);
   vAllLaout->addLayout(difference.createDifferenceHandlerControls());
 
+  // The sequence metrics (PSNR of all frames)
+  QGroupBox *metricsGroupBox = new QGroupBox("Sequence PSNR");
+  QVBoxLayout *metricsLayout = new QVBoxLayout(metricsGroupBox);
+  sequenceMetricsButton = new QPushButton;
+  sequenceMetricsButton->setToolTip("Calculate the PSNR of the Y, U and V components of all frames. No difference images are created for this.");
+  connect(sequenceMetricsButton.data(), &QPushButton::clicked, this, [this]()
+  {
+    if (isSequenceMetricsRunning())
+      cancelSequenceMetrics();
+    else
+      startSequenceMetrics();
+  });
+  metricsLayout->addWidget(sequenceMetricsButton);
+  sequenceMetricsLabel = new QLabel;
+  sequenceMetricsLabel->setWordWrap(true);
+  metricsLayout->addWidget(sequenceMetricsLabel);
+
+  sequenceMetricsTable = new QTableWidget(0, 4);
+  sequenceMetricsTable->setHorizontalHeaderLabels(QStringList() << "Frame" << "PSNR Y" << "PSNR U" << "PSNR V");
+  sequenceMetricsTable->verticalHeader()->setVisible(false);
+  sequenceMetricsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+  sequenceMetricsTable->setMinimumHeight(150);
+  metricsLayout->addWidget(sequenceMetricsTable);
+
+  QtCharts::QChart *chart = new QtCharts::QChart;
+  const QStringList componentNames = QStringList() << "Y" << "U" << "V";
+  sequenceMetricsAxisX = new QtCharts::QValueAxis;
+  sequenceMetricsAxisX->setTitleText("Frame");
+  sequenceMetricsAxisX->setLabelFormat("%d");
+  sequenceMetricsAxisY = new QtCharts::QValueAxis;
+  sequenceMetricsAxisY->setTitleText("PSNR [dB]");
+  chart->addAxis(sequenceMetricsAxisX, Qt::AlignBottom);
+  chart->addAxis(sequenceMetricsAxisY, Qt::AlignLeft);
+  for (int c = 0; c < 3; c++)
+  {
+    sequenceMetricsSeries[c] = new QtCharts::QLineSeries;
+    sequenceMetricsSeries[c]->setName(componentNames[c]);
+    chart->addSeries(sequenceMetricsSeries[c]);
+    sequenceMetricsSeries[c]->attachAxis(sequenceMetricsAxisX);
+    sequenceMetricsSeries[c]->attachAxis(sequenceMetricsAxisY);
+  }
+  sequenceMetricsChartView = new QtCharts::QChartView(chart);
+  sequenceMetricsChartView->setRenderHint(QPainter::Antialiasing);
+  sequenceMetricsChartView->setMinimumHeight(200);
+  metricsLayout->addWidget(sequenceMetricsChartView);
+
+  vAllLaout->addWidget(metricsGroupBox);
+  updateSequenceMetricsControls();
+
+  // The frame hash comparison (find the frames that are not bit-exact)
+  QGroupBox *hashGroupBox = new QGroupBox("Frame Hashes");
+  QVBoxLayout *hashLayout = new QVBoxLayout(hashGroupBox);
+  frameHashButton = new QPushButton;
+  frameHashButton->setToolTip("Compare the MD5 hashes of the raw data of all frames of both inputs. The hashes of a file are saved next to it (*.yuvhash) and reused.");
+  connect(frameHashButton.data(), &QPushButton::clicked, this, [this]()
+  {
+    if (isFrameHashComparisonRunning())
+      cancelFrameHashComparison();
+    else
+      startFrameHashComparison();
+  });
+  hashLayout->addWidget(frameHashButton);
+  frameHashLabel = new QLabel;
+  frameHashLabel->setWordWrap(true);
+  hashLayout->addWidget(frameHashLabel);
+  nextMismatchButton = new QPushButton("Jump to next mismatching frame");
+  connect(nextMismatchButton.data(), &QPushButton::clicked, this, [this]()
+  {
+    const int frameIdx = getNextMismatchingFrame(lastDrawnFrameIdx);
+    if (frameIdx >= 0)
+      emit signalItemJumpToFrame(frameIdx);
+  });
+  hashLayout->addWidget(nextMismatchButton);
+
+  vAllLaout->addWidget(hashGroupBox);
+  updateFrameHashControls();
+
   // Insert a stretch at the bottom of the vertical global layout so that everything
   // gets 'pushed' to the top
-  vAllLaout->insertStretch(3, 1);
+  vAllLaout->insertStretch(5, 1);
 }
 
 void playlistItemDifference::savePlaylist(QDomElement &root, const QDir &playlistDir) const
@@ -256,5 +390,407 @@ void playlistItemDifference::childChanged(bool redraw, recacheIndicator recache)
   // One of the child items changed and needs to redraw. This means that the difference is out of date
   // and has to be recalculated.
   difference.invalidateAllBuffers();
+  // If the child was changed (and not just redrawn), the sequence metrics are out of date.
+  if (recache != RECACHE_NONE)
+  {
+    cancelSequenceMetrics();
+    cancelFrameHashComparison();
+  }
   playlistItemContainer::childChanged(redraw, recache);
-}
\ No newline at end of file
+}
+
+void playlistItemDifference::itemAboutToBeDeleted(playlistItem *item)
+{
+  cancelSequenceMetrics();
+  cancelFrameHashComparison();
+  playlistItemContainer::itemAboutToBeDeleted(item);
+}
+
+void playlistItemDifference::startSequenceMetrics()
+{
+  cancelSequenceMetrics();
+
+  // Get the inputs (format and frame indices) now. The background thread reads the raw frames through the video handlers
+  // of the child items (getRawFrameData). So it is canceled before a child is changed or deleted.
+  sequenceMetricsInput input[2];
+  QVector<int> frameIndices;
+  QString error;
+  if (childCount() != 2 || !difference.inputsValid())
+    error = "Two valid inputs are needed to calculate the PSNR.";
+  for (int i = 0; i < 2 && error.isEmpty(); i++)
+  {
+    videoHandlerYUV *yuvVideo = dynamic_cast<videoHandlerYUV*>(getChildPlaylistItem(i)->getFrameHandler());
+    if (yuvVideo == nullptr)
+      error = "The PSNR can only be calculated for two YUV inputs.";
+    else
+    {
+      input[i].video = yuvVideo;
+      input[i].format = YUV_Internals::yuvPixelFormat(yuvVideo->getRawYUVPixelFormatName());
+      input[i].frameSize = yuvVideo->getFrameSize();
+    }
+  }
+  if (error.isEmpty() && input[0].format.subsampling != input[1].format.subsampling)
+    error = "The PSNR can only be calculated for two inputs with the same chroma subsampling.";
+  if (error.isEmpty())
+  {
+    for (int frameIdxInternal = startEndFrame.first; frameIdxInternal <= startEndFrame.second; frameIdxInternal++)
+    {
+      frameIndices.append(getFrameIdxExternal(frameIdxInternal));
+      for (int i = 0; i < 2; i++)
+        input[i].frameIdxInternal.append(getChildPlaylistItem(i)->getFrameIdxInternal(frameIdxInternal));
+    }
+  }
+
+  {
+    QMutexLocker locker(&sequenceMetricsMutex);
+    sequenceMetrics.clear();
+    sequenceMetricsNrFrames = frameIndices.size();
+    sequenceMetricsError = error;
+    sequenceMetricsRunning = error.isEmpty() && !frameIndices.isEmpty();
+  }
+  if (propertiesWidget)
+  {
+    sequenceMetricsTable->setRowCount(0);
+    for (int c = 0; c < 3; c++)
+      sequenceMetricsSeries[c]->clear();
+  }
+
+  if (isSequenceMetricsRunning())
+  {
+    cancelSequenceMetricsCalculation = false;
+    sequenceMetricsFuture = QtConcurrent::run(this, &playlistItemDifference::calculateSequenceMetrics, input[0], input[1], frameIndices);
+  }
+  updateSequenceMetricsControls();
+}
+
+void playlistItemDifference::cancelSequenceMetrics()
+{
+  if (!sequenceMetricsFuture.isRunning())
+    return;
+
+  cancelSequenceMetricsCalculation = true;
+  sequenceMetricsFuture.waitForFinished();
+  updateSequenceMetricsControls();
+}
+
+QVector<playlistItemDifference::frameMetrics> playlistItemDifference::getSequenceMetrics() const
+{
+  QMutexLocker locker(&sequenceMetricsMutex);
+  return sequenceMetrics;
+}
+
+void playlistItemDifference::calculateSequenceMetrics(sequenceMetricsInput input0, sequenceMetricsInput input1, QVector<int> frameIndices)
+{
+  videoHandler *const video[2] = {input0.video, input1.video};
+  const QVector<int> *const frameIdxInternal[2] = {&input0.frameIdxInternal, &input1.frameIdxInternal};
+  const int nrFrames = frameIndices.size();
+  const double maxValue = double((1 << std::max(input0.format.bitsPerSample, input1.format.bitsPerSample)) - 1);
+  const int chunkSize = int(functions::getOptimalThreadCount()) * 2;
+
+  QString error;
+  for (int chunkStart = 0; chunkStart < nrFrames && !cancelSequenceMetricsCalculation && error.isEmpty(); chunkStart += chunkSize)
+  {
+    const int chunkEnd = std::min(chunkStart + chunkSize, nrFrames);
+
+    // Read the raw frames of both inputs
+    QVector<inputFrame> rawFrames[2];
+    if (!readRawFramesOfBothInputs(video, frameIdxInternal, chunkStart, chunkEnd, nullptr, cancelSequenceMetricsCalculation, rawFrames))
+      break;
+
+    // Calculate the metrics of all frames of the chunk in parallel
+    QVector<frameMetrics> chunkMetrics(chunkEnd - chunkStart);
+    for (int f = chunkStart; f < chunkEnd; f++)
+      chunkMetrics[f - chunkStart].frameIdx = f;
+    QtConcurrent::blockingMap(chunkMetrics, [&](frameMetrics &m)
+    {
+      const int i = m.frameIdx - chunkStart;
+      int64_t sse[3], nrSamples[3];
+      if (!videoHandlerYUV::calculateSSE(rawFrames[0][i].rawData, input0.frameSize, input0.format, rawFrames[1][i].rawData, input1.frameSize, input1.format, sse, nrSamples))
+      {
+        m.frameIdx = -1;
+        return;
+      }
+      for (int c = 0; c < 3; c++)
+      {
+        m.mse[c] = (nrSamples[c] > 0) ? double(sse[c]) / nrSamples[c] : 0.0;
+        m.psnr[c] = (m.mse[c] > 0.0) ? 10.0 * std::log10(maxValue * maxValue / m.mse[c]) : PSNR_IDENTICAL_FRAMES;
+      }
+      m.frameIdx = frameIndices[m.frameIdx];
+    });
+
+    QMutexLocker locker(&sequenceMetricsMutex);
+    for (int i = 0; i < chunkMetrics.size() && error.isEmpty(); i++)
+    {
+      if (chunkMetrics[i].frameIdx == -1)
+        error = QString("Frame %1 could not be loaded.").arg(frameIndices[chunkStart + i]);
+      else
+        sequenceMetrics.append(chunkMetrics[i]);
+    }
+    locker.unlock();
+    emit signalSequenceMetricsUpdated();
+  }
+
+  QMutexLocker locker(&sequenceMetricsMutex);
+  sequenceMetricsError = error;
+  sequenceMetricsRunning = false;
+  locker.unlock();
+  emit signalSequenceMetricsUpdated();
+}
+
+void playlistItemDifference::updateSequenceMetricsControls()
+{
+  if (!propertiesWidget)
+    return;
+
+  QMutexLocker locker(&sequenceMetricsMutex);
+  sequenceMetricsButton->setText(sequenceMetricsRunning ? "Cancel" : "Calculate PSNR of all frames");
+
+  // Add the new frames to the table and the plot
+  const int nrRowsBefore = sequenceMetricsTable->rowCount();
+  sequenceMetricsTable->setRowCount(sequenceMetrics.size());
+  double psnrSum[3] = {0, 0, 0};
+  double psnrMin = PSNR_IDENTICAL_FRAMES;
+  double psnrMax = 0;
+  for (int i = 0; i < sequenceMetrics.size(); i++)
+  {
+    const frameMetrics &m = sequenceMetrics[i];
+    for (int c = 0; c < 3; c++)
+    {
+      psnrSum[c] += m.psnr[c];
+      psnrMin = std::min(psnrMin, m.psnr[c]);
+      psnrMax = std::max(psnrMax, m.psnr[c]);
+    }
+    if (i < nrRowsBefore)
+      continue;
+    sequenceMetricsTable->setItem(i, 0, new QTableWidgetItem(QString::number(m.frameIdx)));
+    for (int c = 0; c < 3; c++)
+    {
+      sequenceMetricsTable->setItem(i, c + 1, new QTableWidgetItem(QString::number(m.psnr[c], 'f', 2)));
+      sequenceMetricsSeries[c]->append(m.frameIdx, m.psnr[c]);
+    }
+  }
+  if (!sequenceMetrics.isEmpty())
+  {
+    sequenceMetricsAxisX->setRange(sequenceMetrics.first().frameIdx, std::max(sequenceMetrics.last().frameIdx, sequenceMetrics.first().frameIdx + 1));
+    sequenceMetricsAxisY->setRange(std::floor(psnrMin) - 1, std::ceil(psnrMax) + 1);
+  }
+
+  // Show the progress, an error or the average PSNR
+  const int n = sequenceMetrics.size();
+  if (!sequenceMetricsError.isEmpty())
+    sequenceMetricsLabel->setText(sequenceMetricsError);
+  else if (sequenceMetricsRunning)
+    sequenceMetricsLabel->setText(QString("Calculated %1 of %2 frames").arg(n).arg(sequenceMetricsNrFrames));
+  else if (n > 0)
+    sequenceMetricsLabel->setText(QString("Average PSNR over %1 frames: Y %2 dB, U %3 dB, V %4 dB%5")
+                                  .arg(n).arg(psnrSum[0] / n, 0, 'f', 2).arg(psnrSum[1] / n, 0, 'f', 2).arg(psnrSum[2] / n, 0, 'f', 2)
+                                  .arg(n < sequenceMetricsNrFrames ? " (canceled)" : ""));
+  else
+    sequenceMetricsLabel->setText("");
+}
+
+void playlistItemDifference::startFrameHashComparison()
+{
+  cancelFrameHashComparison();
+
+  // Get the inputs (plane sizes and frame indices) now. Like for the sequence metrics, the background thread reads the raw
+  // frames through the video handlers of the child items.
+  frameHashInput input[2];
+  QVector<int> frameIndices;
+  QString error;
+  if (childCount() != 2 || !difference.inputsValid())
+    error = "Two valid inputs are needed to compare the frame hashes.";
+  for (int i = 0; i < 2 && error.isEmpty(); i++)
+  {
+    playlistItem *item = getChildPlaylistItem(i);
+    videoHandler *video = dynamic_cast<videoHandler*>(item->getFrameHandler());
+    if (video == nullptr || video->getRawPlaneSizes().isEmpty())
+      error = "The frame hashes can only be compared for inputs with raw data (YUV or RGB).";
+    else
+    {
+      input[i].video = video;
+      input[i].planeSizes = video->getRawPlaneSizes();
+      // Sidecars are only used for raw files. The hashes of the other inputs are hashes of the output of a decoder.
+      // The same file can be opened with different decoders (or decoder settings) that output different frames.
+      if (dynamic_cast<playlistItemRawFile*>(item) && QFileInfo(item->getName()).isFile())
+      {
+        input[i].filePath = item->getName();
+        if (videoHandlerYUV *yuvVideo = dynamic_cast<videoHandlerYUV*>(video))
+          input[i].source = "yuv " + yuvVideo->getRawYUVPixelFormatName();
+        else if (videoHandlerRGB *rgbVideo = dynamic_cast<videoHandlerRGB*>(video))
+          input[i].source = "rgb " + rgbVideo->getRawRGBPixelFormatName();
+      }
+    }
+  }
+  if (error.isEmpty() && !input[1].filePath.isEmpty() && input[1].filePath == input[0].filePath)
+    // Both inputs must never load (and write) the same sidecar
+    input[1].filePath.clear();
+  if (error.isEmpty() && input[0].planeSizes != input[1].planeSizes)
+    error = "The frame hashes can only be compared if the raw frames of both inputs have the same size and planes.";
+  if (error.isEmpty())
+  {
+    for (int frameIdxInternal = startEndFrame.first; frameIdxInternal <= startEndFrame.second; frameIdxInternal++)
+    {
+      frameIndices.append(getFrameIdxExternal(frameIdxInternal));
+      for (int i = 0; i < 2; i++)
+        input[i].frameIdxInternal.append(getChildPlaylistItem(i)->getFrameIdxInternal(frameIdxInternal));
+    }
+  }
+
+  {
+    QMutexLocker locker(&frameHashMutex);
+    mismatchingFrames.clear();
+    frameHashNrFrames = frameIndices.size();
+    frameHashNrFramesDone = 0;
+    frameHashError = error;
+    frameHashRunning = error.isEmpty() && !frameIndices.isEmpty();
+  }
+
+  if (isFrameHashComparisonRunning())
+  {
+    cancelFrameHashCalculation = false;
+    frameHashFuture = QtConcurrent::run(this, &playlistItemDifference::calculateFrameHashes, input[0], input[1], frameIndices);
+  }
+  updateFrameHashControls();
+}
+
+void playlistItemDifference::cancelFrameHashComparison()
+{
+  if (!frameHashFuture.isRunning())
+    return;
+
+  cancelFrameHashCalculation = true;
+  frameHashFuture.waitForFinished();
+  updateFrameHashControls();
+}
+
+QVector<int> playlistItemDifference::getMismatchingFrames() const
+{
+  QMutexLocker locker(&frameHashMutex);
+  return mismatchingFrames;
+}
+
+int playlistItemDifference::getNextMismatchingFrame(int frameIdx) const
+{
+  QMutexLocker locker(&frameHashMutex);
+  if (mismatchingFrames.isEmpty())
+    return -1;
+  // The frames are found in ascending order
+  auto it = std::upper_bound(mismatchingFrames.constBegin(), mismatchingFrames.constEnd(), frameIdx);
+  return (it != mismatchingFrames.constEnd()) ? *it : mismatchingFrames.first();
+}
+
+void playlistItemDifference::calculateFrameHashes(frameHashInput input0, frameHashInput input1, QVector<int> frameIndices)
+{
+  const frameHashInput *input[2] = {&input0, &input1};
+  videoHandler *const video[2] = {input0.video, input1.video};
+  const QVector<int> *const frameIdxInternal[2] = {&input0.frameIdxInternal, &input1.frameIdxInternal};
+  const int nrFrames = frameIndices.size();
+  const int chunkSize = int(functions::getOptimalThreadCount()) * 2;
+
+  // Load the hashes that were calculated before
+  frameHashIndex index[2];
+  for (int i = 0; i < 2; i++)
+  {
+    if (input[i]->filePath.isEmpty())
+      continue;
+    index[i] = frameHashIndex(frameHashIndex::getSidecarFile(input[i]->filePath), frameHashIndex::getKey(input[i]->filePath, input[i]->source, input[i]->planeSizes));
+    index[i].loadSidecar();
+  }
+
+  struct hashJob
+  {
+    int input;
+    int frameIdxInternal;
+    QByteArray rawData;
+    frameHashIndex::planeHashes hashes;
+  };
+
+  QString error;
+  for (int chunkStart = 0; chunkStart < nrFrames && !cancelFrameHashCalculation && error.isEmpty(); chunkStart += chunkSize)
+  {
+    const int chunkEnd = std::min(chunkStart + chunkSize, nrFrames);
+
+    // Read the raw frames that are not in the index yet
+    QVector<inputFrame> rawFrames[2];
+    auto skipFrame = [&](int i, int idx)
+    {
+      return index[i].contains(idx) || (!rawFrames[i].isEmpty() && rawFrames[i].last().frameIdxInternal == idx);
+    };
+    if (!readRawFramesOfBothInputs(video, frameIdxInternal, chunkStart, chunkEnd, skipFrame, cancelFrameHashCalculation, rawFrames))
+      break;
+
+    // Hash all frames of the chunk in parallel
+    QVector<hashJob> allJobs;
+    for (int i = 0; i < 2; i++)
+      for (inputFrame &frame : rawFrames[i])
+      {
+        hashJob job;
+        job.input = i;
+        job.frameIdxInternal = frame.frameIdxInternal;
+        job.rawData.swap(frame.rawData);
+        allJobs.append(job);
+      }
+    QtConcurrent::blockingMap(allJobs, [&](hashJob &job)
+    {
+      job.hashes = frameHashIndex::hashFrame(job.rawData, input[job.input]->planeSizes);
+      job.rawData.clear();
+    });
+    for (const hashJob &job : allJobs)
+    {
+      if (job.hashes.isEmpty())
+      {
+        error = QString("Frame %1 of input %2 could not be loaded.").arg(job.frameIdxInternal).arg(job.input == 0 ? "A" : "B");
+        break;
+      }
+      index[job.input].setHashes(job.frameIdxInternal, job.hashes);
+    }
+    if (!error.isEmpty())
+      break;
+
+    // Compare the hashes of the frames of this chunk
+    QMutexLocker locker(&frameHashMutex);
+    for (int f = chunkStart; f < chunkEnd; f++)
+      if (index[0].getHashes(input0.frameIdxInternal[f]) != index[1].getHashes(input1.frameIdxInternal[f]))
+        mismatchingFrames.append(frameIndices[f]);
+    frameHashNrFramesDone = chunkEnd;
+    locker.unlock();
+    emit signalFrameHashesUpdated();
+  }
+
+  // Also save the hashes if the comparison was canceled. The next comparison can then continue from there.
+  for (int i = 0; i < 2; i++)
+    index[i].saveSidecar();
+
+  QMutexLocker locker(&frameHashMutex);
+  frameHashError = error;
+  frameHashRunning = false;
+  locker.unlock();
+  emit signalFrameHashesUpdated();
+}
+
+void playlistItemDifference::updateFrameHashControls()
+{
+  if (!propertiesWidget)
+    return;
+
+  QMutexLocker locker(&frameHashMutex);
+  frameHashButton->setText(frameHashRunning ? "Cancel" : "Compare hashes of all frames");
+  nextMismatchButton->setEnabled(!mismatchingFrames.isEmpty());
+
+  const int nrMismatches = mismatchingFrames.size();
+  QString text;
+  if (!frameHashError.isEmpty())
+    text = frameHashError;
+  else if (frameHashRunning)
+    text = QString("Compared %1 of %2 frames").arg(frameHashNrFramesDone).arg(frameHashNrFrames);
+  else if (frameHashNrFramesDone > 0 && nrMismatches == 0)
+    text = QString("All %1 compared frames are identical").arg(frameHashNrFramesDone);
+  else if (frameHashNrFramesDone > 0)
+    text = QString("%1 of %2 compared frames differ").arg(nrMismatches).arg(frameHashNrFramesDone);
+  if (frameHashNrFramesDone > 0 && frameHashNrFramesDone < frameHashNrFrames && !frameHashRunning)
+    text += " (canceled)";
+  if (nrMismatches > 0)
+    text += QString(". The first mismatch is frame %1.").arg(mismatchingFrames.first());
+  frameHashLabel->setText(text);
+}
@@ -33,9 +33,23 @@
 #ifndef PLAYLISTITEMDIFFERENCE_H
 #define PLAYLISTITEMDIFFERENCE_H
 
+#include <atomic>
+#include <QFuture>
+#include <QLabel>
+#include <QMutex>
+#include <QPointer>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QtCharts/QChartView>
+#include <QtCharts/QLineSeries>
+#include <QtCharts/QValueAxis>
+
 #include "playlistItemContainer.h"
 #include "video/videoHandlerDifference.h"
 
+// The PSNR that is reported for identical frames (like the HM reference software does)
+#define PSNR_IDENTICAL_FRAMES 99.99
+
 class playlistItemDifference :
   public playlistItemContainer
 {
@@ -43,6 +57,7 @@ class playlistItemDifference :
 
 public:
   playlistItemDifference();
+  virtual ~playlistItemDifference();
 
   virtual infoData getInfo() const Q_DECL_OVERRIDE;
 
@@ -72,9 +87,49 @@ public:
   // Return the frame handler pointer that draws the difference
   virtual frameHandler *getFrameHandler() Q_DECL_OVERRIDE { return &difference; }
 
+  // The calculation of the sequence metrics is stopped before a child item is deleted
+  virtual void itemAboutToBeDeleted(playlistItem *item) Q_DECL_OVERRIDE;
+
+  // The MSE and PSNR of the Y, U and V component of one frame
+  struct frameMetrics
+  {
+    int frameIdx {-1};
+    double mse[3] {0, 0, 0};
+    double psnr[3] {0, 0, 0};
+  };
+
+  // Calculate the MSE/PSNR of all frames in the background (calculateSequenceMetrics). This only works if both
+  // inputs are YUV videos. Already calculated metrics can be retrieved with getSequenceMetrics while this is running.
+  void startSequenceMetrics();
+  void cancelSequenceMetrics();
+  bool isSequenceMetricsRunning() const { QMutexLocker locker(&sequenceMetricsMutex); return sequenceMetricsRunning; }
+  QVector<frameMetrics> getSequenceMetrics() const;
+
+  // Compare the MD5 hashes of all planes of the raw frames of both inputs in the background (calculateFrameHashes).
+  // This works for all raw formats as long as both inputs have the same plane sizes. The hashes of an input file are
+  // saved to a sidecar file (see frameHashIndex), so they only have to be calculated once per file.
+  void startFrameHashComparison();
+  void cancelFrameHashComparison();
+  bool isFrameHashComparisonRunning() const { QMutexLocker locker(&frameHashMutex); return frameHashRunning; }
+  // Get the frames where the hashes of the inputs differ (that were found so far)
+  QVector<int> getMismatchingFrames() const;
+  // Get the first mismatching frame after the given frame (or the first one if there is none after it). Returns -1
+  // if no mismatching frame was found.
+  int getNextMismatchingFrame(int frameIdx) const;
+
+signals:
+  // New sequence metrics were calculated or the calculation finished. This is emitted from the background thread.
+  void signalSequenceMetricsUpdated();
+  // More frame hashes were compared or the comparison finished. This is emitted from the background thread.
+  void signalFrameHashesUpdated();
+
 protected slots:
   virtual void childChanged(bool redraw, recacheIndicator recache) Q_DECL_OVERRIDE;
 
+private slots:
+  void updateSequenceMetricsControls();
+  void updateFrameHashControls();
+
 private:
 
   // Overload from playlistItem. Create a properties widget custom to the playlistItemDifference
@@ -84,6 +139,59 @@ private:
   videoHandlerDifference difference;
   bool isDifferenceLoading;
   bool isDifferenceLoadingToDoubleBuffer;
+
+  // The sequence metrics. The raw frames of both inputs are read in chunks (readRawFramesOfBothInputs) and the SSE of
+  // the frames in a chunk is calculated in parallel (videoHandlerYUV::calculateSSE).
+  struct sequenceMetricsInput
+  {
+    videoHandler *video {nullptr};
+    YUV_Internals::yuvPixelFormat format;
+    QSize frameSize;
+    QVector<int> frameIdxInternal;
+  };
+  void calculateSequenceMetrics(sequenceMetricsInput input0, sequenceMetricsInput input1, QVector<int> frameIndices);
+  QFuture<void> sequenceMetricsFuture;
+  std::atomic<bool> cancelSequenceMetricsCalculation {false};  // Set in the main thread and polled by the background thread
+  mutable QMutex sequenceMetricsMutex;
+  QVector<frameMetrics> sequenceMetrics;
+  int sequenceMetricsNrFrames {0};
+  bool sequenceMetricsRunning {false};
+  QString sequenceMetricsError;
+
+  QPointer<QPushButton> sequenceMetricsButton;
+  QPointer<QLabel> sequenceMetricsLabel;
+  QPointer<QTableWidget> sequenceMetricsTable;
+  QPointer<QtCharts::QChartView> sequenceMetricsChartView;
+  QPointer<QtCharts::QLineSeries> sequenceMetricsSeries[3];
+  QPointer<QtCharts::QValueAxis> sequenceMetricsAxisX;
+  QPointer<QtCharts::QValueAxis> sequenceMetricsAxisY;
+
+  // The frame hash comparison. Like for the sequence metrics, the raw frames of both inputs are read at the same time
+  // and the hashes of the frames are calculated in parallel. Frames that are in the sidecar are not read at all.
+  struct frameHashInput
+  {
+    videoHandler *video {nullptr};
+    QVector<int64_t> planeSizes;
+    QVector<int> frameIdxInternal;
+    QString filePath;  // The sidecar is saved next to this file. Empty if no sidecar is used for the input.
+    QString source;    // How the raw data is read from the file (part of the sidecar key)
+  };
+  void calculateFrameHashes(frameHashInput input0, frameHashInput input1, QVector<int> frameIndices);
+  QFuture<void> frameHashFuture;
+  std::atomic<bool> cancelFrameHashCalculation {false};  // Set in the main thread and polled by the background thread
+  mutable QMutex frameHashMutex;
+  QVector<int> mismatchingFrames;
+  int frameHashNrFrames {0};
+  int frameHashNrFramesDone {0};
+  bool frameHashRunning {false};
+  QString frameHashError;
+
+  // The last drawn frame. The jump to the next mismatching frame starts here.
+  int lastDrawnFrameIdx {0};
+
+  QPointer<QPushButton> frameHashButton;
+  QPointer<QPushButton> nextMismatchButton;
+  QPointer<QLabel> frameHashLabel;
 };
 
 #endif
@@ -54,6 +54,10 @@ playlistItemImageFile::playlistItemImageFile(const QString &filePath)
   // The image file is unchanged
   fileChanged = false;
 
+  // If the image has more than 8 bit per sample, the video handler gets the raw data from this item
+  highBitDepthFrame.setRGBPixelFormat(RGB_Internals::rgbPixelFormat(16, true));
+  highBitDepthFrame.setFrameSource(this);
+
   // Does the file exits?
   QFileInfo fileInfo(filePath);
   if (!fileInfo.exists() || !fileInfo.isFile())
@@ -72,7 +76,18 @@ void playlistItemImageFile::loadFrame(int frameIndex, bool playing, bool loadRaw
   Q_UNUSED(loadRawdata);
 
   imageLoading = true;
-  frame.loadCurrentImageFromFile(plItemNameOrFileName);
+  isHighBitDepth = videoHandlerRGB::isHighBitDepthImageFile(plItemNameOrFileName);
+  if (isHighBitDepth)
+  {
+    QSize frameSize;
+    highBitDepthData = videoHandlerRGB::loadHighBitDepthImageFile(plItemNameOrFileName, frameSize);
+    highBitDepthFrame.setFrameSize(frameSize);
+    // Convert the new data for display
+    highBitDepthFrame.invalidateAllBuffers();
+    highBitDepthFrame.loadFrame(0);
+  }
+  else
+    frame.loadCurrentImageFromFile(plItemNameOrFileName);
   imageLoading = false;
   needToLoadImage = false;
 
@@ -124,7 +139,7 @@ void playlistItemImageFile::drawItem(QPainter *painter, int frameIdx, double zoo
 {
   Q_UNUSED(frameIdx);
   
-  if (!frame.isFormatValid())
+  if (!getFrameHandler()->isFormatValid())
   {
     // The image could not be loaded. Draw a text instead.
     // Get the size of the text and create a QRect of that size which is centered at (0,0)
@@ -139,6 +154,8 @@ void playlistItemImageFile::drawItem(QPainter *painter, int frameIdx, double zoo
     // Draw the text
     painter->drawText(textRect, IMAGEFILE_ERROR_TEXT);
   }
+  else if (isHighBitDepth)
+    highBitDepthFrame.drawFrame(painter, 0, zoomFactor, drawRawData);
   else
     // Draw the frame
     frame.drawFrame(painter, zoomFactor, drawRawData);
@@ -169,7 +186,10 @@ ValuePairListSets playlistItemImageFile::getPixelValues(const QPoint &pixelPos,
   Q_UNUSED(frameIdx);
 
   ValuePairListSets newSet;
-  newSet.append("RGB", frame.getPixelValues(pixelPos, -1));
+  if (isHighBitDepth)
+    newSet.append("RGB", highBitDepthFrame.getPixelValues(pixelPos, 0, nullptr));
+  else
+    newSet.append("RGB", frame.getPixelValues(pixelPos, -1));
   return newSet;
 }
 
@@ -178,7 +198,13 @@ infoData playlistItemImageFile::getInfo() const
   infoData info("Image Info");
 
   info.items.append(infoItem("File", plItemNameOrFileName));
-  if (frame.isFormatValid())
+  if (isHighBitDepth && highBitDepthFrame.isFormatValid())
+  {
+    QSize frameSize = highBitDepthFrame.getFrameSize();
+    info.items.append(infoItem("Resolution", QString("%1x%2").arg(frameSize.width()).arg(frameSize.height()), "The video resolution in pixel (width x height)"));
+    info.items.append(infoItem("Bit depth", "48", "The bit depth of the image. The image is shown as planar 16 bit RGB with the exact values of the file."));
+  }
+  else if (!isHighBitDepth && frame.isFormatValid())
   {
     QSize frameSize = frame.getFrameSize();
     info.items.append(infoItem("Resolution", QString("%1x%2").arg(frameSize.width()).arg(frameSize.height()), "The video resolution in pixel (width x height)"));
@@ -36,6 +36,7 @@
 #include <QFileSystemWatcher>
 #include <QFuture>
 #include "video/frameHandler.h"
+#include "video/videoHandlerRGB.h"
 #include "playlistItem.h"
 
 class playlistItemImageFile : public playlistItem
@@ -54,7 +55,7 @@ public:
   bool isFileSource() const Q_DECL_OVERRIDE { return true; };
 
   // Get the text size (using the current text, font/text size ...)
-  virtual QSize getSize() const Q_DECL_OVERRIDE { return frame.getFrameSize(); }
+  virtual QSize getSize() const Q_DECL_OVERRIDE { return isHighBitDepth ? highBitDepthFrame.getFrameSize() : frame.getFrameSize(); }
 
   // Overload from playlistItem. Save the text item to playlist.
   virtual void savePlaylist(QDomElement &root, const QDir &playlistDir) const Q_DECL_OVERRIDE;
@@ -75,7 +76,7 @@ public:
   static void getSupportedFileExtensions(QStringList &allExtensions, QStringList &filters);
 
   // Get the frame handler
-  virtual frameHandler *getFrameHandler() Q_DECL_OVERRIDE { return &frame; }
+  virtual frameHandler *getFrameHandler() Q_DECL_OVERRIDE { if (isHighBitDepth) return &highBitDepthFrame; return &frame; }
 
   // An image can be used in a difference.
   virtual bool canBeUsedInDifference() const Q_DECL_OVERRIDE { return true; }
@@ -90,6 +91,10 @@ public:
 
   // Is the image currently being loaded?
   virtual bool isLoading() const Q_DECL_OVERRIDE { return imageLoading; }
+
+  // The planar 16 bit RGB data of an image with more than 8 bit per sample. There is only one frame.
+  virtual bool canPullRawFrameData() const Q_DECL_OVERRIDE { return isHighBitDepth; }
+  virtual rawDataView pullRawFrameData(int frameIdxInternal, bool caching) Q_DECL_OVERRIDE { Q_UNUSED(frameIdxInternal); Q_UNUSED(caching); return rawDataView(highBitDepthData); }
   
 private slots:
   // The image file that we loaded was changed.
@@ -99,6 +104,12 @@ private:
   // The frame handler that draws the frame
   frameHandler frame;
 
+  // Images with more than 8 bit per sample are not loaded into the frame handler. Their planar 16 bit RGB data
+  // is kept here and shown by a videoHandlerRGB so that the raw values and differences use the exact values.
+  videoHandlerRGB highBitDepthFrame;
+  QByteArray highBitDepthData;
+  bool isHighBitDepth {false};
+
   // Watch the loaded file for modifications
   QFileSystemWatcher fileWatcher;
   bool fileChanged;
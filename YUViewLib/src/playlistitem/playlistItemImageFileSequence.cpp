@@ -32,13 +32,21 @@
 
 #include "playlistItemImageFileSequence.h"
 
+#include <algorithm>
+#include <cmath>
+#include <QElapsedTimer>
 #include <QImageReader>
 #include <QSettings>
+#include <QtConcurrent>
 #include <QUrl>
 
 #include "common/functions.h"
 #include "filesource/fileSource.h"
 
+// The limits for decoding ahead during playback
+const int decodeAheadMaxFrames = 32;
+const int64_t decodeAheadMaxBytes = 512 * 1024 * 1024;
+
 playlistItemImageFileSequence::playlistItemImageFileSequence(const QString &rawFilePath)
   : playlistItemWithVideo(rawFilePath, playlistItem_Indexed)
 {
@@ -49,6 +57,9 @@ playlistItemImageFileSequence::playlistItemImageFileSequence(const QString &rawF
   loadPlaylistFrameMissing = false;
   isFrameLoading = false;
 
+  // The pool that decodes images ahead during playback. Leave one thread for the conversion of the current frame.
+  decodePool.setMaxThreadCount(std::max(int(functions::getOptimalThreadCount()) - 1, 1));
+
   // Create the video handler
   video.reset(new videoHandler());
 
@@ -75,6 +86,12 @@ playlistItemImageFileSequence::playlistItemImageFileSequence(const QString &rawF
   updateSettings();
 }
 
+playlistItemImageFileSequence::~playlistItemImageFileSequence()
+{
+  decodePool.clear();
+  decodePool.waitForDone();
+}
+
 bool playlistItemImageFileSequence::isImageSequence(const QString &filePath)
 {
   QStringList files;
@@ -166,6 +183,8 @@ infoData playlistItemImageFileSequence::getInfo() const
     QSize videoSize = video->getFrameSize();
     info.items.append(infoItem("Num Frames", QString::number(getNumberFrames())));
     info.items.append(infoItem("Resolution", QString("%1x%2").arg(videoSize.width()).arg(videoSize.height()), "The video resolution in pixels (width x height)"));
+    if (isHighBitDepth)
+      info.items.append(infoItem("Bit depth", "16", "The images have more than 8 bit per sample. The exact values are shown."));
   }
   else
     info.items.append(infoItem("Status", "Error", "There was an error loading the image."));
@@ -265,16 +284,185 @@ void playlistItemImageFileSequence::slotFrameRequest(int frameIdxInternal, bool
 {
   Q_UNUSED(caching);
 
+  // Load the given frame
+  QImage frame = pullFrameImage(frameIdxInternal);
+  if (frame.isNull())
+    return;
+  video->requestedFrame = frame;
+  video->requestedFrame_idx = frameIdxInternal;
+}
+
+QString playlistItemImageFileSequence::getExistingImageFile(int frameIdxInternal) const
+{
   // Does the index/file exist?
   if (frameIdxInternal < 0 || frameIdxInternal >= imageFiles.count())
-    return;
-  QFileInfo fileInfo(imageFiles[frameIdxInternal]);
+    return QString();
+  const QString filePath = imageFiles[frameIdxInternal];
+  QFileInfo fileInfo(filePath);
   if (!fileInfo.exists() || !fileInfo.isFile())
+    return QString();
+  return filePath;
+}
+
+QImage playlistItemImageFileSequence::pullFrameImage(int frameIdxInternal)
+{
+  {
+    // Take the frame if it was decoded ahead
+    QMutexLocker locker(&decodeMutex);
+    auto it = decodedAheadImages.find(frameIdxInternal);
+    if (it != decodedAheadImages.end())
+    {
+      const QImage frame = it.value();
+      decodedAheadImages.erase(it);
+      return frame;
+    }
+  }
+  return loadFrameImage(frameIdxInternal);
+}
+
+QImage playlistItemImageFileSequence::loadFrameImage(int frameIdxInternal)
+{
+  const QString filePath = getExistingImageFile(frameIdxInternal);
+  if (filePath.isEmpty())
+    return QImage();
+
+  // Loading an image does not change anything in this item. This can run in several threads at the same time.
+  return QImage(filePath);
+}
+
+rawDataView playlistItemImageFileSequence::pullRawFrameData(int frameIdxInternal, bool caching)
+{
+  Q_UNUSED(caching);
+  {
+    // Take the frame if it was decoded ahead
+    QMutexLocker locker(&decodeMutex);
+    auto it = decodedAheadData.find(frameIdxInternal);
+    if (it != decodedAheadData.end())
+    {
+      const QByteArray frameData = it.value();
+      decodedAheadData.erase(it);
+      return rawDataView(frameData);
+    }
+  }
+  return loadRawFrameData(frameIdxInternal);
+}
+
+rawDataView playlistItemImageFileSequence::loadRawFrameData(int frameIdxInternal)
+{
+  const QString filePath = getExistingImageFile(frameIdxInternal);
+  if (filePath.isEmpty())
+    return rawDataView();
+
+  QSize frameSize;
+  QByteArray frameData = videoHandlerRGB::loadHighBitDepthImageFile(filePath, frameSize);
+  // All frames must have the size of the first frame
+  if (frameSize != video->getFrameSize())
+    return rawDataView();
+  return rawDataView(frameData);
+}
+
+void playlistItemImageFileSequence::loadFrame(int frameIdx, bool playing, bool loadRawData, bool emitSignals)
+{
+  const int frameIdxInternal = getFrameIdxInternal(frameIdx);
+  if (playing)
+    // The next frame is loaded into the double buffer right away. Decode it (and the ones after it) in the pool.
+    startDecodeAhead(frameIdxInternal + 1);
+  else
+    stopDecodeAhead();
+
+  // If the pool is decoding one of the frames that we need now, wait for it instead of decoding it again.
+  // The frames are then taken from the decoded ahead buffer.
+  waitForDecodeAhead(frameIdxInternal);
+  if (playing)
+    waitForDecodeAhead(frameIdxInternal + 1);
+
+  playlistItemWithVideo::loadFrame(frameIdx, playing, loadRawData, emitSignals);
+}
+
+void playlistItemImageFileSequence::startDecodeAhead(int frameIdxInternal)
+{
+  const indexRange range = startEndFrame;
+  if (range.second < range.first)
     return;
-  
-  // Load the given frame
-  video->requestedFrame = QImage(imageFiles[frameIdxInternal]);
-  video->requestedFrame_idx = frameIdxInternal;
+
+  QMutexLocker locker(&decodeMutex);
+
+  // To keep up with the playback, the number of frames that are decoded at the same time (in the pool or waiting
+  // for it) must cover the time it takes to decode one frame.
+  int nrFrames = decodePool.maxThreadCount();
+  if (decodeDuration > 0 && frameRate > 0)
+    nrFrames = std::max(nrFrames, int(std::ceil(decodeDuration / 1000.0 * frameRate)) + 1);
+  const int64_t bytesPerFrame = std::max(int64_t(video->getCachingFrameSize()), int64_t(1));
+  const int maxFramesMemory = int(std::max(decodeAheadMaxBytes / bytesPerFrame, int64_t(1)));
+  nrFrames = clip(nrFrames, 1, std::min(std::min(decodeAheadMaxFrames, maxFramesMemory), range.second - range.first + 1));
+
+  // These are the frames that are shown next. Playback may wrap around to the first frame of the range.
+  QSet<int> frames;
+  int frame = frameIdxInternal;
+  for (int i = 0; i < nrFrames; i++, frame++)
+  {
+    if (frame > range.second || frame < range.first)
+      frame = range.first;
+    frames.insert(frame);
+  }
+
+  // Free the decoded frames that are not needed anymore (e.g. playback jumped)
+  for (auto it = decodedAheadImages.begin(); it != decodedAheadImages.end();)
+    it = frames.contains(it.key()) ? it + 1 : decodedAheadImages.erase(it);
+  for (auto it = decodedAheadData.begin(); it != decodedAheadData.end();)
+    it = frames.contains(it.key()) ? it + 1 : decodedAheadData.erase(it);
+
+  for (int f : frames)
+  {
+    // Frames that the video cache holds are not decoded again
+    if (decodingFrames.contains(f) || decodedAheadImages.contains(f) || decodedAheadData.contains(f) || video->isInCache(f))
+      continue;
+    decodingFrames.insert(f);
+    QtConcurrent::run(&decodePool, [this, f]{ decodeFrameAhead(f); });
+  }
+}
+
+void playlistItemImageFileSequence::stopDecodeAhead()
+{
+  decodePool.clear();
+  decodePool.waitForDone();
+
+  QMutexLocker locker(&decodeMutex);
+  decodingFrames.clear();
+  decodedAheadImages.clear();
+  decodedAheadData.clear();
+}
+
+void playlistItemImageFileSequence::decodeFrameAhead(int frameIdxInternal)
+{
+  QElapsedTimer timer;
+  timer.start();
+  QImage frame;
+  rawDataView frameData;
+  if (isHighBitDepth)
+    frameData = loadRawFrameData(frameIdxInternal);
+  else
+    frame = loadFrameImage(frameIdxInternal);
+  const double duration = timer.nsecsElapsed() / 1000000.0;
+
+  QMutexLocker locker(&decodeMutex);
+  if (!frame.isNull() || !frameData.isEmpty())
+  {
+    if (isHighBitDepth)
+      decodedAheadData.insert(frameIdxInternal, frameData.byteArray());
+    else
+      decodedAheadImages.insert(frameIdxInternal, frame);
+    decodeDuration = (decodeDuration <= 0) ? duration : decodeDuration * 0.8 + duration * 0.2;
+  }
+  decodingFrames.remove(frameIdxInternal);
+  decodeFinished.wakeAll();
+}
+
+void playlistItemImageFileSequence::waitForDecodeAhead(int frameIdxInternal)
+{
+  QMutexLocker locker(&decodeMutex);
+  while (decodingFrames.contains(frameIdxInternal))
+    decodeFinished.wait(&decodeMutex);
 }
 
 void playlistItemImageFileSequence::setInternals(const QString &filePath)
@@ -283,11 +471,29 @@ void playlistItemImageFileSequence::setInternals(const QString &filePath)
   if (startEndFrame == indexRange(-1,-1))
     startEndFrame = getStartEndFrameLimits();
 
-  // Open frame 0 and set the size of it
-  QImage frame0 = QImage(imageFiles[0]);
-  video->setFrameSize(frame0.size());
+  // Images with more than 8 bit per sample are shown by a videoHandlerRGB. It gets the planar 16 bit RGB data of
+  // the frames so that the raw values and differences use the exact values of the files.
+  isHighBitDepth = videoHandlerRGB::isHighBitDepthImageFile(imageFiles[0]);
+  if (isHighBitDepth)
+  {
+    videoHandlerRGB *rgbVideo = new videoHandlerRGB();
+    rgbVideo->setRGBPixelFormat(RGB_Internals::rgbPixelFormat(16, true));
+    video.reset(rgbVideo);
+    playlistItemWithVideo::connectVideo();
+
+    // Only read the header of frame 0 to get the size
+    QImageReader reader(imageFiles[0]);
+    video->setFrameSize(reader.size());
+  }
+  else
+  {
+    // Open frame 0 and set the size of it
+    QImage frame0 = QImage(imageFiles[0]);
+    video->setFrameSize(frame0.size());
+  }
 
-  cachingEnabled = false;  
+  // The frames are pulled from their files. So the caching threads can decode several images at the same time.
+  cachingEnabled = true;
 
   // Set the internal name
   QFileInfo fi(filePath);
@@ -309,6 +515,9 @@ void playlistItemImageFileSequence::setInternals(const QString &filePath)
 
 void playlistItemImageFileSequence::reloadItemSource()
 {
+  // The frames that were decoded ahead are outdated
+  stopDecodeAhead();
+
   // Clear the video's buffers. The video will ask to reload the images.
   video->invalidateAllBuffers();
 }
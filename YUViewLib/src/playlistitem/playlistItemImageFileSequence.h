@@ -35,9 +35,15 @@
 
 #include <QFileSystemWatcher>
 #include <QFuture>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QThreadPool>
+#include <QWaitCondition>
 #include "playlistItemWithVideo.h"
 #include "playlistItemRawFile.h"
 #include "video/videoHandler.h"
+#include "video/videoHandlerRGB.h"
 
 class playlistItemImageFileSequence : public playlistItemWithVideo
 {
@@ -45,6 +51,7 @@ class playlistItemImageFileSequence : public playlistItemWithVideo
 
 public:
   playlistItemImageFileSequence(const QString &rawFilePath = QString());
+  virtual ~playlistItemImageFileSequence();
 
   // Overload from playlistItem. Save the raw file item to playlist.
   virtual void savePlaylist(QDomElement &root, const QDir &playlistDir) const Q_DECL_OVERRIDE;
@@ -79,6 +86,16 @@ public:
   // Is an image currently being loaded?
   virtual bool isLoading() const Q_DECL_OVERRIDE { return isFrameLoading; }
 
+  // Every frame is a separate file. So several threads can load frames at the same time.
+  // Images with more than 8 bit per sample are loaded as raw planar 16 bit RGB data. All others are loaded as images.
+  virtual bool canPullFrameImage() const Q_DECL_OVERRIDE { return !isHighBitDepth; }
+  virtual QImage pullFrameImage(int frameIdxInternal) Q_DECL_OVERRIDE;
+  virtual bool canPullRawFrameData() const Q_DECL_OVERRIDE { return isHighBitDepth; }
+  virtual rawDataView pullRawFrameData(int frameIdxInternal, bool caching) Q_DECL_OVERRIDE;
+
+  // Load the given frame. During playback, the following frames are decoded in the background.
+  virtual void loadFrame(int frameIdx, bool playing, bool loadRawData, bool emitSignals=true) Q_DECL_OVERRIDE;
+
 private slots:
   // Load the given frame from file. This slot is called by the videoHandler if the frame that is
   // requested to be drawn has not been loaded yet.
@@ -120,6 +137,36 @@ private:
 
   // Is a frame currently being loaded?
   bool isFrameLoading;
+
+  // Do the images have more than 8 bit per sample? Then the video is a videoHandlerRGB which shows the exact values.
+  bool isHighBitDepth {false};
+
+  // Get the path of the image file for the frame. Returns an empty string if the file does not exist.
+  QString getExistingImageFile(int frameIdxInternal) const;
+
+  // ----- Decoding ahead during playback -----
+  // During playback, the frames after the current one are decoded by a pool of threads into a private buffer of this
+  // item. The frames are taken from there when they are pulled (for display or by the video cache). The cache of the
+  // video is never changed, so the video cache keeps track of everything that it holds. How many frames are decoded
+  // ahead depends on the frame rate and the measured decoding time.
+  QThreadPool decodePool;
+  QMutex decodeMutex;
+  QWaitCondition decodeFinished;
+  QSet<int> decodingFrames;                 // The frames that are scheduled or being decoded right now
+  QHash<int, QImage> decodedAheadImages;    // The decoded frames (8 bit images)
+  QHash<int, QByteArray> decodedAheadData;  // The decoded frames (raw data of high bit depth images)
+  double decodeDuration {0};                // Moving average of the time it takes to decode one frame (in ms)
+  // Schedule decoding of the frames after the given one
+  void startDecodeAhead(int frameIdxInternal);
+  // Stop decoding ahead and free the decoded frames
+  void stopDecodeAhead();
+  // Decode the given frame into the decoded ahead buffer. This runs in the decodePool.
+  void decodeFrameAhead(int frameIdxInternal);
+  // Load the frame from the image file
+  QImage loadFrameImage(int frameIdxInternal);
+  rawDataView loadRawFrameData(int frameIdxInternal);
+  // If the given frame is being decoded by the pool right now, wait until it is done
+  void waitForDecodeAhead(int frameIdxInternal);
 };
 
 #endif // PLAYLISTITEMIMAGEFILESEQUENCE_H
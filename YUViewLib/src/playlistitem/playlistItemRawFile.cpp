@@ -32,8 +32,13 @@
 
 #include "playlistItemRawFile.h"
 
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <QElapsedTimer>
 #include <QFileInfo>
 #include <QPainter>
+#include <QtConcurrent>
 #include <QUrl>
 #include <QVBoxLayout>
 
@@ -50,6 +55,10 @@ using namespace YUV_Internals;
 #define DEBUG_RAWFILE(fmt,...) ((void)0)
 #endif
 
+// The limits for reading ahead during playback. The ring of buffers never holds more than this.
+const int readAheadMaxFrames = 16;
+const int64_t readAheadMaxBytes = 256 * 1024 * 1024;
+
 playlistItemRawFile::playlistItemRawFile(const QString &rawFilePath, const QSize &frameSize, const QString &sourcePixelFormat, const QString &fmt)
   : playlistItemWithVideo(rawFilePath, playlistItem_Indexed)
 {
@@ -132,6 +141,11 @@ playlistItemRawFile::playlistItemRawFile(const QString &rawFilePath, const QSize
   cachingEnabled = true;
 }
 
+playlistItemRawFile::~playlistItemRawFile()
+{
+  stopReadAhead();
+}
+
 int64_t playlistItemRawFile::getNumberFrames() const
 {
   if (!dataSource.isOk() || !video->isFormatValid())
@@ -455,25 +469,259 @@ playlistItemRawFile *playlistItemRawFile::newplaylistItemRawFile(const YUViewDom
   return newFile;
 }
 
-void playlistItemRawFile::loadRawData(int frameIdxInternal)
+int64_t playlistItemRawFile::getFrameStartPos(int frameIdxInternal) const
 {
-  if (!video->isFormatValid())
-    return;
-
-  // Load the raw data for the given frameIdx from file and set it in the video
-  int64_t fileStartPos;
   if (isY4MFile)
-    fileStartPos = y4mFrameIndices.at(frameIdxInternal);
-  else
-    fileStartPos = frameIdxInternal * getBytesPerFrame();
-  int64_t nrBytes = getBytesPerFrame();
+    return (frameIdxInternal >= 0 && frameIdxInternal < y4mFrameIndices.count()) ? int64_t(y4mFrameIndices.at(frameIdxInternal)) : -1;
+  return frameIdxInternal * getBytesPerFrame();
+}
 
-  DEBUG_RAWFILE("playlistItemRawFile::loadRawData frame %d bytes %d", frameIdxInternal, int(nrBytes));
-  if (dataSource.readBytes(video->rawData, fileStartPos, nrBytes) < nrBytes)
+void playlistItemRawFile::loadRawData(int frameIdxInternal, bool caching)
+{
+  // Load the raw data for the given frameIdx from file and set it in the video
+  rawDataView frameData = pullRawFrameData(frameIdxInternal, caching);
+  if (frameData.isEmpty())
     return; // Error
+  video->rawData = frameData;
   video->rawData_frameIdx = frameIdxInternal;
+}
+
+rawDataView playlistItemRawFile::pullRawFrameData(int frameIdxInternal, bool caching)
+{
+  if (!video->isFormatValid())
+    return rawDataView();
 
-  DEBUG_RAWFILE("playlistItemRawFile::loadRawData %d Done", frameIdxInternal);
+  int64_t fileStartPos = getFrameStartPos(frameIdxInternal);
+  int64_t nrBytes = getBytesPerFrame();
+  if (fileStartPos < 0)
+    return rawDataView(); // Error
+
+  // Maybe the frame was already read in the background. The caching threads do not take frames from the ring. These
+  // frames are drawn next (or loaded into the double buffer).
+  QByteArray readAheadData;
+  if (!caching && takeReadAheadData(fileStartPos, nrBytes, readAheadData))
+  {
+    DEBUG_RAWFILE("playlistItemRawFile::pullRawFrameData frame %d from read ahead buffer", frameIdxInternal);
+    return rawDataView(readAheadData);
+  }
+
+  DEBUG_RAWFILE("playlistItemRawFile::pullRawFrameData frame %d bytes %d", frameIdxInternal, int(nrBytes));
+  // If the file is memory mapped, this does not copy the data. The converters read directly from the mapping.
+  // Reading is thread safe. Several threads can read from the file at the same time.
+  QElapsedTimer timer;
+  timer.start();
+  rawDataView frameData = dataSource.readBytesView(fileStartPos, nrBytes);
+  if (frameData.size() < nrBytes)
+    return rawDataView(); // Error
+  if (!frameData.isExternal())
+  {
+    QMutexLocker locker(&readAheadMutex);
+    updateReadThroughput(nrBytes, timer.nsecsElapsed());
+  }
+
+  DEBUG_RAWFILE("playlistItemRawFile::pullRawFrameData %d Done", frameIdxInternal);
+  return frameData;
+}
+
+void playlistItemRawFile::loadFrame(int frameIdx, bool playing, bool loadRawData, bool emitSignals)
+{
+  if (playing)
+    // Start reading the following frames before this frame is converted. The next frame will be
+    // loaded into the double buffer right away and can already be read in parallel.
+    startReadAhead(getFrameIdxInternal(frameIdx) + 1);
+  else
+  {
+    // Playback stopped. Free the buffers.
+    bool readAheadActive;
+    {
+      QMutexLocker locker(&readAheadMutex);
+      readAheadActive = readAheadRunning || !readAheadRing.isEmpty();
+    }
+    if (readAheadActive)
+      stopReadAhead();
+  }
+
+  playlistItemWithVideo::loadFrame(frameIdx, playing, loadRawData, emitSignals);
+}
+
+void playlistItemRawFile::startReadAhead(int frameIdxInternal)
+{
+  if (!video->isFormatValid() || !dataSource.isOk())
+    return;
+  const int64_t bytesPerFrame = getBytesPerFrame();
+  if (bytesPerFrame <= 0 || bytesPerFrame > INT_MAX || startEndFrame.second < startEndFrame.first)
+    return;
+
+  QMutexLocker locker(&readAheadMutex);
+
+  // On average, reading a frame must be faster than showing it. The longer reading a frame takes compared to
+  // the time that a frame is shown, the further ahead we read so that variations of the read speed are bridged.
+  int nrFrames = 2;
+  if (readThroughput > 0 && frameRate > 0)
+    nrFrames = int(std::ceil(bytesPerFrame / readThroughput * frameRate * 2)) + 1;
+  const int maxFramesMemory = int(std::max(readAheadMaxBytes / bytesPerFrame, int64_t(1)));
+  const int nrFramesInRange = startEndFrame.second - startEndFrame.first + 1;
+  nrFrames = clip(nrFrames, 1, std::min(std::min(readAheadMaxFrames, maxFramesMemory), nrFramesInRange));
+
+  // These are the frames that are shown next. Playback may wrap around to the first frame of the range.
+  QVector<int64_t> positions;
+  int frame = frameIdxInternal;
+  for (int i = 0; i < nrFrames; i++, frame++)
+  {
+    if (frame > startEndFrame.second || frame < startEndFrame.first)
+      frame = startEndFrame.first;
+    const int64_t pos = getFrameStartPos(frame);
+    if (pos >= 0)
+      positions.append(pos);
+  }
+
+  if (dataSource.isMemoryMapped())
+  {
+    // The frames are read directly from the mapping. Just tell the system to fetch the pages.
+    for (int64_t pos : positions)
+      dataSource.readAheadHint(pos, bytesPerFrame);
+    return;
+  }
+
+  // Free the buffers of frames which are not needed anymore
+  for (readAheadBuffer &b : readAheadRing)
+    if (b.fileStartPos >= 0 && (b.data.size() != bytesPerFrame || !positions.contains(b.fileStartPos)))
+      b.fileStartPos = -1;
+
+  // Tell the system about the frames that are not in the ring yet. It can already fetch them while the worker
+  // reads the frames one after another.
+  for (int64_t pos : positions)
+  {
+    bool buffered = (pos == readAheadInProgressPos);
+    for (const readAheadBuffer &b : readAheadRing)
+      buffered |= (b.fileStartPos == pos);
+    if (!buffered)
+      dataSource.readAheadHint(pos, bytesPerFrame);
+  }
+
+  readAheadPositions = positions;
+  readAheadFrameSize = bytesPerFrame;
+  if (!readAheadRunning)
+  {
+    readAheadRunning = true;
+    readAheadFuture = QtConcurrent::run(this, &playlistItemRawFile::readAheadWorker);
+  }
+}
+
+void playlistItemRawFile::stopReadAhead()
+{
+  {
+    QMutexLocker locker(&readAheadMutex);
+    readAheadCancel = true;
+  }
+  readAheadFuture.waitForFinished();
+
+  QMutexLocker locker(&readAheadMutex);
+  readAheadCancel = false;
+  readAheadRing.clear();
+  readAheadPositions.clear();
+}
+
+void playlistItemRawFile::readAheadWorker()
+{
+  while (true)
+  {
+    int64_t pos = -1;
+    int64_t nrBytes;
+    int slot = -1;
+    QByteArray buffer;
+    {
+      QMutexLocker locker(&readAheadMutex);
+
+      // Get the next frame that is not in the ring yet
+      if (!readAheadCancel)
+        for (int64_t p : readAheadPositions)
+        {
+          bool buffered = false;
+          for (const readAheadBuffer &b : readAheadRing)
+            buffered |= (b.fileStartPos == p);
+          if (!buffered)
+          {
+            pos = p;
+            break;
+          }
+        }
+
+      // Get a free buffer (or add one if the ring is not full yet)
+      if (pos >= 0)
+      {
+        for (int i = 0; i < readAheadRing.count() && slot == -1; i++)
+          if (readAheadRing[i].fileStartPos == -1)
+            slot = i;
+        if (slot == -1 && readAheadRing.count() < readAheadPositions.count())
+        {
+          readAheadRing.append(readAheadBuffer());
+          slot = readAheadRing.count() - 1;
+        }
+      }
+
+      if (pos < 0 || slot < 0)
+      {
+        // Nothing more to read or all buffers hold frames that are still needed
+        readAheadRunning = false;
+        readAheadFrameRead.wakeAll();
+        return;
+      }
+
+      // Reserve the buffer and read into it without holding the lock. The buffer is never shared, so
+      // no new memory is allocated if it already has the right size.
+      nrBytes = readAheadFrameSize;
+      buffer.swap(readAheadRing[slot].data);
+      readAheadRing[slot].fileStartPos = -2;
+      readAheadInProgressPos = pos;
+    }
+
+    buffer.resize(int(nrBytes));
+    QElapsedTimer timer;
+    timer.start();
+    const int64_t nrRead = dataSource.readBytes(buffer, pos, nrBytes);
+    const qint64 nsecs = timer.nsecsElapsed();
+
+    QMutexLocker locker(&readAheadMutex);
+    if (slot < readAheadRing.count())
+    {
+      readAheadRing[slot].data.swap(buffer);
+      readAheadRing[slot].fileStartPos = (nrRead == nrBytes) ? pos : -1;
+    }
+    if (nrRead == nrBytes)
+      updateReadThroughput(nrBytes, nsecs);
+    readAheadInProgressPos = -1;
+    readAheadFrameRead.wakeAll();
+    DEBUG_RAWFILE("playlistItemRawFile::readAheadWorker read %lld bytes at %lld", nrRead, pos);
+  }
+}
+
+bool playlistItemRawFile::takeReadAheadData(int64_t fileStartPos, int64_t nrBytes, QByteArray &data)
+{
+  QMutexLocker locker(&readAheadMutex);
+
+  // If the frame is being read right now, wait for it instead of reading it a second time.
+  while (readAheadInProgressPos == fileStartPos)
+    readAheadFrameRead.wait(&readAheadMutex);
+
+  for (readAheadBuffer &b : readAheadRing)
+    if (b.fileStartPos == fileStartPos && b.data.size() == nrBytes)
+    {
+      // Copy the data. If the ring shared its buffer with the caller, the next read into the buffer would allocate.
+      data = QByteArray(b.data.constData(), b.data.size());
+      b.fileStartPos = -1;
+      return true;
+    }
+  return false;
+}
+
+void playlistItemRawFile::updateReadThroughput(int64_t nrBytes, qint64 nsecs)
+{
+  // The readAheadMutex must be locked
+  if (nsecs <= 0)
+    return;
+  const double bytesPerSecond = double(nrBytes) * 1e9 / double(nsecs);
+  readThroughput = (readThroughput <= 0) ? bytesPerSecond : readThroughput * 0.8 + bytesPerSecond * 0.2;
 }
 
 ValuePairListSets playlistItemRawFile::getPixelValues(const QPoint &pixelPos, int frameIdx)
@@ -501,6 +749,9 @@ void playlistItemRawFile::getSupportedFileExtensions(QStringList &allExtensions,
 
 void playlistItemRawFile::reloadItemSource()
 {
+  // The data that was read ahead is outdated
+  stopReadAhead();
+
   // Reopen the file
   dataSource.openFile(plItemNameOrFileName);
   if (!dataSource.isOk())
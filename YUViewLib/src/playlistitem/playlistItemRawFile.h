@@ -34,7 +34,10 @@
 #define PLAYLISTITEMRAWFILE_H
 
 #include <QFuture>
+#include <QMutex>
 #include <QString>
+#include <QVector>
+#include <QWaitCondition>
 
 #include "filesource/fileSource.h"
 #include "playlistItemWithVideo.h"
@@ -49,6 +52,7 @@ public:
   // extensions (getSupportedFileExtensions), set the format "fmt" to either "rgb" or "yuv". If you already know the frame size and/or 
   // sourcePixelFormat, you can set them as well.
   playlistItemRawFile(const QString &rawFilePath, const QSize &frameSize=QSize(-1,-1), const QString &sourcePixelFormat=QString(), const QString &fmt=QString());
+  virtual ~playlistItemRawFile();
 
   // Overload from playlistItem. Save the raw file item to playlist.
   virtual void savePlaylist(QDomElement &root, const QDir &playlistDir) const Q_DECL_OVERRIDE;
@@ -74,15 +78,23 @@ public:
   // ----- Detection of source/file change events -----
   virtual bool isSourceChanged()  Q_DECL_OVERRIDE { return dataSource.isFileChanged(); }
   virtual void reloadItemSource() Q_DECL_OVERRIDE;
-  virtual void updateSettings()   Q_DECL_OVERRIDE { dataSource.updateFileWatchSetting(); }
+  virtual void updateSettings()   Q_DECL_OVERRIDE { dataSource.updateFileWatchSetting(); dataSource.updateMemoryMapSetting(); playlistItemWithVideo::updateSettings(); }
 
   // Cache the given frame
-  virtual void cacheFrame(int idx, bool testMode) Q_DECL_OVERRIDE { if (testMode) dataSource.clearFileCache(); playlistItemWithVideo::cacheFrame(idx, testMode); }
+  virtual int cacheFrame(int idx, bool testMode) Q_DECL_OVERRIDE { if (testMode) dataSource.clearFileCache(); return playlistItemWithVideo::cacheFrame(idx, testMode); }
+
+  // The raw data of any frame can be read from the file by several threads at the same time. Only the frames that
+  // are drawn (not the ones that are cached) are taken from the read ahead buffers.
+  virtual bool canPullRawFrameData() const Q_DECL_OVERRIDE { return true; }
+  virtual rawDataView pullRawFrameData(int frameIdxInternal, bool caching) Q_DECL_OVERRIDE;
+
+  // Load the given frame. During playback, the following frames are read from the file in the background.
+  virtual void loadFrame(int frameIdx, bool playing, bool loadRawData, bool emitSignals=true) Q_DECL_OVERRIDE;
 
 public slots:
   // Load the raw data for the given frame index from file. This slot is called by the videoHandler if the frame that is
   // requested to be drawn has not been loaded yet.
-  virtual void loadRawData(int frameIdxInternal);
+  virtual void loadRawData(int frameIdxInternal, bool caching);
 
 protected:
   // Override from playlistItemIndexed. For a raw file the index range is 0...numFrames-1. 
@@ -92,6 +104,36 @@ protected:
   // returns false then it failed.
   void setFormatFromFileName();
   
+  // ----- Read ahead during playback -----
+  // During playback, the frames after the current one are read in the background into a small ring of buffers.
+  // So the file access (which can be slow for large frames or network storage) does not delay the playback.
+  // How many frames are read ahead depends on the frame rate and on the measured read throughput.
+  struct readAheadBuffer
+  {
+    int64_t fileStartPos {-1};   // The position of the frame in the file (-1 if the buffer is free)
+    QByteArray data;
+  };
+  QVector<readAheadBuffer> readAheadRing;
+  QVector<int64_t> readAheadPositions;       // The file positions of the frames that are to be read (in this order)
+  int64_t readAheadFrameSize {0};
+  int64_t readAheadInProgressPos {-1};       // The frame (file position) that is currently being read
+  bool readAheadRunning {false};
+  bool readAheadCancel {false};
+  double readThroughput {0};                 // Moving average of the read speed in bytes per second
+  QMutex readAheadMutex;
+  QWaitCondition readAheadFrameRead;
+  QFuture<void> readAheadFuture;
+  // Start reading the frames after the given one in the background
+  void startReadAhead(int frameIdxInternal);
+  // Stop the background reading and clear the buffers
+  void stopReadAhead();
+  // The function that reads the frames in the background
+  void readAheadWorker();
+  // If the data at the given position was read ahead, copy it out of the ring and free the buffer. If it is currently
+  // being read, wait. The ring keeps its buffers so that the worker can read the next frames without allocating.
+  bool takeReadAheadData(int64_t fileStartPos, int64_t nrBytes, QByteArray &data);
+  void updateReadThroughput(int64_t nrBytes, qint64 nsecs);
+
 private:
 
   // Overload from playlistItem. Create a properties widget custom to the RawFile
@@ -103,6 +145,8 @@ private:
   fileSource dataSource;
 
   int64_t getBytesPerFrame() const { return video->getBytesPerFrame(); }
+  // Get the position of the given frame in the file
+  int64_t getFrameStartPos(int frameIdxInternal) const;
 
   // A y4m file is a raw YUV file but it adds a header (which has information about the YUV format)
   // and start indicators for every frame. This file will parse the header and save all the byte
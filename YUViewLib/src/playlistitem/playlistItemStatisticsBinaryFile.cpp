@@ -0,0 +1,153 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "playlistItemStatisticsBinaryFile.h"
+
+#include <QScopedPointer>
+
+#include "playlistItemStatisticsCSVFile.h"
+#include "playlistItemStatisticsVTMBMSFile.h"
+
+playlistItemStatisticsBinaryFile::playlistItemStatisticsBinaryFile(const QString &itemNameOrFileName)
+  : playlistItemStatisticsFile(itemNameOrFileName)
+{
+  // The records of a frame are read in one block. The values within a frame are not sorted by type.
+  fileSortedByPOC = true;
+
+  readHeaderFromFile();
+
+  connect(&statSource, &statisticHandler::updateItem, [this](bool redraw){ emit signalItemChanged(redraw, RECACHE_NONE); });
+  connect(&statSource, &statisticHandler::requestStatisticsLoading, this, &playlistItemStatisticsBinaryFile::loadStatisticToCache, Qt::DirectConnection);
+}
+
+void playlistItemStatisticsBinaryFile::readHeaderFromFile()
+{
+  statSource.clearStatTypes();
+  frameTypeTable.clear();
+  if (!file.isOk())
+    return;
+
+  statisticsBinaryFile::fileHeader header;
+  if (!statisticsBinaryFile::readFileHeader(file, header, parsingError))
+    return;
+
+  for (const StatisticsType &aType : header.types)
+    statSource.addStatType(aType);
+  if (header.frameSize.isValid())
+    statSource.setFrameSize(header.frameSize);
+  if (header.frameRate > 0.0)
+    frameRate = header.frameRate;
+  maxPOC = header.maxPOC;
+  frameTypeTable = header.table;
+}
+
+void playlistItemStatisticsBinaryFile::loadStatisticToCache(int frameIdxInternal, int typeID)
+{
+  const statisticsBinaryFile::frameTypeEntry *entry = statisticsBinaryFile::findEntry(frameTypeTable, frameIdxInternal, typeID);
+  if (!file.isOk() || entry == nullptr)
+  {
+    // There are no statistics in the file for the given frame and index.
+    statSource.statsCache.insert(typeID, statisticsData());
+    return;
+  }
+
+  const rawDataView data = file.readBytesView(entry->offset, entry->size);
+  statisticsData &cacheData = statSource.statsCache[typeID];
+  if ((entry->size > 0 && data.isEmpty()) || !statisticsBinaryFile::decodeFrameType(data.data(), *entry, cacheData))
+  {
+    parsingError = QString("The statistics of frame %1 and type %2 are corrupt.").arg(frameIdxInternal).arg(typeID);
+    cacheData = statisticsData();
+  }
+}
+
+playlistItemStatisticsBinaryFile *playlistItemStatisticsBinaryFile::newplaylistItemStatisticsBinaryFile(const YUViewDomElement &root, const QString &playlistFilePath)
+{
+  // Parse the DOM element. It should have all values of a playlistItemStatisticsFile
+  QString absolutePath = root.findChildValue("absolutePath");
+  QString relativePath = root.findChildValue("relativePath");
+
+  // check if file with absolute path exists, otherwise check relative path
+  QString filePath = fileSource::getAbsPathFromAbsAndRel(playlistFilePath, absolutePath, relativePath);
+  if (filePath.isEmpty())
+    return nullptr;
+
+  // We can still not be sure that the file really exists, but we gave our best to try to find it.
+  playlistItemStatisticsBinaryFile *newStat = new playlistItemStatisticsBinaryFile(filePath);
+
+  // Load the propertied of the playlistItem
+  playlistItem::loadPropertiesFromPlaylist(root, newStat);
+
+  // Load the status of the statistics (which are shown, transparency ...)
+  newStat->statSource.loadPlaylist(root);
+
+  return newStat;
+}
+
+void playlistItemStatisticsBinaryFile::reloadItemSource()
+{
+  // Set default variables
+  blockOutsideOfFrame_idx = -1;
+  parsingError.clear();
+  currentDrawnFrameIdx = -1;
+  maxPOC = 0;
+
+  statSource.statsCache.clear();
+  statSource.statsCacheFrameIdx = -1;
+
+  // Reopen the file
+  file.openFile(plItemNameOrFileName);
+  readHeaderFromFile();
+
+  statSource.updateStatisticsHandlerControls();
+}
+
+void playlistItemStatisticsBinaryFile::getSupportedFileExtensions(QStringList &allExtensions, QStringList &filters)
+{
+  allExtensions.append("yuvstat");
+  filters.append("Binary Statistics File (*.yuvstat)");
+}
+
+bool playlistItemStatisticsBinaryFile::convertStatisticsFile(const QString &sourceFile, const QString &targetFile, QString &errorText, std::function<bool(int)> progressCallback)
+{
+  QScopedPointer<playlistItemStatisticsFile> source(newStatisticsFileForConversion(sourceFile));
+  return source->writeBinaryFile(targetFile, errorText, progressCallback);
+}
+
+playlistItemStatisticsFile *playlistItemStatisticsBinaryFile::newStatisticsFileForConversion(const QString &sourceFile)
+{
+  QStringList vtmbmsExtensions, filters;
+  playlistItemStatisticsVTMBMSFile::getSupportedFileExtensions(vtmbmsExtensions, filters);
+
+  if (vtmbmsExtensions.contains(QFileInfo(sourceFile).suffix().toLower()))
+    return new playlistItemStatisticsVTMBMSFile(sourceFile);
+  return new playlistItemStatisticsCSVFile(sourceFile);
+}
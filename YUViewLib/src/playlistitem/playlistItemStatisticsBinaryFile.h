@@ -0,0 +1,84 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PLAYLISTITEMSTATISTICSBINARYFILE_H
+#define PLAYLISTITEMSTATISTICSBINARYFILE_H
+
+#include <functional>
+
+#include "playlistItemStatisticsFile.h"
+#include "statistics/statisticsBinaryFile.h"
+
+/* A statistics file in the binary statistics format (see statisticsBinaryFile.h). The header and the frame/type table
+ * are read when the file is opened. No background parsing is needed. When a frame/type is requested, the records
+ * are read (from the memory mapped file if mapping is enabled) and decoded directly into the statistics cache.
+ */
+class playlistItemStatisticsBinaryFile : public playlistItemStatisticsFile
+{
+  Q_OBJECT
+
+public:
+
+  playlistItemStatisticsBinaryFile(const QString &itemNameOrFileName);
+
+  // Create a new playlistItemStatisticsBinaryFile from the playlist file entry. Return nullptr if parsing failed.
+  static playlistItemStatisticsBinaryFile *newplaylistItemStatisticsBinaryFile(const YUViewDomElement &root, const QString &playlistFilePath);
+
+  // Add the file type filters and the extensions of files that we can load.
+  static void getSupportedFileExtensions(QStringList &allExtensions, QStringList &filters);
+
+  // Convert a CSV or VTMBMS statistics file (selected by the file extension) to a binary statistics file.
+  // See playlistItemStatisticsFile::writeBinaryFile for the progress callback.
+  static bool convertStatisticsFile(const QString &sourceFile, const QString &targetFile, QString &errorText, std::function<bool(int)> progressCallback=nullptr);
+  // Open a CSV or VTMBMS statistics file (selected by the file extension) as the source of a conversion
+  static playlistItemStatisticsFile *newStatisticsFileForConversion(const QString &sourceFile);
+
+  // ----- Detection of source/file change events -----
+  virtual void reloadItemSource() Q_DECL_OVERRIDE;
+
+public slots:
+  virtual void loadStatisticToCache(int frameIdxInternal, int typeID) Q_DECL_OVERRIDE;
+
+protected:
+  virtual bool canConvertToBinaryFile() const Q_DECL_OVERRIDE { return false; }
+
+private:
+  QString getPlaylistTag() const Q_DECL_OVERRIDE { return "playlistItemStatisticsBinaryFile"; }
+
+  // Read the header, the types and the frame/type table
+  void readHeaderFromFile();
+
+  // The frame/type table of the file (sorted by frame index and type ID)
+  QVector<statisticsBinaryFile::frameTypeEntry> frameTypeTable;
+};
+
+#endif // PLAYLISTITEMSTATISTICSBINARYFILE_H
@@ -32,11 +32,16 @@
 
 #include "playlistItemStatisticsCSVFile.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include <QDebug>
 #include <QtConcurrent>
+#include <QThreadPool>
 #include <QTime>
+
+#include "common/functions.h"
 #include "statistics/statisticsExtensions.h"
 
 // The internal buffer for parsing the starting positions. The buffer must not be larger than 2GB
@@ -64,153 +69,251 @@ playlistItemStatisticsCSVFile::playlistItemStatisticsCSVFile(const QString &item
   connect(&statSource, &statisticHandler::requestStatisticsLoading, this, &playlistItemStatisticsCSVFile::loadStatisticToCache, Qt::DirectConnection);
 }
 
+namespace
+{
+  // The file is split into chunks which are indexed in parallel. A chunk is never smaller than this.
+  const qint64 STAT_PARSING_MIN_CHUNK_SIZE = 16 * 1024 * 1024;
+
+  bool isCSVWhitespace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
+}
+
+bool playlistItemStatisticsCSVFile::parsePOCAndType(const char *p, const char *end, int &poc, int &typeID)
+{
+  while (p < end && isCSVWhitespace(*p))
+    p++;
+  if (p == end || *p == ';' || *p == '%')
+    return false;
+
+  for (int field = 0; field <= 5; field++)
+  {
+    int value = 0;
+    bool negative = false;
+    bool signAllowed = true;
+    bool valid = true;
+    for (; p < end && *p != ';'; p++)
+    {
+      const char c = *p;
+      if (isCSVWhitespace(c))
+        continue;
+      if (signAllowed && (c == '-' || c == '+'))
+        negative = (c == '-');
+      else if (c >= '0' && c <= '9')
+        value = value * 10 + (c - '0');
+      else
+        valid = false;
+      signAllowed = false;
+    }
+    if (!valid)
+      value = 0;
+    if (field == 0)
+      poc = negative ? -value : value;
+    else if (field == 5)
+    {
+      typeID = negative ? -value : value;
+      return true;
+    }
+    if (p == end)
+      return false;
+    // Skip the ';'
+    p++;
+  }
+  return false;
+}
+
+QVector<playlistItemStatisticsCSVFile::pocTypeStart> playlistItemStatisticsCSVFile::indexCSVChunk(fileSource *inputFile, qint64 chunkStart, qint64 chunkEnd, const bool *cancel)
+{
+  QVector<pocTypeStart> starts;
+  int lastPOC = INT_INVALID;
+  int lastType = INT_INVALID;
+
+  QByteArray inputBuffer;
+  QByteArray lineBuffer;
+  qint64 bufferStartPos = (chunkStart > 0) ? chunkStart - 1 : 0;
+  // Before the first newline, we are still in the last line of the previous chunk
+  bool inFirstLine = (chunkStart > 0);
+  qint64 lineStartPos = chunkStart;
+
+  while (!*cancel && lineStartPos < chunkEnd)
+  {
+    const qint64 bufferSize = inputFile->readBytes(inputBuffer, bufferStartPos, STAT_PARSING_BUFFER_SIZE);
+    if (bufferSize <= 0)
+      break;
+    const char *bufferData = inputBuffer.constData();
+    const char *bufferEnd = bufferData + bufferSize;
+    const char *p = bufferData;
+
+    while (p < bufferEnd && lineStartPos < chunkEnd)
+    {
+      const char *newline = (const char*)memchr(p, '\n', bufferEnd - p);
+      if (newline == nullptr)
+      {
+        // The line continues in the next buffer. A corrupted file may contain an arbitrary amount of
+        // non-newline characters. Do not let the line buffer grow without limit.
+        if (!inFirstLine)
+        {
+          if (lineBuffer.size() > STAT_MAX_STRING_SIZE)
+            lineBuffer.clear();
+          lineBuffer.append(p, int(bufferEnd - p));
+        }
+        break;
+      }
+
+      if (!inFirstLine)
+      {
+        int poc, typeID;
+        bool lineValid;
+        if (lineBuffer.isEmpty())
+          lineValid = parsePOCAndType(p, newline, poc, typeID);
+        else
+        {
+          lineBuffer.append(p, int(newline - p));
+          lineValid = parsePOCAndType(lineBuffer.constData(), lineBuffer.constData() + lineBuffer.size(), poc, typeID);
+          lineBuffer.clear();
+        }
+
+        if (lineValid && (poc != lastPOC || typeID != lastType))
+        {
+          starts.append(pocTypeStart{poc, typeID, lineStartPos});
+          lastPOC = poc;
+          lastType = typeID;
+        }
+      }
+
+      inFirstLine = false;
+      lineStartPos = bufferStartPos + (newline - bufferData) + 1;
+      p = newline + 1;
+    }
+
+    if (bufferSize < STAT_PARSING_BUFFER_SIZE)
+      // The file is at the end
+      break;
+    bufferStartPos += bufferSize;
+  }
+
+  return starts;
+}
+
 /** The background task that parses the file and extracts the exact file positions
 * where a new frame or a new type starts. If the user then later requests this type/POC
 * we can directly jump there and parse the actual information. This way we don't have to
 * scan the whole file which can get very slow for large files.
 *
+* The file is split into chunks at arbitrary positions. The chunks are indexed in parallel (indexCSVChunk) and
+* the results are merged in file order so that the positions of the beginning of the file are available first.
+*
 * This function might emit the objectInformationChanged() signal if something went wrong,
 * setting the error message, or if parsing finished successfully.
 */
 void playlistItemStatisticsCSVFile::readFrameAndTypePositionsFromFile()
 {
+  // Open the file (again). Since this is a background process, we open the file again to
+  // not disturb any reading from not background code. All chunk workers read from this file.
+  fileSource inputFile;
+  if (!inputFile.openFile(file.absoluteFilePath()))
+    return;
+
+  const qint64 fileSize = inputFile.getFileSize();
+  const int nrThreads = functions::getOptimalThreadCount();
+  // Use more chunks than threads so that the first results are merged early and the load is balanced
+  const qint64 chunkSize = std::max(STAT_PARSING_MIN_CHUNK_SIZE, fileSize / (nrThreads * 4) + 1);
+
+  QThreadPool chunkThreadPool;
+  chunkThreadPool.setMaxThreadCount(nrThreads);
+  QList<QFuture<QVector<pocTypeStart>>> chunkFutures;
+  for (qint64 chunkStart = 0; chunkStart < fileSize; chunkStart += chunkSize)
+    chunkFutures.append(QtConcurrent::run(&chunkThreadPool, indexCSVChunk, &inputFile, chunkStart, std::min(chunkStart + chunkSize, fileSize), &cancelBackgroundParser));
+
   try
   {
-    // Open the file (again). Since this is a background process, we open the file again to
-    // not disturb any reading from not background code.
-    fileSource inputFile;
-    if (!inputFile.openFile(file.absoluteFilePath()))
-      return;
+    int  lastPOC = INT_INVALID;
+    int  lastType = INT_INVALID;
+    bool sortingFixed = false;
 
-    // We perform reading using an input buffer
-    QByteArray inputBuffer;
-    bool fileAtEnd = false;
-    qint64 bufferStartPos = 0;
-
-    QString lineBuffer;
-    qint64  lineBufferStartPos = 0;
-    int     lastPOC = INT_INVALID;
-    int     lastType = INT_INVALID;
-    bool    sortingFixed = false; 
-    
-    while (!fileAtEnd && !cancelBackgroundParser)
+    for (int chunk = 0; chunk < chunkFutures.size() && !cancelBackgroundParser; chunk++)
     {
-      // Fill the buffer
-      int bufferSize = inputFile.readBytes(inputBuffer, bufferStartPos, STAT_PARSING_BUFFER_SIZE);
-      if (bufferSize < STAT_PARSING_BUFFER_SIZE)
-        // Less bytes than the maximum buffer size were read. The file is at the end.
-        // This is the last run of the loop.
-        fileAtEnd = true;
-      // a corrupted file may contain an arbitrary amount of non-\n symbols
-      // prevent lineBuffer overflow by dumping it for such cases
-      if (lineBuffer.size() > STAT_MAX_STRING_SIZE)
-        lineBuffer.clear(); // prevent an overflow here
-      for (int i = 0; i < bufferSize; i++)
+      for (const pocTypeStart &start : chunkFutures[chunk].result())
       {
-        // Search for '\n' newline characters
-        if (inputBuffer.at(i) == 10)
+        const int poc = start.poc;
+        const int typeID = start.typeID;
+
+        if (typeID == lastType && poc == lastPOC)
+          // The chunk continues the data of the previous chunk
+          continue;
+
+        if (lastType == -1 && lastPOC == -1)
         {
-          // We found a newline character
-          if (lineBuffer.size() > 0)
+          // First POC/type line
+          pocTypeStartList[poc][typeID] = start.pos;
+          if (poc == currentDrawnFrameIdx)
+            // We added a start position for the frame index that is currently drawn. We might have to redraw.
+            emit signalItemChanged(true, RECACHE_NONE);
+
+          lastType = typeID;
+          lastPOC = poc;
+
+          // update number of frames
+          if (poc > maxPOC)
+            maxPOC = poc;
+        }
+        else if (typeID != lastType && poc == lastPOC)
+        {
+          // we found a new type but the POC stayed the same.
+          // This seems to be an interleaved file
+          // Check if we already collected a start position for this type
+          if (!sortingFixed)
           {
-            // Parse the previous line
-            // get components of this line
-            QStringList rowItemList = parseCSVLine(lineBuffer, ';');
-
-            // ignore empty entries and headers
-            if (!rowItemList[0].isEmpty() && rowItemList[0][0] != '%')
-            {
-              // check for POC/type information
-              int poc = rowItemList[0].toInt();
-              int typeID = rowItemList[5].toInt();
-
-              if (lastType == -1 && lastPOC == -1)
-              {
-                // First POC/type line
-                pocTypeStartList[poc][typeID] = lineBufferStartPos;
-                if (poc == currentDrawnFrameIdx)
-                  // We added a start position for the frame index that is currently drawn. We might have to redraw.
-                  emit signalItemChanged(true, RECACHE_NONE);
-
-                lastType = typeID;
-                lastPOC = poc;
-
-                // update number of frames
-                if (poc > maxPOC)
-                  maxPOC = poc;
-              }
-              else if (typeID != lastType && poc == lastPOC)
-              {
-                // we found a new type but the POC stayed the same.
-                // This seems to be an interleaved file
-                // Check if we already collected a start position for this type
-                if (!sortingFixed)
-                {
-                  // we only check the first occurence of this, in a non-interleaved file
-                  // the above condition can be met and will reset fileSortedByPOC
-                  
-                  fileSortedByPOC = true;
-                  sortingFixed = true; 
-                }
-                lastType = typeID;
-                if (!pocTypeStartList[poc].contains(typeID))
-                {
-                  pocTypeStartList[poc][typeID] = lineBufferStartPos;
-                  if (poc == currentDrawnFrameIdx)
-                    // We added a start position for the frame index that is currently drawn. We might have to redraw.
-                    emit signalItemChanged(true, RECACHE_NONE);
-                }
-              }
-              else if (poc != lastPOC)
-              {
-                // this is apparently not sorted by POCs and we will not check it further
-                if(!sortingFixed)
-                  sortingFixed = true;
-                
-                // We found a new POC
-                if (fileSortedByPOC)
-                {
-                  // There must not be a start position for any type with this POC already.
-                  if (pocTypeStartList.contains(poc))
-                    throw "The data for each POC must be continuous in an interleaved statistics file->";
-                }
-                else
-                {
-                
-                  // There must not be a start position for this POC/type already.
-                  if (pocTypeStartList.contains(poc) && pocTypeStartList[poc].contains(typeID))
-                    throw "The data for each typeID must be continuous in an non interleaved statistics file->";
-                }
-
-                lastPOC = poc;
-                lastType = typeID;
-
-                pocTypeStartList[poc][typeID] = lineBufferStartPos;
-                if (poc == currentDrawnFrameIdx)
-                  // We added a start position for the frame index that is currently drawn. We might have to redraw.
-                  emit signalItemChanged(true, RECACHE_NONE);
-
-                // update number of frames
-                if (poc > maxPOC)
-                  maxPOC = poc;
-
-                // Update percent of file parsed
-                backgroundParserProgress = ((double)lineBufferStartPos * 100 / (double)inputFile.getFileSize());
-              }
-            }
-          }
+            // we only check the first occurence of this, in a non-interleaved file
+            // the above condition can be met and will reset fileSortedByPOC
 
-          lineBuffer.clear();
-          lineBufferStartPos = bufferStartPos + i + 1;
+            fileSortedByPOC = true;
+            sortingFixed = true;
+          }
+          lastType = typeID;
+          if (!pocTypeStartList[poc].contains(typeID))
+          {
+            pocTypeStartList[poc][typeID] = start.pos;
+            if (poc == currentDrawnFrameIdx)
+              // We added a start position for the frame index that is currently drawn. We might have to redraw.
+              emit signalItemChanged(true, RECACHE_NONE);
+          }
         }
-        else
+        else if (poc != lastPOC)
         {
-          // No newline character found
-          lineBuffer.append(inputBuffer.at(i));
+          // this is apparently not sorted by POCs and we will not check it further
+          if(!sortingFixed)
+            sortingFixed = true;
+
+          // We found a new POC
+          if (fileSortedByPOC)
+          {
+            // There must not be a start position for any type with this POC already.
+            if (pocTypeStartList.contains(poc))
+              throw "The data for each POC must be continuous in an interleaved statistics file->";
+          }
+          else
+          {
+
+            // There must not be a start position for this POC/type already.
+            if (pocTypeStartList.contains(poc) && pocTypeStartList[poc].contains(typeID))
+              throw "The data for each typeID must be continuous in an non interleaved statistics file->";
+          }
+
+          lastPOC = poc;
+          lastType = typeID;
+
+          pocTypeStartList[poc][typeID] = start.pos;
+          if (poc == currentDrawnFrameIdx)
+            // We added a start position for the frame index that is currently drawn. We might have to redraw.
+            emit signalItemChanged(true, RECACHE_NONE);
+
+          // update number of frames
+          if (poc > maxPOC)
+            maxPOC = poc;
         }
       }
 
-      bufferStartPos += bufferSize;
+      // Update percent of file parsed
+      backgroundParserProgress = (double)std::min((chunk + 1) * chunkSize, fileSize) * 100 / (double)fileSize;
     }
 
     // Parsing complete
@@ -222,20 +325,30 @@ void playlistItemStatisticsCSVFile::readFrameAndTypePositionsFromFile()
   } // try
   catch (const char *str)
   {
+    // Stop the chunk workers right away. The thread pool waits for them before it is destroyed.
+    cancelBackgroundParser = true;
     std::cerr << "Error while parsing meta data: " << str << "\n";
     parsingError = QString("Error while parsing meta data: ") + QString(str);
     emit signalItemChanged(false, RECACHE_NONE);
-    return;
   }
   catch (const std::exception& ex)
   {
+    cancelBackgroundParser = true;
     std::cerr << "Error while parsing:" << ex.what() << "\n";
     parsingError = QString("Error while parsing: ") + QString(ex.what());
     emit signalItemChanged(false, RECACHE_NONE);
-    return;
+  }
+  catch (...)
+  {
+    // Do not let the workers index the rest of the file before the exception is passed on
+    cancelBackgroundParser = true;
+    chunkThreadPool.waitForDone();
+    throw;
   }
 
-  return;
+  // Stop the remaining chunk workers (if parsing was aborted). The workers use inputFile.
+  cancelBackgroundParser = true;
+  chunkThreadPool.waitForDone();
 }
 
 void playlistItemStatisticsCSVFile::readHeaderFromFile()
@@ -64,11 +64,30 @@ public:
 
   // ----- Detection of source/file change events -----
   virtual void reloadItemSource() Q_DECL_OVERRIDE;
+
+  // ----- Indexing -----
+  // The start of a run of lines with the same POC and type in the file
+  struct pocTypeStart
+  {
+    int poc;
+    int typeID;
+    qint64 pos;
+  };
+  // Get the POC (first field) and the type ID (sixth field) of a CSV line without allocating memory.
+  // Like in parseCSVLine, whitespace is ignored and fields that are no number are 0.
+  // Return false for lines that are ignored (empty lines, header lines starting with '%' and lines with less than 6 fields).
+  static bool parsePOCAndType(const char *p, const char *end, int &poc, int &typeID);
+  // Index the lines that start in [chunkStart, chunkEnd). The first (partial) line belongs to the previous chunk
+  // and the last line may end after chunkEnd. Only lines that end with a newline are indexed. Every time
+  // that the POC or the type changes from one line to the next, the start of the line is added to the list.
+  // The background parser indexes the chunks of the file in parallel and merges the lists in file order.
+  static QVector<pocTypeStart> indexCSVChunk(fileSource *inputFile, qint64 chunkStart, qint64 chunkEnd, const bool *cancel);
+
 public slots:
   //! Load the statistics with frameIdx/type from file and put it into the cache.
   //! If the statistics file is in an interleaved format (types are mixed within one POC) this function also parses
   //! types which were not requested by the given 'type'.
-  void loadStatisticToCache(int frameIdxInternal, int type);
+  virtual void loadStatisticToCache(int frameIdxInternal, int type) Q_DECL_OVERRIDE;
 
 private:
 
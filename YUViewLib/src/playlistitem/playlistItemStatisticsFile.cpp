@@ -35,10 +35,17 @@
 #include <cassert>
 #include <iostream>
 #include <QDebug>
+#include <QFileDialog>
+#include <QMessageBox>
+#include <QProgressDialog>
+#include <QPushButton>
 #include <QTime>
 #include <QUrl>
+#include <QtConcurrent>
 
 #include "common/functions.h"
+#include "playlistItemStatisticsBinaryFile.h"
+#include "statistics/statisticsBinaryFile.h"
 #include "statistics/statisticsExtensions.h"
 
 // The internal buffer for parsing the starting positions. The buffer must not be larger than 2GB
@@ -60,6 +67,8 @@ playlistItemStatisticsFile::playlistItemStatisticsFile(const QString &itemNameOr
   // Set statistics icon
   setIcon(0, functions::convertIcon(":img_stats.png"));
 
+  connect(this, &playlistItemStatisticsFile::signalConversionFinished, this, &playlistItemStatisticsFile::onConversionFinished, Qt::QueuedConnection);
+
   file.openFile(itemNameOrFileName);
   if (!file.isOk())
     return;
@@ -67,6 +76,8 @@ playlistItemStatisticsFile::playlistItemStatisticsFile(const QString &itemNameOr
 
 playlistItemStatisticsFile::~playlistItemStatisticsFile()
 {
+  cancelConversion();
+
   // The playlistItemStatisticsFile object is being deleted.
   // Check if the background thread is still running.
   if (backgroundParserFuture.isRunning())
@@ -150,6 +161,12 @@ void playlistItemStatisticsFile::createPropertiesWidget()
   line->setFrameShadow(QFrame::Sunken);
 
   vAllLaout->addLayout(createPlaylistItemControls());
+  if (canConvertToBinaryFile())
+  {
+    QPushButton *convertButton = new QPushButton("Convert to binary statistics file...");
+    connect(convertButton, &QPushButton::clicked, this, &playlistItemStatisticsFile::onConvertToBinaryFileButtonClicked);
+    vAllLaout->addWidget(convertButton);
+  }
   vAllLaout->addWidget(line);
   vAllLaout->addLayout(statSource.createStatisticsHandlerControls());
 
@@ -194,3 +211,130 @@ void playlistItemStatisticsFile::loadFrame(int frameIdx, bool playback, bool loa
       emit signalItemChanged(true, RECACHE_NONE);
   }
 }
+
+bool playlistItemStatisticsFile::writeBinaryFile(const QString &filePath, QString &errorText, std::function<bool(int)> progressCallback)
+{
+  if (!file.isOk())
+  {
+    errorText = "The statistics file could not be opened.";
+    return false;
+  }
+
+  // The positions of all frames/types must be known before the statistics can be converted
+  if (progressCallback && !progressCallback(0))
+    return false;
+  backgroundParserFuture.waitForFinished();
+
+  const StatisticsTypeList types = statSource.getStatisticsTypeList();
+  statisticsBinaryFile::writer binaryWriter(filePath);
+  if (!binaryWriter.start(statSource.getFrameSize(), frameRate, types))
+  {
+    errorText = binaryWriter.errorString();
+    return false;
+  }
+
+  for (int frameIdx = 0; frameIdx <= maxPOC; frameIdx++)
+  {
+    if (progressCallback && !progressCallback(int(qint64(frameIdx) * 100 / (maxPOC + 1))))
+      return false;
+
+    // Depending on the file, loading one type can also load other types of the same frame
+    statSource.statsCache.clear();
+    for (const StatisticsType &aType : types)
+      if (!statSource.statsCache.contains(aType.typeID))
+        loadStatisticToCache(frameIdx, aType.typeID);
+
+    for (const StatisticsType &aType : types)
+    {
+      auto it = statSource.statsCache.constFind(aType.typeID);
+      if (it == statSource.statsCache.constEnd())
+        continue;
+      const statisticsData &data = it.value();
+      if (data.isEmpty())
+        continue;
+      if (!binaryWriter.writeFrameType(frameIdx, aType.typeID, data))
+      {
+        errorText = binaryWriter.errorString();
+        return false;
+      }
+    }
+  }
+  statSource.statsCache.clear();
+  statSource.statsCacheFrameIdx = -1;
+
+  if (!binaryWriter.finish(maxPOC))
+  {
+    errorText = binaryWriter.errorString();
+    return false;
+  }
+  if (progressCallback)
+    progressCallback(100);
+  return true;
+}
+
+void playlistItemStatisticsFile::onConvertToBinaryFileButtonClicked()
+{
+  if (conversionFuture.isRunning())
+    return;
+
+  const QString sourceFile = file.absoluteFilePath();
+  QFileInfo sourceInfo(sourceFile);
+  const QString defaultTarget = sourceInfo.absolutePath() + "/" + sourceInfo.completeBaseName() + ".yuvstat";
+  const QString targetFile = QFileDialog::getSaveFileName(propertiesWidget.data(), "Save binary statistics file", defaultTarget, "Binary Statistics File (*.yuvstat)");
+  if (targetFile.isEmpty())
+    return;
+
+  // The conversion uses a new item for the file so that the statistics cache of this item is not changed.
+  // The item is created here (it is a QObject with a timer and an icon) and only used by the background thread.
+  conversionSource.reset(playlistItemStatisticsBinaryFile::newStatisticsFileForConversion(sourceFile));
+  conversionTargetFile = targetFile;
+  cancelConversionRequested = false;
+
+  conversionProgressDialog = new QProgressDialog("Converting statistics file...", "Cancel", 0, 100, propertiesWidget.data());
+  conversionProgressDialog->setMinimumDuration(1000);
+  conversionProgressDialog->setWindowModality(Qt::WindowModal);
+  connect(this, &playlistItemStatisticsFile::signalConversionProgress, conversionProgressDialog.data(), &QProgressDialog::setValue, Qt::QueuedConnection);
+  connect(conversionProgressDialog.data(), &QProgressDialog::canceled, this, [this]()
+  {
+    // Stop the background thread. It reports the end with signalConversionFinished.
+    cancelConversionRequested = true;
+    conversionSource->cancelBackgroundParsing();
+  });
+
+  conversionFuture = QtConcurrent::run([this, targetFile]()
+  {
+    QString errorText;
+    const bool success = conversionSource->writeBinaryFile(targetFile, errorText, [this](int percent)
+    {
+      emit signalConversionProgress(percent);
+      return !cancelConversionRequested;
+    });
+    emit signalConversionFinished(success, errorText);
+  });
+}
+
+void playlistItemStatisticsFile::onConversionFinished(bool success, QString errorText)
+{
+  conversionFuture.waitForFinished();
+  conversionSource.reset();
+  if (conversionProgressDialog)
+  {
+    conversionProgressDialog->close();
+    conversionProgressDialog->deleteLater();
+  }
+
+  if (success)
+    QMessageBox::information(propertiesWidget.data(), "Conversion finished", QString("The statistics were saved to %1.").arg(conversionTargetFile));
+  else if (!cancelConversionRequested)
+    QMessageBox::critical(propertiesWidget.data(), "Conversion failed", QString("The statistics could not be converted. %1").arg(errorText));
+}
+
+void playlistItemStatisticsFile::cancelConversion()
+{
+  if (!conversionFuture.isRunning())
+    return;
+
+  cancelConversionRequested = true;
+  conversionSource->cancelBackgroundParsing();
+  conversionFuture.waitForFinished();
+}
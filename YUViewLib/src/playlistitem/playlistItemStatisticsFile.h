@@ -33,8 +33,12 @@
 #ifndef PLAYLISTITEMSTATISTICSFILE_H
 #define PLAYLISTITEMSTATISTICSFILE_H
 
+#include <atomic>
+#include <functional>
 #include <QBasicTimer>
 #include <QFuture>
+#include <QPointer>
+#include <QProgressDialog>
 #include "filesource/fileSource.h"
 #include "playlistItem.h"
 #include "statistics/statisticHandler.h"
@@ -83,7 +87,25 @@ public:
 
   // ----- Detection of source/file change events -----
   virtual bool isSourceChanged()  Q_DECL_OVERRIDE { return file.isFileChanged(); }
-  virtual void updateSettings()   Q_DECL_OVERRIDE { file.updateFileWatchSetting(); statSource.updateSettings(); }
+  virtual void updateSettings()   Q_DECL_OVERRIDE { file.updateFileWatchSetting(); file.updateMemoryMapSetting(); statSource.updateSettings(); }
+
+  // Write all statistics of this item to a binary statistics file (see statisticsBinaryFile.h). This waits for the
+  // background parser and then loads all frames and types using loadStatisticToCache, so it should only be called
+  // for an item that is not shown. The progress callback gets the progress in percent. If it returns false, the
+  // conversion is canceled.
+  bool writeBinaryFile(const QString &filePath, QString &errorText, std::function<bool(int)> progressCallback=nullptr);
+  // Stop the background parser. writeBinaryFile does not have to wait for the whole file to be parsed then.
+  void cancelBackgroundParsing() { cancelBackgroundParser = true; }
+
+signals:
+  // The progress (in percent) of the conversion to a binary statistics file. This is emitted from the background thread.
+  void signalConversionProgress(int percent);
+  // The conversion to a binary statistics file finished (or was canceled). This is emitted from the background thread.
+  void signalConversionFinished(bool success, QString errorText);
+
+public slots:
+  // Load the statistics with frameIdx/type from file and put it into the cache.
+  virtual void loadStatisticToCache(int frameIdxInternal, int typeID) = 0;
 
 protected:
   virtual indexRange getStartEndFrameLimits() const Q_DECL_OVERRIDE { return indexRange(0, maxPOC); }
@@ -95,6 +117,9 @@ protected:
   // Get the tag/name which is used when saving the item to a playlist
   virtual QString getPlaylistTag() const = 0;
 
+  // Can the file be converted to a binary statistics file? If yes, a button for this is shown in the properties panel.
+  virtual bool canConvertToBinaryFile() const { return true; }
+
   // The statistics source
   statisticHandler statSource;
 
@@ -122,6 +147,21 @@ protected:
   fileSource file;
 
   int currentDrawnFrameIdx;
+
+private slots:
+  void onConvertToBinaryFileButtonClicked();
+  void onConversionFinished(bool success, QString errorText);
+
+private:
+  // The conversion to a binary statistics file. It uses a new item for the file (so that the statistics cache of this
+  // item is not changed) which is created in the main thread. The statistics are written in the background.
+  void cancelConversion();
+  QScopedPointer<playlistItemStatisticsFile> conversionSource;
+  QFuture<void> conversionFuture;
+  // Set in the main thread and polled by the background thread
+  std::atomic<bool> cancelConversionRequested {false};
+  QString conversionTargetFile;
+  QPointer<QProgressDialog> conversionProgressDialog;
 };
 
 #endif // PLAYLISTITEMSTATISTICSFILE_H
@@ -32,19 +32,24 @@
 
 #include "playlistItemStatisticsVTMBMSFile.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
 #include <QDebug>
 #include <QtConcurrent>
 #include <QTime>
 
 #include "statistics/statisticsExtensions.h"
+#include "statistics/statisticsVTMBMSParser.h"
 
 // The internal buffer for parsing the starting positions. The buffer must not be larger than 2GB
 // so that we can address all the positions in it with int (using such a large buffer is not a good
 // idea anyways)
 #define STAT_PARSING_BUFFER_SIZE 1048576
 #define STAT_MAX_STRING_SIZE 1<<28
+// The size of the chunks in which the statistics of a frame are read (if the file is not memory mapped)
+#define STAT_LOADING_BUFFER_SIZE 16777216
 
 playlistItemStatisticsVTMBMSFile::playlistItemStatisticsVTMBMSFile(const QString &itemNameOrFileName)
   : playlistItemStatisticsFile(itemNameOrFileName)
@@ -88,7 +93,8 @@ void playlistItemStatisticsVTMBMSFile::readFramePositionsFromFile()
     bool fileAtEnd = false;
     qint64 bufferStartPos = 0;
 
-    QString lineBuffer;
+    // A line that started in the previous buffer
+    QByteArray lineBuffer;
     qint64  lineBufferStartPos = 0;
     int     lastPOC = INT_INVALID;
     bool    sortingFixed = false; 
@@ -105,72 +111,72 @@ void playlistItemStatisticsVTMBMSFile::readFramePositionsFromFile()
       // prevent lineBuffer overflow by dumping it for such cases
       if (lineBuffer.size() > STAT_MAX_STRING_SIZE)
         lineBuffer.clear(); // prevent an overflow here
-      for (int i = 0; i < bufferSize; i++)
+      const char *buffer = inputBuffer.constData();
+      int lineStart = 0;
+      while (lineStart < bufferSize)
       {
         // Search for '\n' newline characters
-        if (inputBuffer.at(i) == 10)
+        const char *newline = static_cast<const char*>(memchr(buffer + lineStart, '\n', bufferSize - lineStart));
+        if (newline == nullptr)
         {
-          // We found a newline character
-          if (lineBuffer.size() > 0)
-          {
-            // Parse the previous line
-            // get components of this line
-            // get poc using regular expression
-            // need to match this:
-            // BlockStat: POC 1 @( 120,  80) [ 8x 8] MVL0={ -24,  -2}
-            // BlockStat: POC 1 @( 112,  88) [ 8x 8] PredMode=0
-            QRegularExpression pocRegex("BlockStat: POC ([0-9]+)");
-
-            QRegularExpressionMatch match = pocRegex.match(lineBuffer);
-            // ignore not matching lines
-            if (match.hasMatch())
-            {
-              int poc = match.captured(1).toInt();
-
-              if (lastPOC == -1)
-              {
-                // First POC
-                pocStartList[poc] = lineBufferStartPos;
-                if (poc == currentDrawnFrameIdx)
-                  // We added a start position for the frame index that is currently drawn. We might have to redraw.
-                  emit signalItemChanged(true, RECACHE_NONE);
-
-                lastPOC = poc;
-
-                // update number of frames
-                if (poc > maxPOC)
-                  maxPOC = poc;
-              }
-              else if (poc != lastPOC)
-              {
-                // this is apparently not sorted by POCs and we will not check it further
-                if(!sortingFixed)
-                  sortingFixed = true;
-
-                lastPOC = poc;                
-                pocStartList[poc] = lineBufferStartPos;
-                if (poc == currentDrawnFrameIdx)
-                  // We added a start position for the frame index that is currently drawn. We might have to redraw.
-                  emit signalItemChanged(true, RECACHE_NONE);
-
-                // update number of frames
-                if (poc > maxPOC)
-                  maxPOC = poc;
-
-                // Update percent of file parsed
-                backgroundParserProgress = ((double)lineBufferStartPos * 100 / (double)inputFile.getFileSize());
-              }
-            }
-          }
-
-          lineBuffer.clear();
-          lineBufferStartPos = bufferStartPos + i + 1;
+          // The line continues in the next buffer
+          lineBuffer.append(buffer + lineStart, bufferSize - lineStart);
+          break;
         }
+        const int lineEnd = int(newline - buffer);
+
+        // Get the POC of the line. Lines that are no block statistics are ignored. We need to match this:
+        // BlockStat: POC 1 @( 120,  80) [ 8x 8] MVL0={ -24,  -2}
+        // BlockStat: POC 1 @( 112,  88) [ 8x 8] PredMode=0
+        int poc;
+        if (lineBuffer.isEmpty())
+          poc = statisticsVTMBMSParser::parsePOC(buffer + lineStart, newline);
         else
         {
-          // No newline character found
-          lineBuffer.append(inputBuffer.at(i));
+          lineBuffer.append(buffer + lineStart, lineEnd - lineStart);
+          poc = statisticsVTMBMSParser::parsePOC(lineBuffer.constData(), lineBuffer.constData() + lineBuffer.size());
+        }
+
+        if (poc >= 0)
+        {
+          if (lastPOC == -1)
+          {
+            // First POC
+            pocStartList[poc] = lineBufferStartPos;
+            if (poc == currentDrawnFrameIdx)
+              // We added a start position for the frame index that is currently drawn. We might have to redraw.
+              emit signalItemChanged(true, RECACHE_NONE);
+
+            lastPOC = poc;
+
+            // update number of frames
+            if (poc > maxPOC)
+              maxPOC = poc;
+          }
+          else if (poc != lastPOC)
+          {
+            // this is apparently not sorted by POCs and we will not check it further
+            if(!sortingFixed)
+              sortingFixed = true;
+
+            lastPOC = poc;                
+            pocStartList[poc] = lineBufferStartPos;
+            if (poc == currentDrawnFrameIdx)
+              // We added a start position for the frame index that is currently drawn. We might have to redraw.
+              emit signalItemChanged(true, RECACHE_NONE);
+
+            // update number of frames
+            if (poc > maxPOC)
+              maxPOC = poc;
+
+            // Update percent of file parsed
+            backgroundParserProgress = ((double)lineBufferStartPos * 100 / (double)inputFile.getFileSize());
+          }
         }
+
+        lineBuffer.clear();
+        lineBufferStartPos = bufferStartPos + lineEnd + 1;
+        lineStart = lineEnd + 1;
       }
 
       bufferStartPos += bufferSize;
@@ -367,8 +373,6 @@ void playlistItemStatisticsVTMBMSFile::loadStatisticToCache(int frameIdxInternal
     if (!file.isOk())
       return;
 
-    QTextStream in(file.getQFile());
-
     if (!pocStartList.contains(frameIdxInternal))
     {
       // There are no statistics in the file for the given frame and index.
@@ -376,197 +380,41 @@ void playlistItemStatisticsVTMBMSFile::loadStatisticToCache(int frameIdxInternal
       return;
     }
 
-
-    qint64 startPos = pocStartList[frameIdxInternal];
-
-    // fast forward
-    in.seek(startPos);
-
-    QRegularExpression pocRegex("BlockStat: POC ([0-9]+)");
-
-    // prepare regex for selected type
     StatisticsType *aType = statSource.getStatisticsType(typeID);
     Q_ASSERT_X(aType != nullptr, "StatisticsObject::readStatisticsFromFile", "Stat type not found.");
-    QRegularExpression typeRegex(" " + aType->typeName + "="); // for catching lines of the type
-
-    // for extracting scalar value statistics, need to match:
-    // BlockStat: POC 1 @( 112,  88) [ 8x 8] PredMode=0
-    QRegularExpression scalarRegex("POC ([0-9]+) @\\( *([0-9]+), *([0-9]+)\\) *\\[ *([0-9]+)x *([0-9]+)\\] *\\w+=([0-9\\-]+)");
-    // for extracting vector value statistics, need to match:
-    // BlockStat: POC 1 @( 120,  80) [ 8x 8] MVL0={ -24,  -2}
-    QRegularExpression vectorRegex("POC ([0-9]+) @\\( *([0-9]+), *([0-9]+)\\) *\\[ *([0-9]+)x *([0-9]+)\\] *\\w+={ *([0-9\\-]+), *([0-9\\-]+)}");
-    // for extracting affine transform value statistics, need to match:
-    // BlockStat: POC 2 @( 192,  96) [64x32] AffineMVL0={-324,-116,-276,-116,-324, -92}
-    QRegularExpression affineTFRegex("POC ([0-9]+) @\\( *([0-9]+), *([0-9]+)\\) *\\[ *([0-9]+)x *([0-9]+)\\] *\\w+={ *([0-9\\-]+), *([0-9\\-]+), *([0-9\\-]+), *([0-9\\-]+), *([0-9\\-]+), *([0-9\\-]+)}");
-    // for extracting scalar polygon  statistics, need to match:
-    // BlockStat: POC 2 @[(505, 384)--(511, 384)--(511, 415)--] GeoPUInterIntraFlag=0
-    // BlockStat: POC 2 @[(416, 448)--(447, 448)--(447, 478)--(416, 463)--] GeoPUInterIntraFlag=0
-    // will capture 3-5 points. other polygons are not supported
-    QRegularExpression scalarPolygonRegex("POC ([0-9]+) @\\[((?:\\( *[0-9]+, *[0-9]+\\)--){3,5})\\] *\\w+=([0-9\\-]+)");
-    // for extracting vector polygon statistics:
-    QRegularExpression vectorPolygonRegex("POC ([0-9]+) @\\[((?:\\( *[0-9]+, *[0-9]+\\)--){3,5})\\] *\\w+={ *([0-9\\-]+), *([0-9\\-]+)}");
-    // for extracting the partitioning line, we extract
-    // BlockStat: POC 2 @( 192,  96) [64x32] Line={0,0,31,31}
-    QRegularExpression lineRegex("POC ([0-9]+) @\\( *([0-9]+), *([0-9]+)\\) *\\[ *([0-9]+)x *([0-9]+)\\] *\\w+={ *([0-9\\-]+), *([0-9\\-]+), *([0-9\\-]+), *([0-9\\-]+)}");
-
-    while (!in.atEnd())
+    const statisticsVTMBMSParser::typeParser parser(*aType);
+
+    // Parse the file from the start of the POC until a line of another POC is found. The data is read in chunks
+    // (or taken directly from the memory mapped file) and parsed without converting the lines to strings.
+    statisticsData &cacheData = statSource.statsCache[typeID];
+    const qint64 fileSize = file.getFileSize();
+    qint64 pos = pocStartList[frameIdxInternal];
+    qint64 chunkSize = STAT_LOADING_BUFFER_SIZE;
+    while (pos < fileSize)
     {
-      // read one line
-      QString aLine = in.readLine();
-
-
-      QRegularExpressionMatch pocMatch = pocRegex.match(aLine);
-      // ignore not matching lines
-      if (pocMatch.hasMatch())
+      const qint64 nrBytes = std::min(chunkSize, fileSize - pos);
+      const bool atEnd = (pos + nrBytes == fileSize);
+      const rawDataView data = file.readBytesView(pos, nrBytes);
+      if (data.isEmpty())
+        break;
+
+      const statisticsVTMBMSParser::parseResult result = statisticsVTMBMSParser::parseFrameType(data.data(), data.size(), atEnd, frameIdxInternal, parser, statSource.getFrameSize(), cacheData);
+      if (!result.errorLine.isEmpty())
+        parsingError = QString("Error while parsing statistic: ") + QString(result.errorLine);
+      if (result.blockOutsideOfFrame && blockOutsideOfFrame_idx == -1)
+        // Block not in image. Warn about this.
+        blockOutsideOfFrame_idx = frameIdxInternal;
+      if (result.frameEnd || atEnd)
+        break;
+
+      if (result.bytesParsed == 0)
       {
-        int poc = pocMatch.captured(1).toInt();
-        if (poc != frameIdxInternal)
-        {
+        // The line is longer than the chunk. A corrupted file may contain an arbitrary amount of non-\n symbols.
+        if (chunkSize > STAT_MAX_STRING_SIZE)
           break;
-        }
-
-        // filter lines of different types
-        QRegularExpressionMatch typeMatch = typeRegex.match(aLine);
-        if (typeMatch.hasMatch())
-        {
-          int poc, posX, posY, width, height, scalar, vecX, vecY;
-
-          QRegularExpressionMatch statisitcMatch;
-          // extract statistics info
-          // try block types
-          if (aType->isPolygon == false)
-          {
-            if (aType->hasValueData)
-            {
-              statisitcMatch = scalarRegex.match(aLine);
-            }
-            else if (aType->hasVectorData)
-            {
-              statisitcMatch = vectorRegex.match(aLine);
-              if (!statisitcMatch.hasMatch())
-              {
-                statisitcMatch = lineRegex.match(aLine);
-              }
-            }
-            else if (aType->hasAffineTFData)
-            {
-              statisitcMatch = affineTFRegex.match(aLine);
-            }
-          }
-          else
-          // try polygons
-          {
-            if (aType->hasValueData)
-            {
-              statisitcMatch = scalarPolygonRegex.match(aLine);
-            }
-            else if (aType->hasVectorData)
-            {
-              statisitcMatch = vectorPolygonRegex.match(aLine);
-            }
-          }
-          if (!statisitcMatch.hasMatch())
-          {
-            parsingError = QString("Error while parsing statistic: ") + QString(aLine);
-            continue;
-          }
-
-          // useful for debugging:
-  //        QStringList all_captured = statisitcMatch.capturedTexts();
-
-          poc = statisitcMatch.captured(1).toInt();
-          width = statisitcMatch.captured(4).toInt();
-          height = statisitcMatch.captured(5).toInt();
-          // if there is a new POC, we are done here!
-          if (poc != frameIdxInternal)
-            break;
-
-          // process block statistics
-          if (aType->isPolygon == false)
-          {
-            posX = statisitcMatch.captured(2).toInt();
-            posY = statisitcMatch.captured(3).toInt();
-
-            // Check if block is within the image range
-            if (blockOutsideOfFrame_idx == -1 && (posX + width > statSource.getFrameSize().width() || posY + height > statSource.getFrameSize().height()))
-              // Block not in image. Warn about this.
-              blockOutsideOfFrame_idx = frameIdxInternal;
-
-            if (aType->hasVectorData)
-            {
-              vecX = statisitcMatch.captured(6).toInt();
-              vecY = statisitcMatch.captured(7).toInt();
-              if (statisitcMatch.lastCapturedIndex()>7)
-              {
-                int vecX1 = statisitcMatch.captured(8).toInt();
-                int vecY1 = statisitcMatch.captured(9).toInt();
-                statSource.statsCache[typeID].addLine(posX, posY, width, height, vecX, vecY,vecX1,vecY1);
-              }
-              else
-              {
-                statSource.statsCache[typeID].addBlockVector(posX, posY, width, height, vecX, vecY);
-              }
-            }
-            else if (aType->hasAffineTFData)
-            {
-              int vecX0 = statisitcMatch.captured(6).toInt();
-              int vecY0 = statisitcMatch.captured(7).toInt();
-              int vecX1 = statisitcMatch.captured(8).toInt();
-              int vecY1 = statisitcMatch.captured(9).toInt();
-              int vecX2 = statisitcMatch.captured(10).toInt();
-              int vecY2 = statisitcMatch.captured(11).toInt();
-              statSource.statsCache[typeID].addBlockAffineTF(posX, posY, width, height, vecX0, vecY0, vecX1, vecY1, vecX2, vecY2);
-            }
-            else
-            {
-              scalar = statisitcMatch.captured(6).toInt();
-              statSource.statsCache[typeID].addBlockValue(posX, posY, width, height, scalar);
-            }
-          }
-          else
-          // process polygon statistics
-          {
-            QString corners = statisitcMatch.captured(2);
-            QStringList cornerList = corners.split("--");
-            QRegularExpression cornerRegex("\\( *([0-9]+), *([0-9]+)\\)");
-            QVector<QPoint> points;
-            for (const auto &corner : cornerList)
-            {
-              QRegularExpressionMatch cornerMatch = cornerRegex.match(corner);
-              if( cornerMatch.hasMatch())
-              {
-                int x = cornerMatch.captured(1).toInt();
-                int y = cornerMatch.captured(2).toInt();
-                points << QPoint(x,y);
-
-                // Check if polygon is within the image range
-                if (blockOutsideOfFrame_idx == -1 && (x + width > statSource.getFrameSize().width() || y + height > statSource.getFrameSize().height()))
-                  // Block not in image. Warn about this.
-                  blockOutsideOfFrame_idx = frameIdxInternal;
-              }
-            }
-
-            if (aType->hasVectorData)
-            {
-              vecX = statisitcMatch.captured(3).toInt();
-              vecY = statisitcMatch.captured(4).toInt();
-              statSource.statsCache[typeID].addPolygonVector(points, vecX, vecY);
-            }
-            else if(aType->hasValueData)
-            {
-              scalar = statisitcMatch.captured(3).toInt();
-              statSource.statsCache[typeID].addPolygonValue(points, scalar);
-            }
-          }
-        }
+        chunkSize *= 2;
       }
-    }
-
-    if(!statSource.statsCache.contains(typeID))
-    {
-      // There are no statistics in the file for the given frame and index.
-      statSource.statsCache.insert(typeID, statisticsData());
-      return;
+      pos += result.bytesParsed;
     }
 
   } // try
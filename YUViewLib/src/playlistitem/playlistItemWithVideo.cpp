@@ -57,6 +57,9 @@ void playlistItemWithVideo::connectVideo()
 {
   // Forward these signals from the video source up
   connect(video.data(), &videoHandler::signalHandlerChanged, this, &playlistItem::signalItemChanged);
+
+  // The video can pull frames directly from this item (if the item supports this)
+  video->setFrameSource(this);
 }
 
 void playlistItemWithVideo::drawItem(QPainter *painter, int frameIdx, double zoomFactor, bool drawRawValues)
@@ -35,6 +35,7 @@
 
 #include "playlistItemCompressedVideo.h"
 #include "playlistItemDifference.h"
+#include "playlistItemStatisticsBinaryFile.h"
 #include "playlistItemStatisticsCSVFile.h"
 #include "playlistItemStatisticsVTMBMSFile.h"
 #include "playlistItemImageFile.h"
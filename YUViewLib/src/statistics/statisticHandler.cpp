@@ -32,8 +32,10 @@
 
 #include "statisticHandler.h"
 
+#include <algorithm>
 #include <cmath>
 #include <QPainter>
+#include <QtConcurrent>
 #include <QtMath>
 
 #include "common/functions.h"
@@ -46,6 +48,12 @@
 #define DEBUG_STAT(fmt,...) ((void)0)
 #endif
 
+// The statistics of a frame are only rendered into an image if the image is not bigger than this (in device pixels).
+// Above this, the statistics are drawn directly (only the visible part).
+#define STATISTICS_RASTER_MAX_PIXELS (4096*4096)
+// The maximum number of rendered images (for different zoom factors) that are kept for the current frame
+#define STATISTICS_RASTER_CACHE_SIZE 2
+
 QPoint getPolygonCenter(const QPolygon& polygon)
 {
   QPoint p = QPoint(0, 0);
@@ -66,6 +74,12 @@ statisticHandler::statisticHandler()
   connect(&statisticsStyleUI, &StatisticsStyleControl::StyleChanged, this, &statisticHandler::updateStatisticItem, Qt::QueuedConnection);
 }
 
+statisticHandler::~statisticHandler()
+{
+  // The background rendering accesses the raster cache
+  rasterFuture.waitForFinished();
+}
+
 itemLoadingState statisticHandler::needsLoading(int frameIdx)
 {
   if (frameIdx != statsCacheFrameIdx)
@@ -126,7 +140,12 @@ void statisticHandler::loadStatistics(int frameIdx)
     }
   }
 
+  // Sort the loaded blocks into tiles so that only the visible blocks have to be drawn
+  for (statisticsData &data : statsCache)
+    data.buildTileGrids();
+
   statsCacheFrameIdx = frameIdx;
+  invalidateRasterCache();
 }
 
 void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double zoomFactor)
@@ -136,14 +155,18 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
     // The statistics for the new frame index should be loading the background.
     return;
 
-  // Save the state of the painter. This is restored when the function is done.
-  painter->save();
-  painter->setRenderHint(QPainter::Antialiasing,true);
-
   QRect statRect;
   statRect.setSize(statFrameSize * zoomFactor);
   statRect.moveCenter(QPoint(0,0));
 
+  // If the statistics were already rendered for this frame and zoom factor, only the image has to be drawn
+  if (paintRasterizedStatistics(painter, frameIdx, zoomFactor, statRect))
+    return;
+
+  // Save the state of the painter. This is restored when the function is done.
+  painter->save();
+  painter->setRenderHint(QPainter::Antialiasing,true);
+
   // Get the visible coordinates of the statistics
   QRect viewport = painter->viewport();
   QTransform worldTransform = painter->worldTransform();
@@ -154,10 +177,131 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
 
   painter->translate(statRect.topLeft());
 
+  // Lock the statsCache mutex so that nothing is changed while we draw the data
+  QMutexLocker lock(&statsCacheAccessMutex);
+  paintStatisticsData(painter, zoomFactor, xMin, xMax, yMin, yMax, statsTypeList, statsCache);
+
+  // Restore the state the state of the painter from before this function was called.
+  // This will reset the set pens and the translation.
+  painter->restore();
+}
+
+bool statisticHandler::paintRasterizedStatistics(QPainter *painter, int frameIdx, double zoomFactor, const QRect &statRect)
+{
+  if (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM || statRect.isEmpty())
+    // At this zoom level the values are drawn as text and an image of the whole frame would be huge
+    return false;
+  if (painter->worldTransform().type() > QTransform::TxTranslate)
+    return false;
+
+  const int zoomBucket = qRound(zoomFactor * 1000);
+  const int revision = renderRevision.load();
+  const qreal devicePixelRatio = painter->device()->devicePixelRatioF();
+
+  {
+    QMutexLocker lock(&rasterCacheMutex);
+    if (rasterCacheFrameIdx != frameIdx || rasterCacheRevision != revision || rasterCacheDevicePixelRatio != devicePixelRatio)
+    {
+      // Something changed. All images are outdated.
+      rasterCache.clear();
+      rasterCacheFrameIdx = frameIdx;
+      rasterCacheRevision = revision;
+      rasterCacheDevicePixelRatio = devicePixelRatio;
+    }
+
+    auto it = rasterCache.constFind(zoomBucket);
+    if (it != rasterCache.constEnd() && it->frameSize == statRect.size())
+    {
+      painter->drawImage(it->rect, it->image);
+      return true;
+    }
+  }
+
+  if (rasterFuture.isRunning())
+    // Another image is being rendered. Draw directly for now and try again on the next repaint.
+    return false;
+
+  // Get a copy of the data to draw. The containers are implicitly shared so this is cheap.
+  const StatisticsTypeList typeList = statsTypeList;
+  QHash<int, statisticsData> cache;
+  {
+    QMutexLocker lock(&statsCacheAccessMutex);
+    cache = statsCache;
+  }
+
+  // Vectors and lines can point out of the frame. Extend the image so that they are not cut off.
+  int margin = 0;
+  for (const StatisticsType &type : typeList)
+  {
+    auto it = cache.constFind(type.typeID);
+    if (!type.render || it == cache.constEnd())
+      continue;
+    int vectorMargin = std::max(it->maxLinePointValue, it->maxVectorValue);
+    if (type.vectorScale > 0)
+      vectorMargin = std::max(it->maxLinePointValue, int(std::ceil(float(it->maxVectorValue) / type.vectorScale)));
+    margin = std::max(margin, int(std::ceil(vectorMargin * zoomFactor)));
+  }
+  // Leave some space for the arrow heads and the pen width
+  margin += 16;
+
+  const QRect rect = statRect.adjusted(-margin, -margin, margin, margin);
+  if (qint64(rect.width() * devicePixelRatio) * qint64(rect.height() * devicePixelRatio) > STATISTICS_RASTER_MAX_PIXELS)
+    return false;
+
+  rasterFuture = QtConcurrent::run([=]() {
+    rasterizeStatistics(frameIdx, revision, zoomBucket, zoomFactor, devicePixelRatio, statRect, rect, typeList, cache);
+  });
+  return false;
+}
+
+void statisticHandler::rasterizeStatistics(int frameIdx, int revision, int zoomBucket, double zoomFactor, qreal devicePixelRatio, QRect statRect, QRect rect, StatisticsTypeList typeList, QHash<int, statisticsData> cache)
+{
+  QImage image(rect.size() * devicePixelRatio, QImage::Format_ARGB32_Premultiplied);
+  if (image.isNull())
+    return;
+  image.setDevicePixelRatio(devicePixelRatio);
+  image.fill(Qt::transparent);
+
+  {
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+    // The image starts at the top left of rect. Move the origin to the top left of the frame.
+    const QPoint offset = statRect.topLeft() - rect.topLeft();
+    painter.translate(offset);
+    paintStatisticsData(&painter, zoomFactor, -offset.x(), rect.width() - offset.x(), -offset.y(), rect.height() - offset.y(), typeList, cache);
+  }
+
+  {
+    QMutexLocker lock(&rasterCacheMutex);
+    if (rasterCacheFrameIdx != frameIdx || rasterCacheRevision != revision || renderRevision.load() != revision || rasterCacheDevicePixelRatio != devicePixelRatio)
+      // Something changed while the image was rendered
+      return;
+
+    if (!rasterCache.contains(zoomBucket) && rasterCache.count() >= STATISTICS_RASTER_CACHE_SIZE)
+      rasterCache.erase(rasterCache.begin());
+
+    rasterizedStatistics &entry = rasterCache[zoomBucket];
+    entry.image = image;
+    entry.rect = rect;
+    entry.frameSize = statRect.size();
+  }
+
+  DEBUG_STAT("statisticHandler::rasterizeStatistics frame %d zoom %f done", frameIdx, zoomFactor);
+  // The image can be drawn now. The items expect the signal in the main thread.
+  QMetaObject::invokeMethod(this, "onStatisticsRasterized", Qt::QueuedConnection);
+}
+
+void statisticHandler::paintStatisticsData(QPainter *painter, double zoomFactor, int xMin, int xMax, int yMin, int yMax, const StatisticsTypeList &typeList, const QHash<int, statisticsData> &cache)
+{
+  // The visible area in the coordinates of the statistics. Only the blocks that intersect this area are visited.
+  const QRect visibleArea(QPoint(int(std::floor(xMin / zoomFactor)) - 1, int(std::floor(yMin / zoomFactor)) - 1),
+                          QPoint(int(std::ceil(xMax / zoomFactor)) + 1, int(std::ceil(yMax / zoomFactor)) + 1));
+  QVector<int> blockIndices;
+
   // First, get if more than one statistic that has block values is rendered.
   bool moreThanOneBlockStatRendered = false;
   bool oneBlockStatRendered = false;
-  for (StatisticsType t : statsTypeList)
+  for (StatisticsType t : typeList)
   {
     if(t.render && t.hasValueData)
     {
@@ -171,52 +315,51 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
     }
   }
 
-  // Lock the statsCache mutex so that nothing is changed while we draw the data
-  QMutexLocker lock(&statsCacheAccessMutex);
-
   // Draw all the block types. Also, if the zoom factor is larger than STATISTICS_DRAW_VALUES_ZOOM,
   // also save a list of all the values of the blocks and their position in order to draw the values in the next step.
   QList<QPoint> drawStatPoints;       // The positions of each value
   QList<QStringList> drawStatTexts;   // For each point: The values to draw
   double maxLineWidth = 0.0;          // Also get the maximum width of the lines that is drawn. This will be used as an offset.
-  for (int i = statsTypeList.count() - 1; i >= 0; i--)
+  for (int i = typeList.count() - 1; i >= 0; i--)
   {
-    int typeIdx = statsTypeList[i].typeID;
-    if (!statsTypeList[i].render || !statsCache.contains(typeIdx))
+    int typeIdx = typeList[i].typeID;
+    if (!typeList[i].render || !cache.contains(typeIdx))
       // This statistics type is not rendered or could not be loaded.
       continue;
 
-    // Go through all the value data
-    for (const statisticsItem_Value &valueItem : statsCache[typeIdx].valueData)
+    // Go through all the visible value data
+    const statisticsData &data = cache.constFind(typeIdx).value();
+    data.valueBlocks.getBlocksInArea(visibleArea, blockIndices);
+    for (const int blockIdx : blockIndices)
     {
       // Calculate the size and position of the rectangle to draw (zoomed in)
-      QRect rect = QRect(valueItem.pos[0], valueItem.pos[1], valueItem.size[0], valueItem.size[1]);
+      QRect rect = data.valueBlocks.getRect(blockIdx);
       QRect displayRect = QRect(rect.left()*zoomFactor, rect.top()*zoomFactor, rect.width()*zoomFactor, rect.height()*zoomFactor);
       // Check if the rectangle of the statistics item is even visible
       bool rectVisible = (!(displayRect.left() > xMax || displayRect.right() < xMin || displayRect.top() > yMax || displayRect.bottom() < yMin));
 
       if (rectVisible)
       {
-        int value = valueItem.value; // This value determines the color for this item
-        if (statsTypeList[i].renderValueData)
+        int value = data.values[blockIdx]; // This value determines the color for this item
+        if (typeList[i].renderValueData)
         {
           // Get the right color for the item and draw it.
           QColor rectColor;
-          if (statsTypeList[i].scaleValueToBlockSize)
-            rectColor = statsTypeList[i].colMapper.getColor(float(value) / (valueItem.size[0] * valueItem.size[1]));
+          if (typeList[i].scaleValueToBlockSize)
+            rectColor = typeList[i].colMapper.getColor(float(value) / (rect.width() * rect.height()));
           else
-            rectColor = statsTypeList[i].colMapper.getColor(value);
-          rectColor.setAlpha(rectColor.alpha()*((float)statsTypeList[i].alphaFactor / 100.0));
+            rectColor = typeList[i].colMapper.getColor(value);
+          rectColor.setAlpha(rectColor.alpha()*((float)typeList[i].alphaFactor / 100.0));
           painter->setBrush(rectColor);
           painter->fillRect(displayRect, rectColor);
         }
 
         // optionally, draw a grid around the region
-        if (statsTypeList[i].renderGrid)
+        if (typeList[i].renderGrid)
         {
           // Set the grid color (no fill)
-          QPen gridPen = statsTypeList[i].gridPen;
-          if (statsTypeList[i].scaleGridToZoom)
+          QPen gridPen = typeList[i].gridPen;
+          if (typeList[i].scaleGridToZoom)
             gridPen.setWidthF(gridPen.widthF() * zoomFactor);
           painter->setPen(gridPen);
           painter->setBrush(QBrush(QColor(Qt::color0), Qt::NoBrush));  // no fill color
@@ -231,11 +374,11 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
         // Save the position/text in order to draw the values later
         if (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM)
         {
-          QString valTxt  = statsTypeList[i].getValueTxt(value);
-          if (!statsTypeList[i].valMap.contains(value) && statsTypeList[i].scaleValueToBlockSize)
-            valTxt = QString("%1").arg(float(value) / (valueItem.size[0] * valueItem.size[1]));
+          QString valTxt  = typeList[i].getValueTxt(value);
+          if (!typeList[i].valMap.contains(value) && typeList[i].scaleValueToBlockSize)
+            valTxt = QString("%1").arg(float(value) / (rect.width() * rect.height()));
 
-          QString typeTxt = statsTypeList[i].typeName;
+          QString typeTxt = typeList[i].typeName;
           QString statTxt = moreThanOneBlockStatRendered ? typeTxt + ":" + valTxt : valTxt;
 
           int i = drawStatPoints.indexOf(displayRect.topLeft());
@@ -258,15 +401,15 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
   // QList<QPoint> drawStatPoints;       // The positions of each value
   // QList<QStringList> drawStatTexts;   // For each point: The values to draw
   // double maxLineWidth = 0.0;          // Also get the maximum width of the lines that is drawn. This will be used as an offset.
-  for (int i = statsTypeList.count() - 1; i >= 0; i--)
+  for (int i = typeList.count() - 1; i >= 0; i--)
   {
-    int typeIdx = statsTypeList[i].typeID;
-    if (!statsTypeList[i].render || !statsCache.contains(typeIdx))
+    int typeIdx = typeList[i].typeID;
+    if (!typeList[i].render || !cache.contains(typeIdx))
       // This statistics type is not rendered or could not be loaded.
       continue;
 
     // Go through all the value data
-    for (const statisticsItemPolygon_Value &valueItem : statsCache[typeIdx].polygonValueData)
+    for (const statisticsItemPolygon_Value &valueItem : cache.constFind(typeIdx).value().polygonValueData)
     {
       // Calculate the size and position of the rectangle to draw (zoomed in)
       QRect boundingRect = valueItem.corners.boundingRect();
@@ -281,15 +424,15 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
       if (isVisible)
       {
         int value = valueItem.value; // This value determines the color for this item
-        if (statsTypeList[i].renderValueData)
+        if (typeList[i].renderValueData)
         {
           // Get the right color for the item and draw it.
           QColor color;
-          if (statsTypeList[i].scaleValueToBlockSize)
-            color = statsTypeList[i].colMapper.getColor(float(value) / (boundingRect.size().width() * boundingRect.size().height()));
+          if (typeList[i].scaleValueToBlockSize)
+            color = typeList[i].colMapper.getColor(float(value) / (boundingRect.size().width() * boundingRect.size().height()));
           else
-            color = statsTypeList[i].colMapper.getColor(value);
-          color.setAlpha(color.alpha()*((float)statsTypeList[i].alphaFactor / 100.0));
+            color = typeList[i].colMapper.getColor(value);
+          color.setAlpha(color.alpha()*((float)typeList[i].alphaFactor / 100.0));
           painter->setBrush(color);
 
           // Fill polygon
@@ -299,11 +442,11 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
         }
 
         // optionally, draw a grid around the region
-        if (statsTypeList[i].renderGrid)
+        if (typeList[i].renderGrid)
         {
           // Set the grid color (no fill)
-          QPen gridPen = statsTypeList[i].gridPen;
-          if (statsTypeList[i].scaleGridToZoom)
+          QPen gridPen = typeList[i].gridPen;
+          if (typeList[i].scaleGridToZoom)
             gridPen.setWidthF(gridPen.widthF() * zoomFactor);
           painter->setPen(gridPen);
           painter->setBrush(QBrush(QColor(Qt::color0), Qt::NoBrush));  // no fill color
@@ -319,8 +462,8 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
         // // Save the position/text in order to draw the values later
          if (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM)
          {
-            QString valTxt  = statsTypeList[i].getValueTxt(value);
-            QString typeTxt = statsTypeList[i].typeName;
+            QString valTxt  = typeList[i].getValueTxt(value);
+            QString typeTxt = typeList[i].typeName;
             QString statTxt = moreThanOneBlockStatRendered ? typeTxt + ":" + valTxt : valTxt;
 
            int i = drawStatPoints.indexOf(getPolygonCenter(displayPolygon));
@@ -354,33 +497,44 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
   }
 
   // Draw all the arrows
-  for (int i = statsTypeList.count() - 1; i >= 0; i--)
+  for (int i = typeList.count() - 1; i >= 0; i--)
   {
-    int typeIdx = statsTypeList[i].typeID;
-    if (!statsTypeList[i].render || !statsCache.contains(typeIdx))
+    int typeIdx = typeList[i].typeID;
+    if (!typeList[i].render || !cache.contains(typeIdx))
       // This statistics type is not rendered or could not be loaded.
       continue;
 
-    // Go through all the vector data
-    for (const statisticsItem_Vector &vectorItem : statsCache[typeIdx].vectorData)
+    // A vector (or line) can be visible even if its block is not. Extend the area by the longest vector/line.
+    const statisticsData &data = cache.constFind(typeIdx).value();
+    int vectorMargin = std::max(data.maxLinePointValue, data.maxVectorValue);
+    if (typeList[i].vectorScale > 0)
+      vectorMargin = std::max(data.maxLinePointValue, int(std::ceil(float(data.maxVectorValue) / typeList[i].vectorScale)));
+    data.vectorBlocks.getBlocksInArea(visibleArea.adjusted(-vectorMargin, -vectorMargin, vectorMargin, vectorMargin), blockIndices);
+
+    // Go through all the (possibly) visible vector data
+    for (const int blockIdx : blockIndices)
     {
+      const bool isLine = data.vectorIsLine[blockIdx];
+      const QPoint &point0 = data.vectorPoints0[blockIdx];
+      const QPoint &point1 = data.vectorPoints1[blockIdx];
+
       // Calculate the size and position of the rectangle to draw (zoomed in)
-      const QRect rect = QRect(vectorItem.pos[0], vectorItem.pos[1], vectorItem.size[0], vectorItem.size[1]);
+      const QRect rect = data.vectorBlocks.getRect(blockIdx);
       const QRect displayRect = QRect(rect.left()*zoomFactor, rect.top()*zoomFactor, rect.width()*zoomFactor, rect.height()*zoomFactor);
       
-      if (statsTypeList[i].renderVectorData)
+      if (typeList[i].renderVectorData)
       {
         // Calculate the start and end point of the arrow. The vector starts at center of the block.
         int x1,y1,x2,y2;
         float vx, vy;
-        if (vectorItem.isLine)
+        if (isLine)
         {
-          x1 = displayRect.left() + zoomFactor*vectorItem.point[0].x();
-          y1 = displayRect.top() + zoomFactor*vectorItem.point[0].y();
-          x2 = displayRect.left() + zoomFactor*vectorItem.point[1].x();
-          y2 = displayRect.top() + zoomFactor*vectorItem.point[1].y();
-          vx = (float)(x2-x1) / statsTypeList[i].vectorScale;
-          vy = (float)(y2-y1) / statsTypeList[i].vectorScale;
+          x1 = displayRect.left() + zoomFactor*point0.x();
+          y1 = displayRect.top() + zoomFactor*point0.y();
+          x2 = displayRect.left() + zoomFactor*point1.x();
+          y2 = displayRect.top() + zoomFactor*point1.y();
+          vx = (float)(x2-x1) / typeList[i].vectorScale;
+          vy = (float)(y2-y1) / typeList[i].vectorScale;
         }
         else
         {
@@ -388,8 +542,8 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
           y1 = displayRect.top() + displayRect.height() / 2;
 
           // The length of the vector
-          vx = (float)vectorItem.point[0].x() / statsTypeList[i].vectorScale;
-          vy = (float)vectorItem.point[0].y() / statsTypeList[i].vectorScale;
+          vx = (float)point0.x() / typeList[i].vectorScale;
+          vy = (float)point0.y() / typeList[i].vectorScale;
 
           // The end point of the vector
           x2 = x1 + zoomFactor * vx;
@@ -401,15 +555,15 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
         if (arrowVisible)
         {
           // Set the pen for drawing
-          QPen vectorPen = statsTypeList[i].vectorPen;
+          QPen vectorPen = typeList[i].vectorPen;
           QColor arrowColor = vectorPen.color();
-          if (statsTypeList[i].mapVectorToColor)
+          if (typeList[i].mapVectorToColor)
             arrowColor.setHsvF(clip((atan2f(vy,vx)+M_PI)/(2*M_PI),0.0,1.0), 1.0,1.0);
-          arrowColor.setAlpha(arrowColor.alpha()*((float)statsTypeList[i].alphaFactor / 100.0));
+          arrowColor.setAlpha(arrowColor.alpha()*((float)typeList[i].alphaFactor / 100.0));
           vectorPen.setColor(arrowColor);
-          if (statsTypeList[i].scaleVectorToZoom)
+          if (typeList[i].scaleVectorToZoom)
             vectorPen.setWidthF(vectorPen.widthF() * zoomFactor / 8);
-          if (vectorItem.isLine)
+          if (isLine)
               vectorPen.setCapStyle(Qt::RoundCap);
           painter->setPen(vectorPen);
           painter->setBrush(arrowColor);
@@ -426,12 +580,12 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
             if ((vx != 0 || vy != 0))
             {
               // The size of the arrow head
-              const int headSize = (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM && !statsTypeList[i].scaleVectorToZoom) ? 8 : zoomFactor/2;
+              const int headSize = (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM && !typeList[i].scaleVectorToZoom) ? 8 : zoomFactor/2;
 
-              if (statsTypeList[i].arrowHead != StatisticsType::arrowHead_t::none)
+              if (typeList[i].arrowHead != StatisticsType::arrowHead_t::none)
               {
                 // We draw an arrow head. This means that we will have to draw a shortened line
-                const int shorten = (statsTypeList[i].arrowHead == StatisticsType::arrowHead_t::arrow) ? headSize * 2 : headSize * 0.5;
+                const int shorten = (typeList[i].arrowHead == StatisticsType::arrowHead_t::arrow) ? headSize * 2 : headSize * 0.5;
                 if (sqrt(vx*vx*zoomFactor*zoomFactor + vy*vy*zoomFactor*zoomFactor) > shorten)
                 {
                   // Shorten the line and draw it
@@ -443,7 +597,7 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
                 // Draw the not shortened line
                 painter->drawLine(x1, y1, x2, y2);
 
-              if (statsTypeList[i].arrowHead == StatisticsType::arrowHead_t::arrow)
+              if (typeList[i].arrowHead == StatisticsType::arrowHead_t::arrow)
               {
                 // Save the painter state, translate to the arrow tip, rotate the painter and draw the normal triangle.
                 painter->save();
@@ -457,13 +611,13 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
                 // Restore. Revert translation/rotation of the painter.
                 painter->restore();
               }
-              else if (statsTypeList[i].arrowHead == StatisticsType::arrowHead_t::circle)
+              else if (typeList[i].arrowHead == StatisticsType::arrowHead_t::circle)
                 painter->drawEllipse(x2-headSize/2, y2-headSize/2, headSize, headSize);
             }
 
-            if (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM && statsTypeList[i].renderVectorDataValues)
+            if (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM && typeList[i].renderVectorDataValues)
             {
-              if (vectorItem.isLine)
+              if (isLine)
               {
                 // if we just draw a line, we want to simply see the coordinate pairs
                 QString txt1 = QString("(%1, %2)").arg(x1/zoomFactor).arg(y1/zoomFactor);
@@ -534,10 +688,10 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
       if (rectVisible)
       {
         // optionally, draw a grid around the region that the arrow is defined for
-        if (statsTypeList[i].renderGrid && rectVisible)
+        if (typeList[i].renderGrid && rectVisible)
         {
-          QPen gridPen = statsTypeList[i].gridPen;
-          if (statsTypeList[i].scaleGridToZoom)
+          QPen gridPen = typeList[i].gridPen;
+          if (typeList[i].scaleGridToZoom)
             gridPen.setWidthF(gridPen.widthF() * zoomFactor);
 
           painter->setPen(gridPen);
@@ -548,18 +702,21 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
       }
     }
 
-    // Go through all the affine transform data
-    for (const statisticsItem_AffineTF &affineTFItem : statsCache[typeIdx].affineTFData)
+    // Go through all the visible affine transform data
+    data.affineTFBlocks.getBlocksInArea(visibleArea, blockIndices);
+    for (const int blockIdx : blockIndices)
     {
+      const QPoint *affineTFPoints = &data.affineTFPoints[blockIdx * 3];
+
       // Calculate the size and position of the rectangle to draw (zoomed in)
-      const QRect rect = QRect(affineTFItem.pos[0], affineTFItem.pos[1], affineTFItem.size[0], affineTFItem.size[1]);
+      const QRect rect = data.affineTFBlocks.getRect(blockIdx);
       const QRect displayRect = QRect(rect.left()*zoomFactor, rect.top()*zoomFactor, rect.width()*zoomFactor, rect.height()*zoomFactor);
       // Check if the rectangle of the statistics item is even visible
       const bool rectVisible = (!(displayRect.left() > xMax || displayRect.right() < xMin || displayRect.top() > yMax || displayRect.bottom() < yMin));
 
       if (rectVisible)
       {
-        if (statsTypeList[i].renderVectorData)
+        if (typeList[i].renderVectorData)
         {
           // affine vectors start at bottom left, top left and top right of the block
           // mv0: LT, mv1: RT, mv2: LB
@@ -575,12 +732,12 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
           yLBstart = displayRect.bottom();
 
           // The length of the vectors
-          vxLT = (float)affineTFItem.point[0].x() / statsTypeList[i].vectorScale;
-          vyLT = (float)affineTFItem.point[0].y() / statsTypeList[i].vectorScale;
-          vxRT = (float)affineTFItem.point[1].x() / statsTypeList[i].vectorScale;
-          vyRT = (float)affineTFItem.point[1].y() / statsTypeList[i].vectorScale;
-          vxLB = (float)affineTFItem.point[2].x() / statsTypeList[i].vectorScale;
-          vyLB = (float)affineTFItem.point[2].y() / statsTypeList[i].vectorScale;
+          vxLT = (float)affineTFPoints[0].x() / typeList[i].vectorScale;
+          vyLT = (float)affineTFPoints[0].y() / typeList[i].vectorScale;
+          vxRT = (float)affineTFPoints[1].x() / typeList[i].vectorScale;
+          vyRT = (float)affineTFPoints[1].y() / typeList[i].vectorScale;
+          vxLB = (float)affineTFPoints[2].x() / typeList[i].vectorScale;
+          vyLB = (float)affineTFPoints[2].y() / typeList[i].vectorScale;
 
           // The end point of the vectors
           xLTend = xLTstart + zoomFactor * vxLT;
@@ -590,17 +747,17 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
           xLBend = xLBstart + zoomFactor * vxLB;
           yLBend = yLBstart + zoomFactor * vyLB;
 
-          paintVector(painter, i, zoomFactor, xLTstart, yLTstart, xLTend, yLTend, vxLT, vyLT, false, xMin, xMax, yMin, yMax);
-          paintVector(painter, i, zoomFactor, xRTstart, yRTstart, xRTend, yRTend, vxRT, vyRT, false, xMin, xMax, yMin, yMax);
-          paintVector(painter, i, zoomFactor, xLBstart, yLBstart, xLBend, yLBend, vxLB, vyLB, false, xMin, xMax, yMin, yMax);
+          paintVector(painter, typeList[i], zoomFactor, xLTstart, yLTstart, xLTend, yLTend, vxLT, vyLT, false, xMin, xMax, yMin, yMax);
+          paintVector(painter, typeList[i], zoomFactor, xRTstart, yRTstart, xRTend, yRTend, vxRT, vyRT, false, xMin, xMax, yMin, yMax);
+          paintVector(painter, typeList[i], zoomFactor, xLBstart, yLBstart, xLBend, yLBend, vxLB, vyLB, false, xMin, xMax, yMin, yMax);
 
         }
 
         // optionally, draw a grid around the region that the arrow is defined for
-        if (statsTypeList[i].renderGrid && rectVisible)
+        if (typeList[i].renderGrid && rectVisible)
         {
-          QPen gridPen = statsTypeList[i].gridPen;
-          if (statsTypeList[i].scaleGridToZoom)
+          QPen gridPen = typeList[i].gridPen;
+          if (typeList[i].scaleGridToZoom)
             gridPen.setWidthF(gridPen.widthF() * zoomFactor);
 
           painter->setPen(gridPen);
@@ -613,15 +770,15 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
   }
   
   // Draw all polygon vector data
-  for (int i = statsTypeList.count() - 1; i >= 0; i--)
+  for (int i = typeList.count() - 1; i >= 0; i--)
   {
-    int typeIdx = statsTypeList[i].typeID;
-    if (!statsTypeList[i].render || !statsCache.contains(typeIdx))
+    int typeIdx = typeList[i].typeID;
+    if (!typeList[i].render || !cache.contains(typeIdx))
       // This statistics type is not rendered or could not be loaded.
       continue;
 
     // Go through all the vector data
-    for (const statisticsItemPolygon_Vector &vectorItem : statsCache[typeIdx].polygonVectorData)
+    for (const statisticsItemPolygon_Vector &vectorItem : cache.constFind(typeIdx).value().polygonVectorData)
     {
       // Calculate the size and position of the rectangle to draw (zoomed in)
       QTransform trans;
@@ -634,7 +791,7 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
 
       if (isVisible)
       {
-        if (statsTypeList[i].renderVectorData)
+        if (typeList[i].renderVectorData)
         {
           // start vector at center of the block
           int center_x,center_y,head_x,head_y;
@@ -651,8 +808,8 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
           center_y /= displayPolygon.size();
 
           // The length of the vector
-          vx = (float)vectorItem.point[0].x() / statsTypeList[i].vectorScale;
-          vy = (float)vectorItem.point[0].y() / statsTypeList[i].vectorScale;
+          vx = (float)vectorItem.point[0].x() / typeList[i].vectorScale;
+          vy = (float)vectorItem.point[0].y() / typeList[i].vectorScale;
 
           // The end point of the vector
           head_x = center_x + zoomFactor * vx;
@@ -662,13 +819,13 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
           if (!(center_x < xMin && head_x < xMin) && !(center_x > xMax && head_x > xMax) && !(center_y < yMin && head_y < yMin) && !(center_y > yMax && head_y > yMax))
           {
             // Set the pen for drawing
-            QPen vectorPen = statsTypeList[i].vectorPen;
+            QPen vectorPen = typeList[i].vectorPen;
             QColor arrowColor = vectorPen.color();
-            if (statsTypeList[i].mapVectorToColor)
+            if (typeList[i].mapVectorToColor)
               arrowColor.setHsvF(clip((atan2f(vy,vx)+M_PI)/(2*M_PI),0.0,1.0), 1.0,1.0);
-            arrowColor.setAlpha(arrowColor.alpha()*((float)statsTypeList[i].alphaFactor / 100.0));
+            arrowColor.setAlpha(arrowColor.alpha()*((float)typeList[i].alphaFactor / 100.0));
             vectorPen.setColor(arrowColor);
-            if (statsTypeList[i].scaleVectorToZoom)
+            if (typeList[i].scaleVectorToZoom)
               vectorPen.setWidthF(vectorPen.widthF() * zoomFactor / 8);
             painter->setPen(vectorPen);
             painter->setBrush(arrowColor);
@@ -685,11 +842,11 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
               if ((vx != 0 || vy != 0))
               {
                 // The size of the arrow head
-                const int headSize = (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM && !statsTypeList[i].scaleVectorToZoom) ? 8 : zoomFactor/2;
-                if (statsTypeList[i].arrowHead != StatisticsType::arrowHead_t::none)
+                const int headSize = (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM && !typeList[i].scaleVectorToZoom) ? 8 : zoomFactor/2;
+                if (typeList[i].arrowHead != StatisticsType::arrowHead_t::none)
                 {
                   // We draw an arrow head. This means that we will have to draw a shortened line
-                  const int shorten = (statsTypeList[i].arrowHead == StatisticsType::arrowHead_t::arrow) ? headSize * 2 : headSize * 0.5;
+                  const int shorten = (typeList[i].arrowHead == StatisticsType::arrowHead_t::arrow) ? headSize * 2 : headSize * 0.5;
                   if (sqrt(vx*vx*zoomFactor*zoomFactor + vy*vy*zoomFactor*zoomFactor) > shorten)
                   {
                     // Shorten the line and draw it
@@ -701,7 +858,7 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
                   // Draw the not shortened line
                   painter->drawLine(center_x, center_y, head_x, head_y);
 
-                if (statsTypeList[i].arrowHead == StatisticsType::arrowHead_t::arrow)
+                if (typeList[i].arrowHead == StatisticsType::arrowHead_t::arrow)
                 {
                   // Save the painter state, translate to the arrow tip, rotate the painter and draw the normal triangle.
                   painter->save();
@@ -715,12 +872,12 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
                   // Restore. Revert translation/rotation of the painter.
                   painter->restore();
                 }
-                else if (statsTypeList[i].arrowHead == StatisticsType::arrowHead_t::circle)
+                else if (typeList[i].arrowHead == StatisticsType::arrowHead_t::circle)
                   painter->drawEllipse(head_x-headSize/2, head_y-headSize/2, headSize, headSize);
               }
 
               // Todo
-              // if (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM && statsTypeList[i].renderVectorDataValues)
+              // if (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM && typeList[i].renderVectorDataValues)
               // {
               //   // Also draw the vector value next to the arrow head
               //     QString txt = QString("x %1\ny %2").arg(vx).arg(vy);
@@ -748,10 +905,10 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
         }
 
         // optionally, draw the polygon outline
-        if (statsTypeList[i].renderGrid && isVisible)
+        if (typeList[i].renderGrid && isVisible)
         {
-          QPen gridPen = statsTypeList[i].gridPen;
-          if (statsTypeList[i].scaleGridToZoom)
+          QPen gridPen = typeList[i].gridPen;
+          if (typeList[i].scaleGridToZoom)
             gridPen.setWidthF(gridPen.widthF() * zoomFactor);
 
           painter->setPen(gridPen);
@@ -762,13 +919,9 @@ void statisticHandler::paintStatistics(QPainter *painter, int frameIdx, double z
       }
     }
   }
-
-  // Restore the state the state of the painter from before this function was called.
-  // This will reset the set pens and the translation.
-  painter->restore();
 }
 
-void statisticHandler::paintVector(QPainter *painter, const int& statTypeIdx, const double& zoomFactor,
+void statisticHandler::paintVector(QPainter *painter, const StatisticsType &type, const double& zoomFactor,
                                    const int& x1, const int& y1, const int& x2, const int& y2,
                                    const float& vx, const float& vy, bool isLine,
                                    const int& xMin, const int& xMax, const int& yMin, const int& yMax)
@@ -778,13 +931,13 @@ void statisticHandler::paintVector(QPainter *painter, const int& statTypeIdx, co
   if (!(x1 < xMin && x2 < xMin) && !(x1 > xMax && x2 > xMax) && !(y1 < yMin && y2 < yMin) && !(y1 > yMax && y2 > yMax))
   {
     // Set the pen for drawing
-    QPen vectorPen = statsTypeList[statTypeIdx].vectorPen;
+    QPen vectorPen = type.vectorPen;
     QColor arrowColor = vectorPen.color();
-    if (statsTypeList[statTypeIdx].mapVectorToColor)
+    if (type.mapVectorToColor)
       arrowColor.setHsvF(clip((atan2f(vy,vx)+M_PI)/(2*M_PI),0.0,1.0), 1.0,1.0);
-    arrowColor.setAlpha(arrowColor.alpha()*((float)statsTypeList[statTypeIdx].alphaFactor / 100.0));
+    arrowColor.setAlpha(arrowColor.alpha()*((float)type.alphaFactor / 100.0));
     vectorPen.setColor(arrowColor);
-    if (statsTypeList[statTypeIdx].scaleVectorToZoom)
+    if (type.scaleVectorToZoom)
       vectorPen.setWidthF(vectorPen.widthF() * zoomFactor / 8);
     painter->setPen(vectorPen);
     painter->setBrush(arrowColor);
@@ -801,12 +954,12 @@ void statisticHandler::paintVector(QPainter *painter, const int& statTypeIdx, co
       if ((vx != 0 || vy != 0))
       {
         // The size of the arrow head
-        const int headSize = (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM && !statsTypeList[statTypeIdx].scaleVectorToZoom) ? 8 : zoomFactor/2;
+        const int headSize = (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM && !type.scaleVectorToZoom) ? 8 : zoomFactor/2;
 
-        if (statsTypeList[statTypeIdx].arrowHead != StatisticsType::arrowHead_t::none)
+        if (type.arrowHead != StatisticsType::arrowHead_t::none)
         {
           // We draw an arrow head. This means that we will have to draw a shortened line
-          const int shorten = (statsTypeList[statTypeIdx].arrowHead == StatisticsType::arrowHead_t::arrow) ? headSize * 2 : headSize * 0.5;
+          const int shorten = (type.arrowHead == StatisticsType::arrowHead_t::arrow) ? headSize * 2 : headSize * 0.5;
 
           if (sqrt(vx*vx*zoomFactor*zoomFactor + vy*vy*zoomFactor*zoomFactor) > shorten)
           {
@@ -819,7 +972,7 @@ void statisticHandler::paintVector(QPainter *painter, const int& statTypeIdx, co
           // Draw the not shortened line
           painter->drawLine(x1, y1, x2, y2);
 
-        if (statsTypeList[statTypeIdx].arrowHead == StatisticsType::arrowHead_t::arrow)
+        if (type.arrowHead == StatisticsType::arrowHead_t::arrow)
         {
           // Save the painter state, translate to the arrow tip, rotate the painter and draw the normal triangle.
           painter->save();
@@ -833,11 +986,11 @@ void statisticHandler::paintVector(QPainter *painter, const int& statTypeIdx, co
           // Restore. Revert translation/rotation of the painter.
           painter->restore();
         }
-        else if (statsTypeList[statTypeIdx].arrowHead == StatisticsType::arrowHead_t::circle)
+        else if (type.arrowHead == StatisticsType::arrowHead_t::circle)
           painter->drawEllipse(x2-headSize/2, y2-headSize/2, headSize, headSize);
       }
 
-      if (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM && statsTypeList[statTypeIdx].renderVectorDataValues)
+      if (zoomFactor >= STATISTICS_DRAW_VALUES_ZOOM && type.renderVectorDataValues)
       {
         if (isLine)
         {
@@ -932,42 +1085,41 @@ QStringPairList statisticHandler::getValuesAt(const QPoint &pos)
 
       const StatisticsType* aType = getStatisticsType(typeID);
 
-      // Get all value data entries
+      // Get all value data entries at the position
       bool foundStats = false;
-      for (const statisticsItem_Value &valueItem : statsCache[typeID].valueData)
+      const statisticsData &data = statsCache[typeID];
+      QVector<int> blockIndices;
+      data.valueBlocks.getBlocksInArea(QRect(pos, QSize(1, 1)), blockIndices);
+      for (const int blockIdx : blockIndices)
       {
-        QRect rect = QRect(valueItem.pos[0], valueItem.pos[1], valueItem.size[0], valueItem.size[1]);
-        if (rect.contains(pos))
-        {
-          int value = valueItem.value;
-          QString valTxt  = statsTypeList[i].getValueTxt(value);
-          if (!statsTypeList[i].valMap.contains(value) && statsTypeList[i].scaleValueToBlockSize)
-            valTxt = QString("%1").arg(float(value) / (valueItem.size[0] * valueItem.size[1]));
-          valueList.append(QStringPair(aType->typeName, valTxt));
-          foundStats = true;
-        }
+        const QRect rect = data.valueBlocks.getRect(blockIdx);
+        int value = data.values[blockIdx];
+        QString valTxt  = statsTypeList[i].getValueTxt(value);
+        if (!statsTypeList[i].valMap.contains(value) && statsTypeList[i].scaleValueToBlockSize)
+          valTxt = QString("%1").arg(float(value) / (rect.width() * rect.height()));
+        valueList.append(QStringPair(aType->typeName, valTxt));
+        foundStats = true;
       }
 
-      for (const statisticsItem_Vector &vectorItem : statsCache[typeID].vectorData)
+      data.vectorBlocks.getBlocksInArea(QRect(pos, QSize(1, 1)), blockIndices);
+      for (const int blockIdx : blockIndices)
       {
-        QRect rect = QRect(vectorItem.pos[0], vectorItem.pos[1], vectorItem.size[0], vectorItem.size[1]);
-        if (rect.contains(pos))
+        const QPoint &point0 = data.vectorPoints0[blockIdx];
+        const QPoint &point1 = data.vectorPoints1[blockIdx];
+        float vectorValue1, vectorValue2;
+        if (data.vectorIsLine[blockIdx])
         {
-          float vectorValue1, vectorValue2;
-          if (vectorItem.isLine)
-          {
-           vectorValue1 = (float)(vectorItem.point[1].x() - vectorItem.point[0].x()) / statsTypeList[i].vectorScale;
-           vectorValue2 = (float)(vectorItem.point[1].y() - vectorItem.point[0].y()) / statsTypeList[i].vectorScale;
-          }
-          else
-          {
-            vectorValue1 = (float)vectorItem.point[0].x() / statsTypeList[i].vectorScale;
-            vectorValue2 = (float)vectorItem.point[0].y() / statsTypeList[i].vectorScale;
-          }
-          valueList.append(QStringPair(QString("%1[x]").arg(aType->typeName), QString::number(vectorValue1)));
-          valueList.append(QStringPair(QString("%1[y]").arg(aType->typeName), QString::number(vectorValue2)));
-          foundStats = true;
+          vectorValue1 = (float)(point1.x() - point0.x()) / statsTypeList[i].vectorScale;
+          vectorValue2 = (float)(point1.y() - point0.y()) / statsTypeList[i].vectorScale;
+        }
+        else
+        {
+          vectorValue1 = (float)point0.x() / statsTypeList[i].vectorScale;
+          vectorValue2 = (float)point0.y() / statsTypeList[i].vectorScale;
         }
+        valueList.append(QStringPair(QString("%1[x]").arg(aType->typeName), QString::number(vectorValue1)));
+        valueList.append(QStringPair(QString("%1[y]").arg(aType->typeName), QString::number(vectorValue2)));
+        foundStats = true;
       }
 
       if (!foundStats)
@@ -1019,6 +1171,8 @@ bool statisticHandler::setStatisticsTypeList(const StatisticsTypeList &typeList)
     }
   }
 
+  if (bChanged)
+    invalidateRasterCache();
   return bChanged;
 }
 
@@ -1156,6 +1310,7 @@ void statisticHandler::onStatisticsControlChanged()
     }
   }
 
+  invalidateRasterCache();
   emit updateItem(true);
 }
 
@@ -1188,6 +1343,7 @@ void statisticHandler::onSecondaryStatisticsControlChanged()
     }
   }
 
+  invalidateRasterCache();
   emit updateItem(true);
 }
 
@@ -1210,6 +1366,7 @@ void statisticHandler::loadPlaylist(const YUViewDomElement &root)
 {
   for (int row = 0; row < statsTypeList.length(); ++row)
     statsTypeList[row].loadPlaylist(root);
+  invalidateRasterCache();
 }
 
 void statisticHandler::updateSettings()
@@ -1321,6 +1478,7 @@ void statisticHandler::updateStatisticsHandlerControls()
         }
       }
     }
+    invalidateRasterCache();
 
     // Create new controls
     createStatisticsHandlerControls(true);
@@ -1354,6 +1512,7 @@ void statisticHandler::addStatType(const StatisticsType &type)
   {
     statsTypeList.append(type);
   }
+  invalidateRasterCache();
 }
 
 void statisticHandler::clearStatTypes()
@@ -1364,6 +1523,7 @@ void statisticHandler::clearStatTypes()
 
   // Clear the old list. New items can be added now.
   statsTypeList.clear();
+  invalidateRasterCache();
 }
 
 void statisticHandler::onStyleButtonClicked(int id)
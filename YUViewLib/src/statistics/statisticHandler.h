@@ -33,6 +33,10 @@
 #ifndef STATISTICSOURCE_H
 #define STATISTICSOURCE_H
 
+#include <QAtomicInt>
+#include <QFuture>
+#include <QHash>
+#include <QImage>
 #include <QPointer>
 #include <QVector>
 #include <QMutex>
@@ -53,6 +57,7 @@ class statisticHandler : public QObject
 
 public:
   statisticHandler();
+  virtual ~statisticHandler();
 
   // Get the statistics values under the cursor position (if they are visible)
   QStringPairList getValuesAt(const QPoint &pos);
@@ -80,10 +85,10 @@ public:
   // Returns false if the statistics need to be loaded first.
   void paintStatistics(QPainter *painter, int frameIdx, double zoomFactor);
 
-  // Draw a vector.
-  void paintVector(QPainter *painter, const int &statTypeIdx, const double &zoomFactor,
-                   const int &x1, const int &y1, const int &x2, const int &y2,
-                   const float &vx, const float &vy, bool isLine, const int &xMin, const int &xMax, const int &yMin, const int &yMax);
+  // Draw a vector of the given type.
+  static void paintVector(QPainter *painter, const StatisticsType &type, const double &zoomFactor,
+                          const int &x1, const int &y1, const int &x2, const int &y2,
+                          const float &vx, const float &vy, bool isLine, const int &xMin, const int &xMax, const int &yMin, const int &yMax);
 
   // Do we need to load some of the statistics before we can draw them?
   itemLoadingState needsLoading(int frameIdx);
@@ -95,8 +100,8 @@ public:
   // Get the statisticsType with the given typeID from p_statsTypeList
   StatisticsType *getStatisticsType(int typeID);
 
-  void setFrameSize(QSize frameSize) { statFrameSize = frameSize; }
-  void setFrameSize(int width, int height) { statFrameSize = QSize(width, height); }
+  void setFrameSize(QSize frameSize) { statFrameSize = frameSize; invalidateRasterCache(); }
+  void setFrameSize(int width, int height) { setFrameSize(QSize(width, height)); }
   QSize getFrameSize() const { return statFrameSize; }
 
   // Add new statistics type. Add all types using this function before creating the controls (createStatisticsHandlerControls).
@@ -130,6 +135,37 @@ private:
   // Make sure that nothing is read from the stats cache while it is being changed.
   QMutex statsCacheAccessMutex;
 
+  // Draw the given statistics data. The painter must be translated to the top left of the frame. Only the items that
+  // are visible in the area xMin...xMax, yMin...yMax (in zoomed pixels relative to the top left) are drawn.
+  static void paintStatisticsData(QPainter *painter, double zoomFactor, int xMin, int xMax, int yMin, int yMax, const StatisticsTypeList &typeList, const QHash<int, statisticsData> &cache);
+
+  // ----- Rasterized statistics -----
+  // Drawing all blocks with QPainter is slow for large frames and it is done for every repaint (e.g. when the view
+  // is moved). So if the whole frame fits into an image of reasonable size at the current zoom factor, the statistics
+  // of the frame are drawn into an image in a background thread. Until the image is ready, the statistics are drawn
+  // directly. The images are kept per zoom level. They are dropped when the frame, the statistics data or the render
+  // settings of the types change.
+  struct rasterizedStatistics
+  {
+    QImage image;
+    QRect rect;       // The area that the image covers (relative to the center of the frame)
+    QSize frameSize;  // The zoomed size of the frame that the image was drawn for
+  };
+  QMutex rasterCacheMutex;
+  QHash<int, rasterizedStatistics> rasterCache;   // [zoom bucket]
+  int   rasterCacheFrameIdx {-1};
+  int   rasterCacheRevision {-1};
+  qreal rasterCacheDevicePixelRatio {1.0};
+  QFuture<void> rasterFuture;
+  // This is increased whenever something changes that the images depend on
+  QAtomicInt renderRevision;
+  void invalidateRasterCache() { renderRevision.ref(); }
+  // Draw the image of the statistics if there is one for the frame and zoom factor. If not, start rendering it in the
+  // background (if this is possible for the zoom factor) and return false.
+  bool paintRasterizedStatistics(QPainter *painter, int frameIdx, double zoomFactor, const QRect &statRect);
+  // Draw the statistics into an image and put it into the rasterCache. This runs in a background thread.
+  void rasterizeStatistics(int frameIdx, int revision, int zoomBucket, double zoomFactor, qreal devicePixelRatio, QRect statRect, QRect rect, StatisticsTypeList typeList, QHash<int, statisticsData> cache);
+
   // The list of all statistics that this class can provide (and a backup for updating the list)
   StatisticsTypeList statsTypeList;
   StatisticsTypeList statsTypeListBackup;
@@ -157,7 +193,9 @@ private slots:
   void onStatisticsControlChanged();
   void onSecondaryStatisticsControlChanged();
   void onStyleButtonClicked(int id);
-  void updateStatisticItem() { emit updateItem(true); }
+  void updateStatisticItem() { invalidateRasterCache(); emit updateItem(true); }
+  // The background rendering of the statistics is done. Invoked in the main thread.
+  void onStatisticsRasterized() { emit updateItem(true); }
 };
 
 #endif
@@ -0,0 +1,380 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "statisticsBinaryFile.h"
+
+#include <algorithm>
+#include <cstring>
+#include <QDataStream>
+#include <QtEndian>
+
+namespace statisticsBinaryFile
+{
+
+namespace
+{
+  template<typename T> void appendValue(QByteArray &buffer, T value)
+  {
+    char data[sizeof(T)];
+    qToLittleEndian<T>(value, reinterpret_cast<uchar*>(data));
+    buffer.append(data, sizeof(T));
+  }
+
+  template<typename T> T readValue(const char *&data)
+  {
+    const T value = qFromLittleEndian<T>(reinterpret_cast<const uchar*>(data));
+    data += sizeof(T);
+    return value;
+  }
+
+  void appendPosition(QByteArray &buffer, const statisticsBlockList &blocks, int i)
+  {
+    appendValue<quint16>(buffer, blocks.posX[i]);
+    appendValue<quint16>(buffer, blocks.posY[i]);
+    appendValue<quint16>(buffer, blocks.width[i]);
+    appendValue<quint16>(buffer, blocks.height[i]);
+  }
+
+  void readPosition(const char *&data, unsigned short pos[2], unsigned short size[2])
+  {
+    pos[0] = readValue<quint16>(data);
+    pos[1] = readValue<quint16>(data);
+    size[0] = readValue<quint16>(data);
+    size[1] = readValue<quint16>(data);
+  }
+
+  void appendPoint(QByteArray &buffer, const QPoint &p)
+  {
+    appendValue<qint32>(buffer, p.x());
+    appendValue<qint32>(buffer, p.y());
+  }
+
+  QPoint readPoint(const char *&data)
+  {
+    const int x = readValue<qint32>(data);
+    const int y = readValue<qint32>(data);
+    return QPoint(x, y);
+  }
+
+  QByteArray createHeader(QSize frameSize, double frameRate, int maxPOC, qint64 typesOffset, qint64 typesSize, qint64 tableOffset, int nrEntries)
+  {
+    QByteArray header(magic, 8);
+    appendValue<quint32>(header, version);
+    appendValue<qint32>(header, frameSize.width());
+    appendValue<qint32>(header, frameSize.height());
+    quint64 frameRateBits;
+    memcpy(&frameRateBits, &frameRate, sizeof(double));
+    appendValue<quint64>(header, frameRateBits);
+    appendValue<qint32>(header, maxPOC);
+    appendValue<qint64>(header, typesOffset);
+    appendValue<qint64>(header, typesSize);
+    appendValue<qint64>(header, tableOffset);
+    appendValue<quint32>(header, nrEntries);
+    header.append(headerSize - header.size(), char(0));
+    return header;
+  }
+}
+
+bool readFileHeader(fileSource &file, fileHeader &header, QString &errorText)
+{
+  const rawDataView headerData = file.readBytesView(0, headerSize);
+  if (headerData.isEmpty() || memcmp(headerData.data(), magic, 8) != 0)
+  {
+    errorText = "The file is not a binary statistics file.";
+    return false;
+  }
+
+  const char *data = headerData.data() + 8;
+  if (readValue<quint32>(data) != version)
+  {
+    errorText = "The version of the binary statistics file is not supported.";
+    return false;
+  }
+  const int width = readValue<qint32>(data);
+  const int height = readValue<qint32>(data);
+  header.frameSize = QSize(width, height);
+  const quint64 frameRateBits = readValue<quint64>(data);
+  memcpy(&header.frameRate, &frameRateBits, sizeof(double));
+  header.maxPOC = readValue<qint32>(data);
+  const qint64 typesOffset = readValue<qint64>(data);
+  const qint64 typesSize = readValue<qint64>(data);
+  const qint64 tableOffset = readValue<qint64>(data);
+  const quint32 nrEntries = readValue<quint32>(data);
+
+  // Read the type definitions
+  const rawDataView typesData = file.readBytesView(typesOffset, typesSize);
+  if (typesSize > 0 && typesData.isEmpty())
+  {
+    errorText = "The type definitions could not be read.";
+    return false;
+  }
+  QDataStream typesStream(typesData.byteArray());
+  typesStream.setVersion(QDataStream::Qt_5_6);
+  qint32 nrTypes;
+  typesStream >> nrTypes;
+  header.types.clear();
+  for (int i = 0; i < nrTypes && typesStream.status() == QDataStream::Ok; i++)
+  {
+    StatisticsType aType;
+    aType.readBinary(typesStream);
+    header.types.append(aType);
+  }
+  if (typesStream.status() != QDataStream::Ok)
+  {
+    errorText = "The type definitions are corrupt.";
+    return false;
+  }
+
+  // Read the frame/type table
+  header.table.clear();
+  if (nrEntries == 0)
+    return true;
+  const rawDataView tableData = file.readBytesView(tableOffset, qint64(nrEntries) * tableEntrySize);
+  if (tableData.isEmpty())
+  {
+    errorText = "The frame/type table could not be read.";
+    return false;
+  }
+  header.table.resize(nrEntries);
+  data = tableData.data();
+  for (frameTypeEntry &entry : header.table)
+  {
+    entry.frameIdx = readValue<qint32>(data);
+    entry.typeID = readValue<qint32>(data);
+    entry.offset = readValue<qint64>(data);
+    entry.size = readValue<qint64>(data);
+    entry.nrValues = readValue<quint32>(data);
+    entry.nrVectors = readValue<quint32>(data);
+    entry.nrAffineTFs = readValue<quint32>(data);
+    entry.nrPolygonValues = readValue<quint32>(data);
+    entry.nrPolygonVectors = readValue<quint32>(data);
+    entry.maxBlockSize = readValue<quint32>(data);
+  }
+  return true;
+}
+
+const frameTypeEntry *findEntry(const QVector<frameTypeEntry> &table, int frameIdx, int typeID)
+{
+  frameTypeEntry key;
+  key.frameIdx = frameIdx;
+  key.typeID = typeID;
+  auto it = std::lower_bound(table.constBegin(), table.constEnd(), key);
+  if (it == table.constEnd() || it->frameIdx != frameIdx || it->typeID != typeID)
+    return nullptr;
+  return it;
+}
+
+bool decodeFrameType(const char *data, const frameTypeEntry &entry, statisticsData &out)
+{
+  const qint64 blockRecordsSize = qint64(entry.nrValues) * valueRecordSize + qint64(entry.nrVectors) * vectorRecordSize + qint64(entry.nrAffineTFs) * affineTFRecordSize;
+  if (blockRecordsSize > entry.size)
+    return false;
+  const char *end = data + entry.size;
+
+  out.valueBlocks.reserve(out.valueBlocks.count() + entry.nrValues);
+  out.values.reserve(out.values.size() + entry.nrValues);
+  for (quint32 i = 0; i < entry.nrValues; i++)
+  {
+    unsigned short pos[2], size[2];
+    readPosition(data, pos, size);
+    out.addBlockValue(pos[0], pos[1], size[0], size[1], readValue<qint32>(data));
+  }
+
+  out.vectorBlocks.reserve(out.vectorBlocks.count() + entry.nrVectors);
+  for (quint32 i = 0; i < entry.nrVectors; i++)
+  {
+    unsigned short pos[2], size[2];
+    readPosition(data, pos, size);
+    const QPoint point0 = readPoint(data);
+    const QPoint point1 = readPoint(data);
+    if (readValue<quint32>(data) != 0)
+      out.addLine(pos[0], pos[1], size[0], size[1], point0.x(), point0.y(), point1.x(), point1.y());
+    else
+      out.addBlockVector(pos[0], pos[1], size[0], size[1], point0.x(), point0.y());
+  }
+
+  out.affineTFBlocks.reserve(out.affineTFBlocks.count() + entry.nrAffineTFs);
+  for (quint32 i = 0; i < entry.nrAffineTFs; i++)
+  {
+    unsigned short pos[2], size[2];
+    readPosition(data, pos, size);
+    const QPoint point0 = readPoint(data);
+    const QPoint point1 = readPoint(data);
+    const QPoint point2 = readPoint(data);
+    out.addBlockAffineTF(pos[0], pos[1], size[0], size[1], point0.x(), point0.y(), point1.x(), point1.y(), point2.x(), point2.y());
+  }
+
+  // The polygons have a variable size. Check that every polygon is within the data.
+  for (quint32 i = 0; i < entry.nrPolygonValues; i++)
+  {
+    if (end - data < polygonRecordHeaderSize)
+      return false;
+    const quint32 nrPoints = readValue<quint32>(data);
+    const int value = readValue<qint32>(data);
+    if (quint64(end - data) < quint64(nrPoints) * 8)
+      return false;
+    QVector<QPoint> points(nrPoints);
+    for (QPoint &p : points)
+      p = readPoint(data);
+    out.addPolygonValue(points, value);
+  }
+
+  for (quint32 i = 0; i < entry.nrPolygonVectors; i++)
+  {
+    if (end - data < polygonRecordHeaderSize + 4)
+      return false;
+    const quint32 nrPoints = readValue<quint32>(data);
+    const QPoint vec = readPoint(data);
+    if (quint64(end - data) < quint64(nrPoints) * 8)
+      return false;
+    QVector<QPoint> points(nrPoints);
+    for (QPoint &p : points)
+      p = readPoint(data);
+    out.addPolygonVector(points, vec.x(), vec.y());
+  }
+
+  return true;
+}
+
+bool writer::start(QSize frameSize, double frameRate, const StatisticsTypeList &types)
+{
+  this->frameSize = frameSize;
+  this->frameRate = frameRate;
+  table.clear();
+
+  if (!file.open(QIODevice::WriteOnly))
+    return false;
+
+  // Write a placeholder for the header. It is written again in finish() when all offsets are known.
+  if (file.write(createHeader(frameSize, frameRate, 0, 0, 0, 0, 0)) != headerSize)
+    return false;
+
+  QByteArray typesData;
+  QDataStream typesStream(&typesData, QIODevice::WriteOnly);
+  typesStream.setVersion(QDataStream::Qt_5_6);
+  typesStream << qint32(types.size());
+  for (const StatisticsType &aType : types)
+    aType.writeBinary(typesStream);
+
+  typesOffset = headerSize;
+  typesSize = typesData.size();
+  return file.write(typesData) == typesSize;
+}
+
+bool writer::writeFrameType(int frameIdx, int typeID, const statisticsData &data)
+{
+  frameTypeEntry entry;
+  entry.frameIdx = frameIdx;
+  entry.typeID = typeID;
+  entry.offset = file.pos();
+  entry.nrValues = data.valueBlocks.count();
+  entry.nrVectors = data.vectorBlocks.count();
+  entry.nrAffineTFs = data.affineTFBlocks.count();
+  entry.nrPolygonValues = data.polygonValueData.size();
+  entry.nrPolygonVectors = data.polygonVectorData.size();
+  entry.maxBlockSize = data.maxBlockSize;
+
+  buffer.clear();
+  buffer.reserve(entry.nrValues * valueRecordSize + entry.nrVectors * vectorRecordSize + entry.nrAffineTFs * affineTFRecordSize);
+  for (int i = 0; i < data.valueBlocks.count(); i++)
+  {
+    appendPosition(buffer, data.valueBlocks, i);
+    appendValue<qint32>(buffer, data.values[i]);
+  }
+  for (int i = 0; i < data.vectorBlocks.count(); i++)
+  {
+    const bool isLine = data.vectorIsLine[i];
+    appendPosition(buffer, data.vectorBlocks, i);
+    appendPoint(buffer, data.vectorPoints0[i]);
+    appendPoint(buffer, isLine ? data.vectorPoints1[i] : QPoint());
+    appendValue<quint32>(buffer, isLine ? 1 : 0);
+  }
+  for (int i = 0; i < data.affineTFBlocks.count(); i++)
+  {
+    appendPosition(buffer, data.affineTFBlocks, i);
+    for (int p = 0; p < 3; p++)
+      appendPoint(buffer, data.affineTFPoints[i * 3 + p]);
+  }
+  for (const statisticsItemPolygon_Value &value : data.polygonValueData)
+  {
+    appendValue<quint32>(buffer, value.corners.size());
+    appendValue<qint32>(buffer, value.value);
+    for (const QPoint &p : value.corners)
+      appendPoint(buffer, p);
+  }
+  for (const statisticsItemPolygon_Vector &vec : data.polygonVectorData)
+  {
+    appendValue<quint32>(buffer, vec.corners.size());
+    appendPoint(buffer, vec.point[0]);
+    for (const QPoint &p : vec.corners)
+      appendPoint(buffer, p);
+  }
+
+  entry.size = buffer.size();
+  if (file.write(buffer) != entry.size)
+    return false;
+  table.append(entry);
+  return true;
+}
+
+bool writer::finish(int maxPOC)
+{
+  std::sort(table.begin(), table.end());
+
+  const qint64 tableOffset = file.pos();
+  buffer.clear();
+  buffer.reserve(table.size() * tableEntrySize);
+  for (const frameTypeEntry &entry : table)
+  {
+    appendValue<qint32>(buffer, entry.frameIdx);
+    appendValue<qint32>(buffer, entry.typeID);
+    appendValue<qint64>(buffer, entry.offset);
+    appendValue<qint64>(buffer, entry.size);
+    appendValue<quint32>(buffer, entry.nrValues);
+    appendValue<quint32>(buffer, entry.nrVectors);
+    appendValue<quint32>(buffer, entry.nrAffineTFs);
+    appendValue<quint32>(buffer, entry.nrPolygonValues);
+    appendValue<quint32>(buffer, entry.nrPolygonVectors);
+    appendValue<quint32>(buffer, entry.maxBlockSize);
+  }
+  if (file.write(buffer) != buffer.size())
+    return false;
+
+  if (!file.seek(0))
+    return false;
+  if (file.write(createHeader(frameSize, frameRate, maxPOC, typesOffset, typesSize, tableOffset, table.size())) != headerSize)
+    return false;
+
+  return file.commit();
+}
+
+} // namespace statisticsBinaryFile
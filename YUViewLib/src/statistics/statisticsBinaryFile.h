@@ -0,0 +1,131 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef STATISTICSBINARYFILE_H
+#define STATISTICSBINARYFILE_H
+
+#include <QSaveFile>
+#include <QSize>
+#include <QVector>
+
+#include "filesource/fileSource.h"
+#include "statistics/statisticHandler.h"
+#include "statistics/statisticsExtensions.h"
+
+/* The binary statistics file format. Parsing text statistics (CSV or VTMBMS) is slow because every line has to be
+ * split and converted for every frame and type that is drawn. In the binary format, all values are stored as little
+ * endian integers in fixed-width records which can be copied directly into statisticsData.
+ *
+ * The file consists of:
+ * - The file header (headerSize bytes, see below)
+ * - The definitions of all statistics types (serialized with QDataStream, see StatisticsType::writeBinary)
+ * - The data of all frame/type pairs. For each pair, all value records, vector records, affine transform records,
+ *   polygon value records and polygon vector records follow each other. Block records have a fixed width. A polygon
+ *   record starts with the number of points and the value(s) followed by all points (x, y).
+ * - The frame/type table at the end of the file. It has one entry for every frame/type pair that has data.
+ *   The entries are sorted by frame index and type ID so that an entry can be found with a binary search.
+ */
+namespace statisticsBinaryFile
+{
+  // The header: magic (8 bytes), version, frame width, frame height, frame rate (double), max POC,
+  // offset and size of the type definitions (64 bit), offset of the frame/type table (64 bit) and number of entries.
+  const char magic[] = "YUVSTAT";
+  const int version = 1;
+  const int headerSize = 64;
+
+  // The record sizes in bytes
+  const int valueRecordSize = 12;        // x, y, w, h (16 bit), value (32 bit)
+  const int vectorRecordSize = 28;       // x, y, w, h (16 bit), x0, y0, x1, y1 (32 bit), isLine (32 bit)
+  const int affineTFRecordSize = 32;     // x, y, w, h (16 bit), x0, y0, x1, y1, x2, y2 (32 bit)
+  const int polygonRecordHeaderSize = 8; // Number of points, value (or 12 bytes with vector x, y) and then the points
+  const int tableEntrySize = 48;
+
+  // One entry of the frame/type table
+  struct frameTypeEntry
+  {
+    int frameIdx {-1};
+    int typeID {-1};
+    qint64 offset {0};
+    qint64 size {0};
+    quint32 nrValues {0};
+    quint32 nrVectors {0};
+    quint32 nrAffineTFs {0};
+    quint32 nrPolygonValues {0};
+    quint32 nrPolygonVectors {0};
+    quint32 maxBlockSize {0};
+    bool operator<(const frameTypeEntry &other) const { return frameIdx < other.frameIdx || (frameIdx == other.frameIdx && typeID < other.typeID); }
+  };
+
+  // Everything that is read from the file when it is opened
+  struct fileHeader
+  {
+    QSize frameSize;
+    double frameRate {0.0};
+    int maxPOC {0};
+    StatisticsTypeList types;
+    QVector<frameTypeEntry> table;
+  };
+
+  // Read the header, the type definitions and the frame/type table. Return false and set the error text if the
+  // data is not a valid binary statistics file.
+  bool readFileHeader(fileSource &file, fileHeader &header, QString &errorText);
+
+  // Find the entry for the given frame/type in the (sorted) table. Return nullptr if there is none.
+  const frameTypeEntry *findEntry(const QVector<frameTypeEntry> &table, int frameIdx, int typeID);
+
+  // Decode the records of one frame/type pair (entry.size bytes at data) into the given statistics data.
+  // Return false if the data is corrupt.
+  bool decodeFrameType(const char *data, const frameTypeEntry &entry, statisticsData &out);
+
+  // Write a binary statistics file. Call start, then writeFrameType for all frame/type pairs and finally finish.
+  // The file is only replaced if finish succeeds.
+  class writer
+  {
+  public:
+    writer(const QString &filePath) : file(filePath) {}
+    bool start(QSize frameSize, double frameRate, const StatisticsTypeList &types);
+    bool writeFrameType(int frameIdx, int typeID, const statisticsData &data);
+    bool finish(int maxPOC);
+    QString errorString() const { return file.errorString(); }
+
+  private:
+    QSaveFile file;
+    QSize frameSize;
+    double frameRate {0.0};
+    qint64 typesOffset {0};
+    qint64 typesSize {0};
+    QVector<frameTypeEntry> table;
+    QByteArray buffer;
+  };
+}
+
+#endif // STATISTICSBINARYFILE_H
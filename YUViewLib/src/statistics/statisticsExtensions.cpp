@@ -32,8 +32,11 @@
 
 #include "statisticsExtensions.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdlib>
 #include <random>
+#include <QDataStream>
 
 #include "common/typedef.h"
 #include "common/YUViewDomElement.h"
@@ -300,6 +303,48 @@ void StatisticsType::loadPlaylist(const YUViewDomElement &root)
   }
 }
 
+void StatisticsType::writeBinary(QDataStream &stream) const
+{
+  stream << qint32(typeID) << typeName << description << valMap;
+  stream << render << qint32(alphaFactor);
+
+  stream << hasValueData << renderValueData << scaleValueToBlockSize;
+  stream << qint32(colMapper.type) << qint32(colMapper.rangeMin) << qint32(colMapper.rangeMax);
+  stream << colMapper.minColor << colMapper.maxColor << colMapper.colorMap << colMapper.colorMapOther << colMapper.complexType;
+
+  stream << hasVectorData << hasAffineTFData << renderVectorData << renderVectorDataValues << scaleVectorToZoom;
+  stream << vectorPen << qint32(vectorScale) << mapVectorToColor << qint32(arrowHead);
+
+  stream << renderGrid << gridPen << scaleGridToZoom << isPolygon;
+}
+
+void StatisticsType::readBinary(QDataStream &stream)
+{
+  qint32 id, alpha;
+  stream >> id >> typeName >> description >> valMap;
+  stream >> render >> alpha;
+  typeID = id;
+  alphaFactor = alpha;
+
+  qint32 mapperType, rangeMin, rangeMax;
+  stream >> hasValueData >> renderValueData >> scaleValueToBlockSize;
+  stream >> mapperType >> rangeMin >> rangeMax;
+  stream >> colMapper.minColor >> colMapper.maxColor >> colMapper.colorMap >> colMapper.colorMapOther >> colMapper.complexType;
+  colMapper.type = colorMapper::mappingType(mapperType);
+  colMapper.rangeMin = rangeMin;
+  colMapper.rangeMax = rangeMax;
+
+  qint32 scale, head;
+  stream >> hasVectorData >> hasAffineTFData >> renderVectorData >> renderVectorDataValues >> scaleVectorToZoom;
+  stream >> vectorPen >> scale >> mapVectorToColor >> head;
+  vectorScale = scale;
+  arrowHead = arrowHead_t(head);
+
+  stream >> renderGrid >> gridPen >> scaleGridToZoom >> isPolygon;
+
+  setInitialState();
+}
+
 // If the internal valueMap can map the value to text, text and value will be returned.
 // Otherwise just the value as QString will be returned.
 QString StatisticsType::getValueTxt(int val)
@@ -312,60 +357,144 @@ QString StatisticsType::getValueTxt(int val)
   return QString("%1").arg(val);
 }
 
+// ---------- statisticsBlockList -----------
+
+// The size of the tiles of the grid (in pixels)
+#define STATISTICS_TILE_SIZE 64
+
+void statisticsBlockList::reserve(int size)
+{
+  posX.reserve(size);
+  posY.reserve(size);
+  width.reserve(size);
+  height.reserve(size);
+}
+
+void statisticsBlockList::append(unsigned short x, unsigned short y, unsigned short w, unsigned short h)
+{
+  posX.append(x);
+  posY.append(y);
+  width.append(w);
+  height.append(h);
+
+  maxWidth = std::max(maxWidth, int(w));
+  maxHeight = std::max(maxHeight, int(h));
+  maxPosX = std::max(maxPosX, int(x));
+  maxPosY = std::max(maxPosY, int(y));
+
+  // The grid is not valid anymore
+  tileStart.clear();
+  tileBlocks.clear();
+}
+
+int statisticsBlockList::getTileIdx(int i) const
+{
+  return (posY[i] / STATISTICS_TILE_SIZE) * nrTilesX + posX[i] / STATISTICS_TILE_SIZE;
+}
+
+void statisticsBlockList::buildTileGrid()
+{
+  if (hasTileGrid() || isEmpty())
+    return;
+
+  nrTilesX = maxPosX / STATISTICS_TILE_SIZE + 1;
+  nrTilesY = maxPosY / STATISTICS_TILE_SIZE + 1;
+
+  // Count the blocks per tile and get the start of each tile (counting sort)
+  tileStart.fill(0, nrTilesX * nrTilesY + 1);
+  for (int i = 0; i < count(); i++)
+    tileStart[getTileIdx(i) + 1]++;
+  for (int t = 1; t < tileStart.size(); t++)
+    tileStart[t] += tileStart[t - 1];
+
+  QVector<int> tileFill = tileStart;
+  tileBlocks.resize(count());
+  for (int i = 0; i < count(); i++)
+    tileBlocks[tileFill[getTileIdx(i)]++] = i;
+}
+
+void statisticsBlockList::getBlocksInArea(const QRect &area, QVector<int> &indices) const
+{
+  indices.clear();
+  if (isEmpty() || area.isEmpty())
+    return;
+
+  // If the area covers all blocks (e.g. the whole frame is visible), the grid does not help.
+  const bool allBlocksInArea = area.left() <= 0 && area.top() <= 0 && area.right() >= maxPosX + maxWidth && area.bottom() >= maxPosY + maxHeight;
+  if (!hasTileGrid() || allBlocksInArea)
+  {
+    for (int i = 0; i < count(); i++)
+      if (intersects(i, area))
+        indices.append(i);
+    return;
+  }
+
+  // A block intersects the area if its top left corner is in the area extended by the maximum block size
+  // to the left and top.
+  const int tileX0 = std::max(0, area.left() - maxWidth + 1) / STATISTICS_TILE_SIZE;
+  const int tileY0 = std::max(0, area.top() - maxHeight + 1) / STATISTICS_TILE_SIZE;
+  const int tileX1 = std::min(nrTilesX - 1, area.right() / STATISTICS_TILE_SIZE);
+  const int tileY1 = std::min(nrTilesY - 1, area.bottom() / STATISTICS_TILE_SIZE);
+  for (int tileY = tileY0; tileY <= tileY1; tileY++)
+    for (int tileX = tileX0; tileX <= tileX1; tileX++)
+    {
+      const int tileIdx = tileY * nrTilesX + tileX;
+      for (int b = tileStart[tileIdx]; b < tileStart[tileIdx + 1]; b++)
+        if (intersects(tileBlocks[b], area))
+          indices.append(tileBlocks[b]);
+    }
+
+  // Keep the order in which the blocks were added
+  std::sort(indices.begin(), indices.end());
+}
+
+// ---------- statisticsData -----------
+
 void statisticsData::addBlockValue(unsigned short x, unsigned short y, unsigned short w, unsigned short h, int val)
 {
-  statisticsItem_Value value;
-  value.pos[0] = x;
-  value.pos[1] = y;
-  value.size[0] = w;
-  value.size[1] = h;
-  value.value = val;
+  valueBlocks.append(x, y, w, h);
+  values.append(val);
 
   // Always keep the biggest block size updated.
   unsigned int wh = w*h;
   if (wh > maxBlockSize)
     maxBlockSize = wh;
-
-  valueData.append(value);
 }
 
 void statisticsData::addBlockVector(unsigned short x, unsigned short y, unsigned short w, unsigned short h, int vecX, int vecY)
 {
-  statisticsItem_Vector vec;
-  vec.pos[0] = x;
-  vec.pos[1] = y;
-  vec.size[0] = w;
-  vec.size[1] = h;
-  vec.point[0] = QPoint(vecX,vecY);
-  vec.isLine = false;
-  vectorData.append(vec);
+  vectorBlocks.append(x, y, w, h);
+  vectorPoints0.append(QPoint(vecX,vecY));
+  vectorPoints1.append(QPoint());
+  vectorIsLine.append(false);
+
+  maxVectorValue = std::max(maxVectorValue, std::max(std::abs(vecX), std::abs(vecY)));
 }
 
 void statisticsData::addBlockAffineTF(unsigned short x, unsigned short y, unsigned short w, unsigned short h, int vecX0, int vecY0, int vecX1, int vecY1, int vecX2, int vecY2)
 {
-  statisticsItem_AffineTF affineTF;
-  affineTF.pos[0] = x;
-  affineTF.pos[1] = y;
-  affineTF.size[0] = w;
-  affineTF.size[1] = h;
-  affineTF.point[0] = QPoint(vecX0,vecY0);
-  affineTF.point[1] = QPoint(vecX1,vecY1);
-  affineTF.point[2] = QPoint(vecX2,vecY2);
-  affineTFData.append(affineTF);
+  affineTFBlocks.append(x, y, w, h);
+  affineTFPoints.append(QPoint(vecX0,vecY0));
+  affineTFPoints.append(QPoint(vecX1,vecY1));
+  affineTFPoints.append(QPoint(vecX2,vecY2));
 }
 
 
 void statisticsData::addLine(unsigned short x, unsigned short y, unsigned short w, unsigned short h, int x1, int y1, int x2, int y2)
 {
-  statisticsItem_Vector vec;
-  vec.pos[0] = x;
-  vec.pos[1] = y;
-  vec.size[0] = w;
-  vec.size[1] = h;
-  vec.point[0] = QPoint(x1,y1);
-  vec.point[1] = QPoint(x2,y2);
-  vec.isLine = true;
-  vectorData.append(vec);
+  vectorBlocks.append(x, y, w, h);
+  vectorPoints0.append(QPoint(x1,y1));
+  vectorPoints1.append(QPoint(x2,y2));
+  vectorIsLine.append(true);
+
+  maxLinePointValue = std::max(maxLinePointValue, std::max(std::max(std::abs(x1), std::abs(y1)), std::max(std::abs(x2), std::abs(y2))));
+}
+
+void statisticsData::buildTileGrids()
+{
+  valueBlocks.buildTileGrid();
+  vectorBlocks.buildTileGrid();
+  affineTFBlocks.buildTileGrid();
 }
 
 void statisticsData::addPolygonValue(const QVector<QPoint> &points, int val)
@@ -36,7 +36,10 @@
 #include <QColor>
 #include <QMap>
 #include <QPen>
+#include <QRect>
+#include <QVector>
 
+class QDataStream;
 class YUViewDomElement;
 
 /* This class knows how to map values to color.
@@ -105,6 +108,11 @@ public:
   void savePlaylist(YUViewDomElement &root) const;
   void loadPlaylist(const YUViewDomElement &root);
 
+  // Write/read the complete definition of the type to/from a binary statistics file (see statisticsBinaryFile.h).
+  // After reading, the initial state is set.
+  void writeBinary(QDataStream &stream) const;
+  void readBinary(QDataStream &stream);
+
   // Every statistics type has an ID, a name and possibly a description
   int typeID;
   QString typeName;
@@ -180,36 +188,40 @@ private:
   initialState init;
 };
 
-struct statisticsItem_Value
-{
-  // The position and size of the item. (max 65535)
-  unsigned short pos[2];
-  unsigned short size[2];
-
-  // The actual value
-  int value;
-};
-
-struct statisticsItem_Vector
+// The position and size (max 65535) of a list of blocks stored as a struct of arrays. A grid of tiles can be built over
+// the blocks so that only the blocks that intersect a certain area (e.g. the visible part of the frame) are visited.
+class statisticsBlockList
 {
-  // The position and size of the item. (max 65535)
-  unsigned short pos[2];
-  unsigned short size[2];
+public:
+  int count() const { return posX.size(); }
+  bool isEmpty() const { return posX.isEmpty(); }
+  void reserve(int size);
+  void append(unsigned short x, unsigned short y, unsigned short w, unsigned short h);
+  QRect getRect(int i) const { return QRect(posX[i], posY[i], width[i], height[i]); }
 
-  bool isLine; // the vector is specified by two points
-  // The actual vector value
-  QPoint point[2];
-};
+  // Sort all blocks into the tile grid. Call this after all blocks were added. Appending a block removes the grid.
+  void buildTileGrid();
+  // Get the indices of all blocks that intersect the given area (in ascending order). Without a tile grid, all blocks
+  // are tested.
+  void getBlocksInArea(const QRect &area, QVector<int> &indices) const;
 
-struct statisticsItem_AffineTF
-{
-  // The position and size of the item. (max 65535)
-  unsigned short pos[2];
-  unsigned short size[2];
+  QVector<unsigned short> posX, posY, width, height;
 
-  // the vector is specified by two points
-  // The actual vector value
-  QPoint point[3];
+private:
+  bool intersects(int i, const QRect &area) const { return posX[i] <= area.right() && posX[i] + width[i] > area.left() && posY[i] <= area.bottom() && posY[i] + height[i] > area.top(); }
+  bool hasTileGrid() const { return !tileStart.isEmpty(); }
+  int getTileIdx(int i) const;
+
+  int maxWidth {0};
+  int maxHeight {0};
+  int maxPosX {0};
+  int maxPosY {0};
+
+  // The tile grid. The blocks are sorted by the tile that contains their top left corner.
+  int nrTilesX {0};
+  int nrTilesY {0};
+  QVector<int> tileStart;   // For every tile, the index of its first block in tileBlocks (plus the end of the last tile)
+  QVector<int> tileBlocks;  // The block indices sorted by tile
 };
 
 struct statisticsItemPolygon_Value
@@ -232,6 +244,7 @@ struct statisticsItemPolygon_Vector
 
 
 // A collection of statistics data (value and vector) for a certain context (for example for a certain type and a certain POC).
+// The blocks are kept in contiguous arrays (struct of arrays) so that they can be visited quickly.
 class statisticsData
 {
 public:
@@ -243,14 +256,36 @@ public:
   void addPolygonVector(const QVector<QPoint> &points, int vecX, int vecY);
   void addPolygonValue(const QVector<QPoint> &points, int val);
 
-  QList<statisticsItem_Value> valueData;
-  QList<statisticsItem_Vector> vectorData;
-  QList<statisticsItem_AffineTF> affineTFData;
+  bool isEmpty() const { return valueBlocks.isEmpty() && vectorBlocks.isEmpty() && affineTFBlocks.isEmpty() && polygonValueData.isEmpty() && polygonVectorData.isEmpty(); }
+
+  // Build the tile grids of all block lists. This is done when loading of the data is complete.
+  void buildTileGrids();
+
+  // Value blocks. Every block has one value.
+  statisticsBlockList valueBlocks;
+  QVector<int> values;
+
+  // Vector blocks. A vector starts in the center of the block and vectorPoints0 is the vector (in units of the vector
+  // scale of the type). A line goes from vectorPoints0 to vectorPoints1 (in pixels relative to the top left of the block).
+  statisticsBlockList vectorBlocks;
+  QVector<QPoint> vectorPoints0;
+  QVector<QPoint> vectorPoints1;
+  QVector<bool> vectorIsLine;
+
+  // Affine transform blocks. There are 3 vectors per block (for the top left, top right and bottom left corner).
+  statisticsBlockList affineTFBlocks;
+  QVector<QPoint> affineTFPoints;
+
   QList<statisticsItemPolygon_Value> polygonValueData;
   QList<statisticsItemPolygon_Vector> polygonVectorData;
 
   // What is the size (area) of the biggest block)? This is needed for scaling the blocks according to their size.
   unsigned int maxBlockSize;
+
+  // The biggest absolute x or y value of all vectors and of all line points. A vector or a line can be visible
+  // even if its block is not. When searching for visible vectors, the area has to be extended by this.
+  int maxVectorValue {0};
+  int maxLinePointValue {0};
 };
 
 #endif // STATISTICSEXTENSIONS_H
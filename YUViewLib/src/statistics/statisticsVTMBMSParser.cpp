@@ -0,0 +1,314 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "statisticsVTMBMSParser.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+namespace statisticsVTMBMSParser
+{
+
+namespace
+{
+  // The maximum number of values in braces (an affine transform has 6)
+  const int maxBraceValues = 6;
+  // The number of corners that a polygon can have
+  const int minPolygonCorners = 3;
+  const int maxPolygonCorners = 5;
+
+  const char blockStatPrefix[] = "BlockStat: POC ";
+
+  // The parts of one block statistics line after the POC
+  struct statisticLine
+  {
+    bool isPolygon {false};
+    int x {0};
+    int y {0};
+    int width {0};
+    int height {0};
+    QVector<QPoint> corners;
+    const char *name {nullptr};
+    int nameLength {0};
+    bool isBraced {false};
+    int nrValues {0};
+    int values[maxBraceValues];
+  };
+
+  inline void skipSpaces(const char *&p, const char *end)
+  {
+    while (p < end && *p == ' ')
+      p++;
+  }
+
+  // Skip spaces and then consume the given character
+  inline bool expectChar(const char *&p, const char *end, char c)
+  {
+    skipSpaces(p, end);
+    if (p == end || *p != c)
+      return false;
+    p++;
+    return true;
+  }
+
+  inline bool isDigit(char c) { return c >= '0' && c <= '9'; }
+  inline bool isNameChar(char c) { return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_'; }
+
+  // Skip spaces and parse an integer. Only values and vectors can be negative.
+  inline bool parseNumber(const char *&p, const char *end, int &value, bool allowNegative)
+  {
+    skipSpaces(p, end);
+    bool negative = false;
+    if (allowNegative && p < end && *p == '-')
+    {
+      negative = true;
+      p++;
+    }
+    if (p == end || !isDigit(*p))
+      return false;
+    int64_t v = 0;
+    while (p < end && isDigit(*p))
+    {
+      v = v * 10 + (*p - '0');
+      if (v > INT_MAX)
+        return false;
+      p++;
+    }
+    value = int(negative ? -v : v);
+    return true;
+  }
+
+  // Parse a position "(x, y)"
+  inline bool parsePoint(const char *&p, const char *end, int &x, int &y)
+  {
+    return expectChar(p, end, '(') && parseNumber(p, end, x, false) && expectChar(p, end, ',') && parseNumber(p, end, y, false) && expectChar(p, end, ')');
+  }
+
+  // Parse "BlockStat: POC <poc>" at p and move p behind it
+  int parsePOCAt(const char *&p, const char *end)
+  {
+    const int prefixLength = int(sizeof(blockStatPrefix)) - 1;
+    if (end - p < prefixLength || std::memcmp(p, blockStatPrefix, prefixLength) != 0)
+      return -1;
+    p += prefixLength;
+    int poc;
+    if (!parseNumber(p, end, poc, false))
+      return -1;
+    return poc;
+  }
+
+  // Parse the rest of the line after the POC: The block ("@(x, y) [wxh]") or polygon ("@[(x, y)--(x, y)--...]"),
+  // the name of the type and the value ("=v") or values ("={v0, v1, ...}").
+  bool parseStatisticLine(const char *&p, const char *end, statisticLine &line)
+  {
+    if (!expectChar(p, end, '@'))
+      return false;
+    skipSpaces(p, end);
+    if (p == end)
+      return false;
+
+    if (*p == '(')
+    {
+      line.isPolygon = false;
+      if (!parsePoint(p, end, line.x, line.y) || !expectChar(p, end, '['))
+        return false;
+      if (!parseNumber(p, end, line.width, false) || !expectChar(p, end, 'x') || !parseNumber(p, end, line.height, false) || !expectChar(p, end, ']'))
+        return false;
+    }
+    else if (*p == '[')
+    {
+      line.isPolygon = true;
+      line.corners.resize(0);
+      p++;
+      while (!expectChar(p, end, ']'))
+      {
+        int x, y;
+        if (line.corners.size() == maxPolygonCorners || !parsePoint(p, end, x, y) || !expectChar(p, end, '-') || !expectChar(p, end, '-'))
+          return false;
+        line.corners.append(QPoint(x, y));
+      }
+      if (line.corners.size() < minPolygonCorners)
+        return false;
+    }
+    else
+      return false;
+
+    skipSpaces(p, end);
+    line.name = p;
+    while (p < end && isNameChar(*p))
+      p++;
+    line.nameLength = int(p - line.name);
+    if (line.nameLength == 0 || p == end || *p != '=')
+      return false;
+    p++;
+
+    skipSpaces(p, end);
+    line.isBraced = (p < end && *p == '{');
+    if (!line.isBraced)
+    {
+      line.nrValues = 1;
+      return parseNumber(p, end, line.values[0], true);
+    }
+
+    p++;
+    line.nrValues = 0;
+    while (true)
+    {
+      if (line.nrValues == maxBraceValues || !parseNumber(p, end, line.values[line.nrValues], true))
+        return false;
+      line.nrValues++;
+      skipSpaces(p, end);
+      if (p == end)
+        return false;
+      if (*p == '}')
+        return true;
+      if (*p != ',')
+        return false;
+      p++;
+    }
+  }
+
+  // Add the parsed line to the data according to the type. Return false if the line does not fit the type.
+  bool addStatisticLine(const statisticLine &line, const typeParser &type, QSize frameSize, statisticsData &out, bool &blockOutsideOfFrame)
+  {
+    if (line.isPolygon != type.isPolygon)
+      return false;
+
+    if (!line.isPolygon)
+    {
+      if (type.hasValueData)
+      {
+        if (line.isBraced)
+          return false;
+        out.addBlockValue(line.x, line.y, line.width, line.height, line.values[0]);
+      }
+      else if (type.hasVectorData)
+      {
+        if (line.isBraced && line.nrValues == 2)
+          out.addBlockVector(line.x, line.y, line.width, line.height, line.values[0], line.values[1]);
+        else if (line.isBraced && line.nrValues == 4)
+          out.addLine(line.x, line.y, line.width, line.height, line.values[0], line.values[1], line.values[2], line.values[3]);
+        else
+          return false;
+      }
+      else if (type.hasAffineTFData)
+      {
+        if (!line.isBraced || line.nrValues != 6)
+          return false;
+        out.addBlockAffineTF(line.x, line.y, line.width, line.height, line.values[0], line.values[1], line.values[2], line.values[3], line.values[4], line.values[5]);
+      }
+      else
+        return false;
+
+      if (line.x + line.width > frameSize.width() || line.y + line.height > frameSize.height())
+        blockOutsideOfFrame = true;
+      return true;
+    }
+
+    if (type.hasValueData)
+    {
+      if (line.isBraced)
+        return false;
+      out.addPolygonValue(line.corners, line.values[0]);
+    }
+    else if (type.hasVectorData)
+    {
+      if (!line.isBraced || line.nrValues != 2)
+        return false;
+      out.addPolygonVector(line.corners, line.values[0], line.values[1]);
+    }
+    else
+      return false;
+
+    for (const QPoint &corner : line.corners)
+      if (corner.x() > frameSize.width() || corner.y() > frameSize.height())
+        blockOutsideOfFrame = true;
+    return true;
+  }
+}
+
+int parsePOC(const char *line, const char *lineEnd)
+{
+  return parsePOCAt(line, lineEnd);
+}
+
+typeParser::typeParser(const StatisticsType &type)
+{
+  typeName = type.typeName.toUtf8();
+  typeToken = " " + typeName + "=";
+  isPolygon = type.isPolygon;
+  hasValueData = type.hasValueData;
+  hasVectorData = type.hasVectorData;
+  hasAffineTFData = type.hasAffineTFData;
+}
+
+parseResult parseFrameType(const char *data, int64_t size, bool atEnd, int poc, const typeParser &type, QSize frameSize, statisticsData &out)
+{
+  parseResult result;
+  statisticLine line;
+  const char *end = data + size;
+  const char *lineStart = data;
+  while (lineStart < end)
+  {
+    const char *newline = static_cast<const char*>(std::memchr(lineStart, '\n', size_t(end - lineStart)));
+    if (newline == nullptr && !atEnd)
+      // The line may continue in the data that follows
+      break;
+    const char *lineEnd = (newline == nullptr) ? end : newline;
+
+    const char *p = lineStart;
+    const int linePOC = parsePOCAt(p, lineEnd);
+    if (linePOC >= 0)
+    {
+      if (linePOC != poc)
+      {
+        result.frameEnd = true;
+        break;
+      }
+
+      const bool parsed = parseStatisticLine(p, lineEnd, line);
+      const bool isType = parsed ? (line.nameLength == type.typeName.size() && std::memcmp(line.name, type.typeName.constData(), size_t(line.nameLength)) == 0) :
+                                   (std::search(lineStart, lineEnd, type.typeToken.constBegin(), type.typeToken.constEnd()) != lineEnd);
+      if (isType && (!parsed || !addStatisticLine(line, type, frameSize, out, result.blockOutsideOfFrame)))
+        result.errorLine = QByteArray(lineStart, int(lineEnd - lineStart));
+    }
+
+    lineStart = (newline == nullptr) ? end : newline + 1;
+  }
+
+  result.bytesParsed = lineStart - data;
+  return result;
+}
+
+}
@@ -0,0 +1,91 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef STATISTICSVTMBMSPARSER_H
+#define STATISTICSVTMBMSPARSER_H
+
+#include <cstdint>
+#include <QByteArray>
+#include <QSize>
+
+#include "statistics/statisticsExtensions.h"
+
+/* A tokenizer for the block statistics lines of VTMBMS statistics files. The lines are parsed directly from the bytes
+ * of the file (e.g. a view into the memory mapped file). No QString is created per line. The lines look like this:
+ *
+ * BlockStat: POC 1 @( 112,  88) [ 8x 8] PredMode=0
+ * BlockStat: POC 1 @( 120,  80) [ 8x 8] MVL0={ -24,  -2}
+ * BlockStat: POC 2 @( 192,  96) [64x32] Line={0,0,31,31}
+ * BlockStat: POC 2 @( 192,  96) [64x32] AffineMVL0={-324,-116,-276,-116,-324, -92}
+ * BlockStat: POC 2 @[(505, 384)--(511, 384)--(511, 415)--] GeoPUInterIntraFlag=0
+ *
+ * Polygons must have 3 to 5 corners. The header lines (starting with #) are not handled here.
+ */
+namespace statisticsVTMBMSParser
+{
+  // Get the POC of a block statistics line (from line to lineEnd, without the newline).
+  // Return -1 if the line is no block statistics line.
+  int parsePOC(const char *line, const char *lineEnd);
+
+  // Everything that is needed to parse the lines of one statistics type. Create this once per frame and type.
+  struct typeParser
+  {
+    typeParser(const StatisticsType &type);
+    QByteArray typeName;
+    QByteArray typeToken;   // " <typeName>=" to find lines of the type that could not be parsed
+    bool isPolygon;
+    bool hasValueData;
+    bool hasVectorData;
+    bool hasAffineTFData;
+  };
+
+  struct parseResult
+  {
+    // The number of bytes of the lines that were parsed. If the data did not end with a complete line,
+    // parsing can continue from here once more data is available.
+    int64_t bytesParsed {0};
+    // A line of another POC was found. All lines of the frame were parsed.
+    bool frameEnd {false};
+    // A block (or polygon corner) that was outside of the frame was found
+    bool blockOutsideOfFrame {false};
+    // The last line of the type that could not be parsed (if any)
+    QByteArray errorLine;
+  };
+
+  // Parse the block statistics lines of the given POC and type in the data and add them to out. The data must start
+  // at the beginning of a line. Lines of other types are skipped. Parsing stops at the first block statistics line
+  // of another POC. If atEnd is false, a last line without a newline is not parsed because it may not be complete.
+  parseResult parseFrameType(const char *data, int64_t size, bool atEnd, int poc, const typeParser &type, QSize frameSize, statisticsData &out);
+}
+
+#endif // STATISTICSVTMBMSPARSER_H
@@ -124,7 +124,7 @@ void BitstreamAnalysisWidget::updateParsingStatusText(int progressValue)
     this->ui.parsingStatusText->setText(QString("Parsing file (%1%)").arg(progressValue));
   else
   {
-    const bool parsingLimitSet = !this->ui.parseEntireFileCheckBox->isChecked();
+    const bool parsingLimitSet = this->parser ? this->parser->isParsingLimitEnabled() : !this->ui.parseEntireFileCheckBox->isChecked();
     this->ui.parsingStatusText->setText(parsingLimitSet ? "Partial parsing done. Enable full parsing if needed." : "Parsing done.");
   }
 }
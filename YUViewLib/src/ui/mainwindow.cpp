@@ -105,6 +105,7 @@ MainWindow::MainWindow(bool useAlternativeSources, QWidget *parent) : QMainWindo
   connect(ui.playlistTreeWidget, &PlaylistTreeWidget::itemAboutToBeDeleted, ui.propertiesWidget, &PropertiesWidget::itemAboutToBeDeleted);
   connect(ui.playlistTreeWidget, &PlaylistTreeWidget::openFileDialog, this, &MainWindow::showFileOpenDialog);
   connect(ui.playlistTreeWidget, &PlaylistTreeWidget::selectedItemDoubleBufferLoad, ui.playbackController, &PlaybackController::currentSelectedItemsDoubleBufferLoad);
+  connect(ui.playlistTreeWidget, &PlaylistTreeWidget::selectedItemJumpToFrame, ui.playbackController, [this](int frameIdx) { ui.playbackController->setCurrentFrame(frameIdx); });
 
   ui.displaySplitView->setAttribute(Qt::WA_AcceptTouchEvents);
 
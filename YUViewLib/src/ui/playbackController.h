@@ -64,6 +64,8 @@ public:
   // What is the sate of the playback?
   bool playing() const { return playbackMode != PlaybackStopped; }
   bool isWaitingForCaching() const { return playbackMode == PlaybackWaitingForCache; }
+  // Is the current item repeated (playback will not continue with the next item)?
+  bool isRepeatingCurrentItem() const { return repeatMode == RepeatModeOne; }
 
   // Get the currently shown frame index
   int getCurrentFrame() const { return currentFrameIdx; }
@@ -353,6 +353,7 @@ void PlaylistTreeWidget::appendNewItem(playlistItem *item, bool emitplaylistChan
   insertTopLevelItem(topLevelItemCount(), item);
   connect(item, &playlistItem::signalItemChanged, this, &PlaylistTreeWidget::slotItemChanged);
   connect(item, &playlistItem::signalItemDoubleBufferLoaded, this, &PlaylistTreeWidget::slotItemDoubleBufferLoaded);
+  connect(item, &playlistItem::signalItemJumpToFrame, this, &PlaylistTreeWidget::slotItemJumpToFrame);
   setItemWidget(item, 1, new bufferStatusWidget(item, this));
   header()->resizeSection(1, 50);
 
@@ -448,6 +449,14 @@ void PlaylistTreeWidget::slotItemDoubleBufferLoaded()
     emit selectedItemDoubleBufferLoad(1);
 }
 
+void PlaylistTreeWidget::slotItemJumpToFrame(int frameIdx)
+{
+  auto items = getSelectedItems();
+  QObject *sender = QObject::sender();
+  if (sender == items[0] || sender == items[1])
+    emit selectedItemJumpToFrame(frameIdx);
+}
+
 void PlaylistTreeWidget::mousePressEvent(QMouseEvent *event)
 {
   QModelIndex item = indexAt(event->pos());
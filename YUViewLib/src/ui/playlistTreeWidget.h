@@ -142,6 +142,9 @@ signals:
   // The selected item finished loading the double buffer.
   void selectedItemDoubleBufferLoad(int itemID);
 
+  // The selected item requests to jump to the given frame
+  void selectedItemJumpToFrame(int frameIdx);
+
 protected:
   // Overload from QWidget to create a custom context menu
   virtual void contextMenuEvent(QContextMenuEvent *event) Q_DECL_OVERRIDE;
@@ -173,6 +176,10 @@ protected slots:
   // forward this to the playbackController which might me waiting for this.
   void slotItemDoubleBufferLoaded();
 
+  // All item's signals signalItemJumpToFrame are connected here. The request is only forwarded if the sending item
+  // is currently selected.
+  void slotItemJumpToFrame(int frameIdx);
+
 private:
 
   playlistItem* getDropTarget(const QPoint &pos) const;
@@ -32,7 +32,11 @@
 
 #include "frameHandler.h"
 
+#include <algorithm>
+#include <cmath>
+#include <numeric>
 #include <QPainter>
+#include <QtConcurrent>
 
 #include "common/functions.h"
 #include "playlistitem/playlistItem.h"
@@ -193,7 +197,7 @@ void frameHandler::drawFrame(QPainter *painter, double zoomFactor, bool drawRawV
   videoRect.moveCenter(QPoint(0,0));
 
   // Draw the current image (currentFrame)
-  painter->drawImage(videoRect, currentImage);
+  drawImage(painter, videoRect, currentImage);
 
   if (drawRawValues && zoomFactor >= SPLITVIEW_DRAW_VALUES_ZOOMFACTOR)
   {
@@ -202,6 +206,103 @@ void frameHandler::drawFrame(QPainter *painter, double zoomFactor, bool drawRawV
   }
 }
 
+// The maximum level of the image pyramid (1/256 of the original size)
+#define FRAMEHANDLER_MAX_PYRAMID_LEVEL 8
+
+namespace
+{
+  // Downsample the image by 2 in both directions. Each output pixel is the average of 2x2 input pixels.
+  // The rows are processed in parallel.
+  QImage downsampleImage(const QImage &image)
+  {
+    const QImage::Format format = image.format();
+    const bool isRGB32 = (format == QImage::Format_RGB32 || format == QImage::Format_ARGB32 || format == QImage::Format_ARGB32_Premultiplied);
+    const QImage src = isRGB32 ? image : image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+    const int width = std::max(1, src.width() / 2);
+    const int height = std::max(1, src.height() / 2);
+    QImage dst(width, height, src.format());
+
+    QVector<int> rows(height);
+    std::iota(rows.begin(), rows.end(), 0);
+    QtConcurrent::blockingMap(rows, [&src, &dst, width](int y)
+    {
+      const QRgb *line0 = reinterpret_cast<const QRgb*>(src.constScanLine(std::min(2 * y, src.height() - 1)));
+      const QRgb *line1 = reinterpret_cast<const QRgb*>(src.constScanLine(std::min(2 * y + 1, src.height() - 1)));
+      QRgb *out = reinterpret_cast<QRgb*>(dst.scanLine(y));
+      const int lastX = src.width() - 1;
+      for (int x = 0; x < width; x++)
+      {
+        const int x0 = std::min(2 * x, lastX);
+        const int x1 = std::min(2 * x + 1, lastX);
+        const quint32 p[4] = {line0[x0], line0[x1], line1[x0], line1[x1]};
+        // Add two 8 bit channels at a time (with rounding)
+        quint32 rb = 0x00020002, ag = 0x00020002;
+        for (int i = 0; i < 4; i++)
+        {
+          rb += p[i] & 0x00FF00FF;
+          ag += (p[i] >> 8) & 0x00FF00FF;
+        }
+        out[x] = ((rb >> 2) & 0x00FF00FF) | (((ag >> 2) & 0x00FF00FF) << 8);
+      }
+    });
+    return dst;
+  }
+}
+
+const QImage &frameHandler::getPyramidLevel(const QImage &image, int level)
+{
+  while (pyramidLevels.size() < level)
+    pyramidLevels.append(downsampleImage(pyramidLevels.isEmpty() ? image : pyramidLevels.last()));
+  return pyramidLevels[level - 1];
+}
+
+void frameHandler::drawImage(QPainter *painter, const QRect &videoRect, const QImage &image)
+{
+  if (image.isNull() || videoRect.isEmpty())
+  {
+    painter->drawImage(videoRect, image);
+    return;
+  }
+
+  // A new image. The levels of the old image are not needed anymore. The pyramid is only used if the image is
+  // drawn again.
+  const bool newImage = (image.cacheKey() != pyramidImageKey);
+  if (newImage)
+  {
+    pyramidLevels.clear();
+    pyramidImageKey = image.cacheKey();
+  }
+
+  // Select the smallest pyramid level that still has at least the size that the image is drawn with
+  const double scale = std::max(double(videoRect.width()) / image.width(), double(videoRect.height()) / image.height());
+  int level = 0;
+  while (!newImage && level < FRAMEHANDLER_MAX_PYRAMID_LEVEL && scale * (2 << level) <= 1.0 && (image.width() >> (level + 1)) > 0 && (image.height() >> (level + 1)) > 0)
+    level++;
+  const QImage &levelImage = (level == 0) ? image : getPyramidLevel(image, level);
+
+  // Get the part of the video rect that is visible
+  QRectF visibleRect = painter->worldTransform().inverted().mapRect(QRectF(painter->viewport()));
+  if (painter->hasClipping())
+    visibleRect &= painter->clipBoundingRect();
+  visibleRect &= QRectF(videoRect);
+  if (visibleRect.isEmpty())
+    return;
+
+  // The visible pixels of the image. Only whole pixels are drawn so that the pixel grid is the same as when
+  // drawing the whole image.
+  const double sx = double(videoRect.width()) / levelImage.width();
+  const double sy = double(videoRect.height()) / levelImage.height();
+  const int x0 = clip(int(std::floor((visibleRect.left() - videoRect.left()) / sx)), 0, levelImage.width() - 1);
+  const int y0 = clip(int(std::floor((visibleRect.top() - videoRect.top()) / sy)), 0, levelImage.height() - 1);
+  const int x1 = clip(int(std::ceil((visibleRect.right() - videoRect.left()) / sx)), x0 + 1, levelImage.width());
+  const int y1 = clip(int(std::ceil((visibleRect.bottom() - videoRect.top()) / sy)), y0 + 1, levelImage.height());
+
+  const QRect sourceRect(x0, y0, x1 - x0, y1 - y0);
+  const QRectF targetRect(videoRect.left() + x0 * sx, videoRect.top() + y0 * sy, (x1 - x0) * sx, (y1 - y0) * sy);
+  painter->drawImage(targetRect, levelImage, sourceRect);
+}
+
 void frameHandler::drawPixelValues(QPainter *painter, const int frameIdx, const QRect &videoRect, const double zoomFactor, frameHandler *item2, const bool markDifference, const int frameIdxItem1)
 {
   // Draw the pixel values onto the pixels
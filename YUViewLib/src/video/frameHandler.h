@@ -120,6 +120,11 @@ protected:
   // When slotVideoControlChanged is called, update the controls and return the new selected size
   QSize getNewSizeFromControls();
 
+  // Draw the image into videoRect. Only the part of the image that is visible in the painter (viewport and clipping)
+  // is drawn. If the same image is drawn again at half of its size or smaller (the view is moved or zoomed while the
+  // frame does not change), a downsampled level of the image pyramid is drawn instead of the full resolution image.
+  void drawImage(QPainter *painter, const QRect &videoRect, const QImage &image);
+
   QSettings settings;
 
 private:
@@ -132,6 +137,14 @@ private:
  
   SafeUi<Ui::frameHandler> ui;
 
+  // The pyramid of the last drawn image (identified by its cache key). pyramidLevels[0] is level 1 (half the size).
+  // The levels are created when they are needed. During playback every image is drawn only once and building the
+  // levels would cost more than letting Qt scale the image (nearest neighbor), so no levels are built for the first
+  // draw of an image.
+  const QImage &getPyramidLevel(const QImage &image, int level);
+  qint64 pyramidImageKey {0};
+  QList<QImage> pyramidLevels;
+
 protected slots:
 
   // All the valueChanged() signals from the controls are connected here.
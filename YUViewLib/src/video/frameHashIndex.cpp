@@ -0,0 +1,129 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "frameHashIndex.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStringList>
+#include <QTextStream>
+
+// The first line of a sidecar file. The second line is the key.
+#define FRAMEHASHINDEX_HEADER "YUView frame hashes 1"
+
+QString frameHashIndex::getKey(const QString &filePath, const QString &source, const QVector<int64_t> &planeSizes)
+{
+  const QFileInfo fileInfo(filePath);
+  QStringList planes;
+  for (int64_t size : planeSizes)
+    planes.append(QString::number(size));
+  return QString("size %1 modified %2 source %3 planes %4").arg(fileInfo.size()).arg(fileInfo.lastModified().toMSecsSinceEpoch()).arg(source).arg(planes.join(","));
+}
+
+frameHashIndex::planeHashes frameHashIndex::hashFrame(const QByteArray &rawData, const QVector<int64_t> &planeSizes)
+{
+  planeHashes frameHashes;
+  int64_t offset = 0;
+  for (int64_t size : planeSizes)
+  {
+    if (offset + size > rawData.size())
+      // The frame is incomplete
+      return planeHashes();
+    frameHashes.append(QCryptographicHash::hash(QByteArray::fromRawData(rawData.constData() + offset, int(size)), QCryptographicHash::Md5));
+    offset += size;
+  }
+  return frameHashes;
+}
+
+bool frameHashIndex::loadSidecar()
+{
+  QFile file(sidecarFile);
+  if (sidecarFile.isEmpty() || !file.open(QIODevice::ReadOnly | QIODevice::Text))
+    return false;
+
+  QTextStream in(&file);
+  if (in.readLine() != FRAMEHASHINDEX_HEADER || in.readLine() != key)
+    return false;
+
+  QMap<int, planeHashes> newHashes;
+  while (!in.atEnd())
+  {
+    const QStringList values = in.readLine().split(' ', QString::SkipEmptyParts);
+    if (values.isEmpty())
+      continue;
+    bool ok;
+    const int frameIdx = values[0].toInt(&ok);
+    if (!ok || values.count() < 2)
+      return false;
+    planeHashes frameHashes;
+    for (int i = 1; i < values.count(); i++)
+      frameHashes.append(QByteArray::fromHex(values[i].toLatin1()));
+    newHashes[frameIdx] = frameHashes;
+  }
+
+  // Hashes that were calculated before loading are kept
+  for (auto it = hashes.constBegin(); it != hashes.constEnd(); it++)
+    newHashes[it.key()] = it.value();
+  hashes = newHashes;
+  return true;
+}
+
+bool frameHashIndex::saveSidecar()
+{
+  if (!changed || sidecarFile.isEmpty())
+    return true;
+
+  // Write to a temporary file first so that an interrupted write does not leave a broken sidecar
+  QSaveFile file(sidecarFile);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    return false;
+
+  QTextStream out(&file);
+  out << FRAMEHASHINDEX_HEADER << "\n" << key << "\n";
+  for (auto it = hashes.constBegin(); it != hashes.constEnd(); it++)
+  {
+    out << it.key();
+    for (const QByteArray &hash : it.value())
+      out << " " << hash.toHex();
+    out << "\n";
+  }
+  out.flush();
+  if (!file.commit())
+    return false;
+
+  changed = false;
+  return true;
+}
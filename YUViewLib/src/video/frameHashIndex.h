@@ -0,0 +1,84 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef FRAMEHASHINDEX_H
+#define FRAMEHASHINDEX_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QVector>
+
+// The MD5 hashes of all planes of the raw frames of a video (the data as it is read from the file or the decoder).
+// Comparing the hashes of two videos is a fast way to find the first frame where they differ. The index can be saved
+// to a sidecar file next to the video file so that the hashes of a file only have to be calculated once. The sidecar
+// is a text file with one line per frame ("frameIdx hashPlane0 hashPlane1 ..."), so two of them can also be compared
+// with any diff tool.
+class frameHashIndex
+{
+public:
+  // The hashes of the planes of one frame
+  typedef QVector<QByteArray> planeHashes;
+
+  frameHashIndex() {}
+  // Create an index that is loaded from / saved to the given sidecar file. The key identifies the version of the
+  // video file and the raw format the hashes were calculated for (see getKey). A sidecar with a different key is ignored.
+  frameHashIndex(const QString &sidecarFile, const QString &key) : sidecarFile(sidecarFile), key(key) {}
+
+  // Get the key for the given video file, the source of the raw data (e.g. the pixel format that the file is read
+  // with) and the raw plane sizes. If this changes, the hashes have to be recalculated.
+  static QString getKey(const QString &filePath, const QString &source, const QVector<int64_t> &planeSizes);
+  // Get the sidecar file name for the given video file
+  static QString getSidecarFile(const QString &filePath) { return filePath + ".yuvhash"; }
+
+  // Calculate the hashes of the planes of one raw frame. The planes are stored one after the other in rawData.
+  static planeHashes hashFrame(const QByteArray &rawData, const QVector<int64_t> &planeSizes);
+
+  bool contains(int frameIdx) const { return hashes.contains(frameIdx); }
+  planeHashes getHashes(int frameIdx) const { return hashes.value(frameIdx); }
+  void setHashes(int frameIdx, const planeHashes &frameHashes) { hashes[frameIdx] = frameHashes; changed = true; }
+
+  // Load the hashes from the sidecar file. Returns false if there is no sidecar (or it is not valid for the key).
+  bool loadSidecar();
+  // Save the hashes to the sidecar file if new hashes were added. An error is not critical (the directory of the
+  // video file may not be writable). The hashes are then just calculated again the next time.
+  bool saveSidecar();
+
+private:
+  QString sidecarFile;
+  QString key;
+  QMap<int, planeHashes> hashes;
+  bool changed {false};
+};
+
+#endif // FRAMEHASHINDEX_H
@@ -33,6 +33,7 @@
 #include "videoCache.h"
 
 #include <algorithm>
+#include <QHash>
 #include <QMessageBox>
 #include <QPainter>
 #include <QScrollArea>
@@ -78,6 +79,10 @@ public:
   loadingWorker(QObject *parent) : QObject(parent) { currentCacheItem = nullptr; working = false; id = id_counter++; }
   playlistItem *getCacheItem() { return currentCacheItem; }
   int getCacheFrame() { return currentFrame; }
+  // The item of the last finished caching job, how long the job took (in ms) and how many frames it produced
+  playlistItem *getLastCacheItem() { return lastCacheItem; }
+  double getLastCacheDuration() { return lastCacheDuration; }
+  int getLastCacheNrFrames() { return lastCacheNrFrames; }
   void setJob(playlistItem *item, int frame, bool test=false);
   void setWorking(bool state) { working = state; }
   bool isWorking() { return working; }
@@ -94,6 +99,9 @@ private slots:
 private:
   playlistItem *currentCacheItem;
   int currentFrame;
+  playlistItem *lastCacheItem {nullptr};
+  double lastCacheDuration {0};
+  int lastCacheNrFrames {0};
   bool working;
   bool testMode;
   int id;   // A static ID of the thread. Only used in getStatus().
@@ -131,7 +139,12 @@ void loadingWorker::processCacheJobInternal()
 
   // Just cache the frame that was given to us.
   // This is performed in the thread that this worker is currently placed in.
-  currentCacheItem->cacheFrame(currentFrame, testMode);
+  // Measure how long this takes. This is the cost of recreating the frame if it is removed from the cache.
+  QElapsedTimer timer;
+  timer.start();
+  lastCacheNrFrames = currentCacheItem->cacheFrame(currentFrame, testMode);
+  lastCacheDuration = timer.nsecsElapsed() / 1000000.0;
+  lastCacheItem = currentCacheItem;
   
   currentCacheItem = nullptr;
   DEBUG_JOBS("loadingWorker::processCacheJobInternal emit loadingFinished");
@@ -497,6 +510,9 @@ void videoCache::updateCacheQueue()
   // Playback is running:
   // 1: The item after this item has the highest priority (it will be played next)
   // 2: The item after 2 is next and so on (wrap around in the playlist) until the previous item is reached.
+  //
+  // The frames that may be removed are finally sorted by sortCacheDeQueue(). Frames that are shown again soon
+  // and frames that take long to recreate (e.g. decoded frames) are removed last.
 
   // Let's start with the currently selected item (if no item is selected, the first item in the playlist is considered as being selected)
   auto selection = playlist->getSelectedItems();
@@ -656,92 +672,27 @@ void videoCache::updateCacheQueue()
       // There is currently not enough space in the cache to cache all remaining frames but in general the cache can hold all frames.
       // Delete frames from the cache until it fits.
 
-      // We go through all other items and get the frames that we will delete.
-      // We start with the item before the one before the currently selected one and go back through the list,
-      // wrap around and keep going until we are at the current selected item. Then (as the last resort) we
-      // go to the item before the currently selected one.
-      int i = itemPos - 1;
-      // Go back in the list to the previous item that is indexed
-      while(true)
-      {
-        if (i < 0)
-          i = allItems.count() - 1;
-        if (allItems[i]->isIndexedByFrame())
-          break;
-        i--;
-      }
-      // Go back one item further to the one before the one before the currently selected one.
-      i--;
-      while(true)
-      {
-        if (i < 0)
-          i = allItems.count() - 1;
-        if (allItems[i]->isIndexedByFrame())
-          break;
-        i--;
-      }
+      // Get the cached frames of all other items as candidates for removal. The frames which will be shown last and
+      // which are cheapest to recreate are removed first (see sortFramesForRemoval). Only remove as many frames as needed.
+      QList<plItemFrame> candidates;
+      for (playlistItem *item : allItems)
+        if (item != selection[0] && item->isIndexedByFrame())
+          for (int f : item->getCachedFrames())
+            candidates.append(plItemFrame(item, f));
 
       // Get the cache level without the current item (frames from the current item do not really occupy space in the cache. We want to cache them anyways)
       int64_t cacheLevelWithoutCurrent = cacheLevel - selection[0]->getNumberCachedFrames() * int64_t(selection[0]->getCachingFrameSize());
-      while ((itemSpaceNeeded + cacheLevelWithoutCurrent) > cacheLevelMax)
+      for (const plItemFrame &f : sortFramesForRemoval(candidates, allItems, itemPos, play))
       {
-        if (i == itemPos)
-          // We went through the whole list and arrived back at the beginning.
-          // If playback is running, we go to the previous item at last.
-          i--;
-        if (i < 0)
-        {
-          // There is no previous item or the previous item is the first one in the list
-          i = allItems.count() - 1;
-        }
-        if (allItems[i]->getNumberCachedFrames() == 0)
-        {
-          i--;
-          continue;  // Nothing to delete for this item
-        }
-
-        // Which frames are cached for the item at position i?
-        QList<int> cachedFrames = allItems[i]->getCachedFrames();
-        int64_t cachedFramesSize = cachedFrames.count() * int64_t(allItems[i]->getCachingFrameSize());
-
-        if (additionalItemSpaceNeeded < cachedFramesSize)
-        {
-          // If we delete all frames from item i, there is more than enough space. So we only delete as many frames as needed.
-          int64_t nrFrames = additionalItemSpaceNeeded / allItems[i]->getCachingFrameSize() + 1;
-
-          // Delete nrFrames frames from the back
-          for (int f = cachedFrames.count() - 1; f >= 0 && nrFrames > 0 ; f--)
-          {
-            cacheDeQueue.enqueue(plItemFrame(allItems[i], cachedFrames[f]));
-            cacheLevelWithoutCurrent -= allItems[i]->getCachingFrameSize();
-            if ((cacheLevelWithoutCurrent + itemSpaceNeeded) <= cacheLevelMax)
-              // Now there is enough space
-              break;
-          }
-        }
-        else
-        {
-          // Deleting all frames from this item will not be enough.
-          // Mark all frames of this item as "can be removed if required"
-          QList<int> cachedFrames = allItems[i]->getCachedFrames();
-          for (int f : cachedFrames)
-          {
-            cacheDeQueue.enqueue(plItemFrame(allItems[i], f));
-          }
-          cacheLevelWithoutCurrent -= cachedFramesSize;
-        }
-
-        if (i == itemPos-1)
-        {
-          // We went through all items and tried to delete frames but there is still not enough space.
-          // That is not possible because we determined that the curretn item should fit if we just delete enough frames.
-          DEBUG_CACHING("videoCache::updateCacheQueue ERROR! Deleting loop processed all frames but still not enough space in the cache.");
+        if ((cacheLevelWithoutCurrent + itemSpaceNeeded) <= cacheLevelMax)
+          // Now there is enough space
           break;
-        }
-
-        // Go to the next (previous) item
-        i--;
+        cacheDeQueue.enqueue(f);
+        cacheLevelWithoutCurrent -= f.first->getCachingFrameSize();
       }
+      if ((cacheLevelWithoutCurrent + itemSpaceNeeded) > cacheLevelMax)
+        // We determined that the current item should fit if we just delete enough frames.
+        DEBUG_CACHING("videoCache::updateCacheQueue ERROR! Deleting loop processed all frames but still not enough space in the cache.");
 
       // Enqueue the job. This is the only job.
       // We will not delete any frames from any other items to cache frames from other items.
@@ -818,6 +769,10 @@ void videoCache::updateCacheQueue()
     }
   }
 
+  // The list above only determines which frames may be removed. Sort it so that the frames which are
+  // needed last and which are cheapest to recreate are removed first.
+  sortCacheDeQueue(allItems, itemPos, play);
+
 #if CACHING_DEBUG_OUTPUT && !NDEBUG
   if (!cacheQueue.isEmpty())
   {
@@ -865,6 +820,119 @@ void videoCache::enqueueCacheJob(playlistItem* item, indexRange range)
     cacheQueue.append(cacheJob(item, range));
 }
 
+void videoCache::sortCacheDeQueue(const QList<playlistItem*> &allItems, int itemPos, bool play)
+{
+  if (cacheDeQueue.count() < 2)
+    return;
+
+  const QList<plItemFrame> sortedFrames = sortFramesForRemoval(cacheDeQueue, allItems, itemPos, play);
+  cacheDeQueue.clear();
+  for (const plItemFrame &f : sortedFrames)
+    cacheDeQueue.enqueue(f);
+}
+
+QList<videoCache::plItemFrame> videoCache::sortFramesForRemoval(const QList<plItemFrame> &frames, const QList<playlistItem*> &allItems, int itemPos, bool play)
+{
+  if (frames.count() < 2)
+    return frames;
+
+  // Put all frames of all items on one timeline in the order in which they are played back, starting with
+  // the first frame of the selected item and wrapping around at the end of the playlist.
+  QHash<playlistItem*, int64_t> itemStart;
+  int64_t timelineLength = 0;
+  for (int n = 0; n < allItems.count(); n++)
+  {
+    playlistItem *item = allItems[(itemPos + n) % allItems.count()];
+    itemStart[item] = timelineLength;
+    if (item->isIndexedByFrame())
+    {
+      indexRange range = item->getFrameIdxRange();
+      timelineLength += range.second - range.first + 1;
+    }
+    else
+      timelineLength++;
+  }
+  playlistItem *selectedItem = allItems[itemPos];
+  const indexRange selectedRange = selectedItem->getFrameIdxRange();
+  removalTimeline timeline;
+  timeline.length = timelineLength;
+  timeline.selectedLength = selectedItem->isIndexedByFrame() ? selectedRange.second - selectedRange.first + 1 : 1;
+  timeline.currentPos = selectedItem->isIndexedByFrame() ? clip(int64_t(playback->getCurrentFrame() - selectedRange.first), int64_t(0), timeline.selectedLength - 1) : 0;
+  timeline.playing = play;
+  timeline.repeatItem = playback->isRepeatingCurrentItem();
+
+  // Items which were not measured yet get the average cost of the measured items.
+  double defaultCost = 1.0;
+  if (!cachingCostPerItem.isEmpty())
+  {
+    double sum = 0;
+    for (double c : cachingCostPerItem)
+      sum += c;
+    defaultCost = sum / cachingCostPerItem.count();
+  }
+
+  QList<plItemFrame> validFrames;
+  QVector<removalCandidate> candidates;
+  for (const plItemFrame &f : frames)
+  {
+    playlistItem *item = f.first;
+    if (item == nullptr)
+      continue;
+    const int64_t pos = itemStart.value(item, timelineLength) + (item->isIndexedByFrame() ? f.second - item->getFrameIdxRange().first : 0);
+    validFrames.append(f);
+    candidates.append(removalCandidate{pos, int64_t(item->getCachingFrameSize()), cachingCostPerItem.value(item, defaultCost)});
+  }
+
+  QList<plItemFrame> sortedFrames;
+  sortedFrames.reserve(validFrames.count());
+  for (int i : sortRemovalCandidates(candidates, timeline))
+    sortedFrames.append(validFrames[i]);
+  return sortedFrames;
+}
+
+QVector<int> videoCache::sortRemovalCandidates(const QVector<removalCandidate> &candidates, const removalTimeline &timeline)
+{
+  QVector<QPair<double, int>> scores;
+  scores.reserve(candidates.count());
+  for (int i = 0; i < candidates.count(); i++)
+  {
+    const int64_t pos = candidates[i].pos;
+    int64_t distance;
+    if (timeline.playing)
+    {
+      // During playback, only frames after the current position will be shown. Frames before it are
+      // only reached after wrapping around (either in the current item or in the playlist).
+      if (timeline.repeatItem)
+      {
+        if (pos >= timeline.selectedLength)
+          distance = timeline.length + pos;
+        else
+          distance = (pos >= timeline.currentPos) ? pos - timeline.currentPos : pos - timeline.currentPos + timeline.selectedLength;
+      }
+      else
+        distance = (pos >= timeline.currentPos) ? pos - timeline.currentPos : pos - timeline.currentPos + timeline.length;
+    }
+    else
+    {
+      // If playback is not running, the user may step in both directions
+      const int64_t d = qAbs(pos - timeline.currentPos);
+      distance = std::min(d, timeline.length - d);
+    }
+
+    const double cost = std::max(candidates[i].cost, 0.001);
+    scores.append(QPair<double, int>(double(distance + 1) * candidates[i].size / cost, i));
+  }
+
+  // Keep the original order for frames with the same score
+  std::stable_sort(scores.begin(), scores.end(), [](const QPair<double, int> &a, const QPair<double, int> &b) { return a.first > b.first; });
+
+  QVector<int> order;
+  order.reserve(scores.count());
+  for (const auto &s : scores)
+    order.append(s.second);
+  return order;
+}
+
 void videoCache::startCaching()
 {
   DEBUG_CACHING("videoCache::startCaching %s", testMode ? "Test mode" : "");
@@ -924,6 +992,21 @@ void videoCache::threadCachingFinished()
   worker->setWorking(false);
   DEBUG_CACHING_DETAIL("videoCache::threadCachingFinished - state %d - worker %p", workersState, worker);
 
+  // Update the measured cost of caching a frame of the item. Use a moving average because the
+  // duration of a single job can vary a lot (e.g. a random access in a decoder).
+  // A job can produce no frame (e.g. another thread decodes the GOP of the frame) or several frames (the whole GOP).
+  // So the duration is divided by the number of produced frames and jobs that produced no frame are not counted.
+  playlistItem *lastItem = worker->getLastCacheItem();
+  const int lastNrFrames = worker->getLastCacheNrFrames();
+  if (lastItem && !itemsToDelete.contains(lastItem) && lastNrFrames > 0)
+  {
+    const double costPerFrame = worker->getLastCacheDuration() / lastNrFrames;
+    if (cachingCostPerItem.contains(lastItem))
+      cachingCostPerItem[lastItem] = cachingCostPerItem[lastItem] * 0.9 + costPerFrame * 0.1;
+    else
+      cachingCostPerItem[lastItem] = costPerFrame;
+  }
+
   // Check if all threads have stopped.
   bool jobsRunning = false;
   for (loadingThread *t : cachingThreadList)
@@ -1003,6 +1086,7 @@ void videoCache::threadCachingFinished()
       }
       // Delete the item and remove it from the itemsToDelete list
       DEBUG_CACHING("videoCache::threadCachingFinished delete item now %s", (*it)->getName().toLatin1().data());
+      cachingCostPerItem.remove(*it);
       (*it)->deleteLater();
       it = itemsToDelete.erase(it);
       itemDeleted = true;
@@ -1282,6 +1366,7 @@ void videoCache::itemAboutToBeDeleted(playlistItem* item)
       interactiveItemQueued_Idx[1] = -1;
     }
     // The item can be deleted now.
+    cachingCostPerItem.remove(item);
     item->deleteLater();
     DEBUG_CACHING("videoCache::itemAboutToBeDeleted delete item now %s", item->getName().toLatin1().data());
   }
@@ -1300,6 +1385,8 @@ void videoCache::itemNeedsRecache(playlistItem* item, recacheIndicator clearItem
     // Something about the given playlistitem changed and all items in the cache are invalid.
     // If a thread is currently caching the given item, we have to stop caching, clear the cache,
     // rethink what to cache and restart the caching.
+    // The cost of caching a frame of the item may have changed as well. Measure it again.
+    cachingCostPerItem.remove(item);
     if (workersState != workersIdle)
     {
       // Are we currently caching a frame from this item?
@@ -35,11 +35,13 @@
 
 #include <QDockWidget>
 #include <QElapsedTimer>
+#include <QHash>
 #include <QLabel>
 #include <QPointer>
 #include <QProgressDialog>
 #include <QQueue>
 #include <QTimer>
+#include <QVector>
 #include <QWidget>
 
 #include "ui/playlistTreeWidget.h"
@@ -71,6 +73,28 @@ public:
 
   QStringList getCacheStatusText();
 
+  // ----- The order in which cached frames are removed -----
+  // The frames of all items are put on one timeline in the order in which they are played back. The timeline starts
+  // with the first frame of the selected item and wraps around at the end of the playlist.
+  struct removalTimeline
+  {
+    int64_t length {0};          // The number of frames of all items
+    int64_t selectedLength {1};  // The number of frames of the selected item (at the start of the timeline)
+    int64_t currentPos {0};      // The position of the frame that is shown
+    bool playing {false};
+    bool repeatItem {false};     // Playback repeats the selected item
+  };
+  struct removalCandidate
+  {
+    int64_t pos;   // The position of the frame on the timeline
+    int64_t size;  // The number of bytes that removing the frame frees
+    double cost;   // The time (in ms) that caching the frame takes
+  };
+  // Sort the candidates so that the ones which should be removed first are at the front and return their indices.
+  // The score of a frame is the distance (in frames) until it is shown again, multiplied by the space that is freed
+  // by removing it and divided by the time that it takes to recreate it. The frame with the highest score is first.
+  static QVector<int> sortRemovalCandidates(const QVector<removalCandidate> &candidates, const removalTimeline &timeline);
+
 signals:
   // This will be emitted on a regular basis to update the videoCacheInfoWidget
   void updateCacheStatus();
@@ -136,6 +160,15 @@ private:
   // Enqueue the job in the queue. If all frames within the range are already cached in the item, do nothing.
   void enqueueCacheJob(playlistItem* item, indexRange range);
 
+  // Sort the given frames so that the ones which should be removed first are at the front. These are the frames
+  // which will be shown last (considering the current position and direction of playback) and are cheapest to recreate.
+  // This gets the timeline and the costs of the items and sorts the frames using sortRemovalCandidates.
+  QList<plItemFrame> sortFramesForRemoval(const QList<plItemFrame> &frames, const QList<playlistItem*> &allItems, int itemPos, bool play);
+  // Sort the cacheDeQueue using sortFramesForRemoval
+  void sortCacheDeQueue(const QList<playlistItem*> &allItems, int itemPos, bool play);
+  // The measured time (in ms) that caching one frame of the item takes (moving average)
+  QHash<playlistItem*, double> cachingCostPerItem;
+
   // Start the given number of worker threads (if caching is running, also new jobs will be pushed to the workers)
   void startWorkerThreads(int nrThreads);
   // If this number is > 0, the indicated number of threads will be deleted when a worker finishes (threadCachingFinished() is called)
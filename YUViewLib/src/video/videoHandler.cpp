@@ -33,8 +33,10 @@
 #include "videoHandler.h"
 
 #include <QPainter>
+#include <QSettings>
 
 #include "common/functions.h"
+#include "playlistitem/playlistItem.h"
 
 // Activate this if you want to know when which buffer is loaded/converted to image and so on.
 #define VIDEOHANDLER_DEBUG_LOADING 0
@@ -53,6 +55,9 @@ videoHandler::videoHandler()
   cacheValid = true;
   currentFrameRawData_frameIdx = -1;
   rawData_frameIdx = -1;
+
+  QSettings settings;
+  cacheRawFrames = settings.value("VideoCache/StoreRawFrames", false).toBool();
 }
 
 void videoHandler::slotVideoControlChanged()
@@ -111,7 +116,7 @@ itemLoadingState videoHandler::needsLoading(int frameIdx, bool loadRawValues)
       DEBUG_VIDEO("videoHandler::needsLoading %d is current and %d found in double buffer", frameIdx, frameIdx+1);
       return LoadingNotNeeded;
     }
-    else if (cacheValid && imageCache.contains(frameIdx + 1))
+    else if (cacheValid && imageCache.contains(frameIdx + 1) && !imageCache[frameIdx + 1].image.isNull())
     {
       DEBUG_VIDEO("videoHandler::needsLoading %d is current and %d found in cache", frameIdx, frameIdx+1);
       return LoadingNotNeeded;
@@ -128,7 +133,7 @@ itemLoadingState videoHandler::needsLoading(int frameIdx, bool loadRawValues)
   if (doubleBufferImageFrameIdx == frameIdx)
   {
     // The frame in question is in the double buffer...
-    if (cacheValid && imageCache.contains(frameIdx + 1))
+    if (cacheValid && imageCache.contains(frameIdx + 1) && !imageCache[frameIdx + 1].image.isNull())
     {
       // ... and the one after that is in the cache.
       DEBUG_VIDEO("videoHandler::needsLoading %d found in double buffer. Next frame in cache.", frameIdx);
@@ -153,7 +158,7 @@ itemLoadingState videoHandler::needsLoading(int frameIdx, bool loadRawValues)
       DEBUG_VIDEO("videoHandler::needsLoading %d in cache and %d found in double buffer", frameIdx, frameIdx+1);
       return LoadingNotNeeded;
     }
-    else if (cacheValid && imageCache.contains(frameIdx + 1))
+    else if (cacheValid && imageCache.contains(frameIdx + 1) && !imageCache[frameIdx + 1].image.isNull())
     {
       DEBUG_VIDEO("videoHandler::needsLoading %d in cache and %d found in cache", frameIdx, frameIdx+1);
       return LoadingNotNeeded;
@@ -185,15 +190,10 @@ void videoHandler::drawFrame(QPainter *painter, int frameIdx, double zoomFactor,
       currentImageIdx = frameIdx;
       DEBUG_VIDEO("videoHandler::drawFrame %d loaded from double buffer", frameIdx);
     }
-    else
+    else if (getImageFromCache(frameIdx, currentImage))
     {
-      QMutexLocker lock(&imageCacheAccess);
-      if (cacheValid && imageCache.contains(frameIdx))
-      {
-        currentImage = imageCache[frameIdx];
-        currentImageIdx = frameIdx;
-        DEBUG_VIDEO("videoHandler::drawFrame %d loaded from cache", frameIdx);
-      }
+      currentImageIdx = frameIdx;
+      DEBUG_VIDEO("videoHandler::drawFrame %d loaded from cache", frameIdx);
     }
   }
 
@@ -202,10 +202,12 @@ void videoHandler::drawFrame(QPainter *painter, int frameIdx, double zoomFactor,
   videoRect.setSize(frameSize * zoomFactor);
   videoRect.moveCenter(QPoint(0,0));
 
-  // Draw the current image (currentImage)
+  // Draw the current image (currentImage). Draw a (shallow) copy so that the loading thread can set a new current
+  // image while this one is drawn.
   currentImageSetMutex.lock();
-  painter->drawImage(videoRect, currentImage);
+  const QImage image = currentImage;
   currentImageSetMutex.unlock();
+  drawImage(painter, videoRect, image);
 
   if (drawRawValues && zoomFactor >= SPLITVIEW_DRAW_VALUES_ZOOMFACTOR)
   {
@@ -248,7 +250,7 @@ int videoHandler::getNrFramesCached() const
 }
 
 // Put the frame into the cache (if it is not already in there)
-void videoHandler::cacheFrame(int frameIdx, bool testMode)
+int videoHandler::cacheFrame(int frameIdx, bool testMode)
 {
   DEBUG_VIDEO("videoHandler::cacheFrame %d %s", frameIdx, testMode ? "testMode" : "");
 
@@ -256,27 +258,71 @@ void videoHandler::cacheFrame(int frameIdx, bool testMode)
   {
     // No need to add it again
     DEBUG_VIDEO("videoHandler::cacheFrame frame %i already in cache - returning", frameIdx);
-    return;
+    return 0;
   }
 
   // Load the frame. While this is happening in the background the frame size must not change.
-  QImage cacheImage;
-  loadFrameForCaching(frameIdx, cacheImage);
+  cachedFrame frame;
+  if (isCachingRawFrames())
+    loadRawFrameForCaching(frameIdx, frame.rawData);
+  else
+    loadFrameForCaching(frameIdx, frame.image);
 
   // Put it into the cache
-  if (!cacheImage.isNull())
+  if (!frame.isNull())
   {
     DEBUG_VIDEO("videoHandler::cacheFrame insert frame %i into cache", frameIdx);
     QMutexLocker imageCacheLock(&imageCacheAccess);
     if (cacheValid && !testMode)
-      imageCache.insert(frameIdx, cacheImage);
+      imageCache.insert(frameIdx, frame);
+    return 1;
+  }
+
+  DEBUG_VIDEO("videoHandler::cacheFrame loading frame %i for caching failed", frameIdx);
+  return 0;
+}
+
+bool videoHandler::cacheRawFrame(int frameIdx, const rawDataView &frameData)
+{
+  DEBUG_VIDEO("videoHandler::cacheRawFrame %d", frameIdx);
+
+  if (!canCacheRawFrames() || frameData.isEmpty() || (cacheValid && isInCache(frameIdx)))
+    return false;
+
+  cachedFrame frame;
+  if (isCachingRawFrames())
+  {
+    // Only keep the bytes of the frame. The data might be a view into a buffer that is reused by the decoder.
+    const int64_t nrBytes = getBytesPerFrame();
+    if (frameData.size() < nrBytes)
+      return false;
+    if (frameData.isExternal() || frameData.size() > nrBytes)
+      frame.rawData = QByteArray(frameData.data(), int(nrBytes));
+    else
+      frame.rawData = frameData.byteArray();
   }
   else
-    DEBUG_VIDEO("videoHandler::cacheFrame loading frame %i for caching failed", frameIdx);
+    convertRawFrameFromCache(frameData.byteArray(), frame.image);
+
+  if (!frame.isNull())
+  {
+    DEBUG_VIDEO("videoHandler::cacheRawFrame insert frame %i into cache", frameIdx);
+    QMutexLocker imageCacheLock(&imageCacheAccess);
+    if (cacheValid)
+    {
+      imageCache.insert(frameIdx, frame);
+      return true;
+    }
+  }
+  return false;
 }
 
 unsigned int videoHandler::getCachingFrameSize() const
 {
+  // Raw frames are stored exactly as they are read
+  if (isCachingRawFrames())
+    return (unsigned int)getBytesPerFrame();
+
   auto bytes = functions::bytesPerPixel(functions::platformImageFormat());
   return frameSize.width() * frameSize.height() * bytes;
 }
@@ -304,6 +350,11 @@ void videoHandler::removeFrameFromCache(int frameIdx)
   DEBUG_VIDEO("removeFrameFromCache %d", frameIdx);
   QMutexLocker lock(&imageCacheAccess);
   imageCache.remove(frameIdx);
+  if (frameIdx == lastConvertedFrameIdx)
+  {
+    lastConvertedFrameIdx = -1;
+    lastConvertedImage = QImage();
+  }
   lock.unlock();
 }
 
@@ -312,38 +363,103 @@ void videoHandler::removeAllFrameFromCache()
   DEBUG_VIDEO("removeAllFrameFromCache");
   QMutexLocker lock(&imageCacheAccess);
   imageCache.clear();
+  lastConvertedFrameIdx = -1;
+  lastConvertedImage = QImage();
   cacheValid = true;
   lock.unlock();
 }
 
-void videoHandler::loadFrame(int frameIndex, bool loadToDoubleBuffer)
+void videoHandler::updateCacheStorageSetting()
 {
-  DEBUG_VIDEO("videoHandler::loadFrame %d %s\n", frameIndex, (loadToDoubleBuffer) ? "toDoubleBuffer" : "");
+  QSettings settings;
+  const bool newCacheRawFrames = settings.value("VideoCache/StoreRawFrames", false).toBool();
+  if (newCacheRawFrames == cacheRawFrames)
+    return;
 
-  if (requestedFrame_idx != frameIndex)
+  DEBUG_VIDEO("videoHandler::updateCacheStorageSetting cache raw frames %d", newCacheRawFrames);
   {
-    // Lock the mutex for requesting raw data (we share the requestedFrame buffer with the caching function)
-    QMutexLocker lock(&requestDataMutex);
+    QMutexLocker lock(&imageCacheAccess);
+    cacheRawFrames = newCacheRawFrames;
+  }
+
+  // The frames in the cache can still be drawn but the size of a cached frame changed. Recache everything.
+  if (canCacheRawFrames())
+    emit signalHandlerChanged(false, RECACHE_CLEAR);
+}
 
-    // Request the image to be loaded
-    emit signalRequestFrame(frameIndex, false);
+bool videoHandler::getImageFromCache(int frameIdx, QImage &image)
+{
+  cachedFrame frame;
+  {
+    QMutexLocker lock(&imageCacheAccess);
+    if (!cacheValid || !imageCache.contains(frameIdx))
+      return false;
+    frame = imageCache[frameIdx];
+    if (frame.image.isNull() && frameIdx == lastConvertedFrameIdx)
+    {
+      image = lastConvertedImage;
+      return true;
+    }
+  }
 
-    if (requestedFrame_idx != frameIndex)
-      // Loading failed
-      return;
+  if (!frame.image.isNull())
+  {
+    image = frame.image;
+    return true;
   }
 
+  // The frame is cached raw. Convert it now (outside of the lock).
+  QImage convertedImage;
+  convertRawFrameFromCache(frame.rawData, convertedImage);
+  if (convertedImage.isNull())
+    return false;
+  image = convertedImage;
+
+  QMutexLocker lock(&imageCacheAccess);
+  if (cacheValid && imageCache.contains(frameIdx))
+  {
+    lastConvertedFrameIdx = frameIdx;
+    lastConvertedImage = convertedImage;
+  }
+  return true;
+}
+
+bool videoHandler::loadDoubleBufferFromCache(int frameIdx)
+{
+  QImage image;
+  if (!getImageFromCache(frameIdx, image))
+    return false;
+
+  DEBUG_VIDEO("videoHandler::loadDoubleBufferFromCache %d", frameIdx);
+  doubleBufferImage = image;
+  doubleBufferImageFrameIdx = frameIdx;
+  return true;
+}
+
+void videoHandler::loadFrame(int frameIndex, bool loadToDoubleBuffer)
+{
+  DEBUG_VIDEO("videoHandler::loadFrame %d %s\n", frameIndex, (loadToDoubleBuffer) ? "toDoubleBuffer" : "");
+
+  if (loadToDoubleBuffer && loadDoubleBufferFromCache(frameIndex))
+    return;
+
+  // Request the image to be loaded
+  QImage newImage = requestFrame(frameIndex, false);
+  if (newImage.isNull())
+    // Loading failed
+    return;
+
   if (loadToDoubleBuffer)
   {
     // Save the requested frame in the double buffer
-    doubleBufferImage = requestedFrame;
+    doubleBufferImage = newImage;
     doubleBufferImageFrameIdx = frameIndex;
   }
   else
   {
     // Set the requested frame as the current frame
     QMutexLocker imageLock(&currentImageSetMutex);
-    currentImage = requestedFrame;
+    currentImage = newImage;
     currentImageIdx = frameIndex;
   }
 }
@@ -352,16 +468,71 @@ void videoHandler::loadFrameForCaching(int frameIndex, QImage &frameToCache)
 {
   DEBUG_VIDEO("videoHandler::loadFrameForCaching %d", frameIndex);
 
+  // Request the image to be loaded. If loading failed, this is a null image.
+  frameToCache = requestFrame(frameIndex, true);
+}
+
+void videoHandler::setCurrentFrameRawData(const rawDataView &frameData, int frameIdx)
+{
+  QMutexLocker lock(&currentFrameRawDataMutex);
+  currentFrameRawData = frameData;
+  currentFrameRawData_frameIdx = frameIdx;
+}
+
+rawDataView videoHandler::getCurrentFrameRawData()
+{
+  QMutexLocker lock(&currentFrameRawDataMutex);
+  return currentFrameRawData;
+}
+
+rawDataView videoHandler::requestRawData(int frameIndex, bool caching)
+{
+  if (frameSource && frameSource->canPullRawFrameData())
+    // This does not use any shared buffer. So we don't need to lock anything.
+    return frameSource->pullRawFrameData(frameIndex, caching);
+
+  // Lock the mutex for requesting raw data (the rawData buffer is shared by all threads)
   QMutexLocker lock(&requestDataMutex);
+  emit signalRequestRawData(frameIndex, caching);
+  if (frameIndex != rawData_frameIdx)
+    // Loading failed
+    return rawDataView();
+  return rawData;
+}
 
-  // Request the image to be loaded
-  emit signalRequestFrame(frameIndex, true);
+QImage videoHandler::requestFrame(int frameIndex, bool caching)
+{
+  if (frameSource && frameSource->canPullFrameImage())
+    return frameSource->pullFrameImage(frameIndex);
 
+  // Lock the mutex for requesting the image (the requestedFrame buffer is shared by all threads)
+  QMutexLocker lock(&requestDataMutex);
+  if (caching || requestedFrame_idx != frameIndex)
+    emit signalRequestFrame(frameIndex, caching);
   if (requestedFrame_idx != frameIndex)
+    // Loading failed
+    return QImage();
+  return requestedFrame;
+}
+
+void videoHandler::loadRawFrameForCaching(int frameIndex, QByteArray &frameToCache)
+{
+  DEBUG_VIDEO("videoHandler::loadRawFrameForCaching %d", frameIndex);
+
+  const int64_t bytesPerFrame = getBytesPerFrame();
+
+  rawDataView frameData = requestRawData(frameIndex, true);
+  const bool loadingOk = !frameData.isEmpty();
+
+  if (!loadingOk || bytesPerFrame <= 0 || frameData.size() < bytesPerFrame)
     // Loading failed
     return;
 
-  frameToCache = requestedFrame;
+  // A view into a memory mapped file must be copied. Otherwise the cache would not hold the data.
+  if (frameData.isExternal() || frameData.size() > bytesPerFrame)
+    frameToCache = QByteArray(frameData.data(), int(bytesPerFrame));
+  else
+    frameToCache = frameData.byteArray();
 }
 
 void videoHandler::invalidateAllBuffers()
@@ -381,6 +552,8 @@ void videoHandler::invalidateAllBuffers()
   requestedFrame_idx = -1;
 
   imageCache.clear();
+  lastConvertedFrameIdx = -1;
+  lastConvertedImage = QImage();
   cacheValid = true;
 }
 
@@ -37,8 +37,11 @@
 #include <QFileInfo>
 #include <QMutex>
 
+#include "common/rawDataView.h"
 #include "video/frameHandler.h"
 
+class playlistItem;
+
 /* TODO
 */
 class videoHandler : public frameHandler
@@ -58,16 +61,30 @@ public:
   // --- Caching ----
   // These methods are all thread-safe and can be invoked from any thread.
   int getNrFramesCached() const;
-  void cacheFrame(int frameIdx, bool testMode);
+  // Return the number of frames that were loaded (0 if the frame was already cached or loading failed)
+  int cacheFrame(int frameIdx, bool testMode);
+  // Put the given raw frame data into the cache (converting it to an image if raw frames are not cached). This is used by
+  // items that decode several frames at once in the background and thus can not wait for signalRequestRawData.
+  // Return true if the frame was put into the cache.
+  bool cacheRawFrame(int frameIdx, const rawDataView &frameData);
   unsigned int getCachingFrameSize() const; // How much bytes will be used when caching one frame?
   QList<int> getCachedFrames() const;
   int getNumberCachedFrames() const;
   bool isInCache(int idx) const;
   virtual void removeFrameFromCache(int frameIdx);
   virtual void removeAllFrameFromCache();
+  // Read the cache storage setting (cache converted images or raw frames). If it changed, the cache is rebuilt.
+  void updateCacheStorageSetting();
+
+  // Get a copy of the raw data (getBytesPerFrame() bytes) of the given frame without changing the current frame.
+  // This is thread-safe. An empty array is returned if loading failed.
+  QByteArray getRawFrameData(int frameIdx) { QByteArray frameData; loadRawFrameForCaching(frameIdx, frameData); return frameData; }
 
   // Get the number of bytes for one frame (RGB or YUV) with the current format (if this video handler uses raw data)
   virtual int64_t getBytesPerFrame() const { return -1; }
+  // Get the number of bytes of each plane of one raw frame (in the order in which they are stored). If the format
+  // can not be split into planes (e.g. packed formats), all bytes of the frame are returned as one plane.
+  virtual QVector<int64_t> getRawPlaneSizes() const { return (getBytesPerFrame() > 0) ? QVector<int64_t>() << getBytesPerFrame() : QVector<int64_t>(); }
 
   // The Frame size is about to change. If this happens, our local buffers all need updating.
   virtual void setFrameSize(const QSize &size) Q_DECL_OVERRIDE ;
@@ -89,6 +106,11 @@ public:
   QImage requestedFrame;
   int    requestedFrame_idx;
 
+  // Set the item that the frames are pulled from. If the item can provide frames directly (playlistItem::canPullRawFrameData()
+  // or canPullFrameImage()), the frames are pulled from it and several threads can load frames at the same time. Otherwise,
+  // the frames are requested using signalRequestFrame/signalRequestRawData, which only one thread can use at a time.
+  void setFrameSource(playlistItem *item) { frameSource = item; }
+
   // If reloading a raw file (because it changed), this function will clear all buffers (also the cache). With the next drawFrame(),
   // the data will be reloaded from file.
   void invalidateAllBuffers();
@@ -118,12 +140,18 @@ public:
   // The buffer of the raw data (RGB or YUV) of the current frame (and its frame index)
   // Before using the currentFrameRawData, you have to check if the currentFrameRawData_frameIdx is correct. If not,
   // you have to call loadFrame() to load the frame and set it correctly.
-  QByteArray currentFrameRawData;
-  int        currentFrameRawData_frameIdx;
+  // The raw data may be a view directly into a memory mapped file. It is never modified.
+  rawDataView currentFrameRawData;
+  int         currentFrameRawData_frameIdx;
+  // Frames can be pulled from the item by several threads without locking requestDataMutex. The interactive loader
+  // and the main thread must still not replace (or copy) the shared current frame buffer at the same time.
+  QMutex      currentFrameRawDataMutex;
+  void        setCurrentFrameRawData(const rawDataView &frameData, int frameIdx);
+  rawDataView getCurrentFrameRawData();
 
   // A buffer with the raw RGB data (this is filled if signalRequestRawData() is emitted)
-  QByteArray rawData;
-  int        rawData_frameIdx;
+  rawDataView rawData;
+  int         rawData_frameIdx;
 
   // Scale a value with limited mpeg range (16 ... 245) to the full range (0 ... 255) for output.
   static int convScaleLimitedRange(int value);
@@ -163,10 +191,30 @@ protected:
   // the requested frame. No other internal state of the specific video format handler should be changed.
   // currentFrame/currentFrameIdx is still the frame on screen. This is called from a background thread.
   virtual void loadFrameForCaching(int frameIndex, QImage &frameToCache);
+
+  // If raw frames are cached, loadRawFrameForCaching is used instead of loadFrameForCaching. It is called from a
+  // background thread and gets the raw data of the frame (getBytesPerFrame() bytes) using signalRequestRawData.
+  // convertRawFrameFromCache converts such a frame to an image when it is drawn or loaded to the double buffer.
+  // A video handler that supports this must return true in canCacheRawFrames() and implement convertRawFrameFromCache.
+  virtual bool canCacheRawFrames() const { return false; }
+  virtual void loadRawFrameForCaching(int frameIndex, QByteArray &frameToCache);
+  virtual void convertRawFrameFromCache(const QByteArray &cachedFrame, QImage &outputImage) { Q_UNUSED(cachedFrame); Q_UNUSED(outputImage); }
+
+  // Get the image of the given frame from the cache (convert it if it is cached raw). Return false if the frame is not cached.
+  bool getImageFromCache(int frameIdx, QImage &image);
+  // If the given frame is in the cache, put it into the double buffer and return true.
+  bool loadDoubleBufferFromCache(int frameIdx);
     
-  // Only one thread at a time should request something to be loaded. 
+  // Get the raw data/the image of the given frame. If possible, it is pulled from the frameSource. Otherwise it is
+  // requested using signalRequestRawData/signalRequestFrame. An empty view/a null image is returned if loading failed.
+  rawDataView requestRawData(int frameIndex, bool caching);
+  QImage requestFrame(int frameIndex, bool caching);
+
+  // Only one thread at a time should request something to be loaded using the signals.
   QMutex requestDataMutex;
 
+  playlistItem *frameSource {nullptr};
+
   // We might need to update the currentImage
   int currentImage_frameIndex;
   
@@ -181,8 +229,23 @@ protected:
   void setCacheInvalid() { cacheValid = false; }
 
   // --- Caching
-  QMutex mutable     imageCacheAccess;
-  QMap<int, QImage>  imageCache;
+  // A frame in the cache. Depending on the storage setting, this is either the converted image or
+  // the raw frame data (e.g. planar YUV) which is converted to an image when it is needed.
+  struct cachedFrame
+  {
+    QImage image;
+    QByteArray rawData;
+    bool isNull() const { return image.isNull() && rawData.isEmpty(); }
+  };
+  QMutex mutable          imageCacheAccess;
+  QMap<int, cachedFrame>  imageCache;
+  // The last frame that was converted from a raw frame in the cache. Drawing the same frame again
+  // (e.g. a repaint) does not convert it again. This is also protected by imageCacheAccess.
+  int    lastConvertedFrameIdx {-1};
+  QImage lastConvertedImage;
+  // Cache raw frames instead of images (if the handler supports this)? Use isCachingRawFrames() to check.
+  bool cacheRawFrames {false};
+  bool isCachingRawFrames() const { return cacheRawFrames && canCacheRawFrames() && getBytesPerFrame() > 0; }
   // Is the cache valid? The cache can be ivalid in the following scenario:
   // Somethign about how an item is shown changes (e.g. the resolution) but caching of the item is currently performed.
   // If we just cleared the cache, the wrong (currently being cached) frames would still end up in the cache. So we emit
@@ -69,15 +69,10 @@ void videoHandlerDifference::drawDifferenceFrame(QPainter *painter, int frameIdx
       currentImageIdx = frameIdx;
       DEBUG_VIDEO("videoHandler::drawFrame %d loaded from double buffer", frameIdx);
     }
-    else
+    else if (getImageFromCache(frameIdx, currentImage))
     {
-      QMutexLocker lock(&imageCacheAccess);
-      if (cacheValid && imageCache.contains(frameIdx))
-      {
-        currentImage = imageCache[frameIdx];
-        currentImageIdx = frameIdx;
-        DEBUG_VIDEO("videoHandler::drawFrame %d loaded from cache", frameIdx);
-      }
+      currentImageIdx = frameIdx;
+      DEBUG_VIDEO("videoHandler::drawFrame %d loaded from cache", frameIdx);
     }
   }
 
@@ -116,8 +111,14 @@ void videoHandlerDifference::loadFrameDifference(int frameIndex, int frameIndex0
   if (video0 == nullptr && video1 != nullptr && video1->getCurrentImageIndex() != frameIndex1)
     video1->loadFrame(frameIndex1);
   
-  // Calculate the difference  
-  QImage newFrame = inputVideo[0]->calculateDifference(inputVideo[1], frameIndex0, frameIndex1, differenceInfoList, amplificationFactor, markDifference);
+  // Calculate the difference. For YUV inputs, also get the map of the blocks that differ.
+  videoHandlerYUV *yuvVideo0 = dynamic_cast<videoHandlerYUV*>(inputVideo[0].data());
+  QVector<bool> diffBlocks;
+  QImage newFrame;
+  if (yuvVideo0 != nullptr)
+    newFrame = yuvVideo0->calculateDifference(inputVideo[1], frameIndex0, frameIndex1, differenceInfoList, amplificationFactor, markDifference, diffBlocks);
+  else
+    newFrame = inputVideo[0]->calculateDifference(inputVideo[1], frameIndex0, frameIndex1, differenceInfoList, amplificationFactor, markDifference);
 
   if (!newFrame.isNull())
   {
@@ -126,6 +127,20 @@ void videoHandlerDifference::loadFrameDifference(int frameIndex, int frameIndex0
     currentImageSetMutex.lock();
     currentImage = newFrame;
     currentImageSetMutex.unlock();
+
+    // The YUV difference is overwritten by the next difference calculation. Keep the YUV difference and the map of
+    // differing blocks of the frame on screen for reportFirstDifferencePosition.
+    if (yuvVideo0 != nullptr && yuvVideo0->getIs_YUV_diff())
+    {
+      currentDiffYUV = yuvVideo0->getDiffYUV();
+      currentDiffYUVFormat = yuvVideo0->getDiffYUVFormat();
+      currentDiffBlocks = diffBlocks;
+    }
+    else
+    {
+      currentDiffYUV.clear();
+      currentDiffBlocks.clear();
+    }
   }
 }
 
@@ -243,20 +258,47 @@ void videoHandlerDifference::reportFirstDifferencePosition(QList<infoItem> &info
     int widthLCU  = (frameSize.width()  + 63) / 64;  // Round up
     int heightLCU = (frameSize.height() + 63) / 64;
 
+    // find first difference using YUV instead of QImage. The latter does not work for 10bit videos and very small differences, since it only supports 8bit
+    const bool useYUV = !currentDiffYUV.isEmpty();
+
+    // While calculating the YUV difference of the frame on screen, it was recorded which LCUs differ. So we only
+    // have to scan the first LCU that differs and can list all of them.
+    QVector<bool> diffLCUs;
+    if (useYUV)
+      diffLCUs = currentDiffBlocks;
+    if (diffLCUs.size() != widthLCU * heightLCU)
+      diffLCUs.clear();
+    else
+    {
+      QStringList lcuList;
+      for (int i = 0; i < diffLCUs.size(); i++)
+        if (diffLCUs[i])
+          lcuList.append(QString::number(i));
+      if (lcuList.isEmpty())
+      {
+        infoList.append(infoItem("Difference", "Frames are identical"));
+        return;
+      }
+      infoList.append(infoItem("Differing LCUs", QString("%1 of %2").arg(lcuList.count()).arg(diffLCUs.size())));
+      const int maxListedLCUs = 20;
+      const QString lcuText = lcuList.mid(0, maxListedLCUs).join(", ") + (lcuList.count() > maxListedLCUs ? ", ..." : "");
+      infoList.append(infoItem("Differing LCU list", lcuText, lcuList.join(", ")));
+    }
+
     for (int y = 0; y < heightLCU; y++)
     {
       for (int x = 0; x < widthLCU; x++)
       {
+        if (!diffLCUs.isEmpty() && !diffLCUs[y * widthLCU + x])
+          // There is no difference in this LCU
+          continue;
+
         // Now take the tree approach
         int firstX, firstY, partIndex = 0;
 
-
-        videoHandlerYUV* video0 = dynamic_cast<videoHandlerYUV*>(inputVideo[0].data());
-        if(video0 != NULL && video0->getIs_YUV_diff())
+        if (useYUV)
         {
-
-            // find first difference using YUV instead of QImage. The latter does not work for 10bit videos and very small differences, since it only supports 8bit
-            if (hierarchicalPositionYUV(x*64, y*64, 64, firstX, firstY, partIndex, video0->getDiffYUV(), video0->getDiffYUVFormat()))
+            if (hierarchicalPositionYUV(x*64, y*64, 64, firstX, firstY, partIndex, currentDiffYUV, currentDiffYUVFormat))
             {
               // We found a difference in this block
               infoList.append(infoItem("First Difference LCU", QString::number(y * widthLCU + x)));
@@ -265,7 +307,6 @@ void videoHandlerDifference::reportFirstDifferencePosition(QList<infoItem> &info
               infoList.append(infoItem("First Difference partIndex", QString::number(partIndex)));
               return;
             }
-
         }
         else
         {
@@ -91,6 +91,11 @@ private:
   // The two videos that the difference will be calculated from
   QPointer<frameHandler> inputVideo[2];  
 
+  // The YUV difference of the frame on screen and which of its 64x64 blocks differ (if the difference was calculated in YUV)
+  QByteArray currentDiffYUV;
+  YUV_Internals::yuvPixelFormat currentDiffYUVFormat;
+  QVector<bool> currentDiffBlocks;
+
   // Recursively scan the LCU
   bool hierarchicalPosition(int x, int y, int blockSize, int &firstX, int &firstY, int &partIndex, const QImage &diffImg) const;
   bool hierarchicalPositionYUV(int x, int y, int blockSize, int &firstX, int &firstY, int &partIndex, const QByteArray &diffYUV, const YUV_Internals::yuvPixelFormat &diffYUVFormat) const;
@@ -32,6 +32,8 @@
 
 #include "videoHandlerRGB.h"
 
+#include <limits>
+#include <QImageReader>
 #include <QPainter>
 
 #include "common/functions.h"
@@ -261,9 +263,9 @@ videoHandlerRGB::videoHandlerRGB() : videoHandler()
 
 videoHandlerRGB::~videoHandlerRGB()
 {
-  // This will cause a "QMutex: destroying locked mutex" warning by Qt.
-  // However, here this is on purpose.
-  rgbFormatMutex.lock();
+  // Wait for all caching jobs to finish. This will cause a "destroying locked QReadWriteLock"
+  // warning by Qt. However, here this is on purpose.
+  rgbFormatLock.lockForWrite();
 }
 
 QStringPairList videoHandlerRGB::getPixelValues(const QPoint &pixelPos, int frameIdx, frameHandler *item2, const int frameIdx1)
@@ -487,6 +489,10 @@ void videoHandlerRGB::loadFrame(int frameIndex, bool loadToDoubleBuffer)
     return;
   }
 
+  // If the frame is cached (raw), the double buffer can be converted from the cache
+  if (loadToDoubleBuffer && loadDoubleBufferFromCache(frameIndex))
+    return;
+
   // Does the data in currentFrameRawData need to be updated?
   if (!loadRawRGBData(frameIndex))
   {
@@ -496,17 +502,19 @@ void videoHandlerRGB::loadFrame(int frameIndex, bool loadToDoubleBuffer)
 
   // The data in currentFrameRawData is now up to date. If necessary
   // convert the data to RGB.
+  // Convert from a copy of the view. Another thread may set a new current frame in the meantime.
+  const rawDataView frameData = getCurrentFrameRawData();
   if (loadToDoubleBuffer)
   {
     QImage newImage;
-    convertRGBToImage(currentFrameRawData, newImage);
+    convertRGBToImage(frameData, newImage);
     doubleBufferImage = newImage;
     doubleBufferImageFrameIdx = frameIndex;
   }
   else if (currentImageIdx != frameIndex)
   {
     QImage newImage;
-    convertRGBToImage(currentFrameRawData, newImage);
+    convertRGBToImage(frameData, newImage);
     QMutexLocker writeLock(&currentImageSetMutex);
     currentImage = newImage;
     currentImageIdx = frameIndex;
@@ -517,27 +525,21 @@ void videoHandlerRGB::loadFrameForCaching(int frameIndex, QImage &frameToCache)
 {
   DEBUG_RGB("videoHandlerRGB::loadFrameForCaching %d", frameIndex);
 
-  // Lock the mutex for the rgbFormat. The main thread has to wait until caching is done
-  // before the RGB format can change.
-  rgbFormatMutex.lock();
+  // Lock the rgbFormat for reading. The main thread has to wait until caching is done
+  // before the RGB format can change. Other caching threads can convert frames at the same time.
+  QReadLocker formatLock(&rgbFormatLock);
 
-  requestDataMutex.lock();
-  emit signalRequestRawData(frameIndex, true);
-  tmpBufferRawRGBDataCaching = rawData;
-  requestDataMutex.unlock();
-
-  if (frameIndex != rawData_frameIdx)
+  // If the item supports it, this pulls the data directly and other threads can load frames at the same time.
+  rawDataView frameData = requestRawData(frameIndex, true);
+  if (frameData.isEmpty())
   {
     // Loading failed
     currentImageIdx = -1;
-    rgbFormatMutex.unlock();
     return;
   }
 
   // Convert RGB to image. This can then be cached.
-  convertRGBToImage(tmpBufferRawRGBDataCaching, frameToCache);
-
-  rgbFormatMutex.unlock();
+  convertRGBToImage(frameData, frameToCache);
 }
 
 // Load the raw RGB data for the given frame index into currentFrameRawData.
@@ -556,32 +558,24 @@ bool videoHandlerRGB::loadRawRGBData(int frameIndex)
     // The raw data was loaded in the background. Now we just have to move it to the current
     // buffer. No actual loading is needed.
     requestDataMutex.lock();
-    currentFrameRawData = rawData;
-    currentFrameRawData_frameIdx = frameIndex;
+    setCurrentFrameRawData(rawData, frameIndex);
     requestDataMutex.unlock();
     return true;
   }
 
   DEBUG_RGB("videoHandlerRGB::loadRawRGBData %d", frameIndex);
 
-  // The function loadFrameForCaching also uses the signalRequestRawData to request raw data.
-  // However, only one thread can use this at a time.
-  requestDataMutex.lock();
-  emit signalRequestRawData(frameIndex, false);
-  if (frameIndex == rawData_frameIdx)
-  {
-    currentFrameRawData = rawData;
-    currentFrameRawData_frameIdx = frameIndex;
-  }
-  requestDataMutex.unlock();
+  rawDataView frameData = requestRawData(frameIndex, false);
+  if (!frameData.isEmpty())
+    setCurrentFrameRawData(frameData, frameIndex);
 
-  DEBUG_RGB("videoHandlerRGB::loadRawRGBData %d %s", frameIndex, (frameIndex == rawData_frameIdx) ? "NewDataSet" : "Waiting...");
+  DEBUG_RGB("videoHandlerRGB::loadRawRGBData %d %s", frameIndex, (frameIndex == currentFrameRawData_frameIdx) ? "NewDataSet" : "Waiting...");
   return (currentFrameRawData_frameIdx == frameIndex);
 }
 
 // Convert the given raw RGB data in sourceBuffer (using srcPixelFormat) to image (RGB-888), using the
 // buffer tmpRGBBuffer for intermediate RGB values.
-void videoHandlerRGB::convertRGBToImage(const QByteArray &sourceBuffer, QImage &outputImage)
+void videoHandlerRGB::convertRGBToImage(const rawDataView &sourceBuffer, QImage &outputImage)
 {
   DEBUG_RGB("videoHandlerRGB::convertRGBToImage");
   QSize curFrameSize = frameSize;
@@ -622,14 +616,13 @@ void videoHandlerRGB::convertRGBToImage(const QByteArray &sourceBuffer, QImage &
 
 void videoHandlerRGB::setSrcPixelFormat(const RGB_Internals::rgbPixelFormat &newFormat)
 { 
-  rgbFormatMutex.lock();
+  QWriteLocker formatLock(&rgbFormatLock);
   srcPixelFormat = newFormat;
-  rgbFormatMutex.unlock();
 }
 
 // Convert the data in "sourceBuffer" from the format "srcPixelFormat" to RGB 888. While doing so, apply the
 // scaling factors, inversions and only convert the selected color components.
-void videoHandlerRGB::convertSourceToRGBA32Bit(const QByteArray &sourceBuffer, unsigned char *targetBuffer)
+void videoHandlerRGB::convertSourceToRGBA32Bit(const rawDataView &sourceBuffer, unsigned char *targetBuffer)
 {
   // Check if the source buffer is of the correct size
   Q_ASSERT_X(sourceBuffer.size() >= getBytesPerFrame(), "videoHandlerRGB::convertSourceToRGB888", "The source buffer does not hold enough data.");
@@ -983,6 +976,69 @@ void videoHandlerRGB::setFormatFromSizeAndName(const QSize size, int bitDepth, b
   setSrcPixelFormat(cFormat);
 }
 
+bool videoHandlerRGB::isHighBitDepthImageFile(const QString &filePath)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+  // Only the header of the file is read to get the format
+  QImageReader reader(filePath);
+  const QImage::Format format = reader.imageFormat();
+  if (format == QImage::Format_RGBX64 || format == QImage::Format_RGBA64 || format == QImage::Format_RGBA64_Premultiplied)
+    return true;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+  if (format == QImage::Format_Grayscale16)
+    return true;
+#endif
+#else
+  Q_UNUSED(filePath);
+#endif
+  return false;
+}
+
+QByteArray videoHandlerRGB::loadHighBitDepthImageFile(const QString &filePath, QSize &frameSize)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+  QImageReader reader(filePath);
+  QImage image = reader.read();
+  if (image.isNull())
+    return QByteArray();
+  if (image.format() != QImage::Format_RGBX64 && image.format() != QImage::Format_RGBA64)
+    // Premultiplied or gray values. Get 16 bit RGB values.
+    image = std::move(image).convertToFormat(QImage::Format_RGBA64);
+
+  const int width = image.width();
+  const int height = image.height();
+  const int64_t planeSize = int64_t(width) * height;
+  if (planeSize * 3 * 2 > std::numeric_limits<int>::max())
+    return QByteArray();
+
+  // Copy the values into the R, G and B planes. The QImage is freed when we return.
+  QByteArray data(int(planeSize * 3 * 2), Qt::Uninitialized);
+  unsigned short *dstR = (unsigned short*)data.data();
+  unsigned short *dstG = dstR + planeSize;
+  unsigned short *dstB = dstG + planeSize;
+  for (int y = 0; y < height; y++)
+  {
+    const QRgba64 *src = (const QRgba64*)image.constScanLine(y);
+    for (int x = 0; x < width; x++)
+    {
+      dstR[x] = src[x].red();
+      dstG[x] = src[x].green();
+      dstB[x] = src[x].blue();
+    }
+    dstR += width;
+    dstG += width;
+    dstB += width;
+  }
+
+  frameSize = image.size();
+  return data;
+#else
+  Q_UNUSED(filePath);
+  Q_UNUSED(frameSize);
+  return QByteArray();
+#endif
+}
+
 void videoHandlerRGB::drawPixelValues(QPainter *painter, const int frameIdx, const QRect &videoRect, const double zoomFactor, frameHandler *item2, const bool markDifference, const int frameIdxItem1)
 {
   // First determine which pixels from this item are actually visible, because we only have to draw the pixel values
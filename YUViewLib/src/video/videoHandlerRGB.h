@@ -33,6 +33,8 @@
 #ifndef VIDEOHANDLERRGB_H
 #define VIDEOHANDLERRGB_H
 
+#include <QReadWriteLock>
+
 #include "ui_videoHandlerRGB.h"
 #include "ui_videoHandlerRGB_CustomFormatDialog.h"
 #include "videoHandler.h"
@@ -124,6 +126,13 @@ public:
   // The sub format can be one of: "RGB", "GBR" or "BGR"
   virtual void setFormatFromSizeAndName(const QSize size, int bitDepth, bool packed, int64_t fileSize, const QFileInfo &fileInfo) Q_DECL_OVERRIDE;
 
+  // Image files with more than 8 bit per sample (like 16 bit PNG or TIFF files) lose their exact values if they are
+  // loaded into a QImage for display. These can be loaded as planar 16 bit RGB data (rgbPixelFormat(16, true)) instead
+  // which is 6 bytes per pixel. The alpha channel is dropped. Loading returns an empty array (and does not set the
+  // frameSize) if the file could not be loaded. This needs Qt 5.12 or newer. Both functions can be called from any thread.
+  static bool isHighBitDepthImageFile(const QString &filePath);
+  static QByteArray loadHighBitDepthImageFile(const QString &filePath, QSize &frameSize);
+
   // Draw the pixel values of the visible pixels in the center of each pixel. Only draw values for the given range of pixels.
   // Overridden from playlistItemVideo. This is a RGB source, so we can draw the source RGB values from the source data.
   virtual void drawPixelValues(QPainter *painter, const int frameIdx, const QRect &videoRect, const double zoomFactor, frameHandler *item2 = nullptr, const bool markDifference = false, const int frameIdxItem1 = 0) Q_DECL_OVERRIDE;
@@ -185,6 +194,10 @@ protected:
   // will not be modified.
   virtual void loadFrameForCaching(int frameIndex, QImage &frameToCache) Q_DECL_OVERRIDE;
 
+  // Raw RGB frames can be cached and converted when they are drawn
+  virtual bool canCacheRawFrames() const Q_DECL_OVERRIDE { return true; }
+  virtual void convertRawFrameFromCache(const QByteArray &cachedFrame, QImage &outputImage) Q_DECL_OVERRIDE { convertRGBToImage(cachedFrame, outputImage); }
+
 private:
 
   // Load the raw RGB data for the given frame index into currentFrameRawRGBData.
@@ -192,18 +205,17 @@ private:
   bool loadRawRGBData(int frameIndex);
 
   // Convert from RGB (which ever format is selected) to a QImage in the platform QImage format (platformImageFormat)
-  void convertRGBToImage(const QByteArray &sourceBuffer, QImage &outputImage);
+  void convertRGBToImage(const rawDataView &sourceBuffer, QImage &outputImage);
 
   // Set the new pixel format thread save (lock the mutex)
   void setSrcPixelFormat(const RGB_Internals::rgbPixelFormat &newFormat);
 
   // Convert one frame from the current pixel format to RGB888
-  void convertSourceToRGBA32Bit(const QByteArray &sourceBuffer, unsigned char *targetBuffer);
-  QByteArray tmpBufferRawRGBDataCaching;
+  void convertSourceToRGBA32Bit(const rawDataView &sourceBuffer, unsigned char *targetBuffer);
 
-  // When a caching job is running in the background it will lock this mutex, so that
+  // When a caching job is running in the background it will lock this for reading, so that
   // the main thread does not change the RGB format while this is happening.
-  QMutex rgbFormatMutex;
+  QReadWriteLock rgbFormatLock;
 
   SafeUi<Ui::videoHandlerRGB> ui;
 
@@ -34,12 +34,12 @@
 
 #include <algorithm>
 #include <cstdio>
-#include <xmmintrin.h>
 #include <QDir>
 #include <QPainter>
 
 #include "common/fileInfo.h"
 #include "common/functions.h"
+#include "video/videoHandlerYUVKernels.h"
 
 using namespace YUV_Internals;
 
@@ -722,148 +722,6 @@ void videoHandlerYUV::drawFrame(QPainter *painter, int frameIdx, double zoomFact
 
 /// --- Convert from the current YUV input format to YUV 444
 
-#if SSE_CONVERSION_420_ALT
-void videoHandlerYUV::yuv420_to_argb8888(quint8 *yp, quint8 *up, quint8 *vp, quint32 sy, quint32 suv, int width, int height, quint8 *rgb, quint32 srgb)
-{
-  __m128i y0r0, y0r1, u0, v0;
-  __m128i y00r0, y01r0, y00r1, y01r1;
-  __m128i u00, u01, v00, v01;
-  __m128i rv00, rv01, gu00, gu01, gv00, gv01, bu00, bu01;
-  __m128i r00, r01, g00, g01, b00, b01;
-  __m128i rgb0123, rgb4567, rgb89ab, rgbcdef;
-  __m128i gbgb;
-  __m128i ysub, uvsub;
-  __m128i zero, facy, facrv, facgu, facgv, facbu;
-  __m128i *srcy128r0, *srcy128r1;
-  __m128i *dstrgb128r0, *dstrgb128r1;
-  __m64   *srcu64, *srcv64;
-
-
-  //    Implement the following conversion:
-  //    B = 1.164(Y - 16)                   + 2.018(U - 128)
-  //    G = 1.164(Y - 16) - 0.813(V - 128)  - 0.391(U - 128)
-  //    R = 1.164(Y - 16) + 1.596(V - 128)
-
-  int x, y;
-  // constants
-  ysub  = _mm_set1_epi32(0x00100010); // value 16 for subtraction
-  uvsub = _mm_set1_epi32(0x00800080); // value 128
-
-  // multiplication factors bit shifted by 6
-  facy  = _mm_set1_epi32(0x004a004a);
-  facrv = _mm_set1_epi32(0x00660066);
-  facgu = _mm_set1_epi32(0x00190019);
-  facgv = _mm_set1_epi32(0x00340034);
-  facbu = _mm_set1_epi32(0x00810081);
-
-  zero  = _mm_set1_epi32(0x00000000);
-
-  for(y = 0; y < height; y += 2)
-  {
-    srcy128r0 = (__m128i *)(yp + sy*y);
-    srcy128r1 = (__m128i *)(yp + sy*y + sy);
-    srcu64 = (__m64 *)(up + suv*(y/2));
-    srcv64 = (__m64 *)(vp + suv*(y/2));
-
-    // dst row 0 and row 1
-    dstrgb128r0 = (__m128i *)(rgb + srgb*y);
-    dstrgb128r1 = (__m128i *)(rgb + srgb*y + srgb);
-
-    for(x = 0; x < width; x += 16)
-    {
-      u0 = _mm_loadl_epi64((__m128i *)srcu64); srcu64++;
-      v0 = _mm_loadl_epi64((__m128i *)srcv64); srcv64++;
-
-      y0r0 = _mm_load_si128(srcy128r0++);
-      y0r1 = _mm_load_si128(srcy128r1++);
-
-      // expand to 16 bit, subtract and multiply constant y factors
-      y00r0 = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(y0r0, zero), ysub), facy);
-      y01r0 = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(y0r0, zero), ysub), facy);
-      y00r1 = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(y0r1, zero), ysub), facy);
-      y01r1 = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(y0r1, zero), ysub), facy);
-
-      // expand u and v so they're aligned with y values
-      u0  = _mm_unpacklo_epi8(u0,  zero);
-      u00 = _mm_sub_epi16(_mm_unpacklo_epi16(u0, u0), uvsub);
-      u01 = _mm_sub_epi16(_mm_unpackhi_epi16(u0, u0), uvsub);
-
-      v0  = _mm_unpacklo_epi8(v0,  zero);
-      v00 = _mm_sub_epi16(_mm_unpacklo_epi16(v0, v0), uvsub);
-      v01 = _mm_sub_epi16(_mm_unpackhi_epi16(v0, v0), uvsub);
-
-      // common factors on both rows.
-      rv00 = _mm_mullo_epi16(facrv, v00);
-      rv01 = _mm_mullo_epi16(facrv, v01);
-      gu00 = _mm_mullo_epi16(facgu, u00);
-      gu01 = _mm_mullo_epi16(facgu, u01);
-      gv00 = _mm_mullo_epi16(facgv, v00);
-      gv01 = _mm_mullo_epi16(facgv, v01);
-      bu00 = _mm_mullo_epi16(facbu, u00);
-      bu01 = _mm_mullo_epi16(facbu, u01);
-
-      // add together and bit shift to the right
-      r00 = _mm_srai_epi16(_mm_add_epi16(y00r0, rv00), 6);
-      r01 = _mm_srai_epi16(_mm_add_epi16(y01r0, rv01), 6);
-      g00 = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(y00r0, gu00), gv00), 6);
-      g01 = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(y01r0, gu01), gv01), 6);
-      b00 = _mm_srai_epi16(_mm_add_epi16(y00r0, bu00), 6);
-      b01 = _mm_srai_epi16(_mm_add_epi16(y01r0, bu01), 6);
-
-      r00 = _mm_packus_epi16(r00, r01);
-      g00 = _mm_packus_epi16(g00, g01);
-      b00 = _mm_packus_epi16(b00, b01);
-
-      // shuffle back together to lower 0rgb0rgb...
-      r01     = _mm_unpacklo_epi8(r00,  zero); // 0r0r...
-      gbgb    = _mm_unpacklo_epi8(b00,  g00);  // gbgb...
-      rgb0123 = _mm_unpacklo_epi16(gbgb, r01);  // lower 0rgb0rgb...
-      rgb4567 = _mm_unpackhi_epi16(gbgb, r01);  // upper 0rgb0rgb...
-
-      // shuffle back together to upper 0rgb0rgb...
-      r01     = _mm_unpackhi_epi8(r00,  zero);
-      gbgb    = _mm_unpackhi_epi8(b00,  g00);
-      rgb89ab = _mm_unpacklo_epi16(gbgb, r01);
-      rgbcdef = _mm_unpackhi_epi16(gbgb, r01);
-
-      // write to dst
-      _mm_store_si128(dstrgb128r0++, rgb0123);
-      _mm_store_si128(dstrgb128r0++, rgb4567);
-      _mm_store_si128(dstrgb128r0++, rgb89ab);
-      _mm_store_si128(dstrgb128r0++, rgbcdef);
-
-      // row 1
-      r00 = _mm_srai_epi16(_mm_add_epi16(y00r1, rv00), 6);
-      r01 = _mm_srai_epi16(_mm_add_epi16(y01r1, rv01), 6);
-      g00 = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(y00r1, gu00), gv00), 6);
-      g01 = _mm_srai_epi16(_mm_sub_epi16(_mm_sub_epi16(y01r1, gu01), gv01), 6);
-      b00 = _mm_srai_epi16(_mm_add_epi16(y00r1, bu00), 6);
-      b01 = _mm_srai_epi16(_mm_add_epi16(y01r1, bu01), 6);
-
-      r00 = _mm_packus_epi16(r00, r01);
-      g00 = _mm_packus_epi16(g00, g01);
-      b00 = _mm_packus_epi16(b00, b01);
-
-      r01     = _mm_unpacklo_epi8(r00,  zero);
-      gbgb    = _mm_unpacklo_epi8(b00,  g00);
-      rgb0123 = _mm_unpacklo_epi16(gbgb, r01);
-      rgb4567 = _mm_unpackhi_epi16(gbgb, r01);
-
-      r01     = _mm_unpackhi_epi8(r00,  zero);
-      gbgb    = _mm_unpackhi_epi8(b00,  g00);
-      rgb89ab = _mm_unpacklo_epi16(gbgb, r01);
-      rgbcdef = _mm_unpackhi_epi16(gbgb, r01);
-
-      _mm_store_si128(dstrgb128r1++, rgb0123);
-      _mm_store_si128(dstrgb128r1++, rgb4567);
-      _mm_store_si128(dstrgb128r1++, rgb89ab);
-      _mm_store_si128(dstrgb128r1++, rgbcdef);
-
-    }
-  }
-}
-#endif
-
 QLayout *videoHandlerYUV::createVideoHandlerControls(bool isSizeFixed)
 {
   // Absolutely always only call this function once!
@@ -1769,6 +1627,10 @@ void videoHandlerYUV::loadFrame(int frameIndex, bool loadToDoubleBuffer)
     // We cannot load a frame if the format is not known
     return;
 
+  // If the frame is cached (raw), the double buffer can be converted from the cache
+  if (loadToDoubleBuffer && loadDoubleBufferFromCache(frameIndex))
+    return;
+
   // Does the data in currentFrameRawData need to be updated?
   if (!loadRawYUVData(frameIndex))
     // Loading failed or it is still being performed in the background
@@ -1776,17 +1638,19 @@ void videoHandlerYUV::loadFrame(int frameIndex, bool loadToDoubleBuffer)
 
   // The data in currentFrameRawData is now up to date. If necessary
   // convert the data to RGB.
+  // Convert from a copy of the view. Another thread may set a new current frame in the meantime.
+  const rawDataView frameData = getCurrentFrameRawData();
   if (loadToDoubleBuffer)
   {
     QImage newImage;
-    convertYUVToImage(currentFrameRawData, newImage, srcPixelFormat, frameSize);
+    convertYUVToImage(frameData, newImage, srcPixelFormat, frameSize);
     doubleBufferImage = newImage;
     doubleBufferImageFrameIdx = frameIndex;
   }
   else if (currentImageIdx != frameIndex)
   {
     QImage newImage;
-    convertYUVToImage(currentFrameRawData, newImage, srcPixelFormat, frameSize);
+    convertYUVToImage(frameData, newImage, srcPixelFormat, frameSize);
     QMutexLocker setLock(&currentImageSetMutex);    
     currentImage = newImage;
     currentImageIdx = frameIndex;
@@ -1801,12 +1665,10 @@ void videoHandlerYUV::loadFrameForCaching(int frameIndex, QImage &frameToCache)
   yuvPixelFormat yuvFormat = srcPixelFormat;
   const QSize curFrameSize = frameSize;
 
-  requestDataMutex.lock();
-  emit signalRequestRawData(frameIndex, true);
-  QByteArray tmpBufferRawYUVDataCaching = rawData;
-  requestDataMutex.unlock();
+  // If the item supports it, this pulls the data directly and other threads can load frames at the same time.
+  rawDataView tmpBufferRawYUVDataCaching = requestRawData(frameIndex, true);
 
-  if (frameIndex != rawData_frameIdx)
+  if (tmpBufferRawYUVDataCaching.isEmpty())
   {
     // Loading failed
     DEBUG_YUV("videoHandlerYUV::loadFrameForCaching Loading failed");
@@ -1826,22 +1688,15 @@ bool videoHandlerYUV::loadRawYUVData(int frameIndex)
 
   DEBUG_YUV("videoHandlerYUV::loadRawYUVData %d", frameIndex);
 
-  // The function loadFrameForCaching also uses the signalRequesRawYUVData to request raw data.
-  // However, only one thread can use this at a time.
-  requestDataMutex.lock();
-  emit signalRequestRawData(frameIndex, false);
-
-  if (frameIndex != rawData_frameIdx || rawData.isEmpty())
+  rawDataView frameData = requestRawData(frameIndex, false);
+  if (frameData.isEmpty())
   {
     // Loading failed
     DEBUG_YUV("videoHandlerYUV::loadRawYUVData Loading failed");
-    requestDataMutex.unlock();
     return false;
   }
 
-  currentFrameRawData = rawData;
-  currentFrameRawData_frameIdx = frameIndex;
-  requestDataMutex.unlock();
+  setCurrentFrameRawData(frameData, frameIndex);
   
   DEBUG_YUV("videoHandlerYUV::loadRawYUVData %d Done", frameIndex);
   return true;
@@ -2218,18 +2073,18 @@ inline void UVPlaneResamplingChromaOffset(const yuvPixelFormat format, const int
   const bool bigEndian = format.bigEndian;
   const int bps = format.bitsPerSample;
 
-  const int stride = bps > 8 ? w*2 : w;
   if (offsetX8 != 0)
   {
     // Perform horizontal re-sampling
     for (int y = 0; y < h; y++)
     {
       // On the left side, there is no previous sample, so the first value is never changed.
-      const int srcIdx = y * stride * inValSkip;
+      // All indices are in samples. getValueFromSource/setValueInBuffer take care of the bytes per sample.
+      const int srcIdx = y * w * inValSkip;
       int prevU = getValueFromSource(srcU, srcIdx, bps, bigEndian);
       int prevV = getValueFromSource(srcV, srcIdx, bps, bigEndian);
-      setValueInBuffer(dstU, prevU, y*stride, bps, bigEndian);
-      setValueInBuffer(dstV, prevV, y*stride, bps, bigEndian);
+      setValueInBuffer(dstU, prevU, y*w, bps, bigEndian);
+      setValueInBuffer(dstV, prevV, y*w, bps, bigEndian);
 
       for (int x = 0; x < w-1; x++)
       {
@@ -2241,8 +2096,8 @@ inline void UVPlaneResamplingChromaOffset(const yuvPixelFormat format, const int
         // Perform interpolation and save the value for the current UV value. Goto next value.
         int newU = interpolateUV8Pos(prevU, curU, offsetX8);
         int newV = interpolateUV8Pos(prevV, curV, offsetX8);
-        setValueInBuffer(dstU, newU, y*stride+x, bps, bigEndian);
-        setValueInBuffer(dstV, newV, y*stride+x, bps, bigEndian);
+        setValueInBuffer(dstU, newU, y*w+x+1, bps, bigEndian);
+        setValueInBuffer(dstV, newV, y*w+x+1, bps, bigEndian);
 
         prevU = curU;
         prevV = curV;
@@ -2286,36 +2141,64 @@ inline void UVPlaneResamplingChromaOffset(const yuvPixelFormat format, const int
   }
 }
 
-inline void YUVPlaneToRGB_444(const int componentSize, const yuvMathParameters mathY, const yuvMathParameters mathC,
-                              const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
-                              unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const int inMax, const int bps, const bool bigEndian, const int inValSkip)
+// Up-sample one line of chroma samples horizontally by a factor of 2. Every second sample is interpolated
+// from its neighbors (or held). For the last sample there is no right neighbor, so it is always held.
+inline void upsampleChromaLineHor(const int * restrict src, int * restrict dst, const int widthChroma, const InterpolationMode interpolation)
 {
-  const bool applyMathLuma = mathY.yuvMathRequired();
-  const bool applyMathChroma = mathC.yuvMathRequired();
+  for (int x = 0; x < widthChroma-1; x++)
+  {
+    dst[x*2  ] = src[x];
+    dst[x*2+1] = interpolateUVSample(interpolation, src[x], src[x+1]);
+  }
+  dst[widthChroma*2-2] = src[widthChroma-1];
+  dst[widthChroma*2-1] = src[widthChroma-1];
+}
 
-  for (int i = 0; i < componentSize; ++i)
+// Up-sample the chroma line in between the two given chroma lines (horizontally and vertically by a factor of 2).
+inline void upsampleChromaLineHorVer(const int * restrict src0, const int * restrict src1, int * restrict dst, const int widthChroma, const InterpolationMode interpolation)
+{
+  for (int x = 0; x < widthChroma-1; x++)
   {
-    unsigned int valY = getValueFromSource(srcY, i, bps, bigEndian);
-    unsigned int valU = getValueFromSource(srcU, i*inValSkip, bps, bigEndian);
-    unsigned int valV = getValueFromSource(srcV, i*inValSkip, bps, bigEndian);
+    dst[x*2  ] = interpolateUVSample(interpolation, src0[x], src1[x]);
+    dst[x*2+1] = interpolateUVSample2D(interpolation, src0[x], src0[x+1], src1[x], src1[x+1]);
+  }
+  const int lastValue = interpolateUVSample(interpolation, src0[widthChroma-1], src1[widthChroma-1]);
+  dst[widthChroma*2-2] = lastValue;
+  dst[widthChroma*2-1] = lastValue;
+}
 
-    if (applyMathLuma)
-      valY = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY, inMax);
-    if (applyMathChroma)
-    {
-      valU = transformYUV(mathC.invert, mathC.scale, mathC.offset, valU, inMax);
-      valV = transformYUV(mathC.invert, mathC.scale, mathC.offset, valV, inMax);
-    }
+// Read count samples from src into dst and apply the YUV math (if required).
+inline void readSamplesAndApplyMath(const lineKernels &kernels, const unsigned char * restrict src, int * restrict dst, const int count, const int inValSkip,
+                                    const int bps, const bool bigEndian, const yuvMathParameters math, const int inMax)
+{
+  kernels.readSamples(src, dst, count, inValSkip, bps, bigEndian);
+  if (math.yuvMathRequired())
+    kernels.applyMath(dst, count, math.scale, math.offset, math.invert, inMax);
+}
 
-    // Get the RGB values for this sample
-    int valR, valG, valB;
-    convertYUVToRGB8Bit(valY, valU, valV, valR, valG, valB, RGBConv, fullRange, bps);
+inline void YUVPlaneToRGB_444(const int componentSize, const yuvMathParameters mathY, const yuvMathParameters mathC,
+                              const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
+                              unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const int inMax, const int bps, const bool bigEndian, const int inValSkip)
+{
+  const lineKernels &kernels = getLineKernels();
+  const lineConversionParameters param = getLineConversionParameters(RGBConv, fullRange, bps);
+  const int bytesPerSample = (bps > 8) ? 2 : 1;
 
-    // Save the RGB values
-    dst[i*4  ] = valB;
-    dst[i*4+1] = valG;
-    dst[i*4+2] = valR;
-    dst[i*4+3] = 255;
+  // There is no up-sampling, so we can process the planes in blocks of any size. The block size
+  // is chosen so that the intermediate buffers stay in the cache.
+  const int blockSize = 4096;
+  QVector<int> buffer(blockSize*3);
+  int *valY = buffer.data();
+  int *valU = valY + blockSize;
+  int *valV = valU + blockSize;
+
+  for (int i = 0; i < componentSize; i += blockSize)
+  {
+    const int count = std::min(blockSize, componentSize - i);
+    readSamplesAndApplyMath(kernels, srcY + i*bytesPerSample, valY, count, 1, bps, bigEndian, mathY, inMax);
+    readSamplesAndApplyMath(kernels, srcU + i*inValSkip*bytesPerSample, valU, count, inValSkip, bps, bigEndian, mathC, inMax);
+    readSamplesAndApplyMath(kernels, srcV + i*inValSkip*bytesPerSample, valV, count, inValSkip, bps, bigEndian, mathC, inMax);
+    kernels.convertLineToBGRA(valY, valU, valV, dst + i*4, count, param);
   }
 }
 
@@ -2323,88 +2206,29 @@ inline void YUVPlaneToRGB_422(const int w, const int h, const yuvMathParameters
                               const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
                               unsigned char * restrict dst, const int RGBConv[5], const bool fullRange, const int inMax, const InterpolationMode interpolation, const int bps, const bool bigEndian, const int inValSkip)
 {
-  const bool applyMathLuma = mathY.yuvMathRequired();
-  const bool applyMathChroma = mathC.yuvMathRequired();
-  // Horizontal up-sampling is required. Process two Y values at a time
-  for (int y = 0; y < h; y++)
-  {
-    const int srcIdxUV = y*w/2;
-    int curUSample = getValueFromSource(srcU, srcIdxUV*inValSkip, bps, bigEndian);
-    int curVSample = getValueFromSource(srcV, srcIdxUV*inValSkip, bps, bigEndian);
-    if (applyMathChroma)
-    {
-      curUSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, curUSample, inMax);
-      curVSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, curVSample, inMax);
-    }
-
-    for (int x = 0; x < (w/2)-1; x++)
-    {
-      // Get the next U/V sample
-      const int srcPosLineUV = srcIdxUV + x + 1;
-      int nextUSample = getValueFromSource(srcU, srcPosLineUV*inValSkip, bps, bigEndian);
-      int nextVSample = getValueFromSource(srcV, srcPosLineUV*inValSkip, bps, bigEndian);
-      if (applyMathChroma)
-      {
-        nextUSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextUSample, inMax);
-        nextVSample = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextVSample, inMax);
-      }
-
-      // From the current and the next U/V sample, interpolate the UV sample in between
-      int interpolatedU = interpolateUVSample(interpolation, curUSample, nextUSample);
-      int interpolatedV = interpolateUVSample(interpolation, curVSample, nextVSample);
-
-      // Get the 2 Y samples
-      int valY1 = getValueFromSource(srcY, y*w+x*2,   bps, bigEndian);
-      int valY2 = getValueFromSource(srcY, y*w+x*2+1, bps, bigEndian);
-      if (applyMathLuma)
-      {
-        valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-        valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-      }
-
-      // Convert to 2 RGB values and save them (BGRA)
-      int valR1, valR2, valG1, valG2, valB1, valB2;
-      convertYUVToRGB8Bit(valY1, curUSample   , curVSample   , valR1, valG1, valB1, RGBConv, fullRange, bps);
-      convertYUVToRGB8Bit(valY2, interpolatedU, interpolatedV, valR2, valG2, valB2, RGBConv, fullRange, bps);
-      const int pos = (y*w+x*2)*4;
-      dst[pos  ] = valB1;
-      dst[pos+1] = valG1;
-      dst[pos+2] = valR1;
-      dst[pos+3] = 255;
-      dst[pos+4] = valB2;
-      dst[pos+5] = valG2;
-      dst[pos+6] = valR2;
-      dst[pos+7] = 255;
-
-      // The next one is now the current one
-      curUSample = nextUSample;
-      curVSample = nextVSample;
-    }
+  const lineKernels &kernels = getLineKernels();
+  const lineConversionParameters param = getLineConversionParameters(RGBConv, fullRange, bps);
+  const int bytesPerSample = (bps > 8) ? 2 : 1;
+  const int wh = w/2;
 
-    // For the last row, there is no next sample. Just reuse the current one again. No interpolation required either.
+  // One line of Y, U and V in luma resolution and one line of U and V in chroma resolution
+  QVector<int> buffer(w*3 + wh*2);
+  int *valY = buffer.data();
+  int *valU = valY + w;
+  int *valV = valU + w;
+  int *chromaU = valV + w;
+  int *chromaV = chromaU + wh;
 
-    // Get the 2 Y samples
-    int valY1 = getValueFromSource(srcY, (y+1)*w-2, bps, bigEndian);
-    int valY2 = getValueFromSource(srcY, (y+1)*w-1, bps, bigEndian);
-    if (applyMathLuma)
-    {
-      valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-      valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-    }
+  // Horizontal up-sampling is required. Process one line at a time.
+  for (int y = 0; y < h; y++)
+  {
+    readSamplesAndApplyMath(kernels, srcU + y*wh*inValSkip*bytesPerSample, chromaU, wh, inValSkip, bps, bigEndian, mathC, inMax);
+    readSamplesAndApplyMath(kernels, srcV + y*wh*inValSkip*bytesPerSample, chromaV, wh, inValSkip, bps, bigEndian, mathC, inMax);
+    upsampleChromaLineHor(chromaU, valU, wh, interpolation);
+    upsampleChromaLineHor(chromaV, valV, wh, interpolation);
 
-    // Convert to 2 RGB values and save them
-    int valR1, valR2, valG1, valG2, valB1, valB2;
-    convertYUVToRGB8Bit(valY1, curUSample, curVSample, valR1, valG1, valB1, RGBConv, fullRange, bps);
-    convertYUVToRGB8Bit(valY2, curUSample, curVSample, valR2, valG2, valB2, RGBConv, fullRange, bps);
-    const int pos = ((y+1)*w)*4;
-    dst[pos-8] = valB1;
-    dst[pos-7] = valG1;
-    dst[pos-6] = valR1;
-    dst[pos-5] = 255;
-    dst[pos-4] = valB2;
-    dst[pos-3] = valG2;
-    dst[pos-2] = valR2;
-    dst[pos-1] = 255;
+    readSamplesAndApplyMath(kernels, srcY + y*w*bytesPerSample, valY, w, 1, bps, bigEndian, mathY, inMax);
+    kernels.convertLineToBGRA(valY, valU, valV, dst + y*w*4, w, param);
   }
 }
 
@@ -2503,256 +2327,53 @@ inline void YUVPlaneToRGB_420(const int w, const int h, const yuvMathParameters
                               const unsigned char * restrict srcY, const unsigned char * restrict srcU, const unsigned char * restrict srcV,
                               unsigned char * restrict dst, const int RGBConv[5], const bool fullRange,const int inMax, const InterpolationMode interpolation, const int bps, const bool bigEndian, const int inValSkip)
 {
-  const bool applyMathLuma = mathY.yuvMathRequired();
-  const bool applyMathChroma = mathC.yuvMathRequired();
-  // Format is YUV 4:2:0. Horizontal and vertical up-sampling is required. Process 4 Y positions at a time
+  const lineKernels &kernels = getLineKernels();
+  const lineConversionParameters param = getLineConversionParameters(RGBConv, fullRange, bps);
+  const int bytesPerSample = (bps > 8) ? 2 : 1;
   const int hh = h/2; // The half values
   const int wh = w/2;
-  for (int y = 0; y < hh-1; y++)
-  {
-    // Get the current U/V samples for this y line and the next one (_NL)
-    const int srcIdxUV0 = y*wh;
-    const int srcIdxUV1 = (y+1)*wh;
-    int curU    = getValueFromSource(srcU, srcIdxUV0*inValSkip, bps, bigEndian);
-    int curV    = getValueFromSource(srcV, srcIdxUV0*inValSkip, bps, bigEndian);
-    int curU_NL = getValueFromSource(srcU, srcIdxUV1*inValSkip, bps, bigEndian);
-    int curV_NL = getValueFromSource(srcV, srcIdxUV1*inValSkip, bps, bigEndian);
-    if (applyMathChroma)
-    {
-      curU    = transformYUV(mathC.invert, mathC.scale, mathC.offset, curU, inMax);
-      curV    = transformYUV(mathC.invert, mathC.scale, mathC.offset, curV, inMax);
-      curU_NL = transformYUV(mathC.invert, mathC.scale, mathC.offset, curU_NL, inMax);
-      curV_NL = transformYUV(mathC.invert, mathC.scale, mathC.offset, curV_NL, inMax);
-    }
-
-    for (int x = 0; x < wh-1; x++)
-    {
-      // Get the next U/V sample for this line and the next one
-      const int srcIdxUVLine0 = srcIdxUV0 + x + 1;
-      const int srcIdxUVLine1 = srcIdxUV1 + x + 1;
-      int nextU    = getValueFromSource(srcU, srcIdxUVLine0*inValSkip, bps, bigEndian);
-      int nextV    = getValueFromSource(srcV, srcIdxUVLine0*inValSkip, bps, bigEndian);
-      int nextU_NL = getValueFromSource(srcU, srcIdxUVLine1*inValSkip, bps, bigEndian);
-      int nextV_NL = getValueFromSource(srcV, srcIdxUVLine1*inValSkip, bps, bigEndian);
-      if (applyMathChroma)
-      {
-        nextU    = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextU, inMax);
-        nextV    = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextV, inMax);
-        nextU_NL = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextU_NL, inMax);
-        nextV_NL = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextV_NL, inMax);
-      }
-
-      // From the current and the next U/V sample, interpolate the 3 UV samples in between
-      int interpolatedU_Hor = interpolateUVSample(interpolation, curU, nextU);  // Horizontal interpolation
-      int interpolatedV_Hor = interpolateUVSample(interpolation, curV, nextV);
-      int interpolatedU_Ver = interpolateUVSample(interpolation, curU, curU_NL);  // Vertical interpolation
-      int interpolatedV_Ver = interpolateUVSample(interpolation, curV, curV_NL);
-      int interpolatedU_Bi  = interpolateUVSample2D(interpolation, curU, nextU, curU_NL, nextU_NL);   // 2D interpolation
-      int interpolatedV_Bi  = interpolateUVSample2D(interpolation, curV, nextV, curV_NL, nextV_NL);   // 2D interpolation
-
-      // Get the 4 Y samples
-      int valY1 = getValueFromSource(srcY, (y*w+x)*2,   bps, bigEndian);
-      int valY2 = getValueFromSource(srcY, (y*w+x)*2+1, bps, bigEndian);
-      int valY3 = getValueFromSource(srcY, (y*2+1)*w+x*2,   bps, bigEndian);
-      int valY4 = getValueFromSource(srcY, (y*2+1)*w+x*2+1, bps, bigEndian);
-      if (applyMathLuma)
-      {
-        valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-        valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-        valY3 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY3, inMax);
-        valY4 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY4, inMax);
-      }
 
-      // Convert to 4 RGB values and save them
-      int valR1, valR2, valG1, valG2, valB1, valB2;
-      convertYUVToRGB8Bit(valY1, curU             , curV             , valR1, valG1, valB1, RGBConv, fullRange, bps);
-      convertYUVToRGB8Bit(valY2, interpolatedU_Hor, interpolatedV_Hor, valR2, valG2, valB2, RGBConv, fullRange, bps);
-      const int pos1 = (y*2*w+x*2)*4;
-      dst[pos1  ] = valB1;
-      dst[pos1+1] = valG1;
-      dst[pos1+2] = valR1;
-      dst[pos1+3] = 255;
-      dst[pos1+4] = valB2;
-      dst[pos1+5] = valG2;
-      dst[pos1+6] = valR2;
-      dst[pos1+7] = 255;
-      convertYUVToRGB8Bit(valY3, interpolatedU_Ver, interpolatedV_Ver, valR1, valG1, valB1, RGBConv, fullRange, bps);  // Second line
-      convertYUVToRGB8Bit(valY4, interpolatedU_Bi , interpolatedV_Bi , valR2, valG2, valB2, RGBConv, fullRange, bps);
-      const int pos2 = pos1 + w*4;  // Next line
-      dst[pos2  ] = valB1;
-      dst[pos2+1] = valG1;
-      dst[pos2+2] = valR1;
-      dst[pos2+3] = 255;
-      dst[pos2+4] = valB2;
-      dst[pos2+5] = valG2;
-      dst[pos2+6] = valR2;
-      dst[pos2+7] = 255;
+  // One line of Y, U and V in luma resolution and two lines (the current and the next one) of U and V in chroma resolution
+  QVector<int> buffer(w*3 + wh*4);
+  int *valY = buffer.data();
+  int *valU = valY + w;
+  int *valV = valU + w;
+  int *curU = valV + w;
+  int *curV = curU + wh;
+  int *nextU = curV + wh;
+  int *nextV = nextU + wh;
 
-      // The next one is now the current one
-      curU = nextU;
-      curV = nextV;
-      curU_NL = nextU_NL;
-      curV_NL = nextV_NL;
-    }
-
-    // For the last x value (the right border), there is no next value. Just sample and hold. Only vertical interpolation is required.
-    int interpolatedU_Ver = interpolateUVSample(interpolation, curU, curU_NL);  // Vertical interpolation
-    int interpolatedV_Ver = interpolateUVSample(interpolation, curV, curV_NL);
-
-    // Get the 4 Y samples
-    int valY1 = getValueFromSource(srcY, (y*2+1)*w-2, bps, bigEndian);
-    int valY2 = getValueFromSource(srcY, (y*2+1)*w-1, bps, bigEndian);
-    int valY3 = getValueFromSource(srcY, (y*2+2)*w-2, bps, bigEndian);
-    int valY4 = getValueFromSource(srcY, (y*2+2)*w-1, bps, bigEndian);
-    if (applyMathLuma)
-    {
-      valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-      valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-      valY3 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY3, inMax);
-      valY4 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY4, inMax);
-    }
-
-    // Convert to 4 RGB values and save them
-    int valR1, valR2, valG1, valG2, valB1, valB2;
-    convertYUVToRGB8Bit(valY1, curU, curV, valR1, valG1, valB1, RGBConv, fullRange, bps);
-    convertYUVToRGB8Bit(valY2, curU, curV, valR2, valG2, valB2, RGBConv, fullRange, bps);
-    const int pos1 = ((y*2+1)*w)*4;
-    dst[pos1-8] = valB1;
-    dst[pos1-7] = valG1;
-    dst[pos1-6] = valR1;
-    dst[pos1-5] = 255;
-    dst[pos1-4] = valB2;
-    dst[pos1-3] = valG2;
-    dst[pos1-2] = valR2;
-    dst[pos1-1] = 255;
-    convertYUVToRGB8Bit(valY3, interpolatedU_Ver, interpolatedV_Ver, valR1, valG1, valB1, RGBConv, fullRange, bps);  // Second line
-    convertYUVToRGB8Bit(valY4, interpolatedU_Ver, interpolatedV_Ver, valR2, valG2, valB2, RGBConv, fullRange, bps);
-    const int pos2 = pos1 + w*4;  // Next line
-    dst[pos2-8] = valB1;
-    dst[pos2-7] = valG1;
-    dst[pos2-6] = valR1;
-    dst[pos2-5] = 255;
-    dst[pos2-4] = valB2;
-    dst[pos2-3] = valG2;
-    dst[pos2-2] = valR2;
-    dst[pos2-1] = 255;
-  }
-
-  // At the last Y line (the bottom line) a similar scenario occurs. There is no next Y line. Just sample and hold. Only horizontal interpolation is required.
-
-  // Get the current U/V samples for this y line
-  const int y = hh-1;  // Just process the last y line
-  const int y2 = (hh-1)*2;
-
-  // Get 2 chroma samples from this line
-  const int srcIdxUV = y*wh;
-  int curU = getValueFromSource(srcU, srcIdxUV*inValSkip, bps, bigEndian);
-  int curV = getValueFromSource(srcV, srcIdxUV*inValSkip, bps, bigEndian);
-  if (applyMathChroma)
-  {
-    curU = transformYUV(mathC.invert, mathC.scale, mathC.offset, curU, inMax);
-    curV = transformYUV(mathC.invert, mathC.scale, mathC.offset, curV, inMax);
-  }
-
-  for (int x = 0; x < (w/2)-1; x++)
-  {
-    // Get the next U/V sample for this line and the next one
-    const int srcIdxLineUV = srcIdxUV + x + 1;
-    int nextU = getValueFromSource(srcU, srcIdxLineUV*inValSkip, bps, bigEndian);
-    int nextV = getValueFromSource(srcV, srcIdxLineUV*inValSkip, bps, bigEndian);
-    if (applyMathChroma)
+  // Format is YUV 4:2:0. Horizontal and vertical up-sampling is required. Process two luma lines per chroma line.
+  readSamplesAndApplyMath(kernels, srcU, curU, wh, inValSkip, bps, bigEndian, mathC, inMax);
+  readSamplesAndApplyMath(kernels, srcV, curV, wh, inValSkip, bps, bigEndian, mathC, inMax);
+  for (int y = 0; y < hh; y++)
+  {
+    // At the last chroma line (the bottom line), there is no next line. Just sample and hold. Only horizontal interpolation is required.
+    const bool lastLine = (y == hh-1);
+    if (!lastLine)
     {
-      nextU = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextU, inMax);
-      nextV = transformYUV(mathC.invert, mathC.scale, mathC.offset, nextV, inMax);
+      readSamplesAndApplyMath(kernels, srcU + (y+1)*wh*inValSkip*bytesPerSample, nextU, wh, inValSkip, bps, bigEndian, mathC, inMax);
+      readSamplesAndApplyMath(kernels, srcV + (y+1)*wh*inValSkip*bytesPerSample, nextV, wh, inValSkip, bps, bigEndian, mathC, inMax);
     }
 
-    // From the current and the next U/V sample, interpolate the 3 UV samples in between
-    int interpolatedU_Hor = interpolateUVSample(interpolation, curU, nextU);  // Horizontal interpolation
-    int interpolatedV_Hor = interpolateUVSample(interpolation, curV, nextV);
+    // The first luma line is at the position of the chroma samples
+    upsampleChromaLineHor(curU, valU, wh, interpolation);
+    upsampleChromaLineHor(curV, valV, wh, interpolation);
+    readSamplesAndApplyMath(kernels, srcY + y*2*w*bytesPerSample, valY, w, 1, bps, bigEndian, mathY, inMax);
+    kernels.convertLineToBGRA(valY, valU, valV, dst + y*2*w*4, w, param);
 
-    // Get the 4 Y samples
-    int valY1 = getValueFromSource(srcY, (y*w+x)*2,      bps, bigEndian);
-    int valY2 = getValueFromSource(srcY, (y*w+x)*2+1,    bps, bigEndian);
-    int valY3 = getValueFromSource(srcY, (y2+1)*w+x*2,   bps, bigEndian);
-    int valY4 = getValueFromSource(srcY, (y2+1)*w+x*2+1, bps, bigEndian);
-    if (applyMathLuma)
+    // The second luma line is in between this chroma line and the next one
+    if (!lastLine)
     {
-      valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-      valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-      valY3 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY3, inMax);
-      valY4 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY4, inMax);
+      upsampleChromaLineHorVer(curU, nextU, valU, wh, interpolation);
+      upsampleChromaLineHorVer(curV, nextV, valV, wh, interpolation);
     }
+    readSamplesAndApplyMath(kernels, srcY + (y*2+1)*w*bytesPerSample, valY, w, 1, bps, bigEndian, mathY, inMax);
+    kernels.convertLineToBGRA(valY, valU, valV, dst + (y*2+1)*w*4, w, param);
 
-    // Convert to 4 RGB values and save them
-    int valR1, valR2, valG1, valG2, valB1, valB2;
-    convertYUVToRGB8Bit(valY1, curU             , curV             , valR1, valG1, valB1, RGBConv, fullRange, bps);
-    convertYUVToRGB8Bit(valY2, interpolatedU_Hor, interpolatedV_Hor, valR2, valG2, valB2, RGBConv, fullRange, bps);
-    const int pos1 = (y2*w+x*2)*4;
-    dst[pos1  ] = valB1;
-    dst[pos1+1] = valG1;
-    dst[pos1+2] = valR1;
-    dst[pos1+3] = 255;
-    dst[pos1+4] = valB2;
-    dst[pos1+5] = valG2;
-    dst[pos1+6] = valR2;
-    dst[pos1+7] = 255;
-    convertYUVToRGB8Bit(valY3, curU             , curV             , valR1, valG1, valB1, RGBConv, fullRange, bps);  // Second line
-    convertYUVToRGB8Bit(valY4, interpolatedU_Hor, interpolatedV_Hor, valR2, valG2, valB2, RGBConv, fullRange, bps);
-    const int pos2 = pos1 + w*4;  // Next line
-    dst[pos2  ] = valB1;
-    dst[pos2+1] = valG1;
-    dst[pos2+2] = valR1;
-    dst[pos2+3] = 255;
-    dst[pos2+4] = valB2;
-    dst[pos2+5] = valG2;
-    dst[pos2+6] = valR2;
-    dst[pos2+7] = 255;
-
-    // The next one is now the current one
-    curU = nextU;
-    curV = nextV;
-  }
-
-  // For the last x value in the last y row (the right bottom), there is no next value in neither direction.
-  // Just sample and hold. No interpolation is required.
-
-  // Get the 4 Y samples
-  int valY1 = getValueFromSource(srcY, (y2+1)*w-2, bps, bigEndian);
-  int valY2 = getValueFromSource(srcY, (y2+1)*w-1, bps, bigEndian);
-  int valY3 = getValueFromSource(srcY, (y2+2)*w-2, bps, bigEndian);
-  int valY4 = getValueFromSource(srcY, (y2+2)*w-1, bps, bigEndian);
-  if (applyMathLuma)
-  {
-    valY1 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY1, inMax);
-    valY2 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY2, inMax);
-    valY3 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY3, inMax);
-    valY4 = transformYUV(mathY.invert, mathY.scale, mathY.offset, valY4, inMax);
-  }
-
-  // Convert to 4 RGB values and save them
-  int valR1, valR2, valG1, valG2, valB1, valB2;
-  convertYUVToRGB8Bit(valY1, curU, curV, valR1, valG1, valB1, RGBConv, fullRange, bps);
-  convertYUVToRGB8Bit(valY2, curU, curV, valR2, valG2, valB2, RGBConv, fullRange, bps);
-  const int pos1 = (y2+1)*w*4;
-  dst[pos1-8] = valB1;
-  dst[pos1-7] = valG1;
-  dst[pos1-6] = valR1;
-  dst[pos1-5] = 255;
-  dst[pos1-4] = valB2;
-  dst[pos1-3] = valG2;
-  dst[pos1-2] = valR2;
-  dst[pos1-1] = 255;
-  convertYUVToRGB8Bit(valY3, curU, curV, valR1, valG1, valB1, RGBConv, fullRange, bps);  // Second line
-  convertYUVToRGB8Bit(valY4, curU, curV, valR2, valG2, valB2, RGBConv, fullRange, bps);
-  const int pos2 = pos1 + w*4;  // Next line
-  dst[pos2-8] = valB1;
-  dst[pos2-7] = valG1;
-  dst[pos2-6] = valR1;
-  dst[pos2-5] = 255;
-  dst[pos2-4] = valB2;
-  dst[pos2-3] = valG2;
-  dst[pos2-2] = valR2;
-  dst[pos2-1] = 255;
+    std::swap(curU, nextU);
+    std::swap(curV, nextV);
+  }
 }
 
 inline void YUVPlaneToRGB_410(const int w, const int h, const yuvMathParameters mathY, const yuvMathParameters mathC,
@@ -2963,7 +2584,7 @@ inline void YUVPlaneToRGB_411(const int w, const int h, const yuvMathParameters
   }
 }
 
-bool videoHandlerYUV::convertYUVPackedToPlanar(const QByteArray &sourceBuffer, QByteArray &targetBuffer, const QSize &curFrameSize, yuvPixelFormat &sourceBufferFormat)
+bool videoHandlerYUV::convertYUVPackedToPlanar(const rawDataView &sourceBuffer, QByteArray &targetBuffer, const QSize &curFrameSize, yuvPixelFormat &sourceBufferFormat)
 {
   const yuvPixelFormat format = sourceBufferFormat;
   const YUVPackingOrder packing = format.packingOrder;
@@ -3076,7 +2697,7 @@ bool videoHandlerYUV::convertYUVPackedToPlanar(const QByteArray &sourceBuffer, Q
   return true;
 }
 
-bool videoHandlerYUV::convertYUVPlanarToRGB(const QByteArray &sourceBuffer, uchar *targetBuffer, const QSize &curFrameSize, const yuvPixelFormat &sourceBufferFormat) const
+bool videoHandlerYUV::convertYUVPlanarToRGB(const rawDataView &sourceBuffer, uchar *targetBuffer, const QSize &curFrameSize, const yuvPixelFormat &sourceBufferFormat) const
 {
   // These are constant for the runtime of this function. This way, the compiler can optimize the
   // hell out of this function.
@@ -3241,7 +2862,7 @@ bool videoHandlerYUV::convertYUVPlanarToRGB(const QByteArray &sourceBuffer, ucha
 
 // Convert the given raw YUV data in sourceBuffer (using srcPixelFormat) to image (RGB-888), using the
 // buffer tmpRGBBuffer for intermediate RGB values.
-void videoHandlerYUV::convertYUVToImage(const QByteArray &sourceBuffer, QImage &outputImage, const yuvPixelFormat &yuvFormat, const QSize &curFrameSize)
+void videoHandlerYUV::convertYUVToImage(const rawDataView &sourceBuffer, QImage &outputImage, const yuvPixelFormat &yuvFormat, const QSize &curFrameSize)
 {
   if (!canConvertToRGB(yuvFormat, curFrameSize))
   {
@@ -3404,132 +3025,20 @@ videoHandlerYUV::yuv_t videoHandlerYUV::getPixelValue(const QPoint &pixelPos) co
 // This is a specialized function that can convert 8-bit YUV 4:2:0 to RGB888 using NearestNeighborInterpolation.
 // The chroma must be 0 in x direction and 1 in y direction. No yuvMath is supported.
 // TODO: Correct the chroma subsampling offset.
-#if SSE_CONVERSION
-bool videoHandlerYUV::convertYUV420ToRGB(const byteArrayAligned &sourceBuffer, byteArrayAligned &targetBuffer)
-#else
-bool videoHandlerYUV::convertYUV420ToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &size, const yuvPixelFormat format)
-#endif
+bool videoHandlerYUV::convertYUV420ToRGB(const rawDataView &sourceBuffer, unsigned char *targetBuffer, const QSize &size, const yuvPixelFormat format)
 {
   const int frameWidth = size.width();
   const int frameHeight = size.height();
 
   // For 4:2:0, w and h must be dividible by 2
   assert(frameWidth % 2 == 0 && frameHeight % 2 == 0);
-  
+
   int componentLenghtY  = frameWidth * frameHeight;
   int componentLengthUV = componentLenghtY >> 2;
   Q_ASSERT(sourceBuffer.size() >= componentLenghtY + componentLengthUV + componentLengthUV); // YUV 420 must be (at least) 1.5*Y-area
 
-#if SSE_CONVERSION_420_ALT
-  quint8 *srcYRaw = (quint8*) sourceBuffer.data();
-  quint8 *srcURaw = srcYRaw + componentLenghtY;
-  quint8 *srcVRaw = srcURaw + componentLengthUV;
-
-  quint8 *dstBuffer = (quint8*)targetBuffer.data();
-  quint32 dstBufferStride = frameWidth*4;
-
-  yuv420_to_argb8888(srcYRaw,srcURaw,srcVRaw,frameWidth,frameWidth>>1,frameWidth,frameHeight,dstBuffer,dstBufferStride);
-  return false;
-#endif
-
-#if SSE_CONVERSION
-  // Try to use SSE. If this fails use conventional algorithm
-
-  if (frameWidth % 32 == 0 && frameHeight % 2 == 0)
-  {
-    // We can use 16byte aligned read/write operations
-
-    quint8 *srcY = (quint8*) sourceBuffer.data();
-    quint8 *srcU = srcY + componentLenghtY;
-    quint8 *srcV = srcU + componentLengthUV;
-
-    __m128i yMult  = _mm_set_epi16(75, 75, 75, 75, 75, 75, 75, 75);
-    __m128i ySub   = _mm_set_epi16(16, 16, 16, 16, 16, 16, 16, 16);
-    __m128i ugMult = _mm_set_epi16(25, 25, 25, 25, 25, 25, 25, 25);
-    //__m128i sub16  = _mm_set_epi8(16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16, 16);
-    __m128i sub128 = _mm_set_epi8(128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128);
-
-    //__m128i test = _mm_set_epi8(128, 0, 1, 2, 3, 245, 254, 255, 128, 128, 128, 128, 128, 128, 128, 128);
-
-    __m128i y, u, v, uMult, vMult;
-    __m128i RGBOut0, RGBOut1, RGBOut2;
-    __m128i tmp;
-
-    for (int yh=0; yh < frameHeight / 2; yh++)
-    {
-      for (int x=0; x < frameWidth / 32; x+=32)
-      {
-        // Load 16 bytes U/V
-        u  = _mm_load_si128((__m128i *) &srcU[x / 2]);
-        v  = _mm_load_si128((__m128i *) &srcV[x / 2]);
-        // Subtract 128 from each U/V value (16 values)
-        u = _mm_sub_epi8(u, sub128);
-        v = _mm_sub_epi8(v, sub128);
-
-        // Load 16 bytes Y from this line and the next one
-        y = _mm_load_si128((__m128i *) &srcY[x]);
-
-        // Get the lower 8 (8bit signed) Y values and put them into a 16bit register
-        tmp = _mm_srai_epi16(_mm_unpacklo_epi8(y, y), 8);
-        // Subtract 16 and multiply by 75
-        tmp = _mm_sub_epi16(tmp, ySub);
-        tmp = _mm_mullo_epi16(tmp, yMult);
-
-        // Now to add them to the 16 bit RGB output values
-        RGBOut0 = _mm_shuffle_epi32(tmp, _MM_SHUFFLE(1, 0, 1, 0));
-        RGBOut0 = _mm_shufflelo_epi16(RGBOut0, _MM_SHUFFLE(1, 0, 0, 0));
-        RGBOut0 = _mm_shufflehi_epi16(RGBOut0, _MM_SHUFFLE(2, 2, 1, 1));
-
-        RGBOut1 = _mm_shuffle_epi32(tmp, _MM_SHUFFLE(2, 1, 2, 1));
-        RGBOut1 = _mm_shufflelo_epi16(RGBOut1, _MM_SHUFFLE(1, 1, 1, 0));
-        RGBOut1 = _mm_shufflehi_epi16(RGBOut1, _MM_SHUFFLE(3, 2, 2, 2));
-
-        RGBOut2 = _mm_shuffle_epi32(tmp, _MM_SHUFFLE(3, 2, 3, 2));
-        RGBOut2 = _mm_shufflelo_epi16(RGBOut2, _MM_SHUFFLE(2, 2, 1, 1));
-        RGBOut2 = _mm_shufflehi_epi16(RGBOut2, _MM_SHUFFLE(3, 3, 3, 2));
-
-        //y2 = _mm_load_si128((__m128i *) &srcY[x + 16]);
-
-        // --- Start with the left 8 values from U/V
-
-        // Get the lower 8 (8bit signed) U/V values and put them into a 16bit register
-        uMult = _mm_srai_epi16(_mm_unpacklo_epi8(u, u), 8);
-        vMult = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
-
-        // Multiply
-
-
-        /*y3 = _mm_load_si128((__m128i *) &srcY[x + frameWidth]);
-        y4 = _mm_load_si128((__m128i *) &srcY[x + frameWidth + 16]);*/
-      }
-    }
-
-    return true;
-  }
-#endif
-
-  // Perform software based 420 to RGB conversion
-  static unsigned char clp_buf[384+256+384];
-  static unsigned char *clip_buf = clp_buf+384;
-  static bool clp_buf_initialized = false;
-
-  if (!clp_buf_initialized)
-  {
-    // Initialize clipping table. Because of the static bool, this will only be called once.
-    memset(clp_buf, 0, 384);
-    int i;
-    for (i = 0; i < 256; i++)
-      clp_buf[384+i] = i;
-    memset(clp_buf+384+256, 255, 384);
-    clp_buf_initialized = true;
-  }
-
-  unsigned char * restrict dst = targetBuffer;
-
   // Get/set the parameters used for YUV -> RGB conversion
   const bool fullRange = (yuvColorConversionType == BT709_FullRange || yuvColorConversionType == BT601_FullRange || yuvColorConversionType == BT2020_FullRange);
-  const int yOffset = (fullRange ? 0 : 16);
-  const int cZero = 128;
   const int RGBConv[5] = { 
     yuvRgbConvCoeffs[yuvColorConversionType][0],
     yuvRgbConvCoeffs[yuvColorConversionType][1],
@@ -3544,179 +3053,42 @@ bool videoHandlerYUV::convertYUV420ToRGB(const QByteArray &sourceBuffer, unsigne
   const unsigned char * restrict srcU = uPplaneFirst ? srcY + componentLenghtY : srcY + componentLenghtY + componentLengthUV;
   const unsigned char * restrict srcV = uPplaneFirst ? srcY + componentLenghtY + componentLengthUV : srcY + componentLenghtY;
 
-  int yh;
-  for (yh=0; yh < frameHeight / 2; yh++)
-  {
-    // Process two lines at once, always 4 RGB values at a time (they have the same U/V components)
-
-    int dstAddr1 = yh * 2 * frameWidth * 4;         // The RGB output address of line yh*2
-    int dstAddr2 = (yh * 2 + 1) * frameWidth * 4;   // The RGB output address of line yh*2+1
-    int srcAddrY1 = yh * 2 * frameWidth;            // The Y source address of line yh*2
-    int srcAddrY2 = (yh * 2 + 1) * frameWidth;      // The Y source address of line yh*2+1
-    int srcAddrUV = yh * frameWidth / 2;            // The UV source address of both lines (UV are identical)
-
-    for (int xh=0, x=0; xh < frameWidth / 2; xh++, x+=2)
-    {
-      // Process four pixels (the ones for which U/V are valid
-
-      // Load UV and pre-multiply
-      const int U_tmp_G = ((int)srcU[srcAddrUV + xh] - cZero) * RGBConv[2];
-      const int U_tmp_B = ((int)srcU[srcAddrUV + xh] - cZero) * RGBConv[4];
-      const int V_tmp_R = ((int)srcV[srcAddrUV + xh] - cZero) * RGBConv[1];
-      const int V_tmp_G = ((int)srcV[srcAddrUV + xh] - cZero) * RGBConv[3];
-
-      // Pixel top left
-      {
-        const int Y_tmp = ((int)srcY[srcAddrY1 + x] - yOffset) * RGBConv[0];
-
-        const int R_tmp = (Y_tmp           + V_tmp_R) >> 16;
-        const int G_tmp = (Y_tmp + U_tmp_G + V_tmp_G) >> 16;
-        const int B_tmp = (Y_tmp + U_tmp_B          ) >> 16;
-
-        dst[dstAddr1]   = clip_buf[B_tmp];
-        dst[dstAddr1+1] = clip_buf[G_tmp];
-        dst[dstAddr1+2] = clip_buf[R_tmp];
-        dst[dstAddr1+3] = 255;
-        dstAddr1 += 4;
-      }
-      // Pixel top right
-      {
-        const int Y_tmp = ((int)srcY[srcAddrY1 + x + 1] - yOffset) * RGBConv[0];
-
-        const int R_tmp = (Y_tmp           + V_tmp_R) >> 16;
-        const int G_tmp = (Y_tmp + U_tmp_G + V_tmp_G) >> 16;
-        const int B_tmp = (Y_tmp + U_tmp_B          ) >> 16;
-
-        dst[dstAddr1]   = clip_buf[B_tmp];
-        dst[dstAddr1+1] = clip_buf[G_tmp];
-        dst[dstAddr1+2] = clip_buf[R_tmp];
-        dst[dstAddr1+3] = 255;
-        dstAddr1 += 4;
-      }
-      // Pixel bottom left
-      {
-        const int Y_tmp = ((int)srcY[srcAddrY2 + x] - yOffset) * RGBConv[0];
-
-        const int R_tmp = (Y_tmp           + V_tmp_R) >> 16;
-        const int G_tmp = (Y_tmp + U_tmp_G + V_tmp_G) >> 16;
-        const int B_tmp = (Y_tmp + U_tmp_B          ) >> 16;
-
-        dst[dstAddr2]   = clip_buf[B_tmp];
-        dst[dstAddr2+1] = clip_buf[G_tmp];
-        dst[dstAddr2+2] = clip_buf[R_tmp];
-        dst[dstAddr2+3] = 255;
-        dstAddr2 += 4;
-      }
-      // Pixel bottom right
-      {
-        const int Y_tmp = ((int)srcY[srcAddrY2 + x + 1] - yOffset) * RGBConv[0];
-
-        const int R_tmp = (Y_tmp           + V_tmp_R) >> 16;
-        const int G_tmp = (Y_tmp + U_tmp_G + V_tmp_G) >> 16;
-        const int B_tmp = (Y_tmp + U_tmp_B          ) >> 16;
-
-        dst[dstAddr2]   = clip_buf[B_tmp];
-        dst[dstAddr2+1] = clip_buf[G_tmp];
-        dst[dstAddr2+2] = clip_buf[R_tmp];
-        dst[dstAddr2+3] = 255;
-        dstAddr2 += 4;
-      }
-    }
-  }
-
+  // Without interpolation and YUV math, this is just the generic conversion (using the vectorized line kernels)
+  // without the resampling of the chroma offset.
+  YUVPlaneToRGB_420(frameWidth, frameHeight, yuvMathParameters(), yuvMathParameters(), srcY, srcU, srcV, targetBuffer, RGBConv, fullRange, 255, NearestNeighborInterpolation, 8, false, 1);
   return true;
 }
 
-bool videoHandlerYUV::markDifferencesYUVPlanarToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &curFrameSize, const yuvPixelFormat &sourceBufferFormat) const
+YUV_Internals::yuvPixelFormat videoHandlerYUV::getDiffYUVFormat() const
 {
-  // These are constant for the runtime of this function. This way, the compiler can optimize the
-  // hell out of this function.
-  const yuvPixelFormat format = sourceBufferFormat;
-  const int w = curFrameSize.width();
-  const int h = curFrameSize.height();
-
-  const int bps = format.bitsPerSample;
-  const int cZero = 128<<(bps-8);
-
-  // Other bit depths not (yet) supported. w and h must be divisible by the subsampling.
-  assert(bps >=8 && bps <= 16 && (w % format.getSubsamplingHor()) == 0 && (h % format.getSubsamplingVer()) == 0);
-
-  // The luma component has full resolution. The size of each chroma components depends on the subsampling.
-  const int componentSizeLuma = (w * h);
-  const int componentSizeChroma = (w / format.getSubsamplingHor()) * (h / format.getSubsamplingVer());
-
-  // How many bytes are in each component?
-  const int nrBytesLumaPlane = (bps > 8) ? componentSizeLuma * 2 : componentSizeLuma;
-  const int nrBytesChromaPlane = (bps > 8) ? componentSizeChroma * 2 : componentSizeChroma;
-
-  // Is this big endian (actually the difference buffer should always be big endian)
-  const bool bigEndian = format.bigEndian;
-
-  // A pointer to the output
-  unsigned char * restrict dst = targetBuffer;
-
-  // Get the pointers to the source planes (8 bit per sample)
-  const unsigned char * restrict srcY = (unsigned char*)sourceBuffer.data();
-  const unsigned char * restrict srcU = (format.planeOrder == Order_YUV || format.planeOrder == Order_YUVA) ? srcY + nrBytesLumaPlane : srcY + nrBytesLumaPlane + nrBytesChromaPlane;
-  const unsigned char * restrict srcV = (format.planeOrder == Order_YUV || format.planeOrder == Order_YUVA) ? srcY + nrBytesLumaPlane + nrBytesChromaPlane: srcY + nrBytesLumaPlane;
-
-  const int sampleBlocksX = format.getSubsamplingHor();
-  const int sampleBlocksY = format.getSubsamplingVer();
-
-  const int strideC = w / sampleBlocksX;  // How many samples to the next y line?
-  for (int y = 0; y < h; y+=sampleBlocksY)
-    for (int x = 0; x < w; x+=sampleBlocksX)
-    {
-      // Get the U/V difference value. For all values within the sub-block this is constant.
-      int uvIndex = (y/sampleBlocksY)*strideC + x / sampleBlocksX;
-      int valU = getValueFromSource(srcU, uvIndex, bps, bigEndian);
-      int valV = getValueFromSource(srcV, uvIndex, bps, bigEndian);
-
-      for (int yInBlock = 0; yInBlock < sampleBlocksY; yInBlock++)
-      {
-        for (int xInBlock = 0; xInBlock < sampleBlocksX; xInBlock++)
-        {
-          // Get the Y difference value
-          int valY = getValueFromSource(srcY, (y+yInBlock)*w+x+xInBlock, bps, bigEndian);
-
-          //select RGB color
-          unsigned char R = 0,G = 0,B = 0;
-          if (valY == cZero)
-          {
-            G = (valU == cZero) ? 0 : 70;
-            B = (valV == cZero) ? 0 : 70;
-          }
-          else
-          {
-            // Y difference
-            if (valU == cZero && valV == cZero)
-            {
-              R = 70;
-              G = 70;
-              B = 70;
-            }
-            else
-            {
-              G = (valU == cZero) ? 0 : 255;
-              B = (valV == cZero) ? 0 : 255;
-            }
-          }
-
-          // Set the RGB value for the output
-          dst[((y+yInBlock)*w+x+xInBlock)*4  ] = B;
-          dst[((y+yInBlock)*w+x+xInBlock)*4+1] = G;
-          dst[((y+yInBlock)*w+x+xInBlock)*4+2] = R;
-          dst[((y+yInBlock)*w+x+xInBlock)*4+3] = 255;
-        }
-      }
-    }
-
-  return true;
+    return diffYUVFormat;
 }
 
-YUV_Internals::yuvPixelFormat videoHandlerYUV::getDiffYUVFormat() const
+QVector<int64_t> videoHandlerYUV::getRawPlaneSizes() const
 {
-    return diffYUVFormat;
+  const int64_t bytesPerFrame = getBytesPerFrame();
+  if (!srcPixelFormat.planar || bytesPerFrame <= 0)
+    return videoHandler::getRawPlaneSizes();
+
+  const int64_t bytesPerSample = (srcPixelFormat.bitsPerSample + 7) / 8;
+  const int64_t lumaSize = int64_t(frameSize.width()) * frameSize.height() * bytesPerSample;
+  const bool hasAlpha = (srcPixelFormat.planeOrder == Order_YUVA || srcPixelFormat.planeOrder == Order_YVUA);
+
+  QVector<int64_t> planeSizes;
+  planeSizes.append(lumaSize);
+  if (srcPixelFormat.uvInterleaved)
+  {
+    // The U, V (and A) samples are in one plane
+    if (bytesPerFrame > lumaSize)
+      planeSizes.append(bytesPerFrame - lumaSize);
+    return planeSizes;
+  }
+  const int64_t chromaSize = (bytesPerFrame - lumaSize - (hasAlpha ? lumaSize : 0)) / 2;
+  if (chromaSize > 0)
+    planeSizes << chromaSize << chromaSize;
+  if (hasAlpha)
+    planeSizes.append(lumaSize);
+  return planeSizes;
 }
 
 QByteArray videoHandlerYUV::getDiffYUV() const
@@ -3725,8 +3097,15 @@ QByteArray videoHandlerYUV::getDiffYUV() const
 }
 
 QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference)
+{
+  QVector<bool> diffBlocks;
+  return calculateDifference(item2, frameIdxItem0, frameIdxItem1, differenceInfoList, amplificationFactor, markDifference, diffBlocks);
+}
+
+QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference, QVector<bool> &diffBlocks)
 {
   is_YUV_diff = false;
+  diffBlocks.clear();
 
   videoHandlerYUV *yuvItem2 = dynamic_cast<videoHandlerYUV*>(item2);
   if (yuvItem2 == nullptr)
@@ -3813,115 +3192,160 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
   unsigned char * restrict dstU = dstY + componentSizeLuma_out;
   unsigned char * restrict dstV = dstU + componentSizeChroma_out;
 
-  // Also calculate the MSE while we're at it (Y,U,V)
-  // TODO: Bug: MSE is not scaled correctly in all YUV format cases
-  int64_t mseAdd[3] = {0, 0, 0};
+  // Create the output image in the right format
+  // In both cases, we will set the alpha channel to 255. The format of the raw buffer is: BGRA (each 8 bit).
+  QImage outputImage;
+  if (is_Q_OS_WIN)
+    outputImage = QImage(QSize(w_out, h_out), QImage::Format_ARGB32_Premultiplied);
+  else if (is_Q_OS_MAC)
+    outputImage = QImage(QSize(w_out, h_out), QImage::Format_RGB32);
+  else if (is_Q_OS_LINUX)
+  {
+    QImage::Format f = functions::platformImageFormat();
+    if (f == QImage::Format_ARGB32_Premultiplied)
+      outputImage = QImage(QSize(w_out, h_out), QImage::Format_ARGB32_Premultiplied);
+    if (f == QImage::Format_ARGB32)
+      outputImage = QImage(QSize(w_out, h_out), QImage::Format_ARGB32);
+    else
+      outputImage = QImage(QSize(w_out, h_out), QImage::Format_RGB32);
+  }
 
-  // Calculate Luma sample difference
+  // The difference is calculated line by line. For each line, the samples of both inputs are read and the
+  // difference, MSE, amplification and clipping are done by one kernel. The difference line is written to the
+  // diffYUV buffer and (if possible) converted to RGB right away while it is still in the cache.
+  // The conversion can be done here if it only needs the current and the next chroma line (which is always the case
+  // if we only mark differences). Otherwise (YUV math, chroma offset, ...) the diffYUV buffer is converted afterwards.
+  const YUVSubsamplingType subsampling = srcPixelFormat.subsampling;
+  const bool convertInLoop = markDifference || (componentDisplayMode == DisplayAll && !mathParameters[Luma].yuvMathRequired() && !mathParameters[Chroma].yuvMathRequired() &&
+                                                tmpDiffYUVFormat.chromaOffset[0] == 0 && tmpDiffYUVFormat.chromaOffset[1] == 0 &&
+                                                (subsampling == YUV_444 || subsampling == YUV_422 || subsampling == YUV_420));
+  const bool fullRange = (yuvColorConversionType == BT709_FullRange || yuvColorConversionType == BT601_FullRange || yuvColorConversionType == BT2020_FullRange);
+  const lineKernels &kernels = getLineKernels();
+  const lineConversionParameters param = getLineConversionParameters(yuvRgbConvCoeffs[yuvColorConversionType], fullRange, bps_out);
+
+  const int shift[2] = {bitDepthScaling[0] ? depthScale : 0, bitDepthScaling[1] ? depthScale : 0};
+  const int amplify = amplification ? amplificationFactor : 1;
+  const int bytesPerSample_out = (bps_out > 8) ? 2 : 1;
+  const int wC_out = w_out / subH;
+  const int hC_out = h_out / subV;
   const int stride_in[2] = {bps_in[0] > 8 ? w_in[0]*2 : w_in[0], bps_in[1] > 8 ? w_in[1]*2 : w_in[1]};  // How many bytes to the next y line?
-  for (int y = 0; y < h_out; y++)
-  {
-    for (int x = 0; x < w_out; x++)
-    {
-      int val1 = getValueFromSource(srcY1, x, bps_in[0], bigEndian[0]);
-      int val2 = getValueFromSource(srcY2, x, bps_in[1], bigEndian[1]);
+  const int strideC_in[2] = {w_in[0] / subH * (bps_in[0] > 8 ? 2 : 1), w_in[1] / subH * (bps_in[1] > 8 ? 2 : 1)};  // How many bytes to the next U/V y line
 
-      // Scale (if necessary)
-      if (bitDepthScaling[0])
-        val1 = val1 << depthScale;
-      else if (bitDepthScaling[1])
-        val2 = val2 << depthScale;
+  // Two input lines, the luma difference, the up-sampled chroma differences (luma resolution) and the current and
+  // next chroma difference lines (chroma resolution)
+  QVector<int> buffer(w_out*5 + wC_out*4);
+  int *line1 = buffer.data();
+  int *line2 = line1 + w_out;
+  int *diffY = line2 + w_out;
+  int *valU = diffY + w_out;
+  int *valV = valU + w_out;
+  int *curU = valV + w_out;
+  int *curV = curU + wC_out;
+  int *nextU = curV + wC_out;
+  int *nextV = nextU + wC_out;
 
-      // Calculate the difference, add MSE, (amplify) and clip the difference value
-      int diff = val1 - val2;
-      mseAdd[0] += diff * diff;
-      if (amplification)
-        diff *= amplificationFactor;
-      diff = clip(diff + diffZero, 0, maxVal);
+  // Also calculate the MSE while we're at it (Y,U,V)
+  int64_t mseAdd[3] = {0, 0, 0};
 
-      setValueInBuffer(dstY, diff, 0, bps_out, true);
-      dstY += (bps_out > 8) ? 2 : 1;
+  // Also remember which of the 64x64 blocks contain any difference. The lines are split at the block borders so that
+  // the sum of the squared differences of each line segment tells us if the block differs.
+  const int widthBlocks = (w_out + diffBlockSize - 1) / diffBlockSize;
+  const int heightBlocks = (h_out + diffBlockSize - 1) / diffBlockSize;
+  diffBlocks.fill(false, widthBlocks * heightBlocks);
+  auto differenceLineInBlocks = [&](const int *a, const int *b, int *diff, int count, int blockWidth, int y)
+  {
+    bool *blockRow = diffBlocks.data() + (y / diffBlockSize) * widthBlocks;
+    int64_t sse = 0;
+    for (int x = 0; x < count; x += blockWidth)
+    {
+      const int64_t sseBlock = kernels.differenceLine(a + x, b + x, diff + x, std::min(blockWidth, count - x), shift[0], shift[1], amplify, diffZero, maxVal);
+      if (sseBlock != 0)
+        blockRow[x / blockWidth] = true;
+      sse += sseBlock;
     }
+    return sse;
+  };
 
-    // Goto the next y line
-    srcY1 += stride_in[0];
-    srcY2 += stride_in[1];
-  }
+  // Calculate the U and V difference of the given chroma line
+  auto calculateChromaDifferenceLine = [&](int yC, int *diffU, int *diffV)
+  {
+    if (subsampling == YUV_400)
+    {
+      // There is no chroma. There is no difference.
+      std::fill(diffU, diffU + wC_out, diffZero);
+      std::fill(diffV, diffV + wC_out, diffZero);
+    }
+    else
+    {
+      kernels.readSamples(srcU1 + yC*strideC_in[0], line1, wC_out, 1, bps_in[0], bigEndian[0]);
+      kernels.readSamples(srcU2 + yC*strideC_in[1], line2, wC_out, 1, bps_in[1], bigEndian[1]);
+      mseAdd[1] += differenceLineInBlocks(line1, line2, diffU, wC_out, diffBlockSize / subH, yC*subV);
+      kernels.readSamples(srcV1 + yC*strideC_in[0], line1, wC_out, 1, bps_in[0], bigEndian[0]);
+      kernels.readSamples(srcV2 + yC*strideC_in[1], line2, wC_out, 1, bps_in[1], bigEndian[1]);
+      mseAdd[2] += differenceLineInBlocks(line1, line2, diffV, wC_out, diffBlockSize / subH, yC*subV);
+    }
+    kernels.writeSamples(diffU, dstU + yC*wC_out*bytesPerSample_out, wC_out, bps_out, true);
+    kernels.writeSamples(diffV, dstV + yC*wC_out*bytesPerSample_out, wC_out, bps_out, true);
+  };
 
-  // Next U/V
-  const int strideC_in[2] = {w_in[0] / subH * (bps_in[0] > 8 ? 2 : 1), w_in[1] / subH * (bps_in[1] > 8 ? 2 : 1)};  // How many bytes to the next U/V y line
-  for (int y = 0; y < h_out / subV; y++)
+  if (hC_out > 0)
+    calculateChromaDifferenceLine(0, curU, curV);
+  for (int yC = 0; yC < hC_out; yC++)
   {
-    for (int x = 0; x < w_out / subH; x++)
+    // At the last chroma line, there is no next line
+    const bool lastLine = (yC == hC_out-1);
+    if (!lastLine)
+      calculateChromaDifferenceLine(yC+1, nextU, nextV);
+
+    for (int yInBlock = 0; yInBlock < subV; yInBlock++)
     {
-      int valU1 = getValueFromSource(srcU1, x, bps_in[0], bigEndian[0]);
-      int valU2 = getValueFromSource(srcU2, x, bps_in[1], bigEndian[1]);
-      int valV1 = getValueFromSource(srcV1, x, bps_in[0], bigEndian[0]);
-      int valV2 = getValueFromSource(srcV2, x, bps_in[1], bigEndian[1]);
+      // Calculate the luma difference
+      const int y = yC*subV + yInBlock;
+      kernels.readSamples(srcY1 + y*stride_in[0], line1, w_out, 1, bps_in[0], bigEndian[0]);
+      kernels.readSamples(srcY2 + y*stride_in[1], line2, w_out, 1, bps_in[1], bigEndian[1]);
+      mseAdd[0] += differenceLineInBlocks(line1, line2, diffY, w_out, diffBlockSize, y);
+      kernels.writeSamples(diffY, dstY + y*w_out*bytesPerSample_out, w_out, bps_out, true);
 
-      // Scale (if necessary)
-      if (bitDepthScaling[0])
-      {
-        valU1 = valU1 << depthScale;
-        valV1 = valV1 << depthScale;
-      }
-      else if (bitDepthScaling[1])
+      if (!convertInLoop)
+        continue;
+
+      unsigned char *dstRGB = outputImage.scanLine(y);
+      if (markDifference)
       {
-        valU2 = valU2 << depthScale;
-        valV2 = valV2 << depthScale;
+        // We don't want to see the actual difference but just where differences are. The U/V difference is constant
+        // for all values within the sub-block.
+        for (int x = 0; x < w_out; x++)
+        {
+          valU[x] = curU[x / subH];
+          valV[x] = curV[x / subH];
+        }
+        kernels.markDifferencesLineToBGRA(diffY, valU, valV, dstRGB, w_out, diffZero);
       }
-
-      // Calculate the difference, add MSE, (amplify) and clip the difference value
-      int diffU = valU1 - valU2;
-      int diffV = valV1 - valV2;
-      mseAdd[1] += diffU * diffU;
-      mseAdd[2] += diffV * diffV;
-      if (amplification)
+      else if (subsampling == YUV_444)
+        kernels.convertLineToBGRA(diffY, curU, curV, dstRGB, w_out, param);
+      else
       {
-        diffU *= amplificationFactor;
-        diffV *= amplificationFactor;
+        // The same up-sampling as in YUVPlaneToRGB_422/YUVPlaneToRGB_420. The second luma line of a 4:2:0 block
+        // is in between this chroma line and the next one (at the bottom, the chroma line is just held).
+        if (yInBlock == 0)
+        {
+          upsampleChromaLineHor(curU, valU, wC_out, interpolationMode);
+          upsampleChromaLineHor(curV, valV, wC_out, interpolationMode);
+        }
+        else if (!lastLine)
+        {
+          upsampleChromaLineHorVer(curU, nextU, valU, wC_out, interpolationMode);
+          upsampleChromaLineHorVer(curV, nextV, valV, wC_out, interpolationMode);
+        }
+        kernels.convertLineToBGRA(diffY, valU, valV, dstRGB, w_out, param);
       }
-      diffU = clip(diffU + diffZero, 0, maxVal);
-      diffV = clip(diffV + diffZero, 0, maxVal);
-
-      setValueInBuffer(dstU, diffU, 0, bps_out, true);
-      setValueInBuffer(dstV, diffV, 0, bps_out, true);
-      dstU += (bps_out > 8) ? 2 : 1;
-      dstV += (bps_out > 8) ? 2 : 1;
     }
 
-    // Goto the next y line
-    srcU1 += strideC_in[0];
-    srcV1 += strideC_in[0];
-    srcU2 += strideC_in[1];
-    srcV2 += strideC_in[1];
-  }
-
-  // Next we convert the difference YUV image to RGB, either using the normal conversion function or
-  // another function that only marks the difference values.
-
-  // Create the output image in the right format
-  // In both cases, we will set the alpha channel to 255. The format of the raw buffer is: BGRA (each 8 bit).
-  QImage outputImage;
-  if (is_Q_OS_WIN)
-    outputImage = QImage(QSize(w_out, h_out), QImage::Format_ARGB32_Premultiplied);
-  else if (is_Q_OS_MAC)
-    outputImage = QImage(QSize(w_out, h_out), QImage::Format_RGB32);
-  else if (is_Q_OS_LINUX)
-  {
-    QImage::Format f = functions::platformImageFormat();
-    if (f == QImage::Format_ARGB32_Premultiplied)
-      outputImage = QImage(QSize(w_out, h_out), QImage::Format_ARGB32_Premultiplied);
-    if (f == QImage::Format_ARGB32)
-      outputImage = QImage(QSize(w_out, h_out), QImage::Format_ARGB32);
-    else
-      outputImage = QImage(QSize(w_out, h_out), QImage::Format_RGB32);
+    std::swap(curU, nextU);
+    std::swap(curV, nextV);
   }
 
-  if (markDifference)
-    // We don't want to see the actual difference but just where differences are.
-    markDifferencesYUVPlanarToRGB(diffYUV, outputImage.bits(), QSize(w_out, h_out), tmpDiffYUVFormat);
-  else
+  if (!convertInLoop)
     // Get the format of the tmpDiffYUV buffer and convert it to RGB
     convertYUVPlanarToRGB(diffYUV, outputImage.bits(), QSize(w_out, h_out), tmpDiffYUVFormat);
 
@@ -3929,9 +3353,11 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
   QStringList yuvSubsamplings = QStringList() << "4:4:4" << "4:2:2" << "4:2:0" << "4:4:0" << "4:1:0" << "4:1:1" << "4:0:0";
   differenceInfoList.append(infoItem("Difference Type",QString("YUV %1").arg(yuvSubsamplings[srcPixelFormat.subsampling])));
   double mse[4];
+  // The chroma MSE is normalized by the number of chroma samples
+  const int nrChromaSamples = std::max(wC_out * hC_out, 1);
   mse[0] = double(mseAdd[0]) / (w_out * h_out);
-  mse[1] = double(mseAdd[1]) / (w_out * h_out);
-  mse[2] = double(mseAdd[2]) / (w_out * h_out);
+  mse[1] = double(mseAdd[1]) / nrChromaSamples;
+  mse[2] = double(mseAdd[2]) / nrChromaSamples;
   mse[3] = mse[0] + mse[1] + mse[2];
   differenceInfoList.append(infoItem("MSE Y",QString("%1").arg(mse[0])));
   differenceInfoList.append(infoItem("MSE U",QString("%1").arg(mse[1])));
@@ -3952,6 +3378,98 @@ QImage videoHandlerYUV::calculateDifference(frameHandler *item2, const int frame
   return outputImage;
 }
 
+bool videoHandlerYUV::calculateSSE(const QByteArray &rawData0, const QSize &frameSize0, yuvPixelFormat format0, const QByteArray &rawData1, const QSize &frameSize1, yuvPixelFormat format1, int64_t sse[3], int64_t nrSamples[3])
+{
+  for (int c = 0; c < 3; c++)
+  {
+    sse[c] = 0;
+    nrSamples[c] = 0;
+  }
+
+  if (!format0.isValid() || !format1.isValid() || format0.subsampling != format1.subsampling)
+    return false;
+  if (rawData0.size() < format0.bytesPerFrame(frameSize0) || rawData1.size() < format1.bytesPerFrame(frameSize1))
+    return false;
+
+  // Packed data is converted to planar data first
+  const QByteArray *data[2] = {&rawData0, &rawData1};
+  yuvPixelFormat *format[2] = {&format0, &format1};
+  const QSize size[2] = {frameSize0, frameSize1};
+  QByteArray planarData[2];
+  for (int i = 0; i < 2; i++)
+  {
+    if (!format[i]->planar)
+    {
+      if (!convertYUVPackedToPlanar(*data[i], planarData[i], size[i], *format[i]))
+        return false;
+      data[i] = &planarData[i];
+    }
+  }
+
+  // If the bit depths differ, the input with the lower bit depth is scaled up
+  const int bpsOut = std::max(format0.bitsPerSample, format1.bitsPerSample);
+  const int shift[2] = {bpsOut - format0.bitsPerSample, bpsOut - format1.bitsPerSample};
+
+  const int w_out = std::min(frameSize0.width(), frameSize1.width());
+  const int h_out = std::min(frameSize0.height(), frameSize1.height());
+  const int subH = format0.getSubsamplingHor();
+  const int subV = format0.getSubsamplingVer();
+  const int nrComponents = (format0.subsampling == YUV_400) ? 1 : 3;
+
+  const lineKernels &kernels = getLineKernels();
+  QVector<int> line[2] = {QVector<int>(w_out), QVector<int>(w_out)};
+  for (int c = 0; c < nrComponents; c++)
+  {
+    const int w = (c == 0) ? w_out : w_out / subH;
+    const int h = (c == 0) ? h_out : h_out / subV;
+
+    // Get the start, the line stride and the sample skip of the component in both inputs
+    const unsigned char *src[2];
+    int stride[2], inValSkip[2];
+    for (int i = 0; i < 2; i++)
+    {
+      const yuvPixelFormat &f = *format[i];
+      const int bytesPerSample = (f.bitsPerSample > 8) ? 2 : 1;
+      const int nrBytesLumaPlane = size[i].width() * size[i].height() * bytesPerSample;
+      const int widthChroma = size[i].width() / subH;
+      const int nrBytesChromaPlane = widthChroma * (size[i].height() / subV) * bytesPerSample;
+      src[i] = (const unsigned char*)data[i]->constData();
+      if (c == 0)
+      {
+        stride[i] = size[i].width() * bytesPerSample;
+        inValSkip[i] = 1;
+        continue;
+      }
+
+      // Is the requested chroma component (U: c == 1, V: c == 2) the first one in the data?
+      const bool uFirst = (f.planeOrder == Order_YUV || f.planeOrder == Order_YUVA);
+      const bool firstChroma = (c == 1) == uFirst;
+      if (f.uvInterleaved)
+      {
+        inValSkip[i] = (f.planeOrder == Order_YUV || f.planeOrder == Order_YVU) ? 2 : 3;
+        src[i] += nrBytesLumaPlane + (firstChroma ? 0 : bytesPerSample);
+        stride[i] = widthChroma * inValSkip[i] * bytesPerSample;
+      }
+      else
+      {
+        inValSkip[i] = 1;
+        src[i] += nrBytesLumaPlane + (firstChroma ? 0 : nrBytesChromaPlane);
+        stride[i] = widthChroma * bytesPerSample;
+      }
+    }
+
+    for (int y = 0; y < h; y++)
+    {
+      for (int i = 0; i < 2; i++)
+        kernels.readSamples(src[i] + y * stride[i], line[i].data(), w, inValSkip[i], format[i]->bitsPerSample, format[i]->bigEndian);
+      sse[c] += kernels.sumSquaredDifference(line[0].constData(), line[1].constData(), w, shift[0], shift[1]);
+    }
+    nrSamples[c] = int64_t(w) * h;
+  }
+
+  return true;
+}
+
 void videoHandlerYUV::setYUVPixelFormat(const yuvPixelFormat &newFormat, bool emitSignal)
 {
   if (!newFormat.isValid())
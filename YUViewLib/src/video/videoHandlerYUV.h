@@ -211,9 +211,26 @@ public:
   // we will use the playlistItemVideo::calculateDifference function to calculate the difference
   // using the RGB values.
   virtual QImage calculateDifference(frameHandler *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference) Q_DECL_OVERRIDE;
+  // The same as above. Additionally, for each block of diffBlockSize x diffBlockSize samples (in raster scan order),
+  // diffBlocks is set to whether there was any difference in Y, U or V. The map is returned (and not kept in a member)
+  // because several threads can calculate differences at the same time. It is empty if the YUV difference could not
+  // be calculated.
+  QImage calculateDifference(frameHandler *item2, const int frameIdxItem0, const int frameIdxItem1, QList<infoItem> &differenceInfoList, const int amplificationFactor, const bool markDifference, QVector<bool> &diffBlocks);
+  static const int diffBlockSize = 64;
+
+  // Calculate the sum of squared errors (SSE) of the Y, U and V components of two raw frames in the given formats.
+  // Unlike calculateDifference, no difference image is created and no member is used so this can be called for
+  // several frames in parallel. As in calculateDifference, the top left part that overlaps is compared and the input
+  // with the lower bit depth is scaled up. nrSamples is set to the number of compared samples per component.
+  // Return false if the frames can not be compared (different subsampling, invalid format or not enough data).
+  static bool calculateSSE(const QByteArray &rawData0, const QSize &frameSize0, YUV_Internals::yuvPixelFormat format0,
+                           const QByteArray &rawData1, const QSize &frameSize1, YUV_Internals::yuvPixelFormat format1,
+                           int64_t sse[3], int64_t nrSamples[3]);
 
   // Get the number of bytes for one YUV frame with the current format
   virtual int64_t getBytesPerFrame() const Q_DECL_OVERRIDE { return srcPixelFormat.bytesPerFrame(frameSize); }
+  // The Y, U, V (and A) planes of planar formats. Interleaved U/V planes are returned as one plane.
+  virtual QVector<int64_t> getRawPlaneSizes() const Q_DECL_OVERRIDE;
 
   // If you know the frame size of the video, the file size (and optionally the bit depth) we can guess
   // the remaining values. The rate value is set if a matching format could be found.
@@ -304,6 +321,10 @@ protected:
   // will not be modified.
   virtual void loadFrameForCaching(int frameIndex, QImage &frameToCache) Q_DECL_OVERRIDE;
 
+  // Raw YUV frames can be cached and converted when they are drawn
+  virtual bool canCacheRawFrames() const Q_DECL_OVERRIDE { return true; }
+  virtual void convertRawFrameFromCache(const QByteArray &cachedFrame, QImage &outputImage) Q_DECL_OVERRIDE { convertYUVToImage(cachedFrame, outputImage, srcPixelFormat, frameSize); }
+
 private:
 
   // Load the raw YUV data for the given frame index into currentFrameRawYUVData.
@@ -311,7 +332,7 @@ private:
   bool loadRawYUVData(int frameIndex);
 
   // Convert from YUV (which ever format is selected) to image (RGB-888)
-  void convertYUVToImage(const QByteArray &sourceBuffer, QImage &outputImage, const YUV_Internals::yuvPixelFormat &yuvFormat, const QSize &curFrameSize);
+  void convertYUVToImage(const rawDataView &sourceBuffer, QImage &outputImage, const YUV_Internals::yuvPixelFormat &yuvFormat, const QSize &curFrameSize);
 
   // Set the new pixel format thread save (lock the mutex). We should also emit that something changed (can be disabled).
   void setSrcPixelFormat(YUV_Internals::yuvPixelFormat newFormat, bool emitChangedSignal=true);
@@ -323,22 +344,10 @@ private:
 
   bool canConvertToRGB(YUV_Internals::yuvPixelFormat format, QSize imageSize, QString *whyNot=nullptr) const;
 
-#if SSE_CONVERSION
-  bool convertYUV420ToRGB(const byteArrayAligned &sourceBuffer, byteArrayAligned &targetBuffer);
-#else
-  bool convertYUV420ToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &size, const YUV_Internals::yuvPixelFormat format);
-#endif
-
-  bool convertYUVPackedToPlanar(const QByteArray &sourceBuffer, QByteArray &targetBuffer, const QSize &frameSize, YUV_Internals::yuvPixelFormat &sourceBufferFormat);
-  bool convertYUVPlanarToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat) const;
-  bool markDifferencesYUVPlanarToRGB(const QByteArray &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat) const;
-
-#if SSE_CONVERSION_420_ALT
-  void yuv420_to_argb8888(quint8 *yp, quint8 *up, quint8 *vp,
-                          quint32 sy, quint32 suv,
-                           int width, int height,
-                           quint8 *rgb, quint32 srgb);
-#endif
+  bool convertYUV420ToRGB(const rawDataView &sourceBuffer, unsigned char *targetBuffer, const QSize &size, const YUV_Internals::yuvPixelFormat format);
+
+  static bool convertYUVPackedToPlanar(const rawDataView &sourceBuffer, QByteArray &targetBuffer, const QSize &frameSize, YUV_Internals::yuvPixelFormat &sourceBufferFormat);
+  bool convertYUVPlanarToRGB(const rawDataView &sourceBuffer, unsigned char *targetBuffer, const QSize &frameSize, const YUV_Internals::yuvPixelFormat &sourceBufferFormat) const;
 
   SafeUi<Ui::videoHandlerYUV> ui;
 
@@ -0,0 +1,672 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "videoHandlerYUVKernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define YUV_KERNELS_X86 1
+#else
+#define YUV_KERNELS_X86 0
+#endif
+
+#if YUV_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// The SSE4.1 and AVX2 kernels are compiled for their instruction set using function attributes.
+// This way, the rest of the library is still compiled for the baseline instruction set and the kernels
+// are only called if the CPU supports them. MSVC does not need this. It always allows the intrinsics.
+#if defined(__GNUC__) || defined(__clang__)
+#define TARGET_SSE4_1 __attribute__((target("sse4.1")))
+#define TARGET_AVX2   __attribute__((target("avx2")))
+#else
+#define TARGET_SSE4_1
+#define TARGET_AVX2
+#endif
+
+namespace YUV_Internals
+{
+
+lineConversionParameters getLineConversionParameters(const int RGBConv[5], bool fullRange, int bitsPerSample)
+{
+  lineConversionParameters p;
+  for (int i = 0; i < 5; i++)
+    p.RGBConv[i] = RGBConv[i];
+
+  // The bit depth of an int (32) is not enough to perform a YUV -> RGB conversion for a bit depth > 14 bits.
+  // In this case the lowest 2 bits are dropped before the conversion (see convertYUVToRGB8Bit).
+  p.preShift = (bitsPerSample > 14) ? 2 : 0;
+  const int bps = bitsPerSample - p.preShift;
+  p.yOffset = fullRange ? 0 : 16 << (bps - 8);
+  p.cZero = 128 << (bps - 8);
+  p.shift = 16 + bps - 8;
+  return p;
+}
+
+namespace
+{
+
+// ------------------ Plain C++ kernels ------------------
+
+void readSamples_C(const unsigned char *src, int *dst, int count, int inValSkip, int bps, bool bigEndian)
+{
+  if (bps > 8)
+  {
+    for (int i = 0; i < count; i++)
+    {
+      const unsigned char *s = src + i * inValSkip * 2;
+      dst[i] = bigEndian ? (s[0] << 8 | s[1]) : (s[0] | s[1] << 8);
+    }
+  }
+  else
+  {
+    for (int i = 0; i < count; i++)
+      dst[i] = src[i * inValSkip];
+  }
+}
+
+void applyMath_C(int *samples, int count, int scale, int offset, bool invert, int clipMax)
+{
+  for (int i = 0; i < count; i++)
+  {
+    int newValue = (samples[i] - offset) * scale;
+    newValue = (invert ? -newValue : newValue) + offset;
+    samples[i] = (newValue < 0) ? 0 : (newValue > clipMax) ? clipMax : newValue;
+  }
+}
+
+inline unsigned char clipTo8Bit(int val)
+{
+  return (unsigned char)((val < 0) ? 0 : (val > 255) ? 255 : val);
+}
+
+void convertLineToBGRA_C(const int *srcY, const int *srcU, const int *srcV, unsigned char *dst, int count, const lineConversionParameters &p)
+{
+  for (int i = 0; i < count; i++)
+  {
+    const int Y_tmp = ((srcY[i] >> p.preShift) - p.yOffset) * p.RGBConv[0];
+    const int U_tmp = (srcU[i] >> p.preShift) - p.cZero;
+    const int V_tmp = (srcV[i] >> p.preShift) - p.cZero;
+
+    dst[i*4  ] = clipTo8Bit((Y_tmp + U_tmp * p.RGBConv[4]) >> p.shift);
+    dst[i*4+1] = clipTo8Bit((Y_tmp + U_tmp * p.RGBConv[2] + V_tmp * p.RGBConv[3]) >> p.shift);
+    dst[i*4+2] = clipTo8Bit((Y_tmp + V_tmp * p.RGBConv[1]) >> p.shift);
+    dst[i*4+3] = 255;
+  }
+}
+
+int64_t sumSquaredDifference_C(const int *a, const int *b, int count, int shiftA, int shiftB)
+{
+  int64_t sum = 0;
+  for (int i = 0; i < count; i++)
+  {
+    const int64_t diff = (a[i] << shiftA) - (b[i] << shiftB);
+    sum += diff * diff;
+  }
+  return sum;
+}
+
+int64_t differenceLine_C(const int *a, const int *b, int *diff, int count, int shiftA, int shiftB, int amplification, int diffZero, int clipMax)
+{
+  int64_t sum = 0;
+  for (int i = 0; i < count; i++)
+  {
+    const int d = (a[i] << shiftA) - (b[i] << shiftB);
+    sum += int64_t(d) * d;
+    const int val = d * amplification + diffZero;
+    diff[i] = (val < 0) ? 0 : (val > clipMax) ? clipMax : val;
+  }
+  return sum;
+}
+
+void writeSamples_C(const int *src, unsigned char *dst, int count, int bps, bool bigEndian)
+{
+  if (bps > 8)
+  {
+    for (int i = 0; i < count; i++)
+    {
+      dst[i*2  ] = (unsigned char)(bigEndian ? src[i] >> 8 : src[i]);
+      dst[i*2+1] = (unsigned char)(bigEndian ? src[i] : src[i] >> 8);
+    }
+  }
+  else
+  {
+    for (int i = 0; i < count; i++)
+      dst[i] = (unsigned char)src[i];
+  }
+}
+
+void markDifferencesLineToBGRA_C(const int *srcY, const int *srcU, const int *srcV, unsigned char *dst, int count, int cZero)
+{
+  for (int i = 0; i < count; i++)
+  {
+    // A difference only in U/V is dark, a difference only in Y is grey and a difference in Y and U/V is bright
+    const bool diffU = (srcU[i] != cZero);
+    const bool diffV = (srcV[i] != cZero);
+    unsigned char R = 0, G = 0, B = 0;
+    if (srcY[i] == cZero)
+    {
+      G = diffU ? 70 : 0;
+      B = diffV ? 70 : 0;
+    }
+    else if (!diffU && !diffV)
+    {
+      R = 70;
+      G = 70;
+      B = 70;
+    }
+    else
+    {
+      G = diffU ? 255 : 0;
+      B = diffV ? 255 : 0;
+    }
+    dst[i*4  ] = B;
+    dst[i*4+1] = G;
+    dst[i*4+2] = R;
+    dst[i*4+3] = 255;
+  }
+}
+
+#if YUV_KERNELS_X86
+
+// ------------------ SSE4.1 kernels (4 samples at a time) ------------------
+
+TARGET_SSE4_1 void readSamples_SSE4_1(const unsigned char *src, int *dst, int count, int inValSkip, int bps, bool bigEndian)
+{
+  if (inValSkip != 1)
+  {
+    // Interleaved chroma. Gathering every n-th sample does not pay off.
+    readSamples_C(src, dst, count, inValSkip, bps, bigEndian);
+    return;
+  }
+
+  int i = 0;
+  if (bps > 8)
+  {
+    const __m128i swapBytes = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    for (; i + 8 <= count; i += 8)
+    {
+      __m128i v = _mm_loadu_si128((const __m128i*)(src + i * 2));
+      if (bigEndian)
+        v = _mm_shuffle_epi8(v, swapBytes);
+      _mm_storeu_si128((__m128i*)(dst + i),     _mm_cvtepu16_epi32(v));
+      _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_cvtepu16_epi32(_mm_srli_si128(v, 8)));
+    }
+  }
+  else
+  {
+    for (; i + 16 <= count; i += 16)
+    {
+      const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+      _mm_storeu_si128((__m128i*)(dst + i),      _mm_cvtepu8_epi32(v));
+      _mm_storeu_si128((__m128i*)(dst + i + 4),  _mm_cvtepu8_epi32(_mm_srli_si128(v, 4)));
+      _mm_storeu_si128((__m128i*)(dst + i + 8),  _mm_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+      _mm_storeu_si128((__m128i*)(dst + i + 12), _mm_cvtepu8_epi32(_mm_srli_si128(v, 12)));
+    }
+  }
+  // The rest of the line
+  readSamples_C(src + i * (bps > 8 ? 2 : 1), dst + i, count - i, 1, bps, bigEndian);
+}
+
+TARGET_SSE4_1 void applyMath_SSE4_1(int *samples, int count, int scale, int offset, bool invert, int clipMax)
+{
+  const __m128i vScale = _mm_set1_epi32(invert ? -scale : scale);
+  const __m128i vOffset = _mm_set1_epi32(offset);
+  const __m128i vMax = _mm_set1_epi32(clipMax);
+  const __m128i vZero = _mm_setzero_si128();
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i*)(samples + i));
+    v = _mm_add_epi32(_mm_mullo_epi32(_mm_sub_epi32(v, vOffset), vScale), vOffset);
+    v = _mm_min_epi32(_mm_max_epi32(v, vZero), vMax);
+    _mm_storeu_si128((__m128i*)(samples + i), v);
+  }
+  applyMath_C(samples + i, count - i, scale, offset, invert, clipMax);
+}
+
+TARGET_SSE4_1 void convertLineToBGRA_SSE4_1(const int *srcY, const int *srcU, const int *srcV, unsigned char *dst, int count, const lineConversionParameters &p)
+{
+  const __m128i preShift = _mm_cvtsi32_si128(p.preShift);
+  const __m128i shift = _mm_cvtsi32_si128(p.shift);
+  const __m128i yOffset = _mm_set1_epi32(p.yOffset);
+  const __m128i cZero = _mm_set1_epi32(p.cZero);
+  const __m128i c0 = _mm_set1_epi32(p.RGBConv[0]);
+  const __m128i c1 = _mm_set1_epi32(p.RGBConv[1]);
+  const __m128i c2 = _mm_set1_epi32(p.RGBConv[2]);
+  const __m128i c3 = _mm_set1_epi32(p.RGBConv[3]);
+  const __m128i c4 = _mm_set1_epi32(p.RGBConv[4]);
+  const __m128i vZero = _mm_setzero_si128();
+  const __m128i vMax = _mm_set1_epi32(255);
+  const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128i y = _mm_srl_epi32(_mm_loadu_si128((const __m128i*)(srcY + i)), preShift);
+    const __m128i u = _mm_srl_epi32(_mm_loadu_si128((const __m128i*)(srcU + i)), preShift);
+    const __m128i v = _mm_srl_epi32(_mm_loadu_si128((const __m128i*)(srcV + i)), preShift);
+
+    const __m128i yTmp = _mm_mullo_epi32(_mm_sub_epi32(y, yOffset), c0);
+    const __m128i uTmp = _mm_sub_epi32(u, cZero);
+    const __m128i vTmp = _mm_sub_epi32(v, cZero);
+
+    __m128i r = _mm_sra_epi32(_mm_add_epi32(yTmp, _mm_mullo_epi32(vTmp, c1)), shift);
+    __m128i g = _mm_sra_epi32(_mm_add_epi32(_mm_add_epi32(yTmp, _mm_mullo_epi32(uTmp, c2)), _mm_mullo_epi32(vTmp, c3)), shift);
+    __m128i b = _mm_sra_epi32(_mm_add_epi32(yTmp, _mm_mullo_epi32(uTmp, c4)), shift);
+    r = _mm_min_epi32(_mm_max_epi32(r, vZero), vMax);
+    g = _mm_min_epi32(_mm_max_epi32(g, vZero), vMax);
+    b = _mm_min_epi32(_mm_max_epi32(b, vZero), vMax);
+
+    // BGRA in memory is 0xAARRGGBB as a little endian int
+    const __m128i bgra = _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(r, 16), alpha));
+    _mm_storeu_si128((__m128i*)(dst + i * 4), bgra);
+  }
+  convertLineToBGRA_C(srcY + i, srcU + i, srcV + i, dst + i * 4, count - i, p);
+}
+
+TARGET_SSE4_1 int64_t sumSquaredDifference_SSE4_1(const int *a, const int *b, int count, int shiftA, int shiftB)
+{
+  // The squared difference of 16 bit samples does not fit into 32 bit. _mm_mul_epi32 multiplies the even 32 bit
+  // lanes to 64 bit results. The odd lanes are shifted down for a second multiplication.
+  const __m128i vShiftA = _mm_cvtsi32_si128(shiftA);
+  const __m128i vShiftB = _mm_cvtsi32_si128(shiftB);
+  __m128i sum = _mm_setzero_si128();
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128i va = _mm_sll_epi32(_mm_loadu_si128((const __m128i*)(a + i)), vShiftA);
+    const __m128i vb = _mm_sll_epi32(_mm_loadu_si128((const __m128i*)(b + i)), vShiftB);
+    const __m128i diff = _mm_sub_epi32(va, vb);
+    const __m128i diffOdd = _mm_srli_epi64(diff, 32);
+    sum = _mm_add_epi64(sum, _mm_add_epi64(_mm_mul_epi32(diff, diff), _mm_mul_epi32(diffOdd, diffOdd)));
+  }
+  int64_t lanes[2];
+  _mm_storeu_si128((__m128i*)lanes, sum);
+  return lanes[0] + lanes[1] + sumSquaredDifference_C(a + i, b + i, count - i, shiftA, shiftB);
+}
+
+TARGET_SSE4_1 int64_t differenceLine_SSE4_1(const int *a, const int *b, int *diff, int count, int shiftA, int shiftB, int amplification, int diffZero, int clipMax)
+{
+  const __m128i vShiftA = _mm_cvtsi32_si128(shiftA);
+  const __m128i vShiftB = _mm_cvtsi32_si128(shiftB);
+  const __m128i vAmplification = _mm_set1_epi32(amplification);
+  const __m128i vDiffZero = _mm_set1_epi32(diffZero);
+  const __m128i vMax = _mm_set1_epi32(clipMax);
+  const __m128i vZero = _mm_setzero_si128();
+  __m128i sum = _mm_setzero_si128();
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    const __m128i va = _mm_sll_epi32(_mm_loadu_si128((const __m128i*)(a + i)), vShiftA);
+    const __m128i vb = _mm_sll_epi32(_mm_loadu_si128((const __m128i*)(b + i)), vShiftB);
+    const __m128i d = _mm_sub_epi32(va, vb);
+    const __m128i dOdd = _mm_srli_epi64(d, 32);
+    sum = _mm_add_epi64(sum, _mm_add_epi64(_mm_mul_epi32(d, d), _mm_mul_epi32(dOdd, dOdd)));
+    __m128i val = _mm_add_epi32(_mm_mullo_epi32(d, vAmplification), vDiffZero);
+    val = _mm_min_epi32(_mm_max_epi32(val, vZero), vMax);
+    _mm_storeu_si128((__m128i*)(diff + i), val);
+  }
+  int64_t lanes[2];
+  _mm_storeu_si128((__m128i*)lanes, sum);
+  return lanes[0] + lanes[1] + differenceLine_C(a + i, b + i, diff + i, count - i, shiftA, shiftB, amplification, diffZero, clipMax);
+}
+
+TARGET_SSE4_1 void writeSamples_SSE4_1(const int *src, unsigned char *dst, int count, int bps, bool bigEndian)
+{
+  int i = 0;
+  if (bps > 8)
+  {
+    const __m128i swapBytes = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    for (; i + 8 <= count; i += 8)
+    {
+      __m128i v = _mm_packus_epi32(_mm_loadu_si128((const __m128i*)(src + i)), _mm_loadu_si128((const __m128i*)(src + i + 4)));
+      if (bigEndian)
+        v = _mm_shuffle_epi8(v, swapBytes);
+      _mm_storeu_si128((__m128i*)(dst + i * 2), v);
+    }
+  }
+  else
+  {
+    for (; i + 16 <= count; i += 16)
+    {
+      const __m128i v0 = _mm_packus_epi32(_mm_loadu_si128((const __m128i*)(src + i)),     _mm_loadu_si128((const __m128i*)(src + i + 4)));
+      const __m128i v1 = _mm_packus_epi32(_mm_loadu_si128((const __m128i*)(src + i + 8)), _mm_loadu_si128((const __m128i*)(src + i + 12)));
+      _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(v0, v1));
+    }
+  }
+  writeSamples_C(src + i, dst + i * (bps > 8 ? 2 : 1), count - i, bps, bigEndian);
+}
+
+TARGET_SSE4_1 void markDifferencesLineToBGRA_SSE4_1(const int *srcY, const int *srcU, const int *srcV, unsigned char *dst, int count, int cZero)
+{
+  const __m128i vCZero = _mm_set1_epi32(cZero);
+  const __m128i dark = _mm_set1_epi32(70);
+  const __m128i bright = _mm_set1_epi32(255);
+  const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+
+  int i = 0;
+  for (; i + 4 <= count; i += 4)
+  {
+    // All bits are set in the lanes where there is no difference
+    const __m128i noDiffY = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(srcY + i)), vCZero);
+    const __m128i noDiffU = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(srcU + i)), vCZero);
+    const __m128i noDiffV = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(srcV + i)), vCZero);
+
+    // A difference in Y only is grey. Otherwise, the U/V differences are dark (no Y difference) or bright.
+    const __m128i grey = _mm_and_si128(_mm_andnot_si128(noDiffY, noDiffU), _mm_and_si128(noDiffV, dark));
+    const __m128i chromaVal = _mm_blendv_epi8(bright, dark, noDiffY);
+    const __m128i r = grey;
+    const __m128i g = _mm_or_si128(_mm_andnot_si128(noDiffU, chromaVal), grey);
+    const __m128i b = _mm_or_si128(_mm_andnot_si128(noDiffV, chromaVal), grey);
+
+    const __m128i bgra = _mm_or_si128(_mm_or_si128(b, _mm_slli_epi32(g, 8)), _mm_or_si128(_mm_slli_epi32(r, 16), alpha));
+    _mm_storeu_si128((__m128i*)(dst + i * 4), bgra);
+  }
+  markDifferencesLineToBGRA_C(srcY + i, srcU + i, srcV + i, dst + i * 4, count - i, cZero);
+}
+
+// ------------------ AVX2 kernels (8 samples at a time) ------------------
+
+TARGET_AVX2 void readSamples_AVX2(const unsigned char *src, int *dst, int count, int inValSkip, int bps, bool bigEndian)
+{
+  if (inValSkip != 1)
+  {
+    readSamples_C(src, dst, count, inValSkip, bps, bigEndian);
+    return;
+  }
+
+  int i = 0;
+  if (bps > 8)
+  {
+    const __m128i swapBytes = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    for (; i + 16 <= count; i += 16)
+    {
+      __m128i v0 = _mm_loadu_si128((const __m128i*)(src + i * 2));
+      __m128i v1 = _mm_loadu_si128((const __m128i*)(src + i * 2 + 16));
+      if (bigEndian)
+      {
+        v0 = _mm_shuffle_epi8(v0, swapBytes);
+        v1 = _mm_shuffle_epi8(v1, swapBytes);
+      }
+      _mm256_storeu_si256((__m256i*)(dst + i),     _mm256_cvtepu16_epi32(v0));
+      _mm256_storeu_si256((__m256i*)(dst + i + 8), _mm256_cvtepu16_epi32(v1));
+    }
+  }
+  else
+  {
+    for (; i + 16 <= count; i += 16)
+    {
+      const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+      _mm256_storeu_si256((__m256i*)(dst + i),     _mm256_cvtepu8_epi32(v));
+      _mm256_storeu_si256((__m256i*)(dst + i + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+    }
+  }
+  readSamples_C(src + i * (bps > 8 ? 2 : 1), dst + i, count - i, 1, bps, bigEndian);
+}
+
+TARGET_AVX2 void applyMath_AVX2(int *samples, int count, int scale, int offset, bool invert, int clipMax)
+{
+  const __m256i vScale = _mm256_set1_epi32(invert ? -scale : scale);
+  const __m256i vOffset = _mm256_set1_epi32(offset);
+  const __m256i vMax = _mm256_set1_epi32(clipMax);
+  const __m256i vZero = _mm256_setzero_si256();
+  int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(samples + i));
+    v = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(v, vOffset), vScale), vOffset);
+    v = _mm256_min_epi32(_mm256_max_epi32(v, vZero), vMax);
+    _mm256_storeu_si256((__m256i*)(samples + i), v);
+  }
+  applyMath_C(samples + i, count - i, scale, offset, invert, clipMax);
+}
+
+TARGET_AVX2 void convertLineToBGRA_AVX2(const int *srcY, const int *srcU, const int *srcV, unsigned char *dst, int count, const lineConversionParameters &p)
+{
+  const __m128i preShift = _mm_cvtsi32_si128(p.preShift);
+  const __m128i shift = _mm_cvtsi32_si128(p.shift);
+  const __m256i yOffset = _mm256_set1_epi32(p.yOffset);
+  const __m256i cZero = _mm256_set1_epi32(p.cZero);
+  const __m256i c0 = _mm256_set1_epi32(p.RGBConv[0]);
+  const __m256i c1 = _mm256_set1_epi32(p.RGBConv[1]);
+  const __m256i c2 = _mm256_set1_epi32(p.RGBConv[2]);
+  const __m256i c3 = _mm256_set1_epi32(p.RGBConv[3]);
+  const __m256i c4 = _mm256_set1_epi32(p.RGBConv[4]);
+  const __m256i vZero = _mm256_setzero_si256();
+  const __m256i vMax = _mm256_set1_epi32(255);
+  const __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+
+  int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m256i y = _mm256_srl_epi32(_mm256_loadu_si256((const __m256i*)(srcY + i)), preShift);
+    const __m256i u = _mm256_srl_epi32(_mm256_loadu_si256((const __m256i*)(srcU + i)), preShift);
+    const __m256i v = _mm256_srl_epi32(_mm256_loadu_si256((const __m256i*)(srcV + i)), preShift);
+
+    const __m256i yTmp = _mm256_mullo_epi32(_mm256_sub_epi32(y, yOffset), c0);
+    const __m256i uTmp = _mm256_sub_epi32(u, cZero);
+    const __m256i vTmp = _mm256_sub_epi32(v, cZero);
+
+    __m256i r = _mm256_sra_epi32(_mm256_add_epi32(yTmp, _mm256_mullo_epi32(vTmp, c1)), shift);
+    __m256i g = _mm256_sra_epi32(_mm256_add_epi32(_mm256_add_epi32(yTmp, _mm256_mullo_epi32(uTmp, c2)), _mm256_mullo_epi32(vTmp, c3)), shift);
+    __m256i b = _mm256_sra_epi32(_mm256_add_epi32(yTmp, _mm256_mullo_epi32(uTmp, c4)), shift);
+    r = _mm256_min_epi32(_mm256_max_epi32(r, vZero), vMax);
+    g = _mm256_min_epi32(_mm256_max_epi32(g, vZero), vMax);
+    b = _mm256_min_epi32(_mm256_max_epi32(b, vZero), vMax);
+
+    const __m256i bgra = _mm256_or_si256(_mm256_or_si256(b, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(r, 16), alpha));
+    _mm256_storeu_si256((__m256i*)(dst + i * 4), bgra);
+  }
+  convertLineToBGRA_C(srcY + i, srcU + i, srcV + i, dst + i * 4, count - i, p);
+}
+
+TARGET_AVX2 int64_t sumSquaredDifference_AVX2(const int *a, const int *b, int count, int shiftA, int shiftB)
+{
+  const __m128i vShiftA = _mm_cvtsi32_si128(shiftA);
+  const __m128i vShiftB = _mm_cvtsi32_si128(shiftB);
+  __m256i sum = _mm256_setzero_si256();
+  int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m256i va = _mm256_sll_epi32(_mm256_loadu_si256((const __m256i*)(a + i)), vShiftA);
+    const __m256i vb = _mm256_sll_epi32(_mm256_loadu_si256((const __m256i*)(b + i)), vShiftB);
+    const __m256i diff = _mm256_sub_epi32(va, vb);
+    const __m256i diffOdd = _mm256_srli_epi64(diff, 32);
+    sum = _mm256_add_epi64(sum, _mm256_add_epi64(_mm256_mul_epi32(diff, diff), _mm256_mul_epi32(diffOdd, diffOdd)));
+  }
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i*)lanes, sum);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sumSquaredDifference_C(a + i, b + i, count - i, shiftA, shiftB);
+}
+
+TARGET_AVX2 int64_t differenceLine_AVX2(const int *a, const int *b, int *diff, int count, int shiftA, int shiftB, int amplification, int diffZero, int clipMax)
+{
+  const __m128i vShiftA = _mm_cvtsi32_si128(shiftA);
+  const __m128i vShiftB = _mm_cvtsi32_si128(shiftB);
+  const __m256i vAmplification = _mm256_set1_epi32(amplification);
+  const __m256i vDiffZero = _mm256_set1_epi32(diffZero);
+  const __m256i vMax = _mm256_set1_epi32(clipMax);
+  const __m256i vZero = _mm256_setzero_si256();
+  __m256i sum = _mm256_setzero_si256();
+  int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m256i va = _mm256_sll_epi32(_mm256_loadu_si256((const __m256i*)(a + i)), vShiftA);
+    const __m256i vb = _mm256_sll_epi32(_mm256_loadu_si256((const __m256i*)(b + i)), vShiftB);
+    const __m256i d = _mm256_sub_epi32(va, vb);
+    const __m256i dOdd = _mm256_srli_epi64(d, 32);
+    sum = _mm256_add_epi64(sum, _mm256_add_epi64(_mm256_mul_epi32(d, d), _mm256_mul_epi32(dOdd, dOdd)));
+    __m256i val = _mm256_add_epi32(_mm256_mullo_epi32(d, vAmplification), vDiffZero);
+    val = _mm256_min_epi32(_mm256_max_epi32(val, vZero), vMax);
+    _mm256_storeu_si256((__m256i*)(diff + i), val);
+  }
+  int64_t lanes[4];
+  _mm256_storeu_si256((__m256i*)lanes, sum);
+  return lanes[0] + lanes[1] + lanes[2] + lanes[3] + differenceLine_C(a + i, b + i, diff + i, count - i, shiftA, shiftB, amplification, diffZero, clipMax);
+}
+
+TARGET_AVX2 void writeSamples_AVX2(const int *src, unsigned char *dst, int count, int bps, bool bigEndian)
+{
+  // The pack instructions work per 128 bit lane. The permutation restores the order of the samples.
+  int i = 0;
+  if (bps > 8)
+  {
+    const __m256i swapBytes = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                               1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    for (; i + 16 <= count; i += 16)
+    {
+      __m256i v = _mm256_packus_epi32(_mm256_loadu_si256((const __m256i*)(src + i)), _mm256_loadu_si256((const __m256i*)(src + i + 8)));
+      v = _mm256_permute4x64_epi64(v, 0xd8);
+      if (bigEndian)
+        v = _mm256_shuffle_epi8(v, swapBytes);
+      _mm256_storeu_si256((__m256i*)(dst + i * 2), v);
+    }
+  }
+  else
+  {
+    for (; i + 16 <= count; i += 16)
+    {
+      __m256i v = _mm256_packus_epi32(_mm256_loadu_si256((const __m256i*)(src + i)), _mm256_loadu_si256((const __m256i*)(src + i + 8)));
+      v = _mm256_permute4x64_epi64(v, 0xd8);
+      _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+    }
+  }
+  writeSamples_C(src + i, dst + i * (bps > 8 ? 2 : 1), count - i, bps, bigEndian);
+}
+
+TARGET_AVX2 void markDifferencesLineToBGRA_AVX2(const int *srcY, const int *srcU, const int *srcV, unsigned char *dst, int count, int cZero)
+{
+  const __m256i vCZero = _mm256_set1_epi32(cZero);
+  const __m256i dark = _mm256_set1_epi32(70);
+  const __m256i bright = _mm256_set1_epi32(255);
+  const __m256i alpha = _mm256_set1_epi32((int)0xff000000);
+
+  int i = 0;
+  for (; i + 8 <= count; i += 8)
+  {
+    const __m256i noDiffY = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(srcY + i)), vCZero);
+    const __m256i noDiffU = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(srcU + i)), vCZero);
+    const __m256i noDiffV = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(srcV + i)), vCZero);
+
+    const __m256i grey = _mm256_and_si256(_mm256_andnot_si256(noDiffY, noDiffU), _mm256_and_si256(noDiffV, dark));
+    const __m256i chromaVal = _mm256_blendv_epi8(bright, dark, noDiffY);
+    const __m256i r = grey;
+    const __m256i g = _mm256_or_si256(_mm256_andnot_si256(noDiffU, chromaVal), grey);
+    const __m256i b = _mm256_or_si256(_mm256_andnot_si256(noDiffV, chromaVal), grey);
+
+    const __m256i bgra = _mm256_or_si256(_mm256_or_si256(b, _mm256_slli_epi32(g, 8)), _mm256_or_si256(_mm256_slli_epi32(r, 16), alpha));
+    _mm256_storeu_si256((__m256i*)(dst + i * 4), bgra);
+  }
+  markDifferencesLineToBGRA_C(srcY + i, srcU + i, srcV + i, dst + i * 4, count - i, cZero);
+}
+
+#endif // YUV_KERNELS_X86
+
+SIMDLevel detectSIMDLevel()
+{
+#if YUV_KERNELS_X86
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  const int maxLeaf = info[0];
+  __cpuid(info, 1);
+  const bool sse41 = (info[2] & (1 << 19)) != 0;
+  // AVX2 also requires that the OS saves the YMM registers on a context switch (OSXSAVE + XGETBV)
+  const bool osAVX = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+  bool avx2 = false;
+  if (osAVX && maxLeaf >= 7)
+  {
+    __cpuidex(info, 7, 0);
+    avx2 = (info[1] & (1 << 5)) != 0;
+  }
+#else
+  __builtin_cpu_init();
+  const bool sse41 = __builtin_cpu_supports("sse4.1");
+  const bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+  if (avx2)
+    return SIMD_AVX2;
+  if (sse41)
+    return SIMD_SSE4_1;
+#endif
+  return SIMD_None;
+}
+
+const lineKernels kernelsC = {SIMD_None, &readSamples_C, &applyMath_C, &convertLineToBGRA_C, &sumSquaredDifference_C,
+                              &differenceLine_C, &writeSamples_C, &markDifferencesLineToBGRA_C};
+#if YUV_KERNELS_X86
+const lineKernels kernelsSSE4_1 = {SIMD_SSE4_1, &readSamples_SSE4_1, &applyMath_SSE4_1, &convertLineToBGRA_SSE4_1, &sumSquaredDifference_SSE4_1,
+                                   &differenceLine_SSE4_1, &writeSamples_SSE4_1, &markDifferencesLineToBGRA_SSE4_1};
+const lineKernels kernelsAVX2 = {SIMD_AVX2, &readSamples_AVX2, &applyMath_AVX2, &convertLineToBGRA_AVX2, &sumSquaredDifference_AVX2,
+                                 &differenceLine_AVX2, &writeSamples_AVX2, &markDifferencesLineToBGRA_AVX2};
+#endif
+
+} // anonymous namespace
+
+SIMDLevel getSupportedSIMDLevel()
+{
+  static const SIMDLevel level = detectSIMDLevel();
+  return level;
+}
+
+const char *getSIMDLevelName(SIMDLevel level)
+{
+  if (level == SIMD_SSE4_1)
+    return "SSE4.1";
+  if (level == SIMD_AVX2)
+    return "AVX2";
+  return "None";
+}
+
+const lineKernels &getLineKernels()
+{
+  return getLineKernels(getSupportedSIMDLevel());
+}
+
+const lineKernels &getLineKernels(SIMDLevel level)
+{
+  if (level > getSupportedSIMDLevel())
+    level = getSupportedSIMDLevel();
+#if YUV_KERNELS_X86
+  if (level == SIMD_AVX2)
+    return kernelsAVX2;
+  if (level == SIMD_SSE4_1)
+    return kernelsSSE4_1;
+#endif
+  return kernelsC;
+}
+
+} // namespace YUV_Internals
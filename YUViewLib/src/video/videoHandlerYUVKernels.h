@@ -0,0 +1,102 @@
+/*  This file is part of YUView - The YUV player with advanced analytics toolset
+*   <https://github.com/IENT/YUView>
+*   Copyright (C) 2015  Institut für Nachrichtentechnik, RWTH Aachen University, GERMANY
+*
+*   This program is free software; you can redistribute it and/or modify
+*   it under the terms of the GNU General Public License as published by
+*   the Free Software Foundation; either version 3 of the License, or
+*   (at your option) any later version.
+*
+*   In addition, as a special exception, the copyright holders give
+*   permission to link the code of portions of this program with the
+*   OpenSSL library under certain conditions as described in each
+*   individual source file, and distribute linked combinations including
+*   the two.
+*   
+*   You must obey the GNU General Public License in all respects for all
+*   of the code used other than OpenSSL. If you modify file(s) with this
+*   exception, you may extend this exception to your version of the
+*   file(s), but you are not obligated to do so. If you do not wish to do
+*   so, delete this exception statement from your version. If you delete
+*   this exception statement from all source files in the program, then
+*   also delete it here.
+*
+*   This program is distributed in the hope that it will be useful,
+*   but WITHOUT ANY WARRANTY; without even the implied warranty of
+*   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+*   GNU General Public License for more details.
+*
+*   You should have received a copy of the GNU General Public License
+*   along with this program. If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef VIDEOHANDLERYUVKERNELS_H
+#define VIDEOHANDLERYUVKERNELS_H
+
+#include <cstdint>
+
+// The line kernels used by the YUV to RGB conversion in the videoHandlerYUV. Every kernel exists in a plain C++
+// version and in vectorized versions (SSE4.1, AVX2). The instruction set is selected once at runtime (CPUID).
+// All versions of a kernel produce exactly the same output so that the conversion result does not depend on the CPU.
+// This file is intentionally independent of Qt so that the kernels can also be tested on their own.
+namespace YUV_Internals
+{
+  typedef enum
+  {
+    SIMD_None,    // Plain C++ (always available)
+    SIMD_SSE4_1,
+    SIMD_AVX2,
+    SIMD_NUM
+  } SIMDLevel;
+
+  // The parameters for the conversion of one line of Y, U and V samples to BGRA. The U and V samples must already
+  // be up-sampled to the luma resolution.
+  struct lineConversionParameters
+  {
+    int RGBConv[5];   // The conversion matrix (see yuvRgbConvCoeffs)
+    int yOffset;      // The luma offset (16 in 8 bit for limited range, 0 for full range)
+    int cZero;        // The chroma zero value (128 in 8 bit)
+    int shift;        // The final right shift that brings the result to 8 bit
+    int preShift;     // For bit depths > 14, the samples are reduced by 2 bits before the multiplication (it would overflow otherwise)
+  };
+
+  // Fill the parameters for the given matrix, range and bit depth. This mirrors what convertYUVToRGB8Bit does per sample.
+  lineConversionParameters getLineConversionParameters(const int RGBConv[5], bool fullRange, int bitsPerSample);
+
+  struct lineKernels
+  {
+    SIMDLevel level;
+
+    // Read count samples from the raw source into dst. Every inValSkip-th sample is read (for interleaved U/V planes).
+    void (*readSamples)(const unsigned char *src, int *dst, int count, int inValSkip, int bps, bool bigEndian);
+    // Apply the YUV math (scale/offset/invert) to the samples and clip the result to (0...clipMax). See transformYUV().
+    void (*applyMath)(int *samples, int count, int scale, int offset, bool invert, int clipMax);
+    // Convert count Y/U/V samples to BGRA (4 bytes per pixel, alpha is set to 255)
+    void (*convertLineToBGRA)(const int *srcY, const int *srcU, const int *srcV, unsigned char *dst, int count, const lineConversionParameters &param);
+    // Get the sum of the squared differences between count samples of a and b. Before the difference is taken, the
+    // samples of a and b are shifted left by shiftA and shiftB (to compare samples with different bit depths).
+    int64_t (*sumSquaredDifference)(const int *a, const int *b, int count, int shiftA, int shiftB);
+    // Calculate the difference of count samples of a and b (shifted left like in sumSquaredDifference), multiply it by
+    // the amplification, add diffZero and clip the result to (0...clipMax). The sum of the squared differences (before
+    // the amplification) is returned. This is the whole per sample work of a YUV difference in one pass.
+    int64_t (*differenceLine)(const int *a, const int *b, int *diff, int count, int shiftA, int shiftB, int amplification, int diffZero, int clipMax);
+    // Write count samples to the raw destination (the inverse of readSamples with inValSkip 1). The samples must be
+    // in the range of the bit depth.
+    void (*writeSamples)(const int *src, unsigned char *dst, int count, int bps, bool bigEndian);
+    // Convert count Y/U/V difference samples to BGRA in a way that only marks where there are differences (no
+    // difference is cZero). The U and V samples must already be up-sampled to the luma resolution.
+    void (*markDifferencesLineToBGRA)(const int *srcY, const int *srcU, const int *srcV, unsigned char *dst, int count, int cZero);
+  };
+
+  // Get the best instruction set supported by this CPU (the CPU is only queried once).
+  SIMDLevel getSupportedSIMDLevel();
+  // Get a human readable name of the instruction set
+  const char *getSIMDLevelName(SIMDLevel level);
+  // Get the kernels for the best supported instruction set.
+  const lineKernels &getLineKernels();
+  // Get the kernels for the given instruction set. If the CPU does not support it, the best supported kernels
+  // with a lower level are returned. Use this for testing and benchmarking.
+  const lineKernels &getLineKernels(SIMDLevel level);
+}
+
+#endif // VIDEOHANDLERYUVKERNELS_H
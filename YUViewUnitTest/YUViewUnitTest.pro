@@ -2,4 +2,4 @@ TEMPLATE = subdirs
 
 requires(qtHaveModule(testlib))
 
-SUBDIRS = filesource
+SUBDIRS = cli filesource parser playlistitem statistics video
@@ -0,0 +1,16 @@
+TEMPLATE = app
+
+CONFIG += qt console warn_on no_testcase_installs depend_includepath testcase
+CONFIG -= debug_and_release
+CONFIG -= app_bundled
+
+TARGET = tst_batchAnalysis
+
+QT += testlib widgets opengl xml concurrent network charts
+
+# The batch analysis functions are part of the command line tool (not of the library). Build them into the test.
+INCLUDEPATH += $$top_srcdir/YUViewLib/src $$top_builddir/YUViewLib $$top_srcdir/YUViewCLI/src
+LIBS += -L$$top_builddir/YUViewLib -lYUViewLib
+
+SOURCES += tst_batchAnalysis.cpp $$top_srcdir/YUViewCLI/src/batchAnalysis.cpp
+HEADERS += $$top_srcdir/YUViewCLI/src/batchAnalysis.h
@@ -0,0 +1,128 @@
+#include <QtTest>
+
+#include <batchAnalysis.h>
+#include <video/videoHandlerYUV.h>
+
+class batchAnalysisTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    batchAnalysisTest();
+    ~batchAnalysisTest();
+
+private slots:
+    void testCompareIdenticalFiles();
+    void testCompareDifferentFiles();
+    void testCompareMissingFile();
+
+private:
+    // Write two 4:2:0 8 bit frames of 16x16 samples. The luma samples are set to lumaValue.
+    QString writeRawFile(const QString &fileName, char lumaValue);
+    // Read the PSNR values (Y, U, V) of the given frame from the CSV file of the comparison
+    QList<double> readPSNR(const QString &csvFile, int frameIdx);
+    batchAnalysis::options rawOptions() const;
+
+    QTemporaryDir tempDir;
+};
+
+batchAnalysisTest::batchAnalysisTest()
+{
+}
+
+batchAnalysisTest::~batchAnalysisTest()
+{
+}
+
+QString batchAnalysisTest::writeRawFile(const QString &fileName, char lumaValue)
+{
+    QByteArray frame(16 * 16, lumaValue);
+    frame.append(QByteArray(2 * 8 * 8, char(128)));
+
+    const QString filePath = tempDir.filePath(fileName);
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly))
+        return QString();
+    file.write(frame);
+    file.write(frame);
+    return filePath;
+}
+
+QList<double> batchAnalysisTest::readPSNR(const QString &csvFile, int frameIdx)
+{
+    QList<double> psnr;
+    QFile file(csvFile);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return psnr;
+
+    // Frame;MSE Y;MSE U;MSE V;PSNR Y;PSNR U;PSNR V
+    const QList<QByteArray> lines = file.readAll().split('\n');
+    if (lines.size() < frameIdx + 2)
+        return psnr;
+    const QList<QByteArray> values = lines[frameIdx + 1].split(';');
+    if (values.size() != 7)
+        return psnr;
+    for (int c = 4; c < 7; c++)
+        psnr.append(values[c].toDouble());
+    return psnr;
+}
+
+batchAnalysis::options batchAnalysisTest::rawOptions() const
+{
+    batchAnalysis::options opt;
+    opt.outputDir = tempDir.path();
+    opt.rawFrameSize = QSize(16, 16);
+    opt.rawPixelFormat = YUV_Internals::yuvPixelFormat(YUV_Internals::YUV_420, 8).getName();
+    return opt;
+}
+
+void batchAnalysisTest::testCompareIdenticalFiles()
+{
+    QVERIFY(tempDir.isValid());
+    batchAnalysis::job j;
+    j.fileA = writeRawFile("identicalA.yuv", char(100));
+    j.fileB = writeRawFile("identicalB.yuv", char(100));
+
+    const batchAnalysis::jobResult result = batchAnalysis::compareFiles(j, rawOptions());
+    QVERIFY2(result.success, qPrintable(result.message));
+    // Identical frames get a finite PSNR, so the average is finite as well
+    QVERIFY(result.message.contains("99.99/99.99/99.99"));
+
+    const QList<double> psnr = readPSNR(tempDir.filePath("identicalA_vs_identicalB_psnr.csv"), 1);
+    QCOMPARE(psnr.size(), 3);
+    for (double p : psnr)
+        QCOMPARE(p, 99.99);
+}
+
+void batchAnalysisTest::testCompareDifferentFiles()
+{
+    QVERIFY(tempDir.isValid());
+    batchAnalysis::job j;
+    j.fileA = writeRawFile("differentA.yuv", char(100));
+    j.fileB = writeRawFile("differentB.yuv", char(102));
+
+    const batchAnalysis::jobResult result = batchAnalysis::compareFiles(j, rawOptions());
+    QVERIFY2(result.success, qPrintable(result.message));
+
+    const QList<double> psnr = readPSNR(tempDir.filePath("differentA_vs_differentB_psnr.csv"), 0);
+    QCOMPARE(psnr.size(), 3);
+    // A luma MSE of 4
+    QVERIFY(qAbs(psnr[0] - 10.0 * std::log10(255.0 * 255.0 / 4.0)) < 0.01);
+    QCOMPARE(psnr[1], 99.99);
+    QCOMPARE(psnr[2], 99.99);
+}
+
+void batchAnalysisTest::testCompareMissingFile()
+{
+    QVERIFY(tempDir.isValid());
+    batchAnalysis::job j;
+    j.fileA = writeRawFile("existing.yuv", char(100));
+    j.fileB = tempDir.filePath("missing.yuv");
+
+    const batchAnalysis::jobResult result = batchAnalysis::compareFiles(j, rawOptions());
+    QVERIFY(!result.success);
+}
+
+QTEST_MAIN(batchAnalysisTest)
+
+#include "tst_batchAnalysis.moc"
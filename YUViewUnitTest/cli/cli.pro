@@ -0,0 +1,3 @@
+TEMPLATE = subdirs
+
+SUBDIRS = batchAnalysis
\ No newline at end of file
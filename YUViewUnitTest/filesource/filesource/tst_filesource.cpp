@@ -1,6 +1,10 @@
 #include <QtTest>
 
+#include <thread>
+#include <vector>
+
 #include <filesource/fileSource.h>
+#include <filesource/fileSourceAnnexBFile.h>
 
 class fileSourceTest : public QObject
 {
@@ -13,9 +17,40 @@ public:
 private slots:
     void testFormatFromFilename_data();
     void testFormatFromFilename();
+    void testReadBytesView();
+    void testReadBytesViewTruncatedFile();
+    void testNoMappingOfWatchedFiles();
+    void testReadBytesParallel();
+    void testAnnexBBackgroundReading();
 
 };
 
+namespace
+{
+    // Set a value in the settings and restore the old value when going out of scope
+    class settingOverride
+    {
+    public:
+        settingOverride(const QString &key, const QVariant &value) : key(key)
+        {
+            oldValue = settings.value(key);
+            settings.setValue(key, value);
+        }
+        ~settingOverride()
+        {
+            if (oldValue.isValid())
+                settings.setValue(key, oldValue);
+            else
+                settings.remove(key);
+        }
+
+    private:
+        QSettings settings;
+        QString key;
+        QVariant oldValue;
+    };
+}
+
 fileSourceTest::fileSourceTest()
 {
 }
@@ -115,6 +150,188 @@ void fileSourceTest::testFormatFromFilename()
     QCOMPARE(fileFormat.packed, packed);
 }
 
+void fileSourceTest::testReadBytesView()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QByteArray content(10000, 0);
+    for (int i = 0; i < content.size(); i++)
+        content[i] = char(i * 7);
+    file.write(content);
+    file.close();
+
+    fileSource source;
+    QVERIFY(source.openFile(file.fileName()));
+
+    // The view must hold the same data, no matter if the file is memory mapped or not
+    rawDataView view = source.readBytesView(1000, 5000);
+    QCOMPARE(view.size(), 5000);
+    QCOMPARE(view.toByteArray(), content.mid(1000, 5000));
+
+    QByteArray readData;
+    QCOMPARE(source.readBytes(readData, 1000, 5000), int64_t(5000));
+    QCOMPARE(view.toByteArray(), readData.left(5000));
+
+    // Reading beyond the end of the file returns an empty view
+    QVERIFY(source.readBytesView(9000, 2000).isEmpty());
+
+    // A view stays valid after the file was reopened
+    QVERIFY(source.openFile(file.fileName()));
+    QCOMPARE(view.toByteArray(), content.mid(1000, 5000));
+}
+
+void fileSourceTest::testReadBytesViewTruncatedFile()
+{
+#ifndef Q_OS_UNIX
+    QSKIP("A mapped file can not be truncated on this platform.");
+#endif
+    // Only files that are not watched for changes are mapped
+    settingOverride mapFiles("MemoryMapFiles", true);
+    settingOverride watchFiles("WatchFiles", false);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(QByteArray(10000, char(1)));
+    file.flush();
+
+    fileSource source;
+    QVERIFY(source.openFile(file.fileName()));
+    const bool mapped = source.isMemoryMapped();
+
+    // Truncate the file while it is mapped. Reading the part that was cut off must not crash.
+    QVERIFY(file.resize(4000));
+    QVERIFY(source.readBytesView(6000, 2000).isEmpty());
+    QCOMPARE(source.readBytesView(1000, 2000).toByteArray(), QByteArray(2000, char(1)));
+    // The mapping is not used anymore
+    if (mapped)
+        QVERIFY(!source.isMemoryMapped());
+}
+
+void fileSourceTest::testNoMappingOfWatchedFiles()
+{
+    settingOverride mapFiles("MemoryMapFiles", true);
+    settingOverride watchFiles("WatchFiles", true);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(QByteArray(10000, char(1)));
+    file.flush();
+
+    // A watched file may change while a view is used. So it is read and not mapped.
+    fileSource source;
+    QVERIFY(source.openFile(file.fileName()));
+    QVERIFY(!source.isMemoryMapped());
+    rawDataView view = source.readBytesView(1000, 2000);
+    QVERIFY(!view.isExternal());
+    QVERIFY(file.resize(0));
+    QCOMPARE(view.toByteArray(), QByteArray(2000, char(1)));
+
+    // Switching watching on again drops a mapping that was made while it was off
+    QVERIFY(file.resize(10000));
+    {
+        settingOverride noWatchFiles("WatchFiles", false);
+        source.updateFileWatchSetting();
+        source.updateMemoryMapSetting();
+    }
+    source.updateFileWatchSetting();
+    source.updateMemoryMapSetting();
+    QVERIFY(!source.isMemoryMapped());
+}
+
+void fileSourceTest::testReadBytesParallel()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    const int blockSize = 4096;
+    const int nrBlocks = 64;
+    QByteArray content(blockSize * nrBlocks, 0);
+    for (int i = 0; i < content.size(); i++)
+        content[i] = char((i / blockSize) ^ (i * 13));
+    file.write(content);
+    file.close();
+
+    fileSource source;
+    QVERIFY(source.openFile(file.fileName()));
+
+    // Read all blocks from multiple threads at the same time (in different orders)
+    const int nrThreads = 4;
+    QVector<int> nrErrors(nrThreads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nrThreads; t++)
+        threads.emplace_back([&, t]()
+        {
+            QByteArray buffer;
+            for (int i = 0; i < nrBlocks; i++)
+            {
+                const int block = (i * (2 * t + 1)) % nrBlocks;
+                if (source.readBytes(buffer, int64_t(block) * blockSize, blockSize) != blockSize || buffer.left(blockSize) != content.mid(block * blockSize, blockSize))
+                    nrErrors[t]++;
+            }
+        });
+    for (auto &thread : threads)
+        thread.join();
+
+    for (int t = 0; t < nrThreads; t++)
+        QCOMPARE(nrErrors[t], 0);
+}
+
+void fileSourceTest::testAnnexBBackgroundReading()
+{
+    // Create a file with NAL units of random size that spans multiple buffers. Use both start code lengths.
+    // The payload never contains a 0 byte so that there are no emulated start codes.
+    qsrand(42);
+    QByteArray content;
+    QList<int> nalStartPositions;
+    while (content.size() < 3 * BUFFER_SIZE + 1234)
+    {
+        nalStartPositions.append(content.size());
+        if (qrand() % 2)
+            content.append((char)0);
+        content.append((char)0);
+        content.append((char)0);
+        content.append((char)1);
+        const int nalSize = 1 + qrand() % 20000;
+        for (int i = 0; i < nalSize; i++)
+            content.append(char(0x80 | (qrand() & 0x7f)));
+    }
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write(content);
+    file.close();
+
+    QList<QByteArray> nalsDirect;
+    QList<QUint64Pair> positionsDirect;
+    fileSourceAnnexBFile direct(file.fileName());
+    while (!direct.atEnd())
+    {
+        QUint64Pair pos;
+        nalsDirect.append(direct.getNextNALUnit(false, &pos));
+        positionsDirect.append(pos);
+    }
+    QCOMPARE(nalsDirect.size(), nalStartPositions.size());
+    for (int i = 0; i < nalStartPositions.size(); i++)
+        QCOMPARE(int(positionsDirect[i].first), nalStartPositions[i]);
+
+    // Reading in the background must return the same NAL units
+    fileSourceAnnexBFile background(file.fileName());
+    background.startBackgroundReading();
+    QList<QByteArray> nalsBackground;
+    QList<QUint64Pair> positionsBackground;
+    while (!background.atEnd())
+    {
+        QUint64Pair pos;
+        nalsBackground.append(background.getNextNALUnit(false, &pos));
+        positionsBackground.append(pos);
+    }
+    QCOMPARE(nalsBackground, nalsDirect);
+    QCOMPARE(positionsBackground, positionsDirect);
+
+    // Seeking stops the background reading
+    QVERIFY(background.seek(nalStartPositions[3]));
+    QCOMPARE(background.getNextNALUnit(), nalsDirect[3]);
+}
+
 QTEST_MAIN(fileSourceTest)
 
 #include "tst_filesource.moc"
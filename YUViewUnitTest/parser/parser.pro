@@ -0,0 +1,3 @@
+TEMPLATE = subdirs
+
+SUBDIRS = parserAnnexBIndex parserAnnexBPacketMode subByteReader
\ No newline at end of file
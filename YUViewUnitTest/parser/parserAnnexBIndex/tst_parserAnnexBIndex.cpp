@@ -0,0 +1,280 @@
+#include <QtTest>
+
+#include <parser/parserAnnexBAVC.h>
+
+// Give the test access to reading the bitstream index
+class indexTestParser : public parserAnnexBAVC
+{
+public:
+    using parserAnnexB::loadIndex;
+};
+
+class parserAnnexBIndexTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    parserAnnexBIndexTest();
+    ~parserAnnexBIndexTest();
+
+private slots:
+    void initTestCase();
+    void testSaveAndLoadIndex();
+
+};
+
+namespace
+{
+    // Write the bits of an AVC RBSP
+    class bitWriter
+    {
+    public:
+        void writeBits(unsigned value, int nrBits)
+        {
+            for (int i = nrBits - 1; i >= 0; i--)
+            {
+                if (bitPos % 8 == 0)
+                    data.append(char(0));
+                if ((value >> i) & 1)
+                    data[bitPos / 8] = char(data[bitPos / 8] | (0x80 >> (bitPos % 8)));
+                bitPos++;
+            }
+        }
+        void writeFlag(bool flag) { writeBits(flag ? 1 : 0, 1); }
+        void writeUEV(unsigned value)
+        {
+            int nrBits = 0;
+            while (((value + 1) >> (nrBits + 1)) != 0)
+                nrBits++;
+            writeBits(0, nrBits);
+            writeBits(value + 1, nrBits + 1);
+        }
+        void writeSEV(int value) { writeUEV(value <= 0 ? unsigned(-2 * value) : unsigned(2 * value - 1)); }
+        // Add the rbsp_trailing_bits and return the data
+        QByteArray finish()
+        {
+            writeBits(1, 1);
+            while (bitPos % 8 != 0)
+                writeBits(0, 1);
+            return data;
+        }
+
+    private:
+        QByteArray data;
+        int bitPos {0};
+    };
+
+    // The NAL unit without the start code. Emulation prevention bytes are inserted into the payload.
+    QByteArray nalUnit(int nalRefIdc, int nalUnitType, const QByteArray &rbsp)
+    {
+        QByteArray nal;
+        nal.append(char((nalRefIdc << 5) | nalUnitType));
+        int nrZeros = 0;
+        for (char c : rbsp)
+        {
+            if (nrZeros == 2 && (unsigned char)(c) <= 3)
+            {
+                nal.append(char(3));
+                nrZeros = 0;
+            }
+            nal.append(c);
+            nrZeros = (c == 0) ? nrZeros + 1 : 0;
+        }
+        return nal;
+    }
+
+    QByteArray spsNAL(int widthInMbs, int heightInMbs)
+    {
+        bitWriter w;
+        w.writeBits(66, 8);       // profile_idc (baseline)
+        w.writeBits(0, 8);        // constraint_set flags and reserved_zero_2bits
+        w.writeBits(30, 8);       // level_idc
+        w.writeUEV(0);            // seq_parameter_set_id
+        w.writeUEV(0);            // log2_max_frame_num_minus4
+        w.writeUEV(0);            // pic_order_cnt_type
+        w.writeUEV(0);            // log2_max_pic_order_cnt_lsb_minus4
+        w.writeUEV(1);            // max_num_ref_frames
+        w.writeFlag(false);       // gaps_in_frame_num_value_allowed_flag
+        w.writeUEV(widthInMbs - 1);
+        w.writeUEV(heightInMbs - 1);
+        w.writeFlag(true);        // frame_mbs_only_flag
+        w.writeFlag(true);        // direct_8x8_inference_flag
+        w.writeFlag(false);       // frame_cropping_flag
+        w.writeFlag(false);       // vui_parameters_present_flag
+        return nalUnit(3, 7, w.finish());
+    }
+
+    QByteArray ppsNAL(int ppsID, int initQP)
+    {
+        bitWriter w;
+        w.writeUEV(ppsID);
+        w.writeUEV(0);            // seq_parameter_set_id
+        w.writeFlag(false);       // entropy_coding_mode_flag
+        w.writeFlag(false);       // bottom_field_pic_order_in_frame_present_flag
+        w.writeUEV(0);            // num_slice_groups_minus1
+        w.writeUEV(0);            // num_ref_idx_l0_default_active_minus1
+        w.writeUEV(0);            // num_ref_idx_l1_default_active_minus1
+        w.writeFlag(false);       // weighted_pred_flag
+        w.writeBits(0, 2);        // weighted_bipred_idc
+        w.writeSEV(initQP - 26);  // pic_init_qp_minus26
+        w.writeSEV(0);            // pic_init_qs_minus26
+        w.writeSEV(0);            // chroma_qp_index_offset
+        w.writeFlag(false);       // deblocking_filter_control_present_flag
+        w.writeFlag(false);       // constrained_intra_pred_flag
+        w.writeFlag(false);       // redundant_pic_cnt_present_flag
+        return nalUnit(3, 8, w.finish());
+    }
+
+    // An IDR, a (reference) I or a (non reference) P slice with a header only
+    enum sliceKind { idrSlice, intraSlice, interSlice };
+    QByteArray sliceNAL(sliceKind kind, int ppsID, int frameNum, int pocLsb)
+    {
+        const bool idr = (kind == idrSlice);
+        const bool reference = (kind != interSlice);
+        bitWriter w;
+        w.writeUEV(0);                            // first_mb_in_slice
+        w.writeUEV(kind == interSlice ? 5 : 7);   // slice_type (P or I)
+        w.writeUEV(ppsID);
+        w.writeBits(frameNum, 4);
+        if (idr)
+            w.writeUEV(0);                        // idr_pic_id
+        w.writeBits(pocLsb, 4);                   // pic_order_cnt_lsb
+        if (kind == interSlice)
+        {
+            w.writeFlag(false);                   // num_ref_idx_active_override_flag
+            w.writeFlag(false);                   // ref_pic_list_modification_flag_l0
+        }
+        if (reference)
+        {
+            // dec_ref_pic_marking
+            w.writeFlag(false);
+            if (idr)
+                w.writeFlag(false);
+        }
+        w.writeSEV(0);                            // slice_qp_delta
+        w.writeBits(0x5a, 8);                     // Some slice data
+        return nalUnit(reference ? 3 : 0, idr ? 5 : 1, w.finish());
+    }
+
+    QByteArray startCode() { return QByteArray("\0\0\0\1", 4); }
+}
+
+parserAnnexBIndexTest::parserAnnexBIndexTest()
+{
+}
+
+parserAnnexBIndexTest::~parserAnnexBIndexTest()
+{
+}
+
+void parserAnnexBIndexTest::initTestCase()
+{
+    // Do not write the index files to the cache of the user
+    QStandardPaths::setTestModeEnabled(true);
+}
+
+void parserAnnexBIndexTest::testSaveAndLoadIndex()
+{
+    // Three random access points. The parameter sets change between them (a PPS is replaced, a PPS is added and
+    // the SPS is replaced). Each random access point must get the parameter sets that are active there.
+    const QByteArray sps0 = spsNAL(11, 9);
+    const QByteArray sps1 = spsNAL(22, 18);
+    const QByteArray pps0 = ppsNAL(0, 26);
+    const QByteArray pps0b = ppsNAL(0, 30);
+    const QByteArray pps0c = ppsNAL(0, 32);
+    const QByteArray pps1 = ppsNAL(1, 28);
+
+    QList<QByteArray> nalUnits;
+    nalUnits << sps0 << pps0;
+    nalUnits << sliceNAL(idrSlice, 0, 0, 0) << sliceNAL(interSlice, 0, 1, 2) << sliceNAL(interSlice, 0, 1, 4);
+    nalUnits << pps0b << pps1;
+    nalUnits << sliceNAL(intraSlice, 1, 1, 6) << sliceNAL(interSlice, 0, 2, 8);
+    nalUnits << sps1 << pps0c;
+    nalUnits << sliceNAL(idrSlice, 0, 0, 0) << sliceNAL(interSlice, 1, 1, 2);
+
+    QMap<int, QList<QByteArray>> expectedParameterSets;
+    expectedParameterSets.insert(0, QList<QByteArray>() << sps0 << pps0);
+    expectedParameterSets.insert(3, QList<QByteArray>() << sps0 << pps0b << pps1);
+    expectedParameterSets.insert(5, QList<QByteArray>() << sps1 << pps0c << pps1);
+
+    QByteArray stream;
+    for (const QByteArray &nal : nalUnits)
+        stream += startCode() + nal;
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString filePath = tempDir.filePath("index.h264");
+    {
+        QFile file(filePath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(stream), qint64(stream.size()));
+    }
+
+    // Parse the file. This saves the index.
+    parserAnnexBAVC parser;
+    {
+        QScopedPointer<fileSourceAnnexBFile> file(new fileSourceAnnexBFile(filePath));
+        QVERIFY(parser.parseAnnexBFile(file));
+    }
+    QCOMPARE(parser.getNumberPOCs(), 7);
+    QCOMPARE(parser.getRandomAccessFrames(), expectedParameterSets.keys());
+
+    // Read the index with another parser. It must return the same frames and seek information.
+    indexTestParser indexParser;
+    QVERIFY(indexParser.loadIndex(QFileInfo(filePath)));
+    QCOMPARE(indexParser.getNumberPOCs(), parser.getNumberPOCs());
+    QCOMPARE(indexParser.getRandomAccessFrames(), parser.getRandomAccessFrames());
+    QCOMPARE(indexParser.getSequenceSizeSamples(), parser.getSequenceSizeSamples());
+    for (int frameIdx : expectedParameterSets.keys())
+    {
+        int codingOrderFrameIdx = -1;
+        QCOMPARE(parser.getClosestSeekableFrameNumberBefore(frameIdx, codingOrderFrameIdx), frameIdx);
+        const QUint64Pair frameStartEnd = parser.getFrameStartEndPos(codingOrderFrameIdx);
+        int indexCodingOrderFrameIdx = -1;
+        QCOMPARE(indexParser.getClosestSeekableFrameNumberBefore(frameIdx, indexCodingOrderFrameIdx), frameIdx);
+        QCOMPARE(indexCodingOrderFrameIdx, codingOrderFrameIdx);
+        QCOMPARE(indexParser.getFrameStartEndPos(codingOrderFrameIdx), frameStartEnd);
+
+        uint64_t filePos = 0;
+        QCOMPARE(parser.getSeekFrameParamerSets(frameIdx, filePos), expectedParameterSets[frameIdx]);
+        QCOMPARE(filePos, frameStartEnd.first);
+
+        uint64_t indexFilePos = 0;
+        QCOMPARE(indexParser.getSeekFrameParamerSets(frameIdx, indexFilePos), expectedParameterSets[frameIdx]);
+        QCOMPARE(indexFilePos, filePos);
+    }
+
+    // The index must not be used anymore if the modification time of the bitstream changes
+    {
+        QFile file(filePath);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.setFileTime(QFileInfo(filePath).lastModified().addSecs(-60), QFileDevice::FileModificationTime));
+    }
+    indexTestParser staleTimeParser;
+    QVERIFY(!staleTimeParser.loadIndex(QFileInfo(filePath)));
+
+    // ... or if the size changes. Parsing the file again finds the new frame.
+    {
+        QFile file(filePath);
+        QVERIFY(file.open(QIODevice::Append));
+        const QByteArray frame = startCode() + sliceNAL(interSlice, 0, 2, 4);
+        QCOMPARE(file.write(frame), qint64(frame.size()));
+    }
+    indexTestParser staleSizeParser;
+    QVERIFY(!staleSizeParser.loadIndex(QFileInfo(filePath)));
+    parserAnnexBAVC newParser;
+    {
+        QScopedPointer<fileSourceAnnexBFile> file(new fileSourceAnnexBFile(filePath));
+        QVERIFY(newParser.parseAnnexBFile(file));
+    }
+    QCOMPARE(newParser.getNumberPOCs(), 8);
+
+    // The new index replaces the stale one
+    indexTestParser newIndexParser;
+    QVERIFY(newIndexParser.loadIndex(QFileInfo(filePath)));
+    QCOMPARE(newIndexParser.getNumberPOCs(), 8);
+}
+
+QTEST_MAIN(parserAnnexBIndexTest)
+
+#include "tst_parserAnnexBIndex.moc"
@@ -0,0 +1,112 @@
+#include <QtTest>
+
+#include <parser/parserAnnexBMpeg2.h>
+
+class parserAnnexBPacketModeTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    parserAnnexBPacketModeTest();
+    ~parserAnnexBPacketModeTest();
+
+private slots:
+    void testExpandLateNALUnit();
+
+private:
+    QByteArray sequenceHeader(unsigned width, unsigned height) const;
+    QByteArray intraPictureHeader(unsigned temporalReference) const;
+    QModelIndex findItem(QAbstractItemModel *model, const QModelIndex &parent, const QString &name) const;
+};
+
+parserAnnexBPacketModeTest::parserAnnexBPacketModeTest()
+{
+}
+
+parserAnnexBPacketModeTest::~parserAnnexBPacketModeTest()
+{
+}
+
+QByteArray parserAnnexBPacketModeTest::sequenceHeader(unsigned width, unsigned height) const
+{
+    QByteArray data;
+    data.append(char(0)).append(char(0)).append(char(1)).append(char(0xb3));
+    // horizontal_size_value (12), vertical_size_value (12), aspect_ratio_information 1, frame_rate_code 3
+    data.append(char(width >> 4)).append(char(((width & 0xf) << 4) | (height >> 8))).append(char(height & 0xff)).append(char(0x13));
+    // bit_rate_value 1 (18), marker_bit, vbv_buffer_size_value 1 (10), no flags set
+    data.append(char(0x00)).append(char(0x00)).append(char(0x60)).append(char(0x08));
+    return data;
+}
+
+QByteArray parserAnnexBPacketModeTest::intraPictureHeader(unsigned temporalReference) const
+{
+    QByteArray data;
+    data.append(char(0)).append(char(0)).append(char(1)).append(char(0x00));
+    // temporal_reference (10), picture_coding_type 1 (I), vbv_delay 0xffff (16), 3 bits of padding
+    data.append(char(temporalReference >> 2)).append(char(((temporalReference & 3) << 6) | 0x0f)).append(char(0xff)).append(char(0xf8));
+    return data;
+}
+
+QModelIndex parserAnnexBPacketModeTest::findItem(QAbstractItemModel *model, const QModelIndex &parent, const QString &name) const
+{
+    for (int row = 0; row < model->rowCount(parent); row++)
+    {
+        const QModelIndex index = model->index(row, 0, parent);
+        if (model->data(index).toString() == name)
+            return index;
+        const QModelIndex childIndex = findItem(model, index, name);
+        if (childIndex.isValid())
+            return childIndex;
+    }
+    return QModelIndex();
+}
+
+void parserAnnexBPacketModeTest::testExpandLateNALUnit()
+{
+    // Two sequences with 5 intra pictures each. The second sequence header replaces the first one.
+    QByteArray stream = sequenceHeader(176, 144);
+    for (unsigned t = 0; t < 5; t++)
+        stream.append(intraPictureHeader(t));
+    stream.append(sequenceHeader(352, 288));
+    for (unsigned t = 0; t < 5; t++)
+        stream.append(intraPictureHeader(t));
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString filePath = tempDir.filePath("packetMode.m2v");
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(stream), qint64(stream.size()));
+    file.close();
+
+    parserAnnexBMpeg2 parser;
+    parser.enableModel();
+    QVERIFY(parser.runParsingOfFile(filePath));
+    parser.updateNumberModelItems();
+
+    QAbstractItemModel *model = parser.getPacketItemModel();
+    QCOMPARE(model->rowCount(), 12);
+
+    // Expand the last picture. Only the NAL units since the last random access point and the
+    // latest sequence header are parsed again.
+    const QModelIndex lastPicture = model->index(11, 0);
+    QVERIFY(model->data(lastPicture).toString().contains("Picture Header"));
+    QVERIFY(model->canFetchMore(lastPicture));
+    model->fetchMore(lastPicture);
+    QVERIFY(model->rowCount(lastPicture) > 0);
+    const QModelIndex temporalReference = findItem(model, lastPicture, "temporal_reference");
+    QVERIFY(temporalReference.isValid());
+    QCOMPARE(model->data(temporalReference.sibling(temporalReference.row(), 1)).toString(), QString("4"));
+
+    // Expand the second sequence header
+    const QModelIndex secondSequenceHeader = model->index(6, 0);
+    QVERIFY(model->data(secondSequenceHeader).toString().contains("Sequence Header"));
+    model->fetchMore(secondSequenceHeader);
+    const QModelIndex width = findItem(model, secondSequenceHeader, "horizontal_size_value");
+    QVERIFY(width.isValid());
+    QCOMPARE(model->data(width.sibling(width.row(), 1)).toString(), QString("352"));
+}
+
+QTEST_MAIN(parserAnnexBPacketModeTest)
+
+#include "tst_parserAnnexBPacketMode.moc"
@@ -0,0 +1,139 @@
+#include <QtTest>
+
+#include <parser/parserCommon.h>
+
+using namespace parserCommon;
+
+class subByteReaderTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    subByteReaderTest();
+    ~subByteReaderTest();
+
+private slots:
+    void testReadBits_data();
+    void testReadBits();
+    void testReadUEV();
+
+};
+
+subByteReaderTest::subByteReaderTest()
+{
+}
+
+subByteReaderTest::~subByteReaderTest()
+{
+}
+
+// Insert emulation prevention bytes into the payload (like an encoder does)
+static QByteArray addEmulationPrevention(const QByteArray &payload)
+{
+    QByteArray out;
+    int zeroCount = 0;
+    for (char c : payload)
+    {
+        if (zeroCount == 2 && (unsigned char)c <= 3)
+        {
+            out.append(char(3));
+            zeroCount = 0;
+        }
+        out.append(c);
+        zeroCount = (c == 0) ? zeroCount + 1 : 0;
+    }
+    return out;
+}
+
+static unsigned int getBitsFromPayload(const QByteArray &payload, int bitPos, int nrBits)
+{
+    unsigned int val = 0;
+    for (int i = 0; i < nrBits; i++, bitPos++)
+    {
+        const unsigned char c = (unsigned char)payload[bitPos / 8];
+        val = (val << 1) | ((c >> (7 - bitPos % 8)) & 1);
+    }
+    return val;
+}
+
+void subByteReaderTest::testReadBits_data()
+{
+    QTest::addColumn<bool>("emulationPrevention");
+    QTest::addColumn<bool>("logBits");
+
+    QTest::newRow("plain") << false << false;
+    QTest::newRow("plain_log") << false << true;
+    QTest::newRow("emulationPrevention") << true << false;
+    QTest::newRow("emulationPrevention_log") << true << true;
+}
+
+void subByteReaderTest::testReadBits()
+{
+    QFETCH(bool, emulationPrevention);
+    QFETCH(bool, logBits);
+
+    qsrand(emulationPrevention ? 1 : 2);
+    for (int run = 0; run < 100; run++)
+    {
+        // Many zero bytes so that emulation prevention bytes are inserted
+        QByteArray payload(200 + qrand() % 100, 0);
+        for (int i = 0; i < payload.size(); i++)
+        {
+            const int r = qrand() % 4;
+            payload[i] = (r == 0 || r == 1) ? char(0) : (r == 2) ? char(qrand() % 4) : char(qrand() & 0xff);
+        }
+
+        sub_byte_reader reader(emulationPrevention ? addEmulationPrevention(payload) : payload);
+        if (!emulationPrevention)
+            reader.disableEmulationPrevention();
+
+        int bitPos = 0;
+        while (true)
+        {
+            const int nrBits = 1 + qrand() % 32;
+            if (bitPos + nrBits > payload.size() * 8)
+                break;
+
+            QString bitsRead;
+            const unsigned int val = reader.readBits(nrBits, logBits ? &bitsRead : nullptr);
+            const unsigned int expected = getBitsFromPayload(payload, bitPos, nrBits);
+            QCOMPARE(val, expected);
+            if (logBits)
+                QCOMPARE(bitsRead, QString::number(expected, 2).rightJustified(nrBits, '0'));
+            else
+                QVERIFY(bitsRead.isEmpty());
+            bitPos += nrBits;
+        }
+    }
+}
+
+void subByteReaderTest::testReadUEV()
+{
+    // The ue(v) codes of 0, 1, 2, 3, 7 and 255 with a one bit at the end
+    sub_byte_writer writer;
+    const unsigned int values[] = {0, 1, 2, 3, 7, 255};
+    for (unsigned int v : values)
+    {
+        const unsigned int code = v + 1;
+        int len = 0;
+        while ((code >> len) > 1)
+            len++;
+        writer.writeBits(0, len);
+        writer.writeBits(code, len + 1);
+    }
+    writer.writeBool(true);
+    writer.writeBits(0, 7);
+
+    sub_byte_reader reader(writer.getByteArray());
+    reader.disableEmulationPrevention();
+    for (unsigned int v : values)
+    {
+        int bitCount = 0;
+        QCOMPARE(reader.readUE_V(bitCount), v);
+    }
+    QCOMPARE(reader.readBits(1), 1u);
+}
+
+QTEST_MAIN(subByteReaderTest)
+
+#include "tst_subByteReader.moc"
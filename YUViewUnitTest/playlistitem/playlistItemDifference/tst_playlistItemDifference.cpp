@@ -0,0 +1,120 @@
+#include <QtTest>
+
+#include <cmath>
+
+#include <playlistitem/playlistItemDifference.h>
+#include <playlistitem/playlistItemRawFile.h>
+
+class playlistItemDifferenceTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    playlistItemDifferenceTest();
+    ~playlistItemDifferenceTest();
+
+private slots:
+    void testSequenceMetrics();
+
+};
+
+namespace
+{
+    // 16x8 YUV 4:2:0 8-bit frames
+    const int width = 16;
+    const int height = 8;
+    const int lumaSize = width * height;
+    const int chromaSize = lumaSize / 4;
+    const int nrFrames = 4;
+
+    // Frame f of the second input differs by f in all Y samples and by 2*f in all V samples. U is identical.
+    QByteArray frameData(int frameIdx, bool secondInput)
+    {
+        QByteArray data(lumaSize + 2 * chromaSize, 0);
+        for (int i = 0; i < data.size(); i++)
+        {
+            int value = 100 + (i * 7 + frameIdx * 3) % 50;
+            if (secondInput && i < lumaSize)
+                value += frameIdx;
+            else if (secondInput && i >= lumaSize + chromaSize)
+                value += 2 * frameIdx;
+            data[i] = char(value);
+        }
+        return data;
+    }
+
+    bool writeFile(const QString &filePath, bool secondInput)
+    {
+        QFile file(filePath);
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+        for (int f = 0; f < nrFrames; f++)
+            if (file.write(frameData(f, secondInput)) != lumaSize + 2 * chromaSize)
+                return false;
+        return true;
+    }
+
+    double expectedPSNR(int difference)
+    {
+        if (difference == 0)
+            return PSNR_IDENTICAL_FRAMES;
+        return 10.0 * std::log10(255.0 * 255.0 / double(difference * difference));
+    }
+}
+
+playlistItemDifferenceTest::playlistItemDifferenceTest()
+{
+}
+
+playlistItemDifferenceTest::~playlistItemDifferenceTest()
+{
+}
+
+void playlistItemDifferenceTest::testSequenceMetrics()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString filePath0 = tempDir.filePath("input0.yuv");
+    const QString filePath1 = tempDir.filePath("input1.yuv");
+    QVERIFY(writeFile(filePath0, false));
+    QVERIFY(writeFile(filePath1, true));
+
+    // The difference item owns (and deletes) its children
+    playlistItemDifference difference;
+    difference.addChild(new playlistItemRawFile(filePath0, QSize(width, height), "YUV 4:2:0 8-bit"));
+    difference.addChild(new playlistItemRawFile(filePath1, QSize(width, height), "YUV 4:2:0 8-bit"));
+    difference.updateChildItems();
+
+    // The inputs of the difference are set when it is drawn
+    QImage image(width, height, QImage::Format_ARGB32);
+    {
+        QPainter painter(&image);
+        difference.drawItem(&painter, 0, 1.0, false);
+    }
+
+    difference.startSequenceMetrics();
+    QTRY_VERIFY(!difference.isSequenceMetricsRunning());
+
+    const QVector<playlistItemDifference::frameMetrics> metrics = difference.getSequenceMetrics();
+    QCOMPARE(metrics.size(), nrFrames);
+    for (int f = 0; f < nrFrames; f++)
+    {
+        const playlistItemDifference::frameMetrics &m = metrics[f];
+        QCOMPARE(m.frameIdx, f);
+        QCOMPARE(m.mse[0], double(f * f));
+        QCOMPARE(m.mse[1], 0.0);
+        QCOMPARE(m.mse[2], double(4 * f * f));
+        QCOMPARE(m.psnr[0], expectedPSNR(f));
+        QCOMPARE(m.psnr[1], expectedPSNR(0));
+        QCOMPARE(m.psnr[2], expectedPSNR(2 * f));
+    }
+
+    // Starting again replaces the results
+    difference.startSequenceMetrics();
+    QTRY_VERIFY(!difference.isSequenceMetricsRunning());
+    QCOMPARE(difference.getSequenceMetrics().size(), nrFrames);
+}
+
+QTEST_MAIN(playlistItemDifferenceTest)
+
+#include "tst_playlistItemDifference.moc"
@@ -0,0 +1,155 @@
+#include <QtTest>
+
+#include <algorithm>
+
+#include <playlistitem/playlistItemRawFile.h>
+
+// Give the test access to the read ahead ring
+class readAheadTestItem : public playlistItemRawFile
+{
+public:
+    readAheadTestItem(const QString &filePath) : playlistItemRawFile(filePath, QSize(16, 8), "YUV 4:2:0 8-bit") {}
+
+    using playlistItemRawFile::startReadAhead;
+    using playlistItemRawFile::stopReadAhead;
+
+    void waitForReadAhead() { readAheadFuture.waitForFinished(); }
+    bool isReadAhead(int64_t fileStartPos)
+    {
+        QMutexLocker locker(&readAheadMutex);
+        for (const readAheadBuffer &b : readAheadRing)
+            if (b.fileStartPos == fileStartPos)
+                return true;
+        return false;
+    }
+    // The memory of all buffers in the ring
+    QList<const char*> ringBuffers()
+    {
+        QMutexLocker locker(&readAheadMutex);
+        QList<const char*> buffers;
+        for (const readAheadBuffer &b : readAheadRing)
+            buffers.append(b.data.constData());
+        std::sort(buffers.begin(), buffers.end());
+        return buffers;
+    }
+};
+
+class playlistItemRawFileTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    playlistItemRawFileTest();
+    ~playlistItemRawFileTest();
+
+private slots:
+    void initTestCase();
+    void testReadAheadHit();
+    void testReadAheadMiss();
+
+private:
+    QTemporaryDir tempDir;
+    QString filePath;
+};
+
+namespace
+{
+    // A 16x8 YUV 4:2:0 8-bit frame
+    const int bytesPerFrame = 16 * 8 * 3 / 2;
+    const int nrFrames = 10;
+
+    int64_t framePos(int frameIdx) { return int64_t(frameIdx) * bytesPerFrame; }
+
+    // Every frame has different data
+    QByteArray frameData(int frameIdx)
+    {
+        QByteArray data(bytesPerFrame, 0);
+        for (int i = 0; i < bytesPerFrame; i++)
+            data[i] = char((frameIdx * 37 + i) % 256);
+        return data;
+    }
+}
+
+playlistItemRawFileTest::playlistItemRawFileTest()
+{
+}
+
+playlistItemRawFileTest::~playlistItemRawFileTest()
+{
+}
+
+void playlistItemRawFileTest::initTestCase()
+{
+    QVERIFY(tempDir.isValid());
+    filePath = tempDir.filePath("readAhead.yuv");
+    QFile file(filePath);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    for (int i = 0; i < nrFrames; i++)
+        QCOMPARE(file.write(frameData(i)), qint64(bytesPerFrame));
+}
+
+void playlistItemRawFileTest::testReadAheadHit()
+{
+    readAheadTestItem item(filePath);
+    QCOMPARE(static_cast<playlistItem*>(&item)->getStartEndFrameLimits(), indexRange(0, nrFrames - 1));
+
+    // Without a measured read speed, two frames are read ahead
+    item.startReadAhead(2);
+    item.waitForReadAhead();
+    QVERIFY(item.isReadAhead(framePos(2)));
+    QVERIFY(item.isReadAhead(framePos(3)));
+    const QList<const char*> buffers = item.ringBuffers();
+    QCOMPARE(buffers.count(), 2);
+
+    // A caching thread gets the data but does not take the frame from the ring
+    rawDataView cachingData = item.pullRawFrameData(2, true);
+    QCOMPARE(cachingData.toByteArray(), frameData(2));
+    QVERIFY(item.isReadAhead(framePos(2)));
+
+    // Drawing the frame takes it from the ring. The data is copied so that the ring keeps its buffer.
+    rawDataView drawData = item.pullRawFrameData(2, false);
+    QCOMPARE(drawData.toByteArray(), frameData(2));
+    QVERIFY(!item.isReadAhead(framePos(2)));
+    QVERIFY(item.isReadAhead(framePos(3)));
+    QVERIFY(!buffers.contains(drawData.data()));
+
+    // The next frame is read into the free buffer. No new buffer is allocated while the data is still in use.
+    item.startReadAhead(3);
+    item.waitForReadAhead();
+    QVERIFY(item.isReadAhead(framePos(3)));
+    QVERIFY(item.isReadAhead(framePos(4)));
+    QCOMPARE(item.ringBuffers(), buffers);
+    QCOMPARE(drawData.toByteArray(), frameData(2));
+    QCOMPARE(item.pullRawFrameData(4, false).toByteArray(), frameData(4));
+
+    // At the end of the range, reading ahead continues with the first frame
+    item.startReadAhead(nrFrames - 1);
+    item.waitForReadAhead();
+    QVERIFY(item.isReadAhead(framePos(nrFrames - 1)));
+    QVERIFY(item.isReadAhead(framePos(0)));
+    QCOMPARE(item.pullRawFrameData(0, false).toByteArray(), frameData(0));
+}
+
+void playlistItemRawFileTest::testReadAheadMiss()
+{
+    readAheadTestItem item(filePath);
+
+    // Nothing was read ahead
+    QCOMPARE(item.pullRawFrameData(5, false).toByteArray(), frameData(5));
+
+    // A frame that is not in the ring is read from the file. The ring is not changed.
+    item.startReadAhead(2);
+    item.waitForReadAhead();
+    QCOMPARE(item.pullRawFrameData(6, false).toByteArray(), frameData(6));
+    QVERIFY(item.isReadAhead(framePos(2)));
+    QVERIFY(item.isReadAhead(framePos(3)));
+
+    // Stopping frees the ring
+    item.stopReadAhead();
+    QVERIFY(item.ringBuffers().isEmpty());
+    QCOMPARE(item.pullRawFrameData(2, false).toByteArray(), frameData(2));
+}
+
+QTEST_MAIN(playlistItemRawFileTest)
+
+#include "tst_playlistItemRawFile.moc"
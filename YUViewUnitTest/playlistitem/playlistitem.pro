@@ -0,0 +1,3 @@
+TEMPLATE = subdirs
+
+SUBDIRS = playlistItemDifference playlistItemRawFile
\ No newline at end of file
@@ -0,0 +1,3 @@
+TEMPLATE = subdirs
+
+SUBDIRS = statisticsBinaryFile statisticsBlockList statisticsCSVIndex statisticsVTMBMSParser
\ No newline at end of file
@@ -0,0 +1,15 @@
+TEMPLATE = app
+
+CONFIG += qt console warn_on no_testcase_installs depend_includepath testcase
+CONFIG -= debug_and_release
+CONFIG -= app_bundled
+
+TARGET = tst_statisticsBinaryFile
+
+QT += testlib widgets opengl xml concurrent network charts
+
+# The statistics headers include the generated ui headers of the library. The playlist items need all modules of the library.
+INCLUDEPATH += $$top_srcdir/YUViewLib/src $$top_builddir/YUViewLib
+LIBS += -L$$top_builddir/YUViewLib -lYUViewLib
+
+SOURCES += tst_statisticsBinaryFile.cpp
@@ -0,0 +1,344 @@
+#include <QtTest>
+
+#include <playlistitem/playlistItems.h>
+#include <playlistitem/playlistItemStatisticsBinaryFile.h>
+#include <statistics/statisticsBinaryFile.h>
+
+class statisticsBinaryFileTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    statisticsBinaryFileTest();
+    ~statisticsBinaryFileTest();
+
+private slots:
+    void testWriteAndRead();
+    void testOpenAsPlaylistItem();
+    void testConvertStatisticsFile_data();
+    void testConvertStatisticsFile();
+
+};
+
+namespace
+{
+    // A CSV file with the types interleaved within each POC. There are values, vectors and lines.
+    QByteArray createCSVFile()
+    {
+        QStringList lines;
+        lines << "%;syntax-version;v1.22";
+        lines << "%;seq-specs;test;0;64;32;25";
+        lines << "%;type;1;PredMode;map";
+        lines << "%;mapColor;0;255;0;0;255";
+        lines << "%;mapColor;1;0;255;0;255";
+        lines << "%;type;2;MVL0;vector";
+        lines << "%;scaleFactor;4";
+        lines << "%;type;3;Line;line";
+        lines << "%;type;4;QP;range";
+        lines << "%;defaultRange;0;51;jet";
+        qsrand(8);
+        for (int poc = 0; poc < 5; poc++)
+        {
+            // Frame 2 has no data
+            if (poc == 2)
+                continue;
+            for (int i = 0; i < 60; i++)
+            {
+                const QString block = QString("%1;%2;%3;%4;%5").arg(poc).arg(qrand() % 8 * 8).arg(qrand() % 4 * 8).arg(8 << (qrand() % 2)).arg(8);
+                const int v0 = qrand() % 200 - 100;
+                const int v1 = qrand() % 200 - 100;
+                switch (qrand() % 4)
+                {
+                case 0: lines << QString("%1;1;%2").arg(block).arg(qrand() % 2); break;
+                case 1: lines << QString("%1;2;%2;%3").arg(block).arg(v0).arg(v1); break;
+                case 2: lines << QString("%1;3;%2;%3;%4;%5").arg(block).arg(v0).arg(v1).arg(qrand() % 64).arg(qrand() % 32); break;
+                default: lines << QString("%1;4;%2").arg(block).arg(qrand() % 52); break;
+                }
+            }
+        }
+        return (lines.join("\n") + "\n").toLatin1();
+    }
+
+    QString randomBlock()
+    {
+        return QString("@(%1, %2) [%3x%4] ").arg(qrand() % 8 * 8, 4).arg(qrand() % 4 * 8, 4).arg(8 << (qrand() % 2), 2).arg(8, 2);
+    }
+
+    QString randomPolygon()
+    {
+        return QString("@[(%1, %2)--(%3, %4)--(%5, %6)--] ").arg(qrand() % 64, 3).arg(qrand() % 32, 3).arg(qrand() % 64, 3).arg(qrand() % 32, 3).arg(qrand() % 64, 3).arg(qrand() % 32, 3);
+    }
+
+    QString randomValues(int count)
+    {
+        QStringList values;
+        for (int i = 0; i < count; i++)
+            values.append(QString::number(qrand() % 200 - 100));
+        return "{" + values.join(",") + "}";
+    }
+
+    // A VTMBMS file with all kinds of types
+    QByteArray createVTMBMSFile()
+    {
+        QStringList lines;
+        lines << "# VTMBMS Block Statistics";
+        lines << "# Sequence size: [64x 32]";
+        lines << "# Block Statistic Type: PredMode; Integer; [0, 3]";
+        lines << "# Block Statistic Type: MVL0; Vector; Scale: 4";
+        lines << "# Block Statistic Type: Line; Line; ";
+        lines << "# Block Statistic Type: AffineMVL0; AffineTFVectors; Scale: 4";
+        lines << "# Block Statistic Type: GeoFlag; FlagPolygon; ";
+        lines << "# Block Statistic Type: GeoMVL0; VectorPolygon; Scale: 4";
+        qsrand(9);
+        for (int poc = 0; poc < 4; poc++)
+        {
+            for (int i = 0; i < 60; i++)
+            {
+                const QString start = QString("BlockStat: POC %1 ").arg(poc);
+                switch (qrand() % 6)
+                {
+                case 0: lines << start + randomBlock() + "PredMode=" + QString::number(qrand() % 4); break;
+                case 1: lines << start + randomBlock() + "MVL0=" + randomValues(2); break;
+                case 2: lines << start + randomBlock() + "Line=" + randomValues(4); break;
+                case 3: lines << start + randomBlock() + "AffineMVL0=" + randomValues(6); break;
+                case 4: lines << start + randomPolygon() + "GeoFlag=" + QString::number(qrand() % 2); break;
+                default: lines << start + randomPolygon() + "GeoMVL0=" + randomValues(2); break;
+                }
+            }
+        }
+        return (lines.join("\n") + "\n").toLatin1();
+    }
+
+    void compareBlocks(const statisticsBlockList &actual, const statisticsBlockList &expected)
+    {
+        QCOMPARE(actual.posX, expected.posX);
+        QCOMPARE(actual.posY, expected.posY);
+        QCOMPARE(actual.width, expected.width);
+        QCOMPARE(actual.height, expected.height);
+    }
+
+    void compareData(const statisticsData &actual, const statisticsData &expected)
+    {
+        compareBlocks(actual.valueBlocks, expected.valueBlocks);
+        QCOMPARE(actual.values, expected.values);
+        compareBlocks(actual.vectorBlocks, expected.vectorBlocks);
+        QCOMPARE(actual.vectorPoints0, expected.vectorPoints0);
+        QCOMPARE(actual.vectorPoints1, expected.vectorPoints1);
+        QCOMPARE(actual.vectorIsLine, expected.vectorIsLine);
+        compareBlocks(actual.affineTFBlocks, expected.affineTFBlocks);
+        QCOMPARE(actual.affineTFPoints, expected.affineTFPoints);
+        QCOMPARE(actual.polygonValueData.size(), expected.polygonValueData.size());
+        for (int i = 0; i < expected.polygonValueData.size(); i++)
+        {
+            QCOMPARE(actual.polygonValueData[i].corners, expected.polygonValueData[i].corners);
+            QCOMPARE(actual.polygonValueData[i].value, expected.polygonValueData[i].value);
+        }
+        QCOMPARE(actual.polygonVectorData.size(), expected.polygonVectorData.size());
+        for (int i = 0; i < expected.polygonVectorData.size(); i++)
+        {
+            QCOMPARE(actual.polygonVectorData[i].corners, expected.polygonVectorData[i].corners);
+            QCOMPARE(actual.polygonVectorData[i].point[0], expected.polygonVectorData[i].point[0]);
+        }
+        QCOMPARE(actual.maxBlockSize, expected.maxBlockSize);
+    }
+}
+
+statisticsBinaryFileTest::statisticsBinaryFileTest()
+{
+}
+
+statisticsBinaryFileTest::~statisticsBinaryFileTest()
+{
+}
+
+void statisticsBinaryFileTest::testWriteAndRead()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString filePath = tempDir.filePath("test.yuvstat");
+
+    StatisticsTypeList types;
+    types.append(StatisticsType(1, "PredMode", "jet", 0, 3));
+    types.append(StatisticsType(5, "MVL0", 4));
+    types[1].hasVectorData = true;
+    types[1].valMap.insert(2, "two");
+
+    statisticsData values;
+    values.addBlockValue(0, 0, 16, 8, 3);
+    values.addBlockValue(16, 0, 8, 8, -1);
+
+    statisticsData vectors;
+    vectors.addBlockVector(8, 8, 8, 8, -24, 2);
+    vectors.addLine(0, 8, 8, 8, 1, 2, 3, 4);
+    vectors.addBlockAffineTF(32, 0, 16, 16, 1, -2, 3, -4, 5, -6);
+    vectors.addPolygonValue(QVector<QPoint>() << QPoint(0, 0) << QPoint(4, 0) << QPoint(0, 4), 7);
+    vectors.addPolygonVector(QVector<QPoint>() << QPoint(1, 1) << QPoint(5, 1) << QPoint(5, 5) << QPoint(1, 5), 9, -9);
+
+    {
+        statisticsBinaryFile::writer writer(filePath);
+        QVERIFY(writer.start(QSize(64, 32), 25.0, types));
+        // Write the frames out of order. The table must still be sorted.
+        QVERIFY(writer.writeFrameType(3, 5, vectors));
+        QVERIFY(writer.writeFrameType(0, 1, values));
+        QVERIFY(writer.writeFrameType(3, 1, values));
+        QVERIFY(writer.finish(3));
+    }
+
+    fileSource file;
+    QVERIFY(file.openFile(filePath));
+    statisticsBinaryFile::fileHeader header;
+    QString errorText;
+    QVERIFY(statisticsBinaryFile::readFileHeader(file, header, errorText));
+
+    QCOMPARE(header.frameSize, QSize(64, 32));
+    QCOMPARE(header.frameRate, 25.0);
+    QCOMPARE(header.maxPOC, 3);
+    QCOMPARE(header.types.size(), 2);
+    QCOMPARE(header.types[0].typeName, QString("PredMode"));
+    QCOMPARE(header.types[0].colMapper.complexType, QString("jet"));
+    QCOMPARE(header.types[1].typeID, 5);
+    QCOMPARE(header.types[1].vectorScale, 4);
+    QCOMPARE(header.types[1].valMap.value(2), QString("two"));
+    QCOMPARE(header.table.size(), 3);
+
+    QVERIFY(statisticsBinaryFile::findEntry(header.table, 0, 5) == nullptr);
+    QVERIFY(statisticsBinaryFile::findEntry(header.table, 1, 1) == nullptr);
+
+    const statisticsBinaryFile::frameTypeEntry *valueEntry = statisticsBinaryFile::findEntry(header.table, 3, 1);
+    QVERIFY(valueEntry != nullptr);
+    statisticsData readValues;
+    QVERIFY(statisticsBinaryFile::decodeFrameType(file.readBytesView(valueEntry->offset, valueEntry->size).data(), *valueEntry, readValues));
+    QCOMPARE(readValues.valueBlocks.count(), 2);
+    QCOMPARE(readValues.valueBlocks.getRect(1), QRect(16, 0, 8, 8));
+    QCOMPARE(readValues.values[1], -1);
+    QCOMPARE(readValues.maxBlockSize, values.maxBlockSize);
+
+    const statisticsBinaryFile::frameTypeEntry *vectorEntry = statisticsBinaryFile::findEntry(header.table, 3, 5);
+    QVERIFY(vectorEntry != nullptr);
+    statisticsData readVectors;
+    QVERIFY(statisticsBinaryFile::decodeFrameType(file.readBytesView(vectorEntry->offset, vectorEntry->size).data(), *vectorEntry, readVectors));
+    QCOMPARE(readVectors.vectorBlocks.count(), 2);
+    QCOMPARE(readVectors.vectorIsLine[0], false);
+    QCOMPARE(readVectors.vectorPoints0[0], QPoint(-24, 2));
+    QCOMPARE(readVectors.vectorIsLine[1], true);
+    QCOMPARE(readVectors.vectorPoints1[1], QPoint(3, 4));
+    QCOMPARE(readVectors.affineTFBlocks.count(), 1);
+    QCOMPARE(readVectors.affineTFPoints[2], QPoint(5, -6));
+    QCOMPARE(readVectors.polygonValueData.size(), 1);
+    QCOMPARE(readVectors.polygonValueData[0].corners, vectors.polygonValueData[0].corners);
+    QCOMPARE(readVectors.polygonValueData[0].value, 7);
+    QCOMPARE(readVectors.polygonVectorData.size(), 1);
+    QCOMPARE(readVectors.polygonVectorData[0].corners, vectors.polygonVectorData[0].corners);
+    QCOMPARE(readVectors.polygonVectorData[0].point[0], QPoint(9, -9));
+
+    // Corrupt data must be detected
+    statisticsBinaryFile::frameTypeEntry truncated = *vectorEntry;
+    truncated.size -= 4;
+    statisticsData corrupt;
+    QVERIFY(!statisticsBinaryFile::decodeFrameType(file.readBytesView(truncated.offset, truncated.size).data(), truncated, corrupt));
+}
+
+void statisticsBinaryFileTest::testOpenAsPlaylistItem()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString filePath = tempDir.filePath("test.yuvstat");
+
+    StatisticsTypeList types;
+    types.append(StatisticsType(1, "PredMode", "jet", 0, 3));
+    statisticsData values;
+    values.addBlockValue(0, 0, 16, 8, 3);
+    {
+        statisticsBinaryFile::writer writer(filePath);
+        QVERIFY(writer.start(QSize(64, 32), 25.0, types));
+        QVERIFY(writer.writeFrameType(2, 1, values));
+        QVERIFY(writer.finish(2));
+    }
+
+    // A converted file must be opened as a binary statistics file (and not be taken for another statistics format)
+    QScopedPointer<playlistItem> item(playlistItems::createPlaylistItemFromFile(nullptr, filePath));
+    QVERIFY(!item.isNull());
+    playlistItemStatisticsBinaryFile *binaryItem = qobject_cast<playlistItemStatisticsBinaryFile*>(item.data());
+    QVERIFY(binaryItem != nullptr);
+    QCOMPARE(item->getStartEndFrameLimits(), indexRange(0, 2));
+    QCOMPARE(binaryItem->getStatisticsHandler()->getStatisticsTypeList().size(), 1);
+}
+
+void statisticsBinaryFileTest::testConvertStatisticsFile_data()
+{
+    QTest::addColumn<QString>("fileName");
+    QTest::addColumn<QByteArray>("fileData");
+    QTest::addColumn<int>("nrFrames");
+
+    QTest::newRow("CSV") << "test.csv" << createCSVFile() << 5;
+    QTest::newRow("VTMBMS") << "test.vtmbmsstats" << createVTMBMSFile() << 4;
+}
+
+void statisticsBinaryFileTest::testConvertStatisticsFile()
+{
+    QFETCH(QString, fileName);
+    QFETCH(QByteArray, fileData);
+    QFETCH(int, nrFrames);
+
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString sourcePath = tempDir.filePath(fileName);
+    const QString targetPath = tempDir.filePath("converted.yuvstat");
+    {
+        QFile sourceFile(sourcePath);
+        QVERIFY(sourceFile.open(QIODevice::WriteOnly));
+        QCOMPARE(sourceFile.write(fileData), qint64(fileData.size()));
+    }
+
+    // Convert the file like the conversion in the properties panel does
+    QScopedPointer<playlistItemStatisticsFile> source(playlistItemStatisticsBinaryFile::newStatisticsFileForConversion(sourcePath));
+    QString errorText;
+    QList<int> progress;
+    QVERIFY2(source->writeBinaryFile(targetPath, errorText, [&progress](int percent) { progress.append(percent); return true; }), qPrintable(errorText));
+    QVERIFY(!progress.isEmpty());
+    QCOMPARE(progress.first(), 0);
+    QCOMPARE(progress.last(), 100);
+    for (int i = 1; i < progress.size(); i++)
+        QVERIFY(progress[i] >= progress[i-1]);
+
+    QScopedPointer<playlistItem> converted(playlistItems::createPlaylistItemFromFile(nullptr, targetPath));
+    QVERIFY(qobject_cast<playlistItemStatisticsBinaryFile*>(converted.data()) != nullptr);
+    QCOMPARE(converted->getStartEndFrameLimits(), indexRange(0, nrFrames - 1));
+    QCOMPARE(converted->getSize(), QSize(64, 32));
+
+    statisticHandler *sourceStats = source->getStatisticsHandler();
+    statisticHandler *convertedStats = converted->getStatisticsHandler();
+    const StatisticsTypeList types = sourceStats->getStatisticsTypeList();
+    QCOMPARE(convertedStats->getStatisticsTypeList().size(), types.size());
+
+    // Every frame/type must contain the same blocks as in the source file
+    playlistItemStatisticsBinaryFile *convertedItem = qobject_cast<playlistItemStatisticsBinaryFile*>(converted.data());
+    int nrBlocks = 0;
+    for (int frameIdx = 0; frameIdx < nrFrames; frameIdx++)
+    {
+        for (const StatisticsType &type : types)
+        {
+            const StatisticsType *convertedType = convertedStats->getStatisticsType(type.typeID);
+            QVERIFY(convertedType != nullptr);
+            QCOMPARE(convertedType->typeName, type.typeName);
+
+            sourceStats->statsCache.clear();
+            source->loadStatisticToCache(frameIdx, type.typeID);
+            const statisticsData expected = sourceStats->statsCache.value(type.typeID);
+
+            convertedStats->statsCache.clear();
+            convertedItem->loadStatisticToCache(frameIdx, type.typeID);
+            const statisticsData actual = convertedStats->statsCache.value(type.typeID);
+
+            compareData(actual, expected);
+            if (QTest::currentTestFailed())
+                return;
+            nrBlocks += expected.valueBlocks.count() + expected.vectorBlocks.count() + expected.affineTFBlocks.count() + expected.polygonValueData.size() + expected.polygonVectorData.size();
+        }
+    }
+    QVERIFY(nrBlocks > 200);
+}
+
+QTEST_MAIN(statisticsBinaryFileTest)
+
+#include "tst_statisticsBinaryFile.moc"
@@ -0,0 +1,71 @@
+#include <QtTest>
+
+#include <statistics/statisticsExtensions.h>
+
+class statisticsBlockListTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    statisticsBlockListTest();
+    ~statisticsBlockListTest();
+
+private slots:
+    void testBlocksInArea_data();
+    void testBlocksInArea();
+
+};
+
+statisticsBlockListTest::statisticsBlockListTest()
+{
+}
+
+statisticsBlockListTest::~statisticsBlockListTest()
+{
+}
+
+void statisticsBlockListTest::testBlocksInArea_data()
+{
+    QTest::addColumn<QRect>("area");
+
+    QTest::newRow("all") << QRect(-10, -10, 2000, 2000);
+    QTest::newRow("topLeft") << QRect(0, 0, 1, 1);
+    QTest::newRow("center") << QRect(300, 200, 50, 40);
+    QTest::newRow("tileBorder") << QRect(63, 63, 2, 2);
+    QTest::newRow("bottomRight") << QRect(700, 500, 300, 300);
+    QTest::newRow("outside") << QRect(2000, 2000, 10, 10);
+    QTest::newRow("negative") << QRect(-100, -100, 90, 90);
+}
+
+void statisticsBlockListTest::testBlocksInArea()
+{
+    QFETCH(QRect, area);
+
+    // A frame of 4x4 blocks with some bigger blocks on top
+    statisticsBlockList blocks;
+    for (int y = 0; y < 540; y += 4)
+        for (int x = 0; x < 960; x += 4)
+            blocks.append(x, y, 4, 4);
+    for (int y = 0; y < 540; y += 128)
+        for (int x = 0; x < 960; x += 128)
+            blocks.append(x, y, 128, 128);
+
+    // The expected result from testing every block
+    QVector<int> expected;
+    for (int i = 0; i < blocks.count(); i++)
+        if (blocks.getRect(i).intersects(area))
+            expected.append(i);
+
+    QVector<int> withoutGrid;
+    blocks.getBlocksInArea(area, withoutGrid);
+    QCOMPARE(withoutGrid, expected);
+
+    blocks.buildTileGrid();
+    QVector<int> withGrid;
+    blocks.getBlocksInArea(area, withGrid);
+    QCOMPARE(withGrid, expected);
+}
+
+QTEST_MAIN(statisticsBlockListTest)
+
+#include "tst_statisticsBlockList.moc"
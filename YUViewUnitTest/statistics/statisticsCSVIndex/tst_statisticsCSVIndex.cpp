@@ -0,0 +1,199 @@
+#include <QtTest>
+
+#include <playlistitem/playlistItemStatisticsCSVFile.h>
+
+typedef playlistItemStatisticsCSVFile::pocTypeStart pocTypeStart;
+
+class statisticsCSVIndexTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    statisticsCSVIndexTest();
+    ~statisticsCSVIndexTest();
+
+private slots:
+    void testParsePOCAndType_data();
+    void testParsePOCAndType();
+    void testIndexChunks_data();
+    void testIndexChunks();
+
+};
+
+namespace
+{
+    // Generate a CSV statistics file. Each run has the given number of lines with the same POC and type.
+    // Header lines, empty lines and spaces are mixed in. The last line has no newline if finalNewline is false.
+    QByteArray generateCSVFile(const QList<QPair<int, int>> &pocTypeRuns, int linesPerRun, bool crlf, bool finalNewline)
+    {
+        const QByteArray newline = crlf ? "\r\n" : "\n";
+        QByteArray data;
+        data += "%;syntax-version;v1.22" + newline;
+        data += "%;seq-specs;test;0;16;8;30;" + newline;
+        data += "%;type;7;Pred Mode;range" + newline;
+        for (const QPair<int, int> &run : pocTypeRuns)
+        {
+            for (int l = 0; l < linesPerRun; l++)
+            {
+                if (qrand() % 8 == 0)
+                    data += newline;
+                const QByteArray space = (qrand() % 3 == 0) ? " " : "";
+                data += QString("%1%2;%3;%4;8;8;%5%2;%6").arg(run.first).arg(QString(space)).arg(qrand() % 64 * 8).arg(qrand() % 64 * 8)
+                    .arg(run.second).arg(qrand() % 100).toLatin1();
+                data += newline;
+            }
+        }
+        if (!finalNewline)
+            data += "9;0;0;8;8;1;5";
+        return data;
+    }
+
+    // Index the data like the parser did before the file was indexed in chunks: Every line that ends with a newline
+    // is split with parseCSVLine (all spaces are removed) and the POC and the type are converted with toInt.
+    QVector<pocTypeStart> singlePassIndex(const QByteArray &data)
+    {
+        QVector<pocTypeStart> starts;
+        int lineStart = 0;
+        int newline;
+        while ((newline = data.indexOf('\n', lineStart)) >= 0)
+        {
+            const QString line = QString::fromLatin1(data.mid(lineStart, newline - lineStart)).trimmed().remove(' ');
+            const QStringList rowItemList = line.split(';');
+            if (!rowItemList[0].isEmpty() && rowItemList[0][0] != '%' && rowItemList.size() >= 6)
+            {
+                const int poc = rowItemList[0].toInt();
+                const int typeID = rowItemList[5].toInt();
+                if (starts.isEmpty() || starts.last().poc != poc || starts.last().typeID != typeID)
+                    starts.append(pocTypeStart{poc, typeID, lineStart});
+            }
+            lineStart = newline + 1;
+        }
+        return starts;
+    }
+
+    // Index the file in the given chunks and merge the results like the background parser does
+    QVector<pocTypeStart> chunkedIndex(fileSource *file, const QList<qint64> &chunkStarts)
+    {
+        const bool cancel = false;
+        QVector<pocTypeStart> starts;
+        for (int i = 0; i < chunkStarts.size(); i++)
+        {
+            const qint64 chunkEnd = (i + 1 < chunkStarts.size()) ? chunkStarts[i + 1] : file->getFileSize();
+            for (const pocTypeStart &start : playlistItemStatisticsCSVFile::indexCSVChunk(file, chunkStarts[i], chunkEnd, &cancel))
+                // The chunk may continue the data of the previous chunk
+                if (starts.isEmpty() || starts.last().poc != start.poc || starts.last().typeID != start.typeID)
+                    starts.append(start);
+        }
+        return starts;
+    }
+
+    QStringList toStringList(const QVector<pocTypeStart> &starts)
+    {
+        QStringList list;
+        for (const pocTypeStart &start : starts)
+            list.append(QString("POC %1 type %2 at %3").arg(start.poc).arg(start.typeID).arg(start.pos));
+        return list;
+    }
+}
+
+statisticsCSVIndexTest::statisticsCSVIndexTest()
+{
+}
+
+statisticsCSVIndexTest::~statisticsCSVIndexTest()
+{
+}
+
+void statisticsCSVIndexTest::testParsePOCAndType_data()
+{
+    QTest::addColumn<QByteArray>("line");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<int>("poc");
+    QTest::addColumn<int>("typeID");
+
+    QTest::newRow("plain") << QByteArray("3;0;8;8;8;7;1") << true << 3 << 7;
+    QTest::newRow("spaces") << QByteArray(" 12 ;0;8;8;8; 4 ;1") << true << 12 << 4;
+    QTest::newRow("crlf") << QByteArray("5;0;8;8;8;2;1\r") << true << 5 << 2;
+    QTest::newRow("sign") << QByteArray("-3;0;8;8;8;+4;1") << true << -3 << 4;
+    QTest::newRow("noNumber") << QByteArray("abc;0;8;8;8;2;1") << true << 0 << 2;
+    QTest::newRow("sixFields") << QByteArray("1;0;8;8;8;6") << true << 1 << 6;
+    QTest::newRow("header") << QByteArray("%;type;7;Pred Mode;range") << false << 0 << 0;
+    QTest::newRow("empty") << QByteArray("") << false << 0 << 0;
+    QTest::newRow("whitespace") << QByteArray(" \r") << false << 0 << 0;
+    QTest::newRow("emptyPOC") << QByteArray(";0;8;8;8;2;1") << false << 0 << 0;
+    QTest::newRow("fiveFields") << QByteArray("1;0;8;8;8") << false << 0 << 0;
+}
+
+void statisticsCSVIndexTest::testParsePOCAndType()
+{
+    QFETCH(QByteArray, line);
+    QFETCH(bool, valid);
+    QFETCH(int, poc);
+    QFETCH(int, typeID);
+
+    int parsedPOC = 0;
+    int parsedType = 0;
+    QCOMPARE(playlistItemStatisticsCSVFile::parsePOCAndType(line.constData(), line.constData() + line.size(), parsedPOC, parsedType), valid);
+    if (valid)
+    {
+        QCOMPARE(parsedPOC, poc);
+        QCOMPARE(parsedType, typeID);
+    }
+}
+
+void statisticsCSVIndexTest::testIndexChunks_data()
+{
+    QTest::addColumn<QByteArray>("data");
+
+    qsrand(1);
+    const QList<QPair<int, int>> sortedByPOC = {{0, 1}, {0, 2}, {1, 1}, {1, 2}, {2, 1}, {2, 2}};
+    const QList<QPair<int, int>> sortedByType = {{0, 1}, {1, 1}, {2, 1}, {0, 2}, {1, 2}, {2, 2}};
+    QTest::newRow("lf") << generateCSVFile(sortedByPOC, 5, false, true);
+    QTest::newRow("crlf") << generateCSVFile(sortedByPOC, 5, true, true);
+    QTest::newRow("sortedByType") << generateCSVFile(sortedByType, 3, true, true);
+    QTest::newRow("noFinalNewline") << generateCSVFile(sortedByPOC, 2, false, false);
+    // One run of a POC is much longer than the chunks
+    QTest::newRow("longPOC") << generateCSVFile({{0, 1}, {7, 3}, {1, 1}}, 60, true, true);
+    // Runs with the same POC/type directly after each other are one run
+    QTest::newRow("repeatedRun") << generateCSVFile({{0, 1}, {0, 1}, {3, 1}, {0, 1}}, 4, false, true);
+}
+
+void statisticsCSVIndexTest::testIndexChunks()
+{
+    QFETCH(QByteArray, data);
+
+    QTemporaryFile tempFile;
+    QVERIFY(tempFile.open());
+    QCOMPARE(tempFile.write(data), qint64(data.size()));
+    tempFile.close();
+    fileSource file;
+    QVERIFY(file.openFile(tempFile.fileName()));
+
+    const QStringList expected = toStringList(singlePassIndex(data));
+    QVERIFY(!expected.isEmpty());
+
+    // One chunk (the whole file)
+    QCOMPARE(toStringList(chunkedIndex(&file, {0})), expected);
+
+    // Two chunks split at every position. This splits lines in the middle, between '\r' and '\n', directly before
+    // and after a newline and inside runs of lines with the same POC/type.
+    for (qint64 splitPos = 1; splitPos < data.size(); splitPos++)
+    {
+        const QStringList index = toStringList(chunkedIndex(&file, {0, splitPos}));
+        if (index != expected)
+            QFAIL(qPrintable(QString("Split at %1: %2 instead of %3").arg(splitPos).arg(index.join(", ")).arg(expected.join(", "))));
+    }
+
+    // Many chunks that are smaller than a line. Most chunks do not contain the start of a line.
+    for (qint64 chunkSize : {1, 3, 17, 64})
+    {
+        QList<qint64> chunkStarts;
+        for (qint64 pos = 0; pos < data.size(); pos += chunkSize)
+            chunkStarts.append(pos);
+        QCOMPARE(toStringList(chunkedIndex(&file, chunkStarts)), expected);
+    }
+}
+
+QTEST_MAIN(statisticsCSVIndexTest)
+
+#include "tst_statisticsCSVIndex.moc"
@@ -0,0 +1,257 @@
+#include <QtTest>
+
+#include <statistics/statisticsVTMBMSParser.h>
+
+class statisticsVTMBMSParserTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    statisticsVTMBMSParserTest();
+    ~statisticsVTMBMSParserTest();
+
+private slots:
+    void testParityWithRegexParser();
+
+};
+
+namespace
+{
+    // The regular expression parser that was used to load the statistics of one frame/type before the tokenizer.
+    // The lines are parsed starting at the first line of the frame.
+    void parseWithRegex(const QStringList &lines, int firstLine, int frameIdx, const StatisticsType &type, statisticsData &out, bool &parsingError)
+    {
+        QRegularExpression pocRegex("BlockStat: POC ([0-9]+)");
+        QRegularExpression typeRegex(" " + type.typeName + "=");
+        QRegularExpression scalarRegex("POC ([0-9]+) @\\( *([0-9]+), *([0-9]+)\\) *\\[ *([0-9]+)x *([0-9]+)\\] *\\w+=([0-9\\-]+)");
+        QRegularExpression vectorRegex("POC ([0-9]+) @\\( *([0-9]+), *([0-9]+)\\) *\\[ *([0-9]+)x *([0-9]+)\\] *\\w+={ *([0-9\\-]+), *([0-9\\-]+)}");
+        QRegularExpression affineTFRegex("POC ([0-9]+) @\\( *([0-9]+), *([0-9]+)\\) *\\[ *([0-9]+)x *([0-9]+)\\] *\\w+={ *([0-9\\-]+), *([0-9\\-]+), *([0-9\\-]+), *([0-9\\-]+), *([0-9\\-]+), *([0-9\\-]+)}");
+        QRegularExpression scalarPolygonRegex("POC ([0-9]+) @\\[((?:\\( *[0-9]+, *[0-9]+\\)--){3,5})\\] *\\w+=([0-9\\-]+)");
+        QRegularExpression vectorPolygonRegex("POC ([0-9]+) @\\[((?:\\( *[0-9]+, *[0-9]+\\)--){3,5})\\] *\\w+={ *([0-9\\-]+), *([0-9\\-]+)}");
+        QRegularExpression lineRegex("POC ([0-9]+) @\\( *([0-9]+), *([0-9]+)\\) *\\[ *([0-9]+)x *([0-9]+)\\] *\\w+={ *([0-9\\-]+), *([0-9\\-]+), *([0-9\\-]+), *([0-9\\-]+)}");
+        QRegularExpression cornerRegex("\\( *([0-9]+), *([0-9]+)\\)");
+
+        for (int i = firstLine; i < lines.size(); i++)
+        {
+            const QString &aLine = lines[i];
+            QRegularExpressionMatch pocMatch = pocRegex.match(aLine);
+            if (!pocMatch.hasMatch())
+                continue;
+            if (pocMatch.captured(1).toInt() != frameIdx)
+                break;
+            if (!typeRegex.match(aLine).hasMatch())
+                continue;
+
+            QRegularExpressionMatch match;
+            if (!type.isPolygon)
+            {
+                if (type.hasValueData)
+                    match = scalarRegex.match(aLine);
+                else if (type.hasVectorData)
+                {
+                    match = vectorRegex.match(aLine);
+                    if (!match.hasMatch())
+                        match = lineRegex.match(aLine);
+                }
+                else if (type.hasAffineTFData)
+                    match = affineTFRegex.match(aLine);
+            }
+            else
+            {
+                if (type.hasValueData)
+                    match = scalarPolygonRegex.match(aLine);
+                else if (type.hasVectorData)
+                    match = vectorPolygonRegex.match(aLine);
+            }
+            if (!match.hasMatch())
+            {
+                parsingError = true;
+                continue;
+            }
+
+            if (!type.isPolygon)
+            {
+                const int posX = match.captured(2).toInt();
+                const int posY = match.captured(3).toInt();
+                const int width = match.captured(4).toInt();
+                const int height = match.captured(5).toInt();
+                if (type.hasVectorData && match.lastCapturedIndex() > 7)
+                    out.addLine(posX, posY, width, height, match.captured(6).toInt(), match.captured(7).toInt(), match.captured(8).toInt(), match.captured(9).toInt());
+                else if (type.hasVectorData)
+                    out.addBlockVector(posX, posY, width, height, match.captured(6).toInt(), match.captured(7).toInt());
+                else if (type.hasAffineTFData)
+                    out.addBlockAffineTF(posX, posY, width, height, match.captured(6).toInt(), match.captured(7).toInt(), match.captured(8).toInt(), match.captured(9).toInt(), match.captured(10).toInt(), match.captured(11).toInt());
+                else
+                    out.addBlockValue(posX, posY, width, height, match.captured(6).toInt());
+            }
+            else
+            {
+                QVector<QPoint> points;
+                for (const QString &corner : match.captured(2).split("--"))
+                {
+                    QRegularExpressionMatch cornerMatch = cornerRegex.match(corner);
+                    if (cornerMatch.hasMatch())
+                        points << QPoint(cornerMatch.captured(1).toInt(), cornerMatch.captured(2).toInt());
+                }
+                if (type.hasVectorData)
+                    out.addPolygonVector(points, match.captured(3).toInt(), match.captured(4).toInt());
+                else
+                    out.addPolygonValue(points, match.captured(3).toInt());
+            }
+        }
+    }
+
+    QString randomBlock()
+    {
+        return QString("@(%1, %2) [%3x%4] ").arg(qrand() % 64 * 4, 4).arg(qrand() % 64 * 4, 4).arg(4 << (qrand() % 4), 2).arg(4 << (qrand() % 4), 2);
+    }
+
+    QString randomPolygon()
+    {
+        QString polygon = "@[";
+        const int nrCorners = 3 + qrand() % 3;
+        for (int i = 0; i < nrCorners; i++)
+            polygon += QString("(%1, %2)--").arg(qrand() % 256, 3).arg(qrand() % 256, 3);
+        return polygon + "] ";
+    }
+
+    QString randomValues(int count)
+    {
+        QStringList values;
+        for (int i = 0; i < count; i++)
+            values.append(QString("%1").arg(qrand() % 600 - 300, (qrand() % 2) ? 4 : 0));
+        return "{" + values.join(",") + "}";
+    }
+
+    void compareBlocks(const statisticsBlockList &actual, const statisticsBlockList &expected)
+    {
+        QCOMPARE(actual.posX, expected.posX);
+        QCOMPARE(actual.posY, expected.posY);
+        QCOMPARE(actual.width, expected.width);
+        QCOMPARE(actual.height, expected.height);
+    }
+}
+
+statisticsVTMBMSParserTest::statisticsVTMBMSParserTest()
+{
+}
+
+statisticsVTMBMSParserTest::~statisticsVTMBMSParserTest()
+{
+}
+
+void statisticsVTMBMSParserTest::testParityWithRegexParser()
+{
+    StatisticsTypeList types;
+    types.append(StatisticsType(0, "PredMode", "jet", 0, 3));
+    types.append(StatisticsType(1, "MVL0", 4));
+    types.append(StatisticsType(2, "Line", 1));
+    types.append(StatisticsType(3, "AffineMVL0", 4));
+    types[3].hasVectorData = false;
+    types[3].hasAffineTFData = true;
+    types.append(StatisticsType(4, "GeoPUInterIntraFlag", "jet", 0, 1));
+    types[4].isPolygon = true;
+    types.append(StatisticsType(5, "GeoMVL0", 4));
+    types[5].isPolygon = true;
+
+    // Create a file with the types interleaved within each POC. Some lines can not be parsed. The last POC
+    // has windows line endings.
+    qsrand(42);
+    const int nrFrames = 4;
+    QStringList lines;
+    lines << "# VTMBMS Block Statistics" << "# Sequence size: [256x 256]";
+    QVector<int> frameFirstLine;
+    for (int poc = 0; poc < nrFrames; poc++)
+    {
+        frameFirstLine.append(lines.size());
+        for (int i = 0; i < 400; i++)
+        {
+            const QString start = QString("BlockStat: POC %1 ").arg(poc);
+            QString line;
+            switch (qrand() % 6)
+            {
+            case 0: line = start + randomBlock() + "PredMode=" + QString::number(qrand() % 4 - 1); break;
+            case 1: line = start + randomBlock() + "MVL0=" + randomValues(2); break;
+            case 2: line = start + randomBlock() + "Line=" + randomValues(4); break;
+            case 3: line = start + randomBlock() + "AffineMVL0=" + randomValues(6); break;
+            case 4: line = start + randomPolygon() + "GeoPUInterIntraFlag=" + QString::number(qrand() % 2); break;
+            default: line = start + randomPolygon() + "GeoMVL0=" + randomValues(2); break;
+            }
+            if (i % 97 == 13)
+                line = start + "@(   4,   4) [ 4x 4] PredMode={1,2}";
+            if (poc == nrFrames - 1)
+                line += "\r";
+            lines.append(line);
+        }
+    }
+    const QByteArray file = (lines.join("\n") + "\n").toLatin1();
+
+    QVector<int> frameStartPos;
+    int pos = 0;
+    for (int i = 0; i < lines.size(); i++)
+    {
+        if (frameFirstLine.contains(i))
+            frameStartPos.append(pos);
+        pos += lines[i].size() + 1;
+    }
+
+    for (int poc = 0; poc < nrFrames; poc++)
+    {
+        const char *frameStart = file.constData() + frameStartPos[poc];
+        QCOMPARE(statisticsVTMBMSParser::parsePOC(frameStart, file.constData() + file.size()), poc);
+        QCOMPARE(statisticsVTMBMSParser::parsePOC(file.constData(), file.constData() + file.size()), -1);
+
+        for (const StatisticsType &type : types)
+        {
+            statisticsData expected;
+            bool expectedError = false;
+            parseWithRegex(lines, frameFirstLine[poc], poc, type, expected, expectedError);
+
+            // Parse the data in small chunks so that lines are split between the chunks
+            statisticsData actual;
+            bool actualError = false;
+            const statisticsVTMBMSParser::typeParser parser(type);
+            qint64 start = frameStartPos[poc];
+            qint64 chunkSize = 64;
+            while (start < file.size())
+            {
+                const qint64 nrBytes = qMin(chunkSize, file.size() - start);
+                const bool atEnd = (start + nrBytes == file.size());
+                const statisticsVTMBMSParser::parseResult result = statisticsVTMBMSParser::parseFrameType(file.constData() + start, nrBytes, atEnd, poc, parser, QSize(256, 256), actual);
+                actualError |= !result.errorLine.isEmpty();
+                if (result.frameEnd || atEnd)
+                    break;
+                chunkSize = (result.bytesParsed == 0) ? chunkSize * 2 : 64 + qrand() % 64;
+                start += result.bytesParsed;
+            }
+
+            QCOMPARE(actualError, expectedError);
+            compareBlocks(actual.valueBlocks, expected.valueBlocks);
+            QCOMPARE(actual.values, expected.values);
+            compareBlocks(actual.vectorBlocks, expected.vectorBlocks);
+            QCOMPARE(actual.vectorPoints0, expected.vectorPoints0);
+            QCOMPARE(actual.vectorPoints1, expected.vectorPoints1);
+            QCOMPARE(actual.vectorIsLine, expected.vectorIsLine);
+            compareBlocks(actual.affineTFBlocks, expected.affineTFBlocks);
+            QCOMPARE(actual.affineTFPoints, expected.affineTFPoints);
+            QCOMPARE(actual.polygonValueData.size(), expected.polygonValueData.size());
+            for (int i = 0; i < expected.polygonValueData.size(); i++)
+            {
+                QCOMPARE(actual.polygonValueData[i].corners, expected.polygonValueData[i].corners);
+                QCOMPARE(actual.polygonValueData[i].value, expected.polygonValueData[i].value);
+            }
+            QCOMPARE(actual.polygonVectorData.size(), expected.polygonVectorData.size());
+            for (int i = 0; i < expected.polygonVectorData.size(); i++)
+            {
+                QCOMPARE(actual.polygonVectorData[i].corners, expected.polygonVectorData[i].corners);
+                QCOMPARE(actual.polygonVectorData[i].point[0], expected.polygonVectorData[i].point[0]);
+            }
+            QCOMPARE(actual.maxBlockSize, expected.maxBlockSize);
+            QVERIFY(!actual.isEmpty());
+        }
+    }
+}
+
+QTEST_MAIN(statisticsVTMBMSParserTest)
+
+#include "tst_statisticsVTMBMSParser.moc"
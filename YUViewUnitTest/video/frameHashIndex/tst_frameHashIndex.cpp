@@ -0,0 +1,91 @@
+#include <QtTest>
+
+#include <video/frameHashIndex.h>
+
+class frameHashIndexTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    frameHashIndexTest();
+    ~frameHashIndexTest();
+
+private slots:
+    void testHashFrame();
+    void testSaveAndLoadSidecar();
+
+};
+
+frameHashIndexTest::frameHashIndexTest()
+{
+}
+
+frameHashIndexTest::~frameHashIndexTest()
+{
+}
+
+void frameHashIndexTest::testHashFrame()
+{
+    const QVector<int64_t> planeSizes = QVector<int64_t>() << 16 << 4 << 4;
+    QByteArray frame(24, 0);
+    for (int i = 0; i < frame.size(); i++)
+        frame[i] = char(i);
+
+    const frameHashIndex::planeHashes hashes = frameHashIndex::hashFrame(frame, planeSizes);
+    QCOMPARE(hashes.size(), 3);
+    QCOMPARE(hashes[1], QCryptographicHash::hash(frame.mid(16, 4), QCryptographicHash::Md5));
+
+    // A change in one plane only changes the hash of that plane
+    QByteArray changedFrame = frame;
+    changedFrame[22] = char(99);
+    const frameHashIndex::planeHashes changedHashes = frameHashIndex::hashFrame(changedFrame, planeSizes);
+    QCOMPARE(changedHashes[0], hashes[0]);
+    QCOMPARE(changedHashes[1], hashes[1]);
+    QVERIFY(changedHashes[2] != hashes[2]);
+
+    // An incomplete frame has no hashes
+    QVERIFY(frameHashIndex::hashFrame(frame.left(20), planeSizes).isEmpty());
+}
+
+void frameHashIndexTest::testSaveAndLoadSidecar()
+{
+    QTemporaryDir tempDir;
+    QVERIFY(tempDir.isValid());
+    const QString videoFile = tempDir.filePath("video.yuv");
+    {
+        QFile file(videoFile);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(QByteArray(48, 'a'));
+    }
+
+    const QVector<int64_t> planeSizes = QVector<int64_t>() << 16 << 4 << 4;
+    const QString sidecarFile = frameHashIndex::getSidecarFile(videoFile);
+    const QString key = frameHashIndex::getKey(videoFile, "yuv 4:2:0 8bit", planeSizes);
+    QVERIFY(key != frameHashIndex::getKey(videoFile, "yuv 4:2:0 10bit", planeSizes));
+    QVERIFY(key != frameHashIndex::getKey(videoFile, "yuv 4:2:0 8bit", QVector<int64_t>() << 16 << 8));
+
+    const frameHashIndex::planeHashes hashes = frameHashIndex::hashFrame(QByteArray(24, 'a'), planeSizes);
+    {
+        frameHashIndex index(sidecarFile, key);
+        QVERIFY(!index.loadSidecar());
+        index.setHashes(0, hashes);
+        index.setHashes(1, hashes);
+        QVERIFY(index.saveSidecar());
+    }
+
+    frameHashIndex loaded(sidecarFile, key);
+    QVERIFY(loaded.loadSidecar());
+    QVERIFY(loaded.contains(0));
+    QVERIFY(loaded.contains(1));
+    QVERIFY(!loaded.contains(2));
+    QCOMPARE(loaded.getHashes(1), hashes);
+
+    // The sidecar is ignored if it was written for another source of the raw data
+    frameHashIndex otherSource(sidecarFile, frameHashIndex::getKey(videoFile, "yuv 4:2:0 10bit", planeSizes));
+    QVERIFY(!otherSource.loadSidecar());
+    QVERIFY(!otherSource.contains(0));
+}
+
+QTEST_MAIN(frameHashIndexTest)
+
+#include "tst_frameHashIndex.moc"
@@ -0,0 +1,3 @@
+TEMPLATE = subdirs
+
+SUBDIRS = frameHashIndex videoCacheRemoval videoHandlerRGBHighBitDepth videoHandlerYUVKernels
\ No newline at end of file
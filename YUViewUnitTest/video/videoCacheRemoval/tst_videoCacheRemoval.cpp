@@ -0,0 +1,140 @@
+#include <QtTest>
+
+#include <video/videoCache.h>
+
+class videoCacheRemovalTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    videoCacheRemovalTest();
+    ~videoCacheRemovalTest();
+
+private slots:
+    void testPlaybackDirection();
+    void testRepeatItem();
+    void testStoppedPlayhead();
+    void testExpensiveItem();
+
+};
+
+namespace
+{
+    const int64_t frameSize = 1920 * 1080 * 4;
+
+    // All frames of the timeline with the same size and cost
+    QVector<videoCache::removalCandidate> allFrames(int64_t length, double cost)
+    {
+        QVector<videoCache::removalCandidate> candidates;
+        for (int64_t pos = 0; pos < length; pos++)
+            candidates.append(videoCache::removalCandidate{pos, frameSize, cost});
+        return candidates;
+    }
+
+    // The positions of the candidates in the order in which they are removed
+    QList<int64_t> removalOrder(const QVector<videoCache::removalCandidate> &candidates, const videoCache::removalTimeline &timeline)
+    {
+        QList<int64_t> positions;
+        for (int i : videoCache::sortRemovalCandidates(candidates, timeline))
+            positions.append(candidates[i].pos);
+        return positions;
+    }
+}
+
+videoCacheRemovalTest::videoCacheRemovalTest()
+{
+}
+
+videoCacheRemovalTest::~videoCacheRemovalTest()
+{
+}
+
+void videoCacheRemovalTest::testPlaybackDirection()
+{
+    // During playback, the frames right before the current frame are shown last. They are removed first.
+    videoCache::removalTimeline timeline;
+    timeline.length = 10;
+    timeline.selectedLength = 10;
+    timeline.currentPos = 3;
+    timeline.playing = true;
+    QCOMPARE(removalOrder(allFrames(10, 1.0), timeline), QList<int64_t>({2, 1, 0, 9, 8, 7, 6, 5, 4, 3}));
+
+    // The next item in the playlist is shown after the selected item
+    timeline.selectedLength = 5;
+    timeline.currentPos = 1;
+    QCOMPARE(removalOrder(allFrames(10, 1.0), timeline), QList<int64_t>({0, 9, 8, 7, 6, 5, 4, 3, 2, 1}));
+}
+
+void videoCacheRemovalTest::testRepeatItem()
+{
+    // If the selected item is repeated, the frames of the other items are not shown anymore
+    videoCache::removalTimeline timeline;
+    timeline.length = 10;
+    timeline.selectedLength = 5;
+    timeline.currentPos = 1;
+    timeline.playing = true;
+    timeline.repeatItem = true;
+    QCOMPARE(removalOrder(allFrames(10, 1.0), timeline), QList<int64_t>({9, 8, 7, 6, 5, 0, 4, 3, 2, 1}));
+}
+
+void videoCacheRemovalTest::testStoppedPlayhead()
+{
+    // If playback is stopped, the user may step in both directions. The frames furthest away from the
+    // current frame (wrapping around at the end) are removed first. Frames with the same distance keep their order.
+    videoCache::removalTimeline timeline;
+    timeline.length = 10;
+    timeline.selectedLength = 10;
+    timeline.currentPos = 5;
+    QCOMPARE(removalOrder(allFrames(10, 1.0), timeline), QList<int64_t>({0, 1, 9, 2, 8, 3, 7, 4, 6, 5}));
+
+    timeline.currentPos = 0;
+    QCOMPARE(removalOrder(allFrames(10, 1.0), timeline), QList<int64_t>({5, 4, 6, 3, 7, 2, 8, 1, 9, 0}));
+
+    // The playhead does not matter for the direction if repeating is on
+    timeline.repeatItem = true;
+    QCOMPARE(removalOrder(allFrames(10, 1.0), timeline), QList<int64_t>({5, 4, 6, 3, 7, 2, 8, 1, 9, 0}));
+}
+
+void videoCacheRemovalTest::testExpensiveItem()
+{
+    // A cheap raw item (frames 0-99) and an HEVC item (frames 100-199) that takes 50 times as long to
+    // recreate a frame of the same size. Playback is stopped at the first frame of the raw item.
+    videoCache::removalTimeline timeline;
+    timeline.length = 200;
+    timeline.selectedLength = 100;
+    timeline.currentPos = 0;
+    const double rawCost = 2.0;
+    const double hevcCost = 100.0;
+
+    // A raw frame is removed before an HEVC frame at the same distance
+    QVector<videoCache::removalCandidate> candidates;
+    candidates.append(videoCache::removalCandidate{190, frameSize, hevcCost});
+    candidates.append(videoCache::removalCandidate{10, frameSize, rawCost});
+    QCOMPARE(removalOrder(candidates, timeline), QList<int64_t>({10, 190}));
+
+    // Also a raw frame that is shown a lot sooner is removed first
+    candidates[1].pos = 3;
+    QCOMPARE(removalOrder(candidates, timeline), QList<int64_t>({3, 190}));
+
+    // Only if the HEVC frame is shown more than 50 times later, it is removed first
+    candidates[0].pos = 100;
+    candidates[1].pos = 1;
+    QCOMPARE(removalOrder(candidates, timeline), QList<int64_t>({100, 1}));
+
+    // During playback, all HEVC frames will be shown before the raw frames behind the playhead
+    timeline.playing = true;
+    timeline.currentPos = 50;
+    candidates.clear();
+    candidates.append(videoCache::removalCandidate{150, frameSize, hevcCost});
+    candidates.append(videoCache::removalCandidate{49, frameSize, rawCost});
+    candidates.append(videoCache::removalCandidate{60, frameSize, rawCost});
+    QCOMPARE(removalOrder(candidates, timeline), QList<int64_t>({49, 60, 150}));
+
+    // A frame without a measured cost is never divided by zero
+    candidates[2].cost = 0;
+    QCOMPARE(removalOrder(candidates, timeline).first(), int64_t(60));
+}
+
+QTEST_MAIN(videoCacheRemovalTest)
+
+#include "tst_videoCacheRemoval.moc"
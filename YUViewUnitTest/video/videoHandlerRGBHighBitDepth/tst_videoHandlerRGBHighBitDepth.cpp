@@ -0,0 +1,144 @@
+#include <QtTest>
+
+#include <video/videoHandlerRGB.h>
+
+class videoHandlerRGBHighBitDepthTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    videoHandlerRGBHighBitDepthTest();
+    ~videoHandlerRGBHighBitDepthTest();
+
+private slots:
+    void initTestCase();
+    void testLoadRGB16();
+    void testLoadGray16();
+    void testLoad8Bit();
+    void testLoadInvalidFile();
+
+private:
+    QTemporaryDir tempDir;
+};
+
+namespace
+{
+    const int width = 7;
+    const int height = 5;
+    const int planeSize = width * height;
+
+    // Different 16 bit values for every sample. The lower 8 bits are not zero so that they are lost in an 8 bit image.
+    unsigned short sampleValue(int x, int y, int component)
+    {
+        return (unsigned short)((x * 9001 + y * 3079 + component * 20011 + 0x0155) % 65536);
+    }
+
+    // The value of the sample at (x, y) in the given plane of the planar 16 bit data
+    unsigned short planeValue(const QByteArray &data, int plane, int x, int y)
+    {
+        const unsigned short *values = (const unsigned short*)data.constData();
+        return values[plane * planeSize + y * width + x];
+    }
+}
+
+videoHandlerRGBHighBitDepthTest::videoHandlerRGBHighBitDepthTest()
+{
+}
+
+videoHandlerRGBHighBitDepthTest::~videoHandlerRGBHighBitDepthTest()
+{
+}
+
+void videoHandlerRGBHighBitDepthTest::initTestCase()
+{
+    QVERIFY(tempDir.isValid());
+}
+
+void videoHandlerRGBHighBitDepthTest::testLoadRGB16()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    QImage image(width, height, QImage::Format_RGBX64);
+    for (int y = 0; y < height; y++)
+    {
+        QRgba64 *line = (QRgba64*)image.scanLine(y);
+        for (int x = 0; x < width; x++)
+            line[x] = QRgba64::fromRgba64(sampleValue(x, y, 0), sampleValue(x, y, 1), sampleValue(x, y, 2), 0xffff);
+    }
+    const QString filePath = tempDir.filePath("rgb16.png");
+    QVERIFY(image.save(filePath, "PNG"));
+
+    QVERIFY(videoHandlerRGB::isHighBitDepthImageFile(filePath));
+
+    QSize frameSize;
+    const QByteArray data = videoHandlerRGB::loadHighBitDepthImageFile(filePath, frameSize);
+    QCOMPARE(frameSize, QSize(width, height));
+    QCOMPARE(data.size(), planeSize * 6);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            for (int c = 0; c < 3; c++)
+                QCOMPARE(planeValue(data, c, x, y), sampleValue(x, y, c));
+#else
+    QSKIP("Loading 16 bit images needs Qt 5.12 or newer");
+#endif
+}
+
+void videoHandlerRGBHighBitDepthTest::testLoadGray16()
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+    QImage image(width, height, QImage::Format_Grayscale16);
+    for (int y = 0; y < height; y++)
+    {
+        unsigned short *line = (unsigned short*)image.scanLine(y);
+        for (int x = 0; x < width; x++)
+            line[x] = sampleValue(x, y, 0);
+    }
+    const QString filePath = tempDir.filePath("gray16.png");
+    QVERIFY(image.save(filePath, "PNG"));
+
+    QVERIFY(videoHandlerRGB::isHighBitDepthImageFile(filePath));
+
+    // The gray value is put into all three planes
+    QSize frameSize;
+    const QByteArray data = videoHandlerRGB::loadHighBitDepthImageFile(filePath, frameSize);
+    QCOMPARE(frameSize, QSize(width, height));
+    QCOMPARE(data.size(), planeSize * 6);
+    for (int y = 0; y < height; y++)
+        for (int x = 0; x < width; x++)
+            for (int c = 0; c < 3; c++)
+                QCOMPARE(planeValue(data, c, x, y), sampleValue(x, y, 0));
+#else
+    QSKIP("16 bit gray images need Qt 5.13 or newer");
+#endif
+}
+
+void videoHandlerRGBHighBitDepthTest::testLoad8Bit()
+{
+    // 8 bit images are loaded into a QImage. They are not loaded as 16 bit data.
+    QImage image(width, height, QImage::Format_RGB32);
+    image.fill(qRgb(10, 20, 30));
+    const QString filePath = tempDir.filePath("rgb8.png");
+    QVERIFY(image.save(filePath, "PNG"));
+
+    QVERIFY(!videoHandlerRGB::isHighBitDepthImageFile(filePath));
+}
+
+void videoHandlerRGBHighBitDepthTest::testLoadInvalidFile()
+{
+    const QString filePath = tempDir.filePath("invalid.png");
+    {
+        QFile file(filePath);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QVERIFY(file.write("This is not a PNG file") > 0);
+    }
+
+    QVERIFY(!videoHandlerRGB::isHighBitDepthImageFile(filePath));
+
+    // The frame size is not changed
+    QSize frameSize(3, 4);
+    QVERIFY(videoHandlerRGB::loadHighBitDepthImageFile(filePath, frameSize).isEmpty());
+    QCOMPARE(frameSize, QSize(3, 4));
+}
+
+QTEST_MAIN(videoHandlerRGBHighBitDepthTest)
+
+#include "tst_videoHandlerRGBHighBitDepth.moc"
@@ -0,0 +1,350 @@
+#include <QtTest>
+
+#include <video/videoHandlerYUV.h>
+#include <video/videoHandlerYUVKernels.h>
+
+using namespace YUV_Internals;
+
+namespace
+{
+
+// Give the test access to the conversion of a raw YUV frame to an image
+class testVideoHandlerYUV : public videoHandlerYUV
+{
+public:
+    QImage convertFrame(const QByteArray &rawData, const yuvPixelFormat &format, const QSize &size, InterpolationMode interpolation)
+    {
+        srcPixelFormat = format;
+        frameSize = size;
+        interpolationMode = interpolation;
+        QImage image;
+        convertRawFrameFromCache(rawData, image);
+        return image;
+    }
+};
+
+// The per-pixel YUV to RGB conversion (BT.709 limited range) that was used before the line kernels
+void convertYUVToRGBPerPixel(int valY, int valU, int valV, int &valR, int &valG, int &valB, int bps)
+{
+    const int RGBConv[5] = {76309, 117489, -13975, -34925, 138438};
+    const int yOffset = 16 << (bps - 8);
+    const int cZero = 128 << (bps - 8);
+
+    const int Y_tmp = (valY - yOffset) * RGBConv[0];
+    const int U_tmp = valU - cZero;
+    const int V_tmp = valV - cZero;
+
+    const int R_tmp = (Y_tmp                      + V_tmp * RGBConv[1]) >> (16 + bps - 8);
+    const int G_tmp = (Y_tmp + U_tmp * RGBConv[2] + V_tmp * RGBConv[3]) >> (16 + bps - 8);
+    const int B_tmp = (Y_tmp + U_tmp * RGBConv[4]                     ) >> (16 + bps - 8);
+
+    valR = qBound(0, R_tmp, 255);
+    valG = qBound(0, G_tmp, 255);
+    valB = qBound(0, B_tmp, 255);
+}
+
+int interpolateUVSample(InterpolationMode mode, int sample1, int sample2)
+{
+    if (mode == BiLinearInterpolation)
+        return (sample1 + sample2 + 1) >> 1;
+    return sample1;
+}
+
+int interpolateUVSample2D(InterpolationMode mode, int sample1, int sample2, int sample3, int sample4)
+{
+    if (mode == BiLinearInterpolation)
+        return (sample1 + sample2 + sample3 + sample4 + 2) >> 2;
+    return sample1;
+}
+
+int interpolateUV8Pos(int prev, int cur, int offset8)
+{
+    const int weightCur = 8 - offset8;
+    if (offset8 % 4 == 0)
+        return (prev + cur + 1) / 2;
+    if (offset8 % 2 == 0)
+        return (prev * offset8 / 2 + cur * weightCur / 2 + 2) / 4;
+    return (prev * offset8 + cur * weightCur + 4) / 8;
+}
+
+// Shift the chroma samples by the chroma offset (in 1/8 chroma samples) so that they are aligned with the luma samples
+void resampleChromaOffset(QVector<int> &plane, int wC, int hC, int offsetX8, int offsetY8)
+{
+    if (offsetX8 != 0)
+        for (int y = 0; y < hC; y++)
+            for (int x = wC - 1; x > 0; x--)
+                plane[y * wC + x] = interpolateUV8Pos(plane[y * wC + x - 1], plane[y * wC + x], offsetX8);
+    if (offsetY8 != 0)
+        for (int y = hC - 1; y > 0; y--)
+            for (int x = 0; x < wC; x++)
+                plane[y * wC + x] = interpolateUV8Pos(plane[(y - 1) * wC + x], plane[y * wC + x], offsetY8);
+}
+
+int offsetIn8thSamples(int offset, int subsamplingFactor)
+{
+    return offset * 8 / (2 * subsamplingFactor);
+}
+
+}
+
+class videoHandlerYUVKernelsTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    videoHandlerYUVKernelsTest();
+    ~videoHandlerYUVKernelsTest();
+
+private slots:
+    void testKernelsBitExact_data();
+    void testKernelsBitExact();
+    void testLineConversionMatchesPerPixel_data();
+    void testLineConversionMatchesPerPixel();
+};
+
+videoHandlerYUVKernelsTest::videoHandlerYUVKernelsTest()
+{
+}
+
+videoHandlerYUVKernelsTest::~videoHandlerYUVKernelsTest()
+{
+}
+
+void videoHandlerYUVKernelsTest::testKernelsBitExact_data()
+{
+    QTest::addColumn<int>("bitDepth");
+    QTest::addColumn<bool>("bigEndian");
+    QTest::addColumn<int>("inValSkip");
+
+    for (int bitDepth = 8; bitDepth <= 16; bitDepth++)
+        for (int bigEndian = 0; bigEndian < 2; bigEndian++)
+            for (int inValSkip = 1; inValSkip <= 3; inValSkip++)
+            {
+                if (bitDepth == 8 && bigEndian)
+                    continue;
+                const QString name = QString("%1bit_%2_skip%3").arg(bitDepth).arg(bigEndian ? "BE" : "LE").arg(inValSkip);
+                QTest::newRow(name.toLatin1().constData()) << bitDepth << bool(bigEndian) << inValSkip;
+            }
+}
+
+void videoHandlerYUVKernelsTest::testKernelsBitExact()
+{
+    QFETCH(int, bitDepth);
+    QFETCH(bool, bigEndian);
+    QFETCH(int, inValSkip);
+
+    // The conversion matrices of all the supported ColorConversion types (see videoHandlerYUV.cpp)
+    const int yuvRgbConvCoeffs[6][5] =
+    {
+        {76309, 117489, -13975, -34925, 138438},
+        {65536, 103206, -12276, -30679, 121608},
+        {76309, 104597, -25675, -53279, 132201},
+        {65536,  91881, -22553, -46802, 116129},
+        {76309, 110013, -12276, -42626, 140363},
+        {65536,  96638, -10783, -37444, 123299}
+    };
+
+    // An odd number of samples so that the remainder after the vectorized part is also tested
+    const int count = 1001;
+    const int bytesPerSample = (bitDepth > 8) ? 2 : 1;
+    const int maxVal = (1 << bitDepth) - 1;
+
+    qsrand(bitDepth * 6 + inValSkip);
+    QByteArray source(count * inValSkip * bytesPerSample, 0);
+    for (int i = 0; i < source.size(); i++)
+        source[i] = char(qrand() & 0xff);
+
+    const lineKernels &reference = getLineKernels(SIMD_None);
+    for (int level = SIMD_None + 1; level < SIMD_NUM; level++)
+    {
+        const lineKernels &kernels = getLineKernels(SIMDLevel(level));
+        if (kernels.level != level)
+            // Not supported by this CPU
+            continue;
+
+        const unsigned char *src = (const unsigned char*)source.constData();
+        QVector<int> expected(count), actual(count);
+        reference.readSamples(src, expected.data(), count, inValSkip, bitDepth, bigEndian);
+        kernels.readSamples(src, actual.data(), count, inValSkip, bitDepth, bigEndian);
+        QCOMPARE(actual, expected);
+
+        // Clip the values to the bit depth. The kernels only read 16 bit values.
+        for (int i = 0; i < count; i++)
+            expected[i] &= maxVal;
+
+        QVector<int> mathExpected = expected, mathActual = expected;
+        reference.applyMath(mathExpected.data(), count, 3, 1 << (bitDepth - 1), true, maxVal);
+        kernels.applyMath(mathActual.data(), count, 3, 1 << (bitDepth - 1), true, maxVal);
+        QCOMPARE(mathActual, mathExpected);
+
+        QVector<int> valU(count), valV(count);
+        for (int i = 0; i < count; i++)
+        {
+            valU[i] = expected[(i * 7) % count];
+            valV[i] = expected[(i * 13) % count];
+        }
+        for (int conversion = 0; conversion < 6; conversion++)
+        {
+            const lineConversionParameters param = getLineConversionParameters(yuvRgbConvCoeffs[conversion], conversion % 2 == 1, bitDepth);
+            QByteArray bgraExpected(count * 4, 0), bgraActual(count * 4, 0);
+            reference.convertLineToBGRA(expected.constData(), valU.constData(), valV.constData(), (unsigned char*)bgraExpected.data(), count, param);
+            kernels.convertLineToBGRA(expected.constData(), valU.constData(), valV.constData(), (unsigned char*)bgraActual.data(), count, param);
+            QCOMPARE(bgraActual, bgraExpected);
+        }
+
+        for (int shift = 0; shift < 2; shift++)
+        {
+            const int64_t sseExpected = reference.sumSquaredDifference(expected.constData(), valU.constData(), count, shift, 0);
+            const int64_t sseActual = kernels.sumSquaredDifference(expected.constData(), valU.constData(), count, shift, 0);
+            QCOMPARE(sseActual, sseExpected);
+        }
+
+        const int diffZero = 1 << (bitDepth - 1);
+        for (int amplification = 1; amplification <= 4; amplification += 3)
+        {
+            QVector<int> diffExpected(count), diffActual(count);
+            const int64_t sseExpected = reference.differenceLine(expected.constData(), valU.constData(), diffExpected.data(), count, 0, 0, amplification, diffZero, maxVal);
+            const int64_t sseActual = kernels.differenceLine(expected.constData(), valU.constData(), diffActual.data(), count, 0, 0, amplification, diffZero, maxVal);
+            QCOMPARE(sseActual, sseExpected);
+            QCOMPARE(diffActual, diffExpected);
+
+            // Writing the difference and reading it back must give the same samples
+            QByteArray rawExpected(count * bytesPerSample, 0), rawActual(count * bytesPerSample, 0);
+            reference.writeSamples(diffExpected.constData(), (unsigned char*)rawExpected.data(), count, bitDepth, bigEndian);
+            kernels.writeSamples(diffExpected.constData(), (unsigned char*)rawActual.data(), count, bitDepth, bigEndian);
+            QCOMPARE(rawActual, rawExpected);
+            QVector<int> readBack(count);
+            reference.readSamples((const unsigned char*)rawActual.constData(), readBack.data(), count, 1, bitDepth, bigEndian);
+            QCOMPARE(readBack, diffExpected);
+
+            // Make some of the chroma samples have no difference
+            QVector<int> markU = valU, markV = valV;
+            for (int i = 0; i < count; i += 3)
+                markU[i] = diffZero;
+            for (int i = 0; i < count; i += 5)
+                markV[i] = diffZero;
+            QByteArray bgraExpected(count * 4, 0), bgraActual(count * 4, 0);
+            reference.markDifferencesLineToBGRA(diffExpected.constData(), markU.constData(), markV.constData(), (unsigned char*)bgraExpected.data(), count, diffZero);
+            kernels.markDifferencesLineToBGRA(diffExpected.constData(), markU.constData(), markV.constData(), (unsigned char*)bgraActual.data(), count, diffZero);
+            QCOMPARE(bgraActual, bgraExpected);
+        }
+    }
+}
+
+void videoHandlerYUVKernelsTest::testLineConversionMatchesPerPixel_data()
+{
+    QTest::addColumn<int>("subsampling");
+    QTest::addColumn<int>("bitDepth");
+    QTest::addColumn<int>("interpolation");
+    QTest::addColumn<int>("chromaOffsetX");
+    QTest::addColumn<int>("chromaOffsetY");
+
+    const YUVSubsamplingType subsamplings[] = {YUV_444, YUV_422, YUV_420};
+    const char *subsamplingNames[] = {"444", "422", "420"};
+    for (int s = 0; s < 3; s++)
+        for (int bitDepth = 8; bitDepth <= 10; bitDepth += 2)
+            for (int interpolation = 0; interpolation < 2; interpolation++)
+            {
+                // The default chroma offset and odd offsets which require resampling of the chroma planes
+                yuvPixelFormat defaultFormat(subsamplings[s], bitDepth);
+                QList<QPoint> offsets = QList<QPoint>() << QPoint(defaultFormat.chromaOffset[0], defaultFormat.chromaOffset[1]) << QPoint(1, 1);
+                if (subsamplings[s] != YUV_444)
+                    offsets << QPoint(3, (subsamplings[s] == YUV_420) ? 3 : 1);
+
+                for (const QPoint &offset : offsets)
+                {
+                    const QString name = QString("%1_%2bit_%3_offset%4_%5").arg(subsamplingNames[s]).arg(bitDepth).arg(interpolation ? "bilinear" : "nearest").arg(offset.x()).arg(offset.y());
+                    QTest::newRow(name.toLatin1().constData()) << int(subsamplings[s]) << bitDepth << interpolation << offset.x() << offset.y();
+                }
+            }
+}
+
+void videoHandlerYUVKernelsTest::testLineConversionMatchesPerPixel()
+{
+    QFETCH(int, subsampling);
+    QFETCH(int, bitDepth);
+    QFETCH(int, interpolation);
+    QFETCH(int, chromaOffsetX);
+    QFETCH(int, chromaOffsetY);
+
+    yuvPixelFormat format(YUVSubsamplingType(subsampling), bitDepth);
+    format.chromaOffset[0] = chromaOffsetX;
+    format.chromaOffset[1] = chromaOffsetY;
+    const InterpolationMode interpolationMode = (interpolation == 0) ? NearestNeighborInterpolation : BiLinearInterpolation;
+
+    // Not a multiple of the vector width, so that the remainder of each line is converted as well
+    const int w = 34;
+    const int h = 18;
+    const int subX = format.getSubsamplingHor();
+    const int subY = format.getSubsamplingVer();
+    const int wC = w / subX;
+    const int hC = h / subY;
+    const int bytesPerSample = (bitDepth > 8) ? 2 : 1;
+
+    // Random samples in the Y, U and V plane
+    qsrand(subsampling * 100 + bitDepth * 10 + chromaOffsetX * 4 + chromaOffsetY);
+    QVector<int> planes[3] = {QVector<int>(w * h), QVector<int>(wC * hC), QVector<int>(wC * hC)};
+    QByteArray rawData;
+    for (int c = 0; c < 3; c++)
+        for (int &val : planes[c])
+        {
+            val = qrand() % (1 << bitDepth);
+            rawData.append(char(val & 0xff));
+            if (bytesPerSample == 2)
+                rawData.append(char(val >> 8));
+        }
+
+    testVideoHandlerYUV handler;
+    const QImage image = handler.convertFrame(rawData, format, QSize(w, h), interpolationMode);
+    QCOMPARE(image.size(), QSize(w, h));
+
+    // The 8 bit 4:2:0 conversion for the default chroma offset does not resample the chroma planes
+    const bool fastPath420 = (bitDepth == 8 && format.subsampling == YUV_420 && interpolationMode == NearestNeighborInterpolation &&
+                              chromaOffsetX == 0 && chromaOffsetY == 1);
+    if (!fastPath420)
+        for (int c = 1; c < 3; c++)
+            resampleChromaOffset(planes[c], wC, hC, offsetIn8thSamples(chromaOffsetX, subX), offsetIn8thSamples(chromaOffsetY, subY));
+
+    // The per-pixel reference. The odd luma positions use the interpolated chroma value between the current and
+    // the next chroma sample. At the right and bottom border, the last chroma sample is repeated.
+    for (int y = 0; y < h; y++)
+        for (int x = 0; x < w; x++)
+        {
+            const int xC = x / subX;
+            const int yC = y / subY;
+            const int xCNext = qMin(xC + 1, wC - 1);
+            const int yCNext = qMin(yC + 1, hC - 1);
+            const bool interpolateX = (subX == 2 && x % 2 == 1);
+            const bool interpolateY = (subY == 2 && y % 2 == 1);
+
+            int chroma[2];
+            for (int c = 0; c < 2; c++)
+            {
+                const QVector<int> &plane = planes[c + 1];
+                const int cur = plane[yC * wC + xC];
+                const int next = plane[yC * wC + xCNext];
+                const int curNextLine = plane[yCNext * wC + xC];
+                const int nextNextLine = plane[yCNext * wC + xCNext];
+                if (interpolateX && interpolateY)
+                    chroma[c] = interpolateUVSample2D(interpolationMode, cur, next, curNextLine, nextNextLine);
+                else if (interpolateX)
+                    chroma[c] = interpolateUVSample(interpolationMode, cur, next);
+                else if (interpolateY)
+                    chroma[c] = interpolateUVSample(interpolationMode, cur, curNextLine);
+                else
+                    chroma[c] = cur;
+            }
+
+            int valR, valG, valB;
+            convertYUVToRGBPerPixel(planes[0][y * w + x], chroma[0], chroma[1], valR, valG, valB, bitDepth);
+
+            const QRgb pixel = image.pixel(x, y);
+            if (qRed(pixel) != valR || qGreen(pixel) != valG || qBlue(pixel) != valB)
+                QFAIL(qPrintable(QString("Pixel (%1,%2) is (%3,%4,%5) but the per-pixel conversion gives (%6,%7,%8)")
+                                 .arg(x).arg(y).arg(qRed(pixel)).arg(qGreen(pixel)).arg(qBlue(pixel)).arg(valR).arg(valG).arg(valB)));
+        }
+}
+
+QTEST_MAIN(videoHandlerYUVKernelsTest)
+
+#include "tst_videoHandlerYUVKernels.moc"